@@ -30,6 +30,8 @@
 //============================================================================
 
 
+#include <cmath>
+#include <limits>
 #include "IonexStore.hpp"
 
 using namespace gpstk::StringUtils;
@@ -430,6 +432,317 @@ namespace gpstk
 
 
 
+      /* Prepare the TEC and RMS maps of an epoch to be interpolated at
+       * many points, with the same strategies as getIonexValue().
+       *
+       * @param t          Time tag of signal (CommonTime object)
+       * @param grid       Object to hold the maps of the epoch.
+       * @param strategy   Interpolation strategy
+       *                   @sa IonexStore::getIonexValue
+       * @param height     Height of the ionosphere (meters), used
+       *                   only with 3D maps.
+       */
+   void IonexStore::prepareGrid( const CommonTime& t,
+                                 IonexGrid& grid,
+                                 int strategy,
+                                 double height ) const
+      throw(InvalidRequest)
+   {
+
+         // current time check
+      if (t < getInitialTime())
+      {
+         InvalidRequest e("Inadequate data before requested time");
+         GPSTK_THROW(e);
+      }
+
+      if (t > getFinalTime() )
+      {
+         InvalidRequest e("Inadequate data after requested time");
+         GPSTK_THROW(e);
+      }
+
+      if (strategy < 1 || strategy > 4)
+      {
+         InvalidRequest e("Invalid interpolation stategy");
+         GPSTK_THROW(e);
+      }
+
+         // let's look for the maps bracketing the epoch
+      IonexMap::const_iterator itm[2];
+      itm[1] = inxMaps.lower_bound(t);
+
+      if( itm[1] == inxMaps.end() )
+      {
+         InvalidRequest e("IonexStore::prepareGrid() ... Invalid time!");
+         GPSTK_THROW(e);
+      }
+
+      if( itm[1]->first == t )
+      {
+            // exact match of t: current and next map, if any
+         itm[0] = itm[1];
+         ++itm[1];
+      }
+      else if( itm[1] != inxMaps.begin() )
+      {
+         itm[0] = itm[1];
+         --itm[0];
+      }
+      else
+      {
+         InvalidRequest e("IonexStore::prepareGrid() ... Invalid time!");
+         GPSTK_THROW(e);
+      }
+
+         // factors (As in Eq.(3), pag.2 of the manual)
+      int nmap( (strategy == 1 || strategy == 4) ? 1 : 2 );
+      double f[2] = { 1.0, 0.0 };
+
+      if( itm[1] == inxMaps.end() )
+      {
+            // last map of the store
+         nmap = 1;
+      }
+      else
+      {
+         f[0] = (itm[1]->first - t) / (itm[1]->first - itm[0]->first);
+         f[1] = (t - itm[0]->first) / (itm[1]->first - itm[0]->first);
+
+            // if only one map, then we have to use the neareast
+         if( nmap == 1 )
+         {
+            if( f[1] > f[0] ) itm[0] = itm[1];
+            f[0] = 1.0;
+         }
+
+            // a map of zero weight is left out, so that its undefined
+            // nodes do not turn the result into NaN
+         else if( f[1] == 0.0 )
+         {
+            nmap = 1;
+         }
+         else if( f[0] == 0.0 )
+         {
+            itm[0] = itm[1];
+            f[0] = 1.0;
+            nmap = 1;
+         }
+      }
+
+         // seconds of time to degree (360.0 / 86400.0)
+      const double sec2deg( 4.16666666666667e-3 );
+
+      grid.epoch = t;
+      grid.strategy = strategy;
+      grid.haveRMS = false;
+      grid.nlayer = 0;
+
+      for(int imap = 0; imap < nmap; imap++)
+      {
+
+         IonexValTypeMap::const_iterator itTEC(
+                                    itm[imap]->second.find(IonexData::TEC) );
+         IonexValTypeMap::const_iterator itRMS(
+                                    itm[imap]->second.find(IonexData::RMS) );
+
+         if( itTEC == itm[imap]->second.end() )
+         {
+            InvalidRequest e("IonexStore::prepareGrid() ... No TEC map!");
+            GPSTK_THROW(e);
+         }
+
+         const IonexData& iod( itTEC->second );
+
+         if( imap == 0 )
+         {
+            grid.nlat = iod.dim[0];
+            grid.nlon = iod.dim[1];
+            grid.lat0 = iod.lat[0];
+            grid.dlat = iod.lat[2];
+            grid.lon0 = iod.lon[0];
+            grid.dlon = iod.lon[2];
+            grid.ncyc = static_cast<int>( (360.0/std::abs(iod.lon[2])) + 0.5 );
+         }
+         else if( iod.dim[0] != grid.nlat || iod.dim[1] != grid.nlon ||
+                  iod.lat[0] != grid.lat0 || iod.lat[2] != grid.dlat ||
+                  iod.lon[0] != grid.lon0 || iod.lon[2] != grid.dlon )
+         {
+            InvalidRequest e("IonexStore::prepareGrid() ... Maps with "
+                             "different grids!");
+            GPSTK_THROW(e);
+         }
+
+         if( grid.nlat < 2 || grid.nlon < 2 )
+         {
+            InvalidRequest e("IonexStore::prepareGrid() ... Invalid grid!");
+            GPSTK_THROW(e);
+         }
+
+            // height layer of 3D maps
+         int ihgt(0);
+         if( iod.hgt[2] != 0.0 )
+         {
+            ihgt = static_cast<int>(
+                           (height/1000.0 - iod.hgt[0]) / iod.hgt[2] + 1.0 ) - 1;
+
+            if( ihgt < 0 || ihgt >= iod.dim[2] )
+            {
+               InvalidRequest e( "Irregular height. Height: "
+                                 + asString( height/1000.0 ) + " km.");
+               GPSTK_THROW(e);
+            }
+         }
+
+            // rotation of the map, if any
+         double shift( (strategy == 1 || strategy == 2) ?
+                                 0.0 : (t - itm[imap]->first) * sec2deg );
+
+            // maps with the same rotation are added into the same grid
+         int layer( grid.nlayer );
+         bool add( layer > 0 && grid.shift[layer-1] == shift );
+         if( add )
+         {
+            --layer;
+         }
+         else
+         {
+            grid.shift[layer] = shift;
+            ++grid.nlayer;
+         }
+
+         size_t size( grid.nlat*grid.nlon );
+         size_t offset( ihgt*size );
+
+         const double undefined( std::numeric_limits<double>::quiet_NaN() );
+
+         for(int k = 0; k < 2; k++)
+         {
+            std::vector<double>& g( (k == 0) ? grid.tec[layer]
+                                             : grid.rms[layer] );
+
+            if(!add) g.assign(size, 0.0);
+
+            const IonexData* pData( &iod );
+            if( k == 1 )
+            {
+               if( itRMS == itm[imap]->second.end() ) continue;
+               pData = &itRMS->second;
+               grid.haveRMS = true;
+            }
+
+            for(size_t i = 0; i < size; i++)
+            {
+               double val( pData->data[offset+i] );
+               g[i] += (val != 999.9) ? f[imap]*val : undefined;
+            }
+         }
+
+      }  // End of 'for(int imap = 0; imap < nmap; imap++)...'
+
+   }  // End of method 'IonexStore::prepareGrid()'
+
+
+
+      // Interpolate the TEC and RMS maps at a set of points.
+   void IonexGrid::interpolate( size_t n,
+                                const double* lat,
+                                const double* lon,
+                                double* tec,
+                                double* rms ) const
+   {
+
+      interpolate(this->tec, n, lat, lon, tec);
+
+      if( rms != NULL )
+      {
+         if( haveRMS )
+         {
+            interpolate(this->rms, n, lat, lon, rms);
+         }
+         else
+         {
+            for(size_t k = 0; k < n; k++) rms[k] = 0.0;
+         }
+      }
+
+   }  // End of method 'IonexGrid::interpolate()'
+
+
+
+      // Interpolate one set of maps
+   void IonexGrid::interpolate( const std::vector<double>* maps,
+                                size_t n,
+                                const double* lat,
+                                const double* lon,
+                                double* val ) const
+   {
+
+      const double undefined( std::numeric_limits<double>::quiet_NaN() );
+
+      for(size_t k = 0; k < n; k++) val[k] = (nlayer > 0) ? 0.0 : undefined;
+
+      for(int layer = 0; layer < nlayer; layer++)
+      {
+
+         const double* g( &maps[layer][0] );
+
+         for(size_t k = 0; k < n; k++)
+         {
+
+               // latitude: row and factor Q
+            double x( (lat[k] - lat0) / dlat );
+            if( !(x >= 0.0 && x <= nlat-1.0) )
+            {
+               val[k] = undefined;
+               continue;
+            }
+
+            int i( static_cast<int>(x) );
+            if( i > nlat-2 ) i = nlat-2;
+            double q( x - i );
+
+               // longitude: column and factor P, within [-180 180]
+            double lambda( lon[k] + shift[layer] );
+            if( lambda > 180.0 ) lambda -= 360.0;
+
+            double y( (lambda - lon0) / dlon );
+            if( !(y > -nlon && y < 2.0*nlon) )
+            {
+               val[k] = undefined;
+               continue;
+            }
+
+            int j( static_cast<int>( std::floor(y) ) );
+            double p( y - j );
+
+            if( j < 0 ) j += ncyc;
+            else if( j > nlon-1 ) j -= ncyc;
+
+            int j1( j + 1 );
+            if( j1 > nlon-1 ) j1 -= ncyc;
+
+            if( j < 0 || j > nlon-1 || j1 < 0 || j1 > nlon-1 )
+            {
+               val[k] = undefined;
+               continue;
+            }
+
+               // bivariate interpolation (pag.3, IONEX manual)
+            const double* row( g + i*nlon );
+            val[k] += (1.0-p) * (1.0-q) * row[j] +
+                           p  * (1.0-q) * row[j1] +
+                      (1.0-p) *      q  * row[nlon+j] +
+                           p  *      q  * row[nlon+j1];
+
+         }  // End of 'for(size_t k = 0; k < n; k++)...'
+
+      }  // End of 'for(int layer = 0; layer < nlayer; layer++)...'
+
+   }  // End of method 'IonexGrid::interpolate()'
+
+
+
       /** Get slant total electron content (STEC) in TECU
        *
        * @param elevation     Time tag of signal (CommonTime object)
@@ -526,6 +839,35 @@ namespace gpstk
 
 
 
+      /* Get ionospheric slant delays for a given frequency, for a set
+       * of points.
+       *
+       * @param n             Number of points.
+       * @param elevation     Elevations of the satellites (degrees).
+       * @param tecval        TEC values (TECU).
+       * @param imap          Values of the ionosphere mapping function.
+       * @param freq          Frequency value, in Hz
+       * @param delay         Ionosphere slant delays (meters)
+       */
+   void IonexStore::getIono( size_t n,
+                             const double* elevation,
+                             const double* tecval,
+                             const double* imap,
+                             const double& freq,
+                             double* delay ) const
+   {
+
+      const double factor( C2_FACT / (freq * freq) );
+
+      for(size_t k = 0; k < n; k++)
+      {
+         delay[k] = (elevation[k] < 0.0) ? 0.0 : factor*tecval[k]*imap[k];
+      }
+
+   }  // End of method 'IonexStore::getIono()'
+
+
+
       /** Ionosphere mapping function
        *
        * @param elevation     Elevation of satellite as seen at receiver
@@ -599,6 +941,59 @@ namespace gpstk
 
 
 
+      /* Ionosphere mapping function, for a set of elevations.
+       *
+       * @param n             Number of elevations.
+       * @param elevation     Elevations of the satellites (degrees).
+       * @param ionoMapType   Type of ionosphere mapping function (string)
+       *                      @sa IonexStore::iono_mapping_function
+       * @param imap          Values of the mapping function.
+       */
+   void IonexStore::iono_mapping_function( size_t n,
+                                           const double* elevation,
+                                           const std::string& ionoMapType,
+                                           double* imap ) const
+   {
+
+         // Earth's radius in KM
+      const double Re = 6371.0;
+
+      if( ionoMapType == "SLM" )
+      {
+
+         const double ratio( Re / (Re + 450.0) );
+
+         for(size_t k = 0; k < n; k++)
+         {
+            double sinzipp( ratio * std::sin((90.0-elevation[k])*DEG_TO_RAD) );
+            imap[k] = 1.0/std::sqrt(1.0 - sinzipp*sinzipp);
+         }
+
+      }
+      else if( ionoMapType == "MSLM" )
+      {
+
+         const double ratio( Re / (Re + 506.7) );
+         const double alfa( 0.9782 );
+
+         for(size_t k = 0; k < n; k++)
+         {
+            double z0( 90.0 - elevation[k] );
+            double sinzipp( ratio * std::sin(alfa * z0 * DEG_TO_RAD) );
+            imap[k] = (z0 <= 80.0) ? 1.0/std::sqrt(1.0 - sinzipp*sinzipp)
+                                   : 1.0;
+         }
+
+      }
+      else
+      {
+         for(size_t k = 0; k < n; k++) imap[k] = 1.0;
+      }
+
+   }  // End of method 'IonexStore::iono_mapping_function()'
+
+
+
       /** Find a DCB value
        *
        * @param sat     SatID of satellite of interest
@@ -34,6 +34,7 @@
 
 
 #include <map>
+#include <vector>
 
 #include "FileStore.hpp"
 #include "IonexData.hpp"
@@ -47,6 +48,100 @@ namespace gpstk
       /** @addtogroup IonosphereMaps */
       //@{
 
+      /** This class holds the TEC and RMS maps of an epoch, taken from an
+       *  IonexStore object with IonexStore::prepareGrid(), to interpolate
+       *  them at many points at once.
+       *
+       * The maps bracketing the epoch are weighted and, when they share the
+       * same rotation, added into a single grid, so the interpolation at
+       * every point takes the same four grid values as
+       * IonexStore::getIonexValue() would take from every map. With the
+       * strategy of two consecutive rotated maps, the rotation of each map
+       * is kept as a longitude shift, and two grids are interpolated.
+       *
+       * Undefined grid values are kept as NaN, and so are the values
+       * interpolated from them, or at points off the grid.
+       */
+   class IonexGrid
+   {
+   public:
+
+         /// Default constructor, with no maps.
+      IonexGrid()
+         : strategy(0), nlat(0), nlon(0), ncyc(0), nlayer(0), haveRMS(false)
+      {};
+
+
+         /// Epoch of the maps
+      CommonTime getEpoch() const
+      { return epoch; };
+
+
+         /// Interpolation strategy of the maps
+      int getStrategy() const
+      { return strategy; };
+
+
+         /// Whether the grid holds maps
+      bool isValid() const
+      { return (nlayer > 0); };
+
+
+         /// Whether the grid holds RMS maps
+      bool hasRMS() const
+      { return haveRMS; };
+
+
+         /** Interpolate the TEC and RMS maps at a set of points.
+          *
+          * @param n       Number of points.
+          * @param lat     Geocentric latitudes of the points (degrees).
+          * @param lon     Longitudes of the points (degrees East).
+          * @param tec     TEC values at the points (TECU).
+          * @param rms     RMS values at the points (TECU), or NULL if not
+          *                needed.
+          */
+      void interpolate( size_t n,
+                        const double* lat,
+                        const double* lon,
+                        double* tec,
+                        double* rms = NULL ) const;
+
+
+   private:
+
+      friend class IonexStore;
+
+
+         /// Interpolate one set of maps
+      void interpolate( const std::vector<double>* maps,
+                        size_t n,
+                        const double* lat,
+                        const double* lon,
+                        double* val ) const;
+
+
+         /// Epoch and interpolation strategy of the maps
+      CommonTime epoch;
+      int strategy;
+
+         /// Grid in latitude and longitude
+      int nlat, nlon, ncyc;
+      double lat0, dlat, lon0, dlon;
+
+         /// Number of grids, and longitude shift of each one (degrees)
+      int nlayer;
+      double shift[2];
+
+         /// Weighted TEC and RMS grids
+      std::vector<double> tec[2];
+      std::vector<double> rms[2];
+      bool haveRMS;
+
+   }; // End of class 'IonexGrid'
+
+
+
       /** This class reads and stores Ionosphere maps.
        *
        * It computes TEC and RMS values with respect to time and receiver
@@ -136,6 +231,24 @@ namespace gpstk
 
 
 
+         /** Prepare the TEC and RMS maps of an epoch to be interpolated at
+          *  many points, with the same strategies as getIonexValue().
+          *
+          * @param t          Time tag of signal (CommonTime object)
+          * @param grid       Object to hold the maps of the epoch.
+          * @param strategy   Interpolation strategy
+          *                   @sa IonexStore::getIonexValue
+          * @param height     Height of the ionosphere (meters), used
+          *                   only with 3D maps.
+          */
+      void prepareGrid( const CommonTime& t,
+                        IonexGrid& grid,
+                        int strategy = 3,
+                        double height = 450000.0 ) const
+         throw(InvalidRequest);
+
+
+
       /** Get slant total electron content (STEC) in TECU
        *
        * @param elevation     Time tag of signal (CommonTime object)
@@ -268,6 +381,24 @@ namespace gpstk
       { return getIono(elevation, tecval, L8_FREQ_GAL, ionoMapType); };
 
 
+         /** Get ionospheric slant delays for a given frequency, for a set
+          *  of points.
+          *
+          * @param n             Number of points.
+          * @param elevation     Elevations of the satellites (degrees).
+          * @param tecval        TEC values (TECU).
+          * @param imap          Values of the ionosphere mapping function.
+          * @param freq          Frequency value, in Hz
+          * @param delay         Ionosphere slant delays (meters)
+          */
+      void getIono( size_t n,
+                    const double* elevation,
+                    const double* tecval,
+                    const double* imap,
+                    const double& freq,
+                    double* delay ) const;
+
+
          /** Ionosphere mapping function
           *
           * @param elevation     Elevation of satellite as seen at receiver
@@ -286,6 +417,20 @@ namespace gpstk
                                     const std::string& ionoMapType ) const;
 
 
+         /** Ionosphere mapping function, for a set of elevations.
+          *
+          * @param n             Number of elevations.
+          * @param elevation     Elevations of the satellites (degrees).
+          * @param ionoMapType   Type of ionosphere mapping function (string)
+          *                      @sa IonexStore::iono_mapping_function
+          * @param imap          Values of the mapping function.
+          */
+      void iono_mapping_function( size_t n,
+                                  const double* elevation,
+                                  const std::string& ionoMapType,
+                                  double* imap ) const;
+
+
          /** Determine the earliest time for which this object can
           *  successfully determine the TEC values, and implicitly, the
           *  ionospheric delay for any object.
@@ -87,6 +87,7 @@ namespace gpstk
    {
       headerRead = false;
       header = Rinex3ObsHeader();
+      headerCount = 0;
       timesystem = TimeSystem::GPS;
    }
 
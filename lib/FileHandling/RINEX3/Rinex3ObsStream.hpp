@@ -107,6 +107,9 @@ namespace gpstk
          /// The header for this file.
       Rinex3ObsHeader header;
 
+         /// Number of headers read, telling when the header changes
+      unsigned long headerCount;
+
          /// Time system for epochs in this file
       TimeSystem timesystem;
 
@@ -0,0 +1,852 @@
+//============================================================================
+//
+//  This file is part of GPSTk, the GPS Toolkit.
+//
+//  The GPSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 3.0 of the License, or
+//  any later version.
+//
+//  The GPSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GPSTk; if not, write to the Free Software Foundation,
+//  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+//
+//============================================================================
+
+/**
+ * @file SinexNEQ.cpp
+ * Read, write and stack SINEX normal equations as packed matrices.
+ */
+
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include "StringUtils.hpp"
+#include "SinexNEQ.hpp"
+
+using namespace gpstk::StringUtils;
+using namespace std;
+
+namespace gpstk
+{
+namespace Sinex
+{
+
+   namespace
+   {
+         /// Matrix kinds of the SOLUTION/MATRIX_* blocks
+      enum MatrixKind { COVA, CORR, INFO };
+
+         /// Seconds in a year, for the station velocities
+      const double  SEC_PER_YEAR = 365.25 * 86400.0;
+
+
+         /// Read a value of a matrix line; blank or missing fields are 0
+      double matrixValue(const std::string& line, size_t pos, size_t len)
+      {
+         if (line.size() <= pos)
+         {
+            return 0.0;
+         }
+         std::string  field(line.substr(pos, len) );
+         for (size_t i = 0; i < field.size(); ++i)
+         {
+            if ( (field[i] == 'D') || (field[i] == 'd') )
+            {
+               field[i] = 'E';
+            }
+         }
+         return std::strtod(field.c_str(), NULL);
+      }
+
+
+         /// Whether a SINEX time is the special 00:000:00000
+      bool isZero(const Time& t)
+      {
+         return (t.year == 0) && (t.doy == 0) && (t.sod == 0);
+      }
+
+
+         /**
+          * Invert, in place, the rows and columns of a packed symmetric
+          * matrix whose diagonal is not zero, by Cholesky factorization.
+          */
+      void invertPacked(std::vector<double>& A, size_t n)
+      {
+         std::vector<size_t>  act;
+         for (size_t i = 0; i < n; ++i)
+         {
+            if (A[i*(i+1)/2 + i] != 0.0)
+            {
+               act.push_back(i);
+            }
+         }
+
+         const size_t  m = act.size();
+         std::vector<double>  L(m*(m+1)/2);
+         for (size_t i = 0; i < m; ++i)
+         {
+            for (size_t j = 0; j <= i; ++j)
+            {
+               L[i*(i+1)/2 + j] = A[act[i]*(act[i]+1)/2 + act[j] ];
+            }
+         }
+
+            // L*L'
+         for (size_t i = 0; i < m; ++i)
+         {
+            double  *Li = &L[i*(i+1)/2];
+            for (size_t j = 0; j <= i; ++j)
+            {
+               const double  *Lj = &L[j*(j+1)/2];
+               double  s = Li[j];
+               for (size_t k = 0; k < j; ++k)
+               {
+                  s -= Li[k]*Lj[k];
+               }
+               if (j < i)
+               {
+                  Li[j] = s/Lj[j];
+               }
+               else if (s > 0.0)
+               {
+                  Li[i] = std::sqrt(s);
+               }
+               else
+               {
+                  Exception  err("SINEX matrix is not positive definite.");
+                  GPSTK_THROW(err);
+               }
+            }
+         }
+
+            // W = inverse(L), row by row
+         std::vector<double>  row(m);
+         for (size_t i = 0; i < m; ++i)
+         {
+            double  *Li = &L[i*(i+1)/2];
+            std::copy(Li, Li+i+1, row.begin() );
+            Li[i] = 1.0/row[i];
+            for (size_t j = 0; j < i; ++j)
+            {
+               double  s = 0.0;
+               for (size_t k = j; k < i; ++k)
+               {
+                  s += row[k]*L[k*(k+1)/2 + j];
+               }
+               Li[j] = -s/row[i];
+            }
+         }
+
+            // inverse(A) = W'*W
+         for (size_t i = 0; i < m; ++i)
+         {
+            for (size_t j = 0; j <= i; ++j)
+            {
+               double  s = 0.0;
+               for (size_t k = i; k < m; ++k)
+               {
+                  const double  *Wk = &L[k*(k+1)/2];
+                  s += Wk[i]*Wk[j];
+               }
+               A[act[i]*(act[i]+1)/2 + act[j] ] = s;
+            }
+         }
+      }
+
+
+         /// Turn a SOLUTION/MATRIX_* block into an information matrix
+      void toInformation(std::vector<double>& A, size_t n, MatrixKind kind)
+      {
+         if (kind == INFO)
+         {
+            return;
+         }
+         if (kind == CORR)
+         {
+               // The diagonal holds the standard deviations
+            std::vector<double>  sd(n);
+            for (size_t i = 0; i < n; ++i)
+            {
+               sd[i] = A[i*(i+1)/2 + i];
+            }
+            for (size_t i = 0; i < n; ++i)
+            {
+               for (size_t j = 0; j < i; ++j)
+               {
+                  A[i*(i+1)/2 + j] *= sd[i]*sd[j];
+               }
+               A[i*(i+1)/2 + i] = sd[i]*sd[i];
+            }
+         }
+         invertPacked(A, n);
+      }
+
+   }  // anonymous namespace
+
+
+   std::string NEQParameter::key() const
+   {
+      std::string  k(strip(paramType) );
+      k += '|' + strip(siteCode);
+      k += '|' + strip(pointCode);
+      k += '|' + strip(solutionId);
+      k += '|' + (std::string)epoch;
+      return k;
+
+   }  // NEQParameter::key()
+
+
+   void NormalEquation::resize(size_t n)
+   {
+      params.resize(n);
+      rhs.resize(n, 0.0);
+      matrix.resize(n*(n+1)/2, 0.0);
+
+   }  // NormalEquation::resize()
+
+
+   void NormalEquation::clear()
+   {
+      params.clear();
+      rhs.clear();
+      matrix.clear();
+      lPl = 0.0;
+      numObs = 0.0;
+
+   }  // NormalEquation::clear()
+
+
+   void NormalEquation::read(std::istream& s)
+      throw(Exception)
+   {
+      clear();
+
+         // Block being read: its matrix, if any, and how it is stored
+      std::string  block;
+      std::vector<double>  *target = NULL;
+      bool  upper = false;
+
+         // Estimate and its covariance, and a priori constraints
+      std::vector<double>  estimate, estMatrix, aprMatrix;
+      MatrixKind  estKind = COVA;
+      MatrixKind  aprKind = COVA;
+      bool  haveNEQ = false;
+      bool  haveEst = false;
+      bool  haveApr = false;
+
+      double  varFactor = 1.0;
+      double  sumOC = -1.0;
+      double  vtpv = -1.0;
+
+      std::string  line;
+      try
+      {
+         while (std::getline(s, line) )
+         {
+            if ( (line.size() > 0) && (line[line.size()-1] == '\r') )
+            {
+               line.erase(line.size()-1);
+            }
+            if (line.size() < 1)
+            {
+               continue;
+            }
+
+            switch (line[0])
+            {
+               case BLOCK_START:
+               {
+                  block = stripTrailing(line.substr(1) );
+                  target = NULL;
+                  upper = (block.find(" U") != std::string::npos);
+
+                  MatrixKind  kind = COVA;
+                  if (block.find("CORR") != std::string::npos)
+                  {
+                     kind = CORR;
+                  }
+                  else if (block.find("INFO") != std::string::npos)
+                  {
+                     kind = INFO;
+                  }
+
+                  if (block.find("SOLUTION/NORMAL_EQUATION_MATRIX") == 0)
+                  {
+                     target = &matrix;
+                     haveNEQ = true;
+                  }
+                  else if (block.find("SOLUTION/MATRIX_ESTIMATE") == 0)
+                  {
+                     target = &estMatrix;
+                     estKind = kind;
+                     haveEst = true;
+                  }
+                  else if (block.find("SOLUTION/MATRIX_APRIORI") == 0)
+                  {
+                     target = &aprMatrix;
+                     aprKind = kind;
+                     haveApr = true;
+                  }
+                  break;
+               }
+               case BLOCK_END:
+               {
+                  block.clear();
+                  target = NULL;
+                  break;
+               }
+               case DATA_START:
+               {
+                  if (target != NULL)
+                  {
+                        // Matrix lines are parsed in place, as there are
+                        // n*(n+1)/6 of them
+                     size_t  r = std::strtoul(line.substr(1, 5).c_str(),
+                                              NULL, 10);
+                     size_t  c = std::strtoul(line.substr(7, 5).c_str(),
+                                              NULL, 10);
+                     if ( (r < 1) || (c < 1) )
+                     {
+                        Exception  err("Invalid matrix line: " + line);
+                        GPSTK_THROW(err);
+                     }
+                     for (size_t k = 0; k < 3; ++k)
+                     {
+                        double  value = matrixValue(line, 13 + 22*k, 21);
+                        size_t  i = r - 1;
+                        size_t  j = c - 1 + k;
+                        if (upper)
+                        {
+                           std::swap(i, j);
+                        }
+                        if (j > i)
+                        {
+                           continue;
+                        }
+                        if (target == &matrix)
+                        {
+                           if (i >= size() )
+                           {
+                              resize(i+1);
+                           }
+                        }
+                        else if (i*(i+1)/2 + j >= target->size() )
+                        {
+                           target->resize( (i+1)*(i+2)/2, 0.0);
+                        }
+                        (*target)[i*(i+1)/2 + j] = value;
+                     }
+                  }
+                  else if (block == SolutionStatistics::BLOCK_TITLE)
+                  {
+                     std::string  type(strip(line.substr(1, 30) ) );
+                     double  value = matrixValue(line, 32, 22);
+                     if (type == "NUMBER OF OBSERVATIONS")
+                     {
+                        numObs = value;
+                     }
+                     else if (type == "WEIGHTED SQUARE SUM OF O-C")
+                     {
+                        sumOC = value;
+                     }
+                     else if (type == "SQUARE SUM OF RESIDUALS (VTPV)")
+                     {
+                        vtpv = value;
+                     }
+                     else if (type == "VARIANCE FACTOR")
+                     {
+                        varFactor = value;
+                     }
+                  }
+                  else if (block == SolutionApriori::BLOCK_TITLE)
+                  {
+                     SolutionApriori  apr(line);
+                     size_t  i = apr.paramIndex - 1;
+                     if (i >= size() )
+                     {
+                        resize(i+1);
+                     }
+                     NEQParameter&  par = params[i];
+                     par.paramType      = apr.paramType;
+                     par.siteCode       = apr.siteCode;
+                     par.pointCode      = apr.pointCode;
+                     par.solutionId     = apr.solutionId;
+                     par.epoch          = apr.epoch;
+                     par.paramUnits     = apr.paramUnits;
+                     par.constraintCode = apr.constraintCode;
+                     par.apriori        = apr.paramApriori;
+                  }
+                  else if (block == SolutionNormalEquationVector::BLOCK_TITLE)
+                  {
+                     SolutionNormalEquationVector  vec(line);
+                     size_t  i = vec.paramIndex - 1;
+                     if (i >= size() )
+                     {
+                        resize(i+1);
+                     }
+                     NEQParameter&  par = params[i];
+                     par.paramType      = vec.paramType;
+                     par.siteCode       = vec.siteCode;
+                     par.pointCode      = vec.pointCode;
+                     par.solutionId     = vec.solutionId;
+                     par.epoch          = vec.epoch;
+                     par.paramUnits     = vec.paramUnits;
+                     par.constraintCode = vec.constraintCode;
+                     rhs[i]             = vec.value;
+                  }
+                  else if (block == SolutionEstimate::BLOCK_TITLE)
+                  {
+                     SolutionEstimate  est(line);
+                     size_t  i = est.paramIndex - 1;
+                     if (i >= size() )
+                     {
+                        resize(i+1);
+                     }
+                     if (i >= estimate.size() )
+                     {
+                        estimate.resize(i+1, 0.0);
+                     }
+                     estimate[i] = est.paramEstimate;
+
+                        // The a priori block, if any, has the same fields
+                     NEQParameter&  par = params[i];
+                     if (par.paramType.empty() )
+                     {
+                        par.paramType      = est.paramType;
+                        par.siteCode       = est.siteCode;
+                        par.pointCode      = est.pointCode;
+                        par.solutionId     = est.solutionId;
+                        par.epoch          = est.epoch;
+                        par.paramUnits     = est.paramUnits;
+                        par.constraintCode = est.constraintCode;
+                     }
+                  }
+                  break;
+               }
+               default:
+               {
+                     // Header, trailer and comments
+                  break;
+               }
+
+            }  // switch
+         }
+      }
+      catch (Exception& exc)
+      {
+         GPSTK_RETHROW(exc);
+      }
+
+      const size_t  n = size();
+
+      if (haveNEQ)
+      {
+         lPl = (sumOC >= 0.0) ? sumOC : 0.0;
+         return;
+      }
+
+      if (!haveEst)
+      {
+         Exception  err("No normal equation or covariance in SINEX stream.");
+         GPSTK_THROW(err);
+      }
+
+         // N + constraints = inverse of the covariance of the estimate,
+         // and (N + constraints)*dx = b
+      estMatrix.resize(n*(n+1)/2, 0.0);
+      estimate.resize(n, 0.0);
+      toInformation(estMatrix, n, estKind);
+
+      std::vector<double>  dx(n);
+      for (size_t i = 0; i < n; ++i)
+      {
+         dx[i] = estimate[i] - params[i].apriori;
+      }
+
+      for (size_t i = 0; i < n; ++i)
+      {
+         for (size_t j = 0; j <= i; ++j)
+         {
+            double  v = estMatrix[i*(i+1)/2 + j] * varFactor;
+            matrix[i*(i+1)/2 + j] = v;
+            rhs[i] += v*dx[j];
+            if (j < i)
+            {
+               rhs[j] += v*dx[i];
+            }
+         }
+      }
+
+         // Remove the constraints
+      if (haveApr)
+      {
+         aprMatrix.resize(n*(n+1)/2, 0.0);
+         toInformation(aprMatrix, n, aprKind);
+         for (size_t k = 0; k < matrix.size(); ++k)
+         {
+            matrix[k] -= aprMatrix[k];
+         }
+      }
+
+      if (sumOC >= 0.0)
+      {
+         lPl = sumOC;
+      }
+      else if (vtpv >= 0.0)
+      {
+         lPl = vtpv;
+         for (size_t i = 0; i < n; ++i)
+         {
+            lPl += rhs[i]*dx[i];
+         }
+      }
+
+   }  // NormalEquation::read()
+
+
+   void NormalEquation::read(const std::string& filename)
+      throw(Exception)
+   {
+      std::ifstream  s(filename.c_str() );
+      if (!s)
+      {
+         FileMissingException  err("Cannot open file: " + filename);
+         GPSTK_THROW(err);
+      }
+      try
+      {
+         read(s);
+      }
+      catch (Exception& exc)
+      {
+         GPSTK_RETHROW(exc);
+      }
+
+   }  // NormalEquation::read()
+
+
+   void NormalEquation::write(std::ostream& s, const Header& header) const
+      throw(Exception)
+   {
+      try
+      {
+         const size_t  n = size();
+
+         Header  h(header);
+         h.paramCount = n;
+         s << (std::string)h << endl;
+
+         s << BLOCK_START << SolutionStatistics::BLOCK_TITLE << endl;
+         s << DATA_START << formatStr("NUMBER OF OBSERVATIONS", 30)
+           << ' ' << formatFor(numObs, 22, 2) << endl;
+         s << DATA_START << formatStr("NUMBER OF UNKNOWNS", 30)
+           << ' ' << formatFor(double(n), 22, 2) << endl;
+         s << DATA_START << formatStr("WEIGHTED SQUARE SUM OF O-C", 30)
+           << ' ' << formatFor(lPl, 22, 2) << endl;
+         s << BLOCK_END << SolutionStatistics::BLOCK_TITLE << endl;
+
+         s << BLOCK_START << SolutionApriori::BLOCK_TITLE << endl;
+         for (size_t i = 0; i < n; ++i)
+         {
+            const NEQParameter&  par = params[i];
+            SolutionApriori  apr;
+            apr.paramIndex     = i + 1;
+            apr.paramType      = par.paramType;
+            apr.siteCode       = par.siteCode;
+            apr.pointCode      = par.pointCode;
+            apr.solutionId     = par.solutionId;
+            apr.epoch          = par.epoch;
+            apr.paramUnits     = par.paramUnits;
+            apr.constraintCode = par.constraintCode;
+            apr.paramApriori   = par.apriori;
+            apr.paramStdDev    = 0.0;
+            s << (std::string)apr << endl;
+         }
+         s << BLOCK_END << SolutionApriori::BLOCK_TITLE << endl;
+
+         s << BLOCK_START << SolutionNormalEquationVector::BLOCK_TITLE << endl;
+         for (size_t i = 0; i < n; ++i)
+         {
+            const NEQParameter&  par = params[i];
+            SolutionNormalEquationVector  vec;
+            vec.paramIndex     = i + 1;
+            vec.paramType      = par.paramType;
+            vec.siteCode       = par.siteCode;
+            vec.pointCode      = par.pointCode;
+            vec.solutionId     = par.solutionId;
+            vec.epoch          = par.epoch;
+            vec.paramUnits     = par.paramUnits;
+            vec.constraintCode = par.constraintCode;
+            vec.value          = rhs[i];
+            s << (std::string)vec << endl;
+         }
+         s << BLOCK_END << SolutionNormalEquationVector::BLOCK_TITLE << endl;
+
+            // Lines which are all zeros are left out
+         s << BLOCK_START << SolutionNormalEquationMatrixL::BLOCK_TITLE << endl;
+         for (size_t i = 0; i < n; ++i)
+         {
+            const double  *Ni = &matrix[i*(i+1)/2];
+            for (size_t j = 0; j <= i; j += 3)
+            {
+               SolutionNormalEquationMatrixL  mat;
+               mat.row  = i + 1;
+               mat.col  = j + 1;
+               mat.val1 = Ni[j];
+               mat.val2 = (j+1 <= i) ? Ni[j+1] : 0.0;
+               mat.val3 = (j+2 <= i) ? Ni[j+2] : 0.0;
+               if ( (mat.val1 != 0.0) || (mat.val2 != 0.0) ||
+                    (mat.val3 != 0.0) )
+               {
+                  s << (std::string)mat << endl;
+               }
+            }
+         }
+         s << BLOCK_END << SolutionNormalEquationMatrixL::BLOCK_TITLE << endl;
+
+         s << FILE_END << endl;
+      }
+      catch (Exception& exc)
+      {
+         GPSTK_RETHROW(exc);
+      }
+
+   }  // NormalEquation::write()
+
+
+   void NormalEquation::write(const std::string& filename,
+                              const Header& header) const
+      throw(Exception)
+   {
+      std::ofstream  s(filename.c_str() );
+      if (!s)
+      {
+         FileMissingException  err("Cannot open file: " + filename);
+         GPSTK_THROW(err);
+      }
+      try
+      {
+         write(s, header);
+      }
+      catch (Exception& exc)
+      {
+         GPSTK_RETHROW(exc);
+      }
+
+   }  // NormalEquation::write()
+
+
+   NEQStack& NEQStack::setReferenceEpoch(const CommonTime& epoch)
+   {
+      refTime = epoch;
+      refEpoch = (CommonTime)refTime;
+      useRefEpoch = true;
+      return (*this);
+
+   }  // NEQStack::setReferenceEpoch()
+
+
+   size_t NEQStack::getParameter(const NEQParameter& param)
+   {
+      std::string  k(param.key() );
+      std::map<std::string, size_t>::const_iterator  it = index.find(k);
+      if (it != index.end() )
+      {
+         return it->second;
+      }
+
+      size_t  n = stack.size();
+      stack.resize(n+1);
+      stack.params[n] = param;
+      index[k] = n;
+      return n;
+
+   }  // NEQStack::getParameter()
+
+
+   NEQStack& NEQStack::add(const NormalEquation& neq)
+      throw(Exception)
+   {
+      const size_t  m = neq.size();
+
+         // A priori velocities of the normal equation
+      std::map<std::string, double>  velApriori;
+      for (size_t i = 0; i < m; ++i)
+      {
+         const NEQParameter&  par = neq.params[i];
+         if (par.paramType.compare(0, 3, "VEL") == 0)
+         {
+            NEQParameter  vel(par);
+            vel.epoch = Time();
+            velApriori[vel.key()] = par.apriori;
+         }
+      }
+
+         // Every parameter of the normal equation is a combination of
+         // parameters of the stack, plus the difference of a priori values
+      std::vector< std::vector< std::pair<size_t, double> > >  terms(m);
+      std::vector<double>  delta(m, 0.0);
+
+      for (size_t i = 0; i < m; ++i)
+      {
+         const NEQParameter&  par = neq.params[i];
+         std::string  type(strip(par.paramType) );
+
+         bool  isPos = useRefEpoch &&
+                       ( (type == "STAX") || (type == "STAY") ||
+                         (type == "STAZ") );
+         bool  isVel = useRefEpoch &&
+                       ( (type == "VELX") || (type == "VELY") ||
+                         (type == "VELZ") );
+
+         if (isPos)
+         {
+            double  dt = isZero(par.epoch) ? 0.0 :
+                         ( (CommonTime)par.epoch - refEpoch ) / SEC_PER_YEAR;
+
+            NEQParameter  vel(par);
+            vel.paramType.replace(0, 3, "VEL");
+            vel.paramUnits = "m/y";
+            vel.epoch = Time();
+
+            double  vapr = 0.0;
+            std::map<std::string, double>::const_iterator  itv =
+               velApriori.find(vel.key() );
+            if (itv != velApriori.end() )
+            {
+               vapr = itv->second;
+            }
+
+            NEQParameter  pos(par);
+            pos.epoch = refTime;
+            pos.apriori = par.apriori - dt*vapr;
+            size_t  k = getParameter(pos);
+            terms[i].push_back(std::make_pair(k, 1.0) );
+
+            if (estimateVelocities)
+            {
+               vel.epoch = refTime;
+               vel.apriori = vapr;
+               size_t  v = getParameter(vel);
+               terms[i].push_back(std::make_pair(v, dt) );
+               vapr = stack.params[v].apriori;
+            }
+
+            delta[i] = stack.params[k].apriori + dt*vapr - par.apriori;
+         }
+         else
+         {
+            NEQParameter  p(par);
+            if (isVel)
+            {
+               p.epoch = refTime;
+            }
+            size_t  k = getParameter(p);
+            terms[i].push_back(std::make_pair(k, 1.0) );
+            delta[i] = stack.params[k].apriori - par.apriori;
+         }
+      }
+
+         // Shift to the a priori values of the stack:
+         // b - N*delta, l'Pl - 2*b'*delta + delta'*N*delta
+      std::vector<double>  b(neq.rhs);
+      double  lPl = neq.lPl;
+
+      bool  shifted = false;
+      for (size_t i = 0; i < m; ++i)
+      {
+         if (delta[i] != 0.0)
+         {
+            shifted = true;
+            break;
+         }
+      }
+
+      if (shifted)
+      {
+         std::vector<double>  Nd(m, 0.0);
+         for (size_t i = 0; i < m; ++i)
+         {
+            const double  *Ni = &neq.matrix[i*(i+1)/2];
+            for (size_t j = 0; j < i; ++j)
+            {
+               Nd[i] += Ni[j]*delta[j];
+               Nd[j] += Ni[j]*delta[i];
+            }
+            Nd[i] += Ni[i]*delta[i];
+         }
+         for (size_t i = 0; i < m; ++i)
+         {
+            lPl += delta[i]*(Nd[i] - 2.0*neq.rhs[i]);
+            b[i] -= Nd[i];
+         }
+      }
+
+         // T'*N*T and T'*b
+      for (size_t i = 0; i < m; ++i)
+      {
+         const std::vector< std::pair<size_t, double> >&  Ti = terms[i];
+         const double  *Ni = &neq.matrix[i*(i+1)/2];
+
+         for (size_t j = 0; j <= i; ++j)
+         {
+            if (Ni[j] == 0.0)
+            {
+               continue;
+            }
+
+            const std::vector< std::pair<size_t, double> >&  Tj = terms[j];
+            for (size_t a = 0; a < Ti.size(); ++a)
+            {
+               for (size_t c = 0; c < Tj.size(); ++c)
+               {
+                  size_t  p = Ti[a].first;
+                  size_t  q = Tj[c].first;
+                  double  v = Ni[j] * Ti[a].second * Tj[c].second;
+                  if (i == j)
+                  {
+                     if (p >= q)
+                     {
+                        stack(p, q) += v;
+                     }
+                  }
+                  else
+                  {
+                     stack(p, q) += (p == q) ? 2.0*v : v;
+                  }
+               }
+            }
+         }
+
+         for (size_t a = 0; a < Ti.size(); ++a)
+         {
+            stack.rhs[Ti[a].first] += Ti[a].second * b[i];
+         }
+      }
+
+      stack.lPl += lPl;
+      stack.numObs += neq.numObs;
+      ++numNEQ;
+
+      return (*this);
+
+   }  // NEQStack::add()
+
+
+   void NEQStack::clear()
+   {
+      stack.clear();
+      index.clear();
+      numNEQ = 0;
+
+   }  // NEQStack::clear()
+
+}  // namespace Sinex
+
+}  // namespace gpstk
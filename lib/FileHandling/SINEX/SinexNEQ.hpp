@@ -0,0 +1,220 @@
+//============================================================================
+//
+//  This file is part of GPSTk, the GPS Toolkit.
+//
+//  The GPSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 3.0 of the License, or
+//  any later version.
+//
+//  The GPSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GPSTk; if not, write to the Free Software Foundation,
+//  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+//
+//============================================================================
+
+/**
+ * @file SinexNEQ.hpp
+ * Read, write and stack SINEX normal equations as packed matrices.
+ */
+
+#ifndef GPSTK_SINEXNEQ_HPP
+#define GPSTK_SINEXNEQ_HPP
+
+#include <map>
+#include <vector>
+#include <iostream>
+#include "SinexTypes.hpp"
+
+namespace gpstk
+{
+   namespace Sinex
+   {
+         /// @ingroup FileHandling
+         //@{
+
+         /**
+          * Parameter of a SINEX normal equation, as given in the
+          * SOLUTION/APRIORI or SOLUTION/NORMAL_EQUATION_VECTOR blocks.
+          */
+      struct NEQParameter
+      {
+            /// Constructor
+         NEQParameter() : constraintCode('2'), apriori(0.0) {}
+
+            /// Key used to match parameters: type, site, point, solution
+            /// and epoch
+         std::string key() const;
+
+         std::string  paramType;
+         std::string  siteCode;    ///< Call sign for a site
+         std::string  pointCode;   ///< Physical monument used at a site
+         std::string  solutionId;  ///< Solution number at a site
+         Time         epoch;
+         std::string  paramUnits;
+         char         constraintCode;
+         double       apriori;     ///< A priori value of the parameter
+
+      }; // struct NEQParameter
+
+
+         /**
+          * Normal equation N*dx = b of a SINEX file, dx being the
+          * corrections to the a priori values of the parameters.
+          *
+          * The matrix is kept packed: the lower triangle, row by row, so
+          * element (i,j), i >= j, is at i*(i+1)/2 + j. Adding a parameter
+          * only appends a row.
+          *
+          * 'read()' parses the file line by line straight into the packed
+          * matrix, without building the block lists of Sinex::Data. It takes
+          * the SOLUTION/NORMAL_EQUATION_MATRIX and VECTOR blocks if present.
+          * Otherwise the normal equation is recovered from the estimate and
+          * its covariance (COVA, CORR or INFO), and the constraints given in
+          * SOLUTION/MATRIX_APRIORI are removed, so the result is always the
+          * unconstrained normal equation.
+          */
+      class NormalEquation
+      {
+      public:
+
+            /// Constructor
+         NormalEquation() : lPl(0.0), numObs(0.0) {}
+
+            /// Destructor
+         virtual ~NormalEquation() {}
+
+            /// Number of parameters
+         size_t size() const
+         { return params.size(); }
+
+            /// Change the number of parameters, keeping the existing ones
+         void resize(size_t n);
+
+            /// Remove all the parameters
+         void clear();
+
+            /// Element (i,j) of the normal matrix
+         double& operator()(size_t i, size_t j)
+         { return (i >= j) ? matrix[i*(i+1)/2 + j] : matrix[j*(j+1)/2 + i]; }
+
+            /// Element (i,j) of the normal matrix
+         double operator()(size_t i, size_t j) const
+         { return (i >= j) ? matrix[i*(i+1)/2 + j] : matrix[j*(j+1)/2 + i]; }
+
+            /// Read the normal equation from a SINEX stream.
+         void read(std::istream& s)
+            throw(Exception);
+
+            /// Read the normal equation from a SINEX file.
+         void read(const std::string& filename)
+            throw(Exception);
+
+            /**
+             * Write the normal equation as a SINEX stream, with the
+             * SOLUTION/STATISTICS, APRIORI, NORMAL_EQUATION_VECTOR and
+             * NORMAL_EQUATION_MATRIX L blocks. The parameter count of the
+             * header is set to the size of the normal equation.
+             */
+         void write(std::ostream& s, const Header& header) const
+            throw(Exception);
+
+            /// Write the normal equation to a SINEX file.
+         void write(const std::string& filename, const Header& header) const
+            throw(Exception);
+
+         std::vector<NEQParameter>  params;  ///< Parameters
+         std::vector<double>        rhs;     ///< Right hand side b
+         std::vector<double>        matrix;  ///< Packed lower triangle of N
+         double                     lPl;     ///< Weighted square sum of O-C
+         double                     numObs;  ///< Number of observations
+
+      }; // class NormalEquation
+
+
+         /**
+          * Stacking of SINEX normal equations, e.g. daily ones into a
+          * weekly one, or weekly ones into a multi-year combination.
+          *
+          * Parameters are matched by type, site, point, solution and epoch.
+          * With a reference epoch set, station coordinates (STAX, STAY,
+          * STAZ) are transformed to it: x(t) = x(t0) + (t-t0)*v, using the
+          * a priori velocity (VELX, VELY, VELZ) of the normal equation if
+          * any, or estimating the velocity too if asked for.
+          *
+          * A parameter takes the a priori value of the first normal
+          * equation where it appears; later normal equations with other
+          * a priori values are shifted to it before being added.
+          *
+          * @code
+          *   Sinex::NEQStack  stack;
+          *   stack.setReferenceEpoch(midWeek);
+          *   for (int day = 0; day < 7; ++day)
+          *   {
+          *      Sinex::NormalEquation  neq;
+          *      neq.read(files[day]);
+          *      stack.add(neq);
+          *   }
+          *   stack.getNormalEquation().write("week.snx", header);
+          * @endcode
+          */
+      class NEQStack
+      {
+      public:
+
+            /// Constructor
+         NEQStack()
+            : useRefEpoch(false), estimateVelocities(false), numNEQ(0) {}
+
+            /// Destructor
+         virtual ~NEQStack() {}
+
+            /// Set the epoch the station coordinates are transformed to
+         NEQStack& setReferenceEpoch(const CommonTime& epoch);
+
+            /// Set whether the station velocities are estimated
+         NEQStack& setEstimateVelocities(bool estimate)
+         { estimateVelocities = estimate; return (*this); }
+
+            /// Add a normal equation to the stack.
+         NEQStack& add(const NormalEquation& neq)
+            throw(Exception);
+
+            /// Get the stacked normal equation
+         const NormalEquation& getNormalEquation() const
+         { return stack; }
+
+            /// Get the number of normal equations stacked
+         int getNumNEQ() const
+         { return numNEQ; }
+
+            /// Remove all the normal equations
+         void clear();
+
+      private:
+
+            /// Get the index of a parameter in the stack, adding it if new
+         size_t getParameter(const NEQParameter& param);
+
+         NormalEquation               stack;
+         std::map<std::string, size_t>  index;
+         CommonTime                   refEpoch;
+         Time                         refTime;
+         bool                         useRefEpoch;
+         bool                         estimateVelocities;
+         int                          numNEQ;
+
+      }; // class NEQStack
+
+         //@}
+
+   }  // namespace Sinex
+
+}  // namespace gpstk
+
+#endif // GPSTK_SINEXNEQ_HPP
@@ -0,0 +1,152 @@
+/// @file EpochReclaimer.cpp
+/// Epoch-based reclamation of objects shared between one writer thread and
+/// lock-free readers, used by RollingSatStore.
+
+//============================================================================
+//
+//  This file is part of GPSTk, the GPS Toolkit.
+//
+//  The GPSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 2.1 of the License, or
+//  any later version.
+//
+//  The GPSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GPSTk; if not, write to the Free Software Foundation,
+//  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+//
+//============================================================================
+
+#include "EpochReclaimer.hpp"
+
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
+
+namespace gpstk
+{
+   //---------------------------------------------------------------------------------
+   EpochReclaimer::EpochReclaimer(int maxReaders)
+      : numSlots(maxReaders > 0 ? maxReaders : 1), globalEpoch(1)
+   {
+      slots = new Slot[numSlots];
+   }
+
+   //---------------------------------------------------------------------------------
+   EpochReclaimer::~EpochReclaimer()
+   {
+      release(globalEpoch + 1);
+      delete [] slots;
+   }
+
+   //---------------------------------------------------------------------------------
+   int EpochReclaimer::enter(void) const
+   {
+      // Start from the slot of the thread, so that the threads of one team
+      // seldom compete for a slot, and take the first free one.
+      int i(0);
+#ifdef USE_OPENMP
+      i = omp_get_thread_num() % numSlots;
+#endif
+      while(true) {
+         int was;
+#ifdef USE_OPENMP
+   #pragma omp atomic capture
+#endif
+         { was = slots[i].busy; slots[i].busy = 1; }
+
+         if(was == 0) break;
+         if(++i == numSlots) i = 0;
+      }
+
+      // Publish the epoch, then check that the writer did not advance it
+      // meanwhile; if it did, the writer may have missed this slot when it
+      // scanned them, so publish the new epoch instead. Either way, once
+      // the loop ends the writer sees this slot before it deletes anything
+      // retired at or after the epoch.
+      Slot& s(slots[i]);
+      unsigned long e(globalEpoch);
+      while(true) {
+         s.epoch = e;
+#ifdef USE_OPENMP
+   #pragma omp flush
+#endif
+         unsigned long now(globalEpoch);
+         if(now == e) break;
+         e = now;
+      }
+
+      return i;
+   }
+
+   //---------------------------------------------------------------------------------
+   void EpochReclaimer::leave(int slot) const
+   {
+      Slot& s(slots[slot]);
+#ifdef USE_OPENMP
+   #pragma omp flush
+#endif
+      s.epoch = 0;
+#ifdef USE_OPENMP
+   #pragma omp flush
+#endif
+      s.busy = 0;
+   }
+
+   //---------------------------------------------------------------------------------
+   void EpochReclaimer::retire(void* p, void (*deleter)(void*))
+   {
+      if(!p) return;
+
+      Retired r;
+      r.p = p;
+      r.deleter = deleter;
+      r.epoch = globalEpoch;
+      retired.push_back(r);
+   }
+
+   //---------------------------------------------------------------------------------
+   size_t EpochReclaimer::collect(void)
+   {
+      if(retired.empty()) return 0;
+
+      // Readers that enter from now on get the new epoch, and cannot load
+      // the objects that were unpublished before.
+#ifdef USE_OPENMP
+   #pragma omp flush
+#endif
+      globalEpoch = globalEpoch + 1;
+#ifdef USE_OPENMP
+   #pragma omp flush
+#endif
+
+      unsigned long oldest(globalEpoch);
+      for(int i = 0; i < numSlots; i++) {
+         unsigned long e(slots[i].epoch);
+         if(e != 0 && e < oldest) oldest = e;
+      }
+
+      return release(oldest);
+   }
+
+   //---------------------------------------------------------------------------------
+   size_t EpochReclaimer::release(unsigned long oldest)
+   {
+      // Objects are retired in order of epoch, so the ones to delete are the
+      // first ones.
+      size_t n(0);
+      while(n < retired.size() && retired[n].epoch < oldest) {
+         retired[n].deleter(retired[n].p);
+         n++;
+      }
+      retired.erase(retired.begin(), retired.begin() + n);
+
+      return n;
+   }
+
+}  // End of namespace gpstk
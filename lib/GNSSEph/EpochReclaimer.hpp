@@ -0,0 +1,130 @@
+/// @file EpochReclaimer.hpp
+/// Epoch-based reclamation of objects shared between one writer thread and
+/// lock-free readers, used by RollingSatStore.
+
+//============================================================================
+//
+//  This file is part of GPSTk, the GPS Toolkit.
+//
+//  The GPSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 2.1 of the License, or
+//  any later version.
+//
+//  The GPSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GPSTk; if not, write to the Free Software Foundation,
+//  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+//
+//============================================================================
+
+#ifndef GPSTK_EPOCHRECLAIMER_HPP
+#define GPSTK_EPOCHRECLAIMER_HPP
+
+#include <cstddef>
+#include <vector>
+
+namespace gpstk
+{
+   /** @addtogroup ephemstore */
+   //@{
+
+   /// Defers the deletion of objects that readers may still be using.
+   ///
+   /// A reader calls enter() before it loads a shared pointer and leave()
+   /// when it is done with the object; in between it holds a reader slot
+   /// stamped with the global epoch. The writer first unpublishes an object
+   /// (replaces the pointer readers load), then hands it to retire(). Each
+   /// collect() advances the global epoch and deletes the objects retired
+   /// before the oldest epoch still held by a reader.
+   ///
+   /// Readers never wait for the writer nor for each other, unless more
+   /// than maxReaders() of them are inside enter()/leave() at once; the
+   /// writer never waits for readers, it only keeps the objects longer.
+   /// Only one thread may call retire() and collect().
+   ///
+   /// Memory ordering comes from OpenMP flushes; without USE_OPENMP the
+   /// class assumes a single thread.
+   class EpochReclaimer
+   {
+   public:
+
+      /// Constructor.
+      /// @param maxReaders  number of reader slots, i.e. of readers that
+      ///                    can be inside enter()/leave() at the same time
+      explicit EpochReclaimer(int maxReaders = 128);
+
+      /// Destructor, deletes every retired object. No reader may be active.
+      ~EpochReclaimer();
+
+      /// Start a read: take a reader slot and stamp it with the current
+      /// epoch. Objects loaded after this call stay alive until leave().
+      /// @return the slot, to be given to leave()
+      int enter(void) const;
+
+      /// End the read started by enter() and free its slot
+      void leave(int slot) const;
+
+      /// Hand an object, already unpublished, to be deleted with 'deleter'
+      /// once no reader can hold it. Writer only.
+      void retire(void* p, void (*deleter)(void*));
+
+      /// Advance the epoch and delete the retired objects that no reader
+      /// can hold any more. Writer only.
+      /// @return the number of objects deleted
+      size_t collect(void);
+
+      /// Number of retired objects not deleted yet
+      size_t pending(void) const
+      { return retired.size(); }
+
+      /// Number of reader slots
+      int maxReaders(void) const
+      { return numSlots; }
+
+   private:
+
+      /// One reader slot, alone in its cache line
+      struct Slot
+      {
+         Slot() : busy(0), epoch(0) {}
+
+         volatile int busy;               ///< 1 while owned by a reader
+         volatile unsigned long epoch;    ///< epoch of the read, 0 if none
+         char pad[64 - sizeof(int) - sizeof(unsigned long)];
+      };
+
+      /// An object waiting for deletion
+      struct Retired
+      {
+         void* p;
+         void (*deleter)(void*);
+         unsigned long epoch;             ///< global epoch when retired
+      };
+
+      /// Delete retired objects older than 'oldest'
+      size_t release(unsigned long oldest);
+
+      int numSlots;
+      Slot* slots;
+
+      /// Current epoch, starts at 1 and is written by the writer only
+      volatile unsigned long globalEpoch;
+
+      /// Objects waiting for deletion, in order of retirement
+      std::vector<Retired> retired;
+
+      EpochReclaimer(const EpochReclaimer&);
+      EpochReclaimer& operator=(const EpochReclaimer&);
+
+   }; // End of class 'EpochReclaimer'
+
+   //@}
+
+}  // End of namespace gpstk
+
+#endif   // GPSTK_EPOCHRECLAIMER_HPP
@@ -229,6 +229,9 @@ namespace gpstk
         finalTime   = rCei->second->endValid;
 
       } // end outer for-loop
+
+      // validity intervals and keys have changed
+      if(indexed) buildIndex();
    }
 
    //-----------------------------------------------------------------------------
@@ -104,6 +104,9 @@ namespace gpstk {
       if(!dataLoadedFlag)
          GPSTK_THROW(InvalidRequest("Data not loaded"));
 
+      if(kernel.isReady())
+         return kernel.svXvt(t - ctToe);
+
       Xvt sv;
       double ea;              // eccentric anomaly
       double delea;           // delta eccentric anomaly during iteration
@@ -248,6 +251,9 @@ namespace gpstk {
       if(!dataLoadedFlag)
          GPSTK_THROW(InvalidRequest("Data not loaded"));
 
+      if(kernel.isReady())
+         return kernel.svRelativity(t - ctToe);
+
       GPSEllipsoid ell;
       double twoPI  = 2.0 * PI;
       double sqrtgm = SQRT(ell.gm());
@@ -53,6 +53,7 @@
 #include "ObsID.hpp"
 #include "SatID.hpp"
 #include "Xvt.hpp"
+#include "OrbitEphKernel.hpp"
 
 namespace gpstk
 {
@@ -122,6 +123,17 @@ namespace gpstk
       /// @throw Invalid Request if the required data has not been stored.
       double svRelativity(const CommonTime& t) const;
 
+      /// Build the precomputed form (OrbitEphKernel) of this ephemeris, used
+      /// by svXvt() and svRelativity() from then on. Call it again after
+      /// changing any of the clock or orbit parameters below.
+      /// @throw Invalid Request if the required data has not been stored.
+      void precompute(void)
+      { kernel.compute(*this); }
+
+      /// Return the precomputed form of this ephemeris; check isReady().
+      const OrbitEphKernel& getKernel(void) const
+      { return kernel; }
+
       /// adjustBeginningValidity determines the beginValid and endValid times.
       /// In OrbitEph it simply assumes a 4-hour fit interval; however the derived
       /// class should override this function, using an appropriate fit interval.
@@ -205,6 +217,11 @@ namespace gpstk
       CommonTime beginValid;  ///< Time at beginning of validity
       CommonTime endValid;    ///< Time at end of fit validity
 
+   protected:
+
+      /// Epoch-independent constants, see precompute()
+      OrbitEphKernel kernel;
+
    }; // end class OrbitEph
 
    //@}
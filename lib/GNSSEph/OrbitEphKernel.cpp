@@ -0,0 +1,269 @@
+/// @file OrbitEphKernel.cpp
+/// Precomputed ("compiled") form of a broadcast OrbitEph, holding the parts of
+/// the IS-GPS-200 orbit evaluation that do not depend on the epoch, plus a
+/// batched Kepler solver used to evaluate many satellites/epochs at once.
+
+//============================================================================
+//
+//  This file is part of GPSTk, the GPS Toolkit.
+//
+//  The GPSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 2.1 of the License, or
+//  any later version.
+//
+//  The GPSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GPSTk; if not, write to the Free Software Foundation,
+//  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+//
+//============================================================================
+
+#include <vector>
+
+#include "OrbitEphKernel.hpp"
+#include "OrbitEph.hpp"
+#include "MathBase.hpp"
+#include "constants.hpp"
+#include "GPSWeekSecond.hpp"
+#include "GPSEllipsoid.hpp"
+
+using namespace std;
+
+namespace gpstk
+{
+
+      // (Re)compute the constants from the given ephemeris.
+   void OrbitEphKernel::compute(const OrbitEph& eph)
+   {
+      if(!eph.dataLoadedFlag)
+         GPSTK_THROW(InvalidRequest("Data not loaded"));
+
+      GPSEllipsoid ell;
+      double ToeSOW = GPSWeekSecond(eph.ctToe).sow;   // time-system-independent
+
+      sqrtgm   = SQRT(ell.gm());
+      A        = eph.A;
+      Adot     = eph.Adot;
+      Ahalf    = SQRT(A);
+      n0       = sqrtgm / (A*Ahalf);                 // Eqn specifies A0, not Ak
+      dn       = eph.dn;
+      dndot    = eph.dndot;
+      M0       = eph.M0;
+      ecc      = eph.ecc;
+      q        = SQRT(1.0 - ecc*ecc);
+      w        = eph.w;
+      i0       = eph.i0;
+      idot     = eph.idot;
+      OMEGAk0  = eph.OMEGA0 - ell.angVelocity() * ToeSOW;
+      domk     = eph.OMEGAdot - ell.angVelocity();
+
+      Cuc = eph.Cuc; Cus = eph.Cus;
+      Crc = eph.Crc; Crs = eph.Crs;
+      Cic = eph.Cic; Cis = eph.Cis;
+
+      af0 = eph.af0; af1 = eph.af1; af2 = eph.af2;
+      tocOffset = eph.ctToe - eph.ctToc;
+
+      ready = true;
+
+   }  // End of method 'OrbitEphKernel::compute()'
+
+
+      // Mean anomaly at elapte. The relativity correction of OrbitEph has
+      // never included the rate of the mean motion correction, keep it so.
+   double OrbitEphKernel::meanAnomaly(double elapte, bool withRate) const
+   {
+      double amm = n0 + dn;
+      if(withRate) amm += 0.5*dndot*elapte;
+      return ::fmod(M0 + elapte*amm, TWO_PI);
+   }
+
+
+      // Solve Kepler's equation for n (M,e) pairs.
+   void OrbitEphKernel::solveKepler( int n,
+                                     const double* meana,
+                                     const double* ecc,
+                                     double* ea,
+                                     double tol,
+                                     int maxIter )
+   {
+         // Third order starter, E0 = M + e*sin(M)*(1 + e*cos(M)). For GNSS
+         // eccentricities the first Newton step already lands below 1e-9 rad.
+#if defined(_OPENMP) && (_OPENMP >= 201307)
+   #pragma omp simd
+#endif
+      for(int i=0; i<n; ++i)
+      {
+         double sm = ::sin(meana[i]);
+         double cm = ::cos(meana[i]);
+         ea[i] = meana[i] + ecc[i]*sm*(1.0 + ecc[i]*cm);
+      }
+
+      for(int iter=0; iter<maxIter; ++iter)
+      {
+         double maxDel(0.0);
+
+#if defined(_OPENMP) && (_OPENMP >= 201307)
+   #pragma omp simd reduction(max:maxDel)
+#endif
+         for(int i=0; i<n; ++i)
+         {
+            double F = meana[i] - (ea[i] - ecc[i] * ::sin(ea[i]));
+            double G = 1.0 - ecc[i] * ::cos(ea[i]);
+            double delea = F/G;
+            ea[i] += delea;
+            double adel = ::fabs(delea);
+            maxDel = (adel > maxDel) ? adel : maxDel;
+         }
+
+         if(maxDel <= tol) break;
+      }
+
+   }  // End of method 'OrbitEphKernel::solveKepler()'
+
+
+      // Evaluate the orbit once the eccentric anomalies are known.
+   void OrbitEphKernel::evaluate( double elapte,
+                                  double ea,
+                                  double eaRel,
+                                  Xvt& sv ) const
+   {
+      double Ak  = A + Adot*elapte;
+      double amm = n0 + dn + 0.5*dndot*elapte;
+
+         // Clock corrections
+      double elaptc = elapte + tocOffset;
+      sv.relcorr  = REL_CONST * ecc * SQRT(Ak) * ::sin(eaRel);
+      sv.clkbias  = af0 + elaptc * (af1 + elaptc * af2);
+      sv.clkdrift = af1 + elaptc * af2;
+      sv.frame    = ReferenceFrame::WGS84;
+
+         // True anomaly
+      double sinea = ::sin(ea);
+      double cosea = ::cos(ea);
+      double G     = 1.0 - ecc * cosea;
+      double truea = ::atan2(q * sinea, cosea - ecc);
+
+         // Argument of lat and correction terms (2nd harmonic)
+      double alat  = truea + w;
+      double c2al  = ::cos(2.0*alat);
+      double s2al  = ::sin(2.0*alat);
+
+      double du = c2al * Cuc + s2al * Cus;
+      double dr = c2al * Crc + s2al * Crs;
+      double di = c2al * Cic + s2al * Cis;
+
+         // U = updated argument of lat, R = radius, AINC = inclination
+      double U     = alat + du;
+      double R     = Ak*G + dr;
+      double AINC  = i0 + idot*elapte + di;
+      double ANLON = OMEGAk0 + domk*elapte;
+
+         // In plane location
+      double cosu = ::cos(U);
+      double sinu = ::sin(U);
+      double xip  = R * cosu;
+      double yip  = R * sinu;
+
+         // Angles for rotation to earth fixed
+      double can  = ::cos(ANLON);
+      double san  = ::sin(ANLON);
+      double cinc = ::cos(AINC);
+      double sinc = ::sin(AINC);
+
+      sv.x[0] = xip*can - yip*cinc*san;
+      sv.x[1] = xip*san + yip*cinc*can;
+      sv.x[2] =           yip*sinc;
+
+         // Velocity of rotation coordinates
+      double dek = amm * Ak / R;
+      double dlk = Ahalf * q * sqrtgm / (R*R);
+      double div = idot - 2.0 * dlk * (Cic * s2al - Cis * c2al);
+      double duv = dlk * (1.0 + 2.0 * (Cus*c2al - Cuc*s2al));
+      double drv = Ak * ecc * dek * sinea - 2.0 * dlk * (Crc * s2al - Crs * c2al);
+      double dxp = drv*cosu - R*sinu*duv;
+      double dyp = drv*sinu + R*cosu*duv;
+
+      sv.v[0] = dxp*can - xip*san*domk - dyp*cinc*san
+                + yip*(sinc*san*div - cinc*can*domk);
+      sv.v[1] = dxp*san + xip*can*domk + dyp*cinc*can
+                - yip*(sinc*can*div + cinc*san*domk);
+      sv.v[2] = dyp*sinc + yip*cinc*div;
+
+   }  // End of method 'OrbitEphKernel::evaluate()'
+
+
+      // Compute position, velocity and clock of the satellite.
+   Xvt OrbitEphKernel::svXvt(double elapte) const
+   {
+      const OrbitEphKernel* self = this;
+      Xvt sv;
+      svXvt(1, &self, &elapte, &sv);
+      return sv;
+   }
+
+
+      // Compute the relativity correction (sec).
+   double OrbitEphKernel::svRelativity(double elapte) const
+   {
+      if(!ready)
+         GPSTK_THROW(InvalidRequest("Kernel not computed"));
+
+      double meana = meanAnomaly(elapte, false);
+      double ea;
+      solveKepler(1, &meana, &ecc, &ea);
+
+      return REL_CONST * ecc * SQRT(A + Adot*elapte) * ::sin(ea);
+   }
+
+
+      // Evaluate a batch of kernels.
+   void OrbitEphKernel::svXvt( int n,
+                               const OrbitEphKernel* const* kernel,
+                               const double* elapte,
+                               Xvt* xvt )
+   {
+      if(n <= 0) return;
+
+      for(int i=0; i<n; ++i)
+      {
+         if(!kernel[i]->ready)
+            GPSTK_THROW(InvalidRequest("Kernel not computed"));
+      }
+
+         // Gather the mean anomalies and eccentricities of the whole batch,
+         // so that Kepler's equation is solved in one vectorized sweep.
+      std::vector<double> meana(n), ecc(n), ea(n);
+      for(int i=0; i<n; ++i)
+      {
+         meana[i] = kernel[i]->meanAnomaly(elapte[i], true);
+         ecc[i]   = kernel[i]->ecc;
+      }
+
+      solveKepler(n, &meana[0], &ecc[0], &ea[0]);
+
+      for(int i=0; i<n; ++i)
+      {
+         const OrbitEphKernel& k = *kernel[i];
+
+            // The relativity term ignores dndot; only CNAV-like records
+            // (dndot != 0) need a second solution.
+         double eaRel(ea[i]);
+         if(k.dndot != 0.0)
+         {
+            double mRel = k.meanAnomaly(elapte[i], false);
+            solveKepler(1, &mRel, &k.ecc, &eaRel);
+         }
+
+         k.evaluate(elapte[i], ea[i], eaRel, xvt[i]);
+      }
+
+   }  // End of method 'OrbitEphKernel::svXvt()'
+
+
+}  // End of namespace gpstk
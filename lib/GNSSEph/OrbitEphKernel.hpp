@@ -0,0 +1,138 @@
+/// @file OrbitEphKernel.hpp
+/// Precomputed ("compiled") form of a broadcast OrbitEph, holding the parts of
+/// the IS-GPS-200 orbit evaluation that do not depend on the epoch, plus a
+/// batched Kepler solver used to evaluate many satellites/epochs at once.
+
+//============================================================================
+//
+//  This file is part of GPSTk, the GPS Toolkit.
+//
+//  The GPSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 2.1 of the License, or
+//  any later version.
+//
+//  The GPSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GPSTk; if not, write to the Free Software Foundation,
+//  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+//
+//============================================================================
+
+#ifndef GPSTK_ORBITEPHKERNEL_HPP
+#define GPSTK_ORBITEPHKERNEL_HPP
+
+#include "Xvt.hpp"
+
+namespace gpstk
+{
+   class OrbitEph;
+
+   /** @addtogroup ephemstore */
+   //@{
+
+   /// The epoch-independent constants of an OrbitEph (semi-major axis, mean
+   /// motion, sqrt(1-e^2), node longitude at Toe, clock offsets, ...). It is
+   /// built once per ephemeris by OrbitEph::precompute(), which OrbitEphStore
+   /// calls for every ephemeris it stores, so that svXvt() only evaluates the
+   /// time-dependent terms.
+   ///
+   /// The results are those of OrbitEph::svXvt(); only the Kepler iteration
+   /// differs, starting from a third order guess instead of M + e*sin(M).
+   class OrbitEphKernel
+   {
+   public:
+
+      /// Default constructor, the kernel is not ready until compute() is called
+      OrbitEphKernel(void) : ready(false)
+      { }
+
+      /// Build the kernel of the given ephemeris
+      explicit OrbitEphKernel(const OrbitEph& eph) : ready(false)
+      { compute(eph); }
+
+      /// (Re)compute the constants from the given ephemeris.
+      /// @throw Invalid Request if the ephemeris has no data loaded.
+      void compute(const OrbitEph& eph);
+
+      /// Return true if compute() has been called
+      bool isReady(void) const
+      { return ready; }
+
+      /// Mark the kernel as stale
+      void reset(void)
+      { ready = false; }
+
+      /// Compute position, velocity and clock of the satellite.
+      /// @param elapte  time since Toe (sec), i.e. t - ctToe
+      Xvt svXvt(double elapte) const;
+
+      /// Compute the relativity correction (sec).
+      /// @param elapte  time since Toe (sec), i.e. t - ctToe
+      double svRelativity(double elapte) const;
+
+      /// Evaluate a batch of kernels. Element i of xvt is the state of
+      /// kernel[i] at elapte[i] seconds from its Toe.
+      static void svXvt( int n,
+                         const OrbitEphKernel* const* kernel,
+                         const double* elapte,
+                         Xvt* xvt );
+
+      /// Solve Kepler's equation E - e*sin(E) = M for n (M,e) pairs.
+      /// The loops are written over plain arrays so that they vectorize; the
+      /// iteration stops when the largest correction of the whole batch is
+      /// below 'tol', or after 'maxIter' iterations.
+      static void solveKepler( int n,
+                               const double* meana,
+                               const double* ecc,
+                               double* ea,
+                               double tol = 1.0e-11,
+                               int maxIter = 20 );
+
+   private:
+
+      /// Evaluate the orbit once the eccentric anomalies are known.
+      /// @param ea     eccentric anomaly of the orbit
+      /// @param eaRel  eccentric anomaly used by the relativity correction
+      void evaluate(double elapte, double ea, double eaRel, Xvt& sv) const;
+
+      /// Mean anomaly at elapte, using (or not) the mean motion rate
+      double meanAnomaly(double elapte, bool withRate) const;
+
+      bool ready;
+
+      // Orbit
+      double A;            ///< Semi-major axis at Toe (m)
+      double Adot;         ///< Rate of semi-major axis (m/sec)
+      double Ahalf;        ///< sqrt(A)
+      double n0;           ///< Computed mean motion sqrt(GM/A^3) (rad/sec)
+      double dn;           ///< Correction to mean motion (rad/sec)
+      double dndot;        ///< Rate of correction to mean motion (rad/sec/sec)
+      double M0;           ///< Mean anomaly (rad)
+      double ecc;          ///< Eccentricity
+      double q;            ///< sqrt(1 - e^2)
+      double w;            ///< Argument of perigee (rad)
+      double i0;           ///< Inclination (rad)
+      double idot;         ///< Rate of inclination angle (rad/sec)
+      double OMEGAk0;      ///< OMEGA0 - wE*ToeSOW (rad)
+      double domk;         ///< OMEGAdot - wE (rad/sec)
+      double sqrtgm;       ///< sqrt(GM)
+
+      // Harmonic perturbations
+      double Cuc, Cus, Crc, Crs, Cic, Cis;
+
+      // Clock
+      double af0, af1, af2;
+      double tocOffset;    ///< ctToe - ctToc (sec)
+
+   }; // End of class 'OrbitEphKernel'
+
+   //@}
+
+}  // End of namespace gpstk
+
+#endif   // GPSTK_ORBITEPHKERNEL_HPP
@@ -81,6 +81,61 @@ namespace gpstk
       catch(InvalidRequest& ir) { GPSTK_RETHROW(ir); }
    }
 
+   //---------------------------------------------------------------------------------
+   int OrbitEphStore::getXvt( const vector<SatID>& sats,
+                              const vector<CommonTime>& times,
+                              vector<Xvt>& xvt,
+                              vector<bool>& valid ) const
+   {
+      if(sats.size() != times.size())
+         GPSTK_THROW(InvalidParameter("Sizes of satellites and times differ"));
+
+      const int n = sats.size();
+      xvt.assign(n, Xvt());
+      valid.assign(n, false);
+
+      // look up the ephemerides first, the evaluation is then done in one batch
+      vector<int> index;
+      vector<const OrbitEphKernel*> kernels;
+      vector<double> elapte;
+      index.reserve(n);
+      kernels.reserve(n);
+      elapte.reserve(n);
+
+      for(int i=0; i<n; i++) {
+         const OrbitEph *eph = findOrbitEph(sats[i], times[i]);
+         if(!eph) continue;
+         if(onlyHealthy && !eph->isHealthy()) continue;
+
+         // stored ephemerides are always precomputed, unless they were
+         // modified through the non-const interface afterwards
+         if(!eph->getKernel().isReady()) {
+            xvt[i] = eph->svXvt(times[i]);
+            valid[i] = true;
+            continue;
+         }
+
+         index.push_back(i);
+         kernels.push_back(&eph->getKernel());
+         elapte.push_back(times[i] - eph->ctToe);
+      }
+
+      if(index.size() > 0) {
+         vector<Xvt> batch(index.size());
+         OrbitEphKernel::svXvt(index.size(), &kernels[0], &elapte[0], &batch[0]);
+         for(size_t j=0; j<index.size(); j++) {
+            xvt[index[j]] = batch[j];
+            valid[index[j]] = true;
+         }
+      }
+
+      int nvalid(0);
+      for(int i=0; i<n; i++)
+         if(valid[i]) nvalid++;
+
+      return nvalid;
+   }
+
    //---------------------------------------------------------------------------------
    void OrbitEphStore::dump(ostream& os, short detail) const
    {
@@ -188,10 +243,37 @@ namespace gpstk
 
    } // end OrbitEphStore::dump
 
+   //---------------------------------------------------------------------------------
+   OrbitEph* OrbitEphStore::addEphemeris(const OrbitEph* eph)
+   {
+      OrbitEph *ret = insertEphemeris(eph);
+      if(!ret || !indexed)
+         return ret;
+
+      // Usual real-time case: the new ephemeris is the latest of its satellite
+      // and nothing was replaced, so it goes at the end of the index.
+      SatIndex& si = satIndex[eph->satID];
+      const TimeOrbitEphTable& table = satTables[eph->satID];
+      if(table.size() == si.intervals.size()+1 &&
+         (si.intervals.empty() || si.intervals.back().key < ret->beginValid))
+      {
+         ValidityInterval vi;
+         vi.key = ret->beginValid;
+         vi.begin = ret->beginValid;
+         vi.end = ret->endValid;
+         vi.eph = ret;
+         si.intervals.push_back(vi);
+         return ret;
+      }
+
+      buildIndex(eph->satID);
+      return ret;
+   }
+
    //---------------------------------------------------------------------------------
    // Keeps only one OrbitEph for a given satellite and Toe.
    // If keys are repeated, keep the one with the earliest transmit time.
-   OrbitEph* OrbitEphStore::addEphemeris(const OrbitEph* eph)
+   OrbitEph* OrbitEphStore::insertEphemeris(const OrbitEph* eph)
    {
 
 //      std::cout << eph->satID << std::endl;
@@ -210,6 +292,7 @@ namespace gpstk
             // if map is empty, load object and return
          if(toet.size() == 0) {
             ret = eph->clone();
+            ret->precompute();
             toet[eph->beginValid] = ret;
             updateTimeLimits(ret);
             return ret;
@@ -235,7 +318,9 @@ namespace gpstk
             // from  https://github.com/SGL-UT/GPSTk/issues/9
             else if(it->second->ctToe < eph->ctToe)
             {
+                delete it->second;
                 ret = eph->clone();
+                ret->precompute();
                 toet[eph->beginValid] = ret;
                 updateTimeLimits(ret);
                 return ret;
@@ -261,9 +346,11 @@ namespace gpstk
          if(it==toet.begin()) {
             // candidate is before beginning of map
             if(it->second->ctToe == eph->ctToe) {
+               delete it->second;
                toet.erase(it);
             }
             ret = eph->clone();
+            ret->precompute();
             toet[eph->beginValid] = ret;
             updateTimeLimits(ret);
             return ret;
@@ -275,6 +362,7 @@ namespace gpstk
             TimeOrbitEphTable::reverse_iterator rit = toet.rbegin();
             if(rit->second->ctToe != eph->ctToe) {
                ret = eph->clone();
+               ret->precompute();
                toet[eph->beginValid] = ret;
                updateTimeLimits(ret);
             }
@@ -286,8 +374,10 @@ namespace gpstk
          // Check if iterator points to late transmission of
          // same OrbitEph as candidate
          if(it->second->ctToe == eph->ctToe) {
+            delete it->second;
             toet.erase(it);
             ret = eph->clone();
+            ret->precompute();
             toet[eph->beginValid] = ret;
             updateTimeLimits(ret);
             return ret;
@@ -301,6 +391,7 @@ namespace gpstk
          it--;
          if(it->second->ctToe != eph->ctToe) {
             ret = eph->clone();
+            ret->precompute();
             toet[eph->beginValid] = ret;
             updateTimeLimits(ret);
          }
@@ -309,7 +400,7 @@ namespace gpstk
       }
       catch(Exception& e) { GPSTK_RETHROW(e) }
 
-   }  // end OrbitEph* OrbitEphStore::addEphemeris(const OrbitEph* eph)
+   }  // end OrbitEph* OrbitEphStore::insertEphemeris(const OrbitEph* eph)
 
    //---------------------------------------------------------------------------------
    void OrbitEphStore::edit(const CommonTime& tmin, const CommonTime& tmax)
@@ -337,6 +428,109 @@ namespace gpstk
 
       initialTime = tmin;
       finalTime   = tmax;
+
+      if(indexed) buildIndex();
+   }
+
+   //---------------------------------------------------------------------------------
+   void OrbitEphStore::copyFrom(const OrbitEphStore& right)
+   {
+      timeSystem = right.timeSystem;
+      strictMethod = right.strictMethod;
+      onlyHealthy = right.onlyHealthy;
+      message = right.message;
+
+      for(SatTableMap::const_iterator it = right.satTables.begin();
+          it != right.satTables.end(); it++)
+      {
+         TimeOrbitEphTable& toet = satTables[it->first];
+         for(TimeOrbitEphTable::const_iterator ei = it->second.begin();
+             ei != it->second.end(); ei++)
+         {
+            OrbitEph *eph = ei->second->clone();
+            eph->precompute();
+            toet[ei->first] = eph;
+         }
+      }
+
+      // edit() may have set limits other than those of the ephemerides
+      initialTime = right.initialTime;
+      finalTime = right.finalTime;
+
+      satIndex.clear();
+      indexed = false;
+      if(right.indexed) buildIndex();
+   }
+
+   //---------------------------------------------------------------------------------
+   void OrbitEphStore::deleteEphemerides(void)
+   {
+      for(SatTableMap::iterator it = satTables.begin(); it != satTables.end(); it++)
+      {
+         TimeOrbitEphTable& toet = it->second;
+         for(TimeOrbitEphTable::iterator ei = toet.begin(); ei != toet.end(); ei++)
+            delete ei->second;
+         toet.clear();
+      }
+
+      satTables.clear();
+      satIndex.clear();
+
+      initialTime = CommonTime::END_OF_TIME;
+      initialTime.setTimeSystem(timeSystem);
+      finalTime = CommonTime::BEGINNING_OF_TIME;
+      finalTime.setTimeSystem(timeSystem);
+   }
+
+   //---------------------------------------------------------------------------------
+   void OrbitEphStore::buildIndex(void)
+   {
+      satIndex.clear();
+      for(SatTableMap::const_iterator it = satTables.begin();
+          it != satTables.end(); it++)
+         buildIndex(it->first);
+
+      indexed = true;
+   }
+
+   //---------------------------------------------------------------------------------
+   void OrbitEphStore::buildIndex(const SatID& sat)
+   {
+      SatIndex& si = satIndex[sat];
+      si.intervals.clear();
+
+      SatTableMap::const_iterator it = satTables.find(sat);
+      if(it != satTables.end()) {
+         const TimeOrbitEphTable& table = it->second;
+         si.intervals.reserve(table.size());
+         for(TimeOrbitEphTable::const_iterator ei = table.begin();
+             ei != table.end(); ei++)
+         {
+            ValidityInterval vi;
+            vi.key = ei->first;
+            vi.begin = ei->second->beginValid;
+            vi.end = ei->second->endValid;
+            vi.eph = ei->second;
+            si.intervals.push_back(vi);
+         }
+      }
+   }
+
+   //---------------------------------------------------------------------------------
+   int OrbitEphStore::locate(const SatIndex& si, const CommonTime& t) const
+   {
+      const vector<ValidityInterval>& v = si.intervals;
+
+      // binary search of the first key >= t; lookups write nothing, so
+      // that threads can share the store
+      int lo(0), hi(v.size());
+      while(lo < hi) {
+         int mid = (lo + hi) / 2;
+         if(v[mid].key < t) lo = mid + 1;
+         else hi = mid;
+      }
+
+      return lo - 1;
    }
 
    //---------------------------------------------------------------------------------
@@ -377,6 +571,24 @@ namespace gpstk
    const OrbitEph* OrbitEphStore::findUserOrbitEph(const SatID& sat,
                                                    const CommonTime& t) const
    {
+      // With the index, the search below reduces to: the element with the
+      // latest key strictly before t, if it is valid at t.
+      if(indexed) {
+         SatIndexMap::const_iterator sit = satIndex.find(sat);
+         if(sit == satIndex.end())
+            return NULL;
+
+         const int i = locate(sit->second, t);
+         if(i < 0)
+            return NULL;
+
+         const ValidityInterval& vi = sit->second.intervals[i];
+         if(t < vi.begin || t > vi.end)
+            return NULL;
+
+         return vi.eph;
+      }
+
       // Is this satellite found in the table?
       if(satTables.find(sat) == satTables.end())
          return NULL;
@@ -453,6 +665,35 @@ namespace gpstk
    const OrbitEph* OrbitEphStore::findNearOrbitEph(const SatID& sat,
                                                    const CommonTime& t) const
    {
+      if(indexed) {
+         SatIndexMap::const_iterator sit = satIndex.find(sat);
+         if(sit == satIndex.end())
+            return NULL;
+
+         const vector<ValidityInterval>& v = sit->second.intervals;
+         if(v.empty())
+            return NULL;
+
+         // itPrior/itNext of the search below
+         const int iPrior = locate(sit->second, t);
+         const int iNext = iPrior + 1;
+         const int n = v.size();
+
+         if(iNext < n && v[iNext].key == t)     // exact match
+            return v[iNext].eph;
+         if(iPrior < 0)                         // before all OrbitEph
+            return v[0].eph;
+         if(iNext == n)                         // after all OrbitEph
+            return v[n-1].eph;
+
+         double diffToNext = v[iNext].eph->ctToe - t;
+         double diffFromLast = t - v[iPrior].eph->ctToe;
+         if(diffToNext > diffFromLast)
+            return v[iPrior].eph;
+
+         return v[iNext].eph;
+      }
+
         // Check for any OrbitEph for this SV
       if(satTables.find(sat) == satTables.end())
          return NULL;
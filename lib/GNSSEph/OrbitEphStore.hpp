@@ -47,6 +47,7 @@
 
 #include <iostream>
 #include <list>
+#include <vector>
 
 #include "OrbitEph.hpp"
 #include "Exception.hpp"
@@ -74,15 +75,31 @@ namespace gpstk
       OrbitEphStore()
          : initialTime(CommonTime::END_OF_TIME),
            finalTime(CommonTime::BEGINNING_OF_TIME),
-           strictMethod(true), onlyHealthy(false)
+           strictMethod(true), onlyHealthy(false), indexed(false)
       {
          timeSystem = TimeSystem::Any;
          initialTime.setTimeSystem(timeSystem);
          finalTime.setTimeSystem(timeSystem);
       }
 
-      /// Destructor
-      virtual ~OrbitEphStore() { clear(); }
+      /// Copy constructor. The OrbitEphs are cloned, so that the copy can be
+      /// edited independently of the original (see RollingSatStore).
+      OrbitEphStore(const OrbitEphStore& right)
+         : XvtStore<SatID>(right), indexed(false)
+      { copyFrom(right); }
+
+      /// Assignment operator, cloning the OrbitEphs as the copy constructor
+      OrbitEphStore& operator=(const OrbitEphStore& right)
+      {
+         if(this != &right) {
+            deleteEphemerides();
+            copyFrom(right);
+         }
+         return *this;
+      }
+
+      /// Destructor, deletes the OrbitEphs
+      virtual ~OrbitEphStore() { deleteEphemerides(); }
 
       /// Return a string that will identify the derived class
       virtual std::string getName(void) const
@@ -97,6 +114,23 @@ namespace gpstk
       ///        orbit elements at time t.
       virtual Xvt getXvt(const SatID& id, const CommonTime& t) const;
 
+      /// Batched version of getXvt(): xvt[i] is the state of sats[i] at
+      /// times[i]. The ephemerides are looked up first and then evaluated
+      /// together (see OrbitEphKernel::svXvt()), which is much cheaper than
+      /// n calls of getXvt() when many satellites or epochs are needed.
+      /// Requests that getXvt() would reject (no OrbitEph, unhealthy) do not
+      /// throw; they get valid[i] = false instead.
+      /// @param[in] sats satellites of interest
+      /// @param[in] times times of interest, same size as sats
+      /// @param[out] xvt the Xvt of each request
+      /// @param[out] valid true for every request that could be computed
+      /// @return the number of valid requests
+      /// @throw InvalidParameter if sats and times differ in size.
+      virtual int getXvt( const std::vector<SatID>& sats,
+                          const std::vector<CommonTime>& times,
+                          std::vector<Xvt>& xvt,
+                          std::vector<bool>& valid ) const;
+
       /// Output summary of store data in human readable form, with detail:
       ///  0: Time limits and number of entries for entire store
       ///  1: Level 0 plus for each satellite: one line giving number and time limits
@@ -116,21 +150,9 @@ namespace gpstk
       virtual void edit(const CommonTime& tmin,
                         const CommonTime& tmax = CommonTime::END_OF_TIME);
 
-      /// Clear the dataset, meaning remove all data
+      /// Clear the dataset, meaning remove (and delete) all data
       virtual void clear(void)
-      {
-         for(SatTableMap::iterator ui=satTables.begin(); ui!=satTables.end(); ui++) {
-            TimeOrbitEphTable& toet = ui->second;
-            toet.clear();
-         }
-
-         satTables.clear();
-
-         initialTime = CommonTime::END_OF_TIME;
-         initialTime.setTimeSystem(timeSystem);
-         finalTime = CommonTime::BEGINNING_OF_TIME;
-         finalTime.setTimeSystem(timeSystem);
-      }
+      { deleteEphemerides(); }
 
       /// Return the earliest time in the store.
       /// @return The store initial time
@@ -215,11 +237,33 @@ namespace gpstk
       /// @return the number of OrbitEph records stored for the given satellite.
       unsigned size(const SatID& sat) const;
 
-      /// Add an OrbitEph object to this collection.
+      /// Add an OrbitEph object to this collection. When the store is indexed
+      /// (see buildIndex()), the index of the satellite is kept up to date:
+      /// an ephemeris newer than all the others of its satellite, which is
+      /// the normal case for real-time navigation messages, is simply
+      /// appended to it.
       /// @param eph pointer to the OrbitEph to add
       /// @return pointer to new OrbitEph if it successful, NULL otherwise
       virtual OrbitEph* addEphemeris(const OrbitEph* eph);
 
+      /// Build the time-sorted index of validity intervals of every satellite,
+      /// used by findUserOrbitEph() and findNearOrbitEph() instead of walking
+      /// the TimeOrbitEphTable maps. Call it once after loading (and after
+      /// rationalize(), which rebuilds it anyway if it exists); from then on
+      /// addEphemeris() and edit() maintain it.
+      /// Lookups are O(log n) and read only, so any number of threads may
+      /// run them at once; buildIndex(), addEphemeris() and edit() must not
+      /// run at the same time as lookups.
+      void buildIndex(void);
+
+      /// Drop the index; lookups go back to the TimeOrbitEphTable maps.
+      void clearIndex(void)
+      { satIndex.clear(); indexed = false; }
+
+      /// Return true if the store is indexed, see buildIndex()
+      bool isIndexed(void) const
+      { return indexed; }
+
       /// Add an OrbitEph object to this collection, converting the given RINEX
       /// navigation data.
       /// @param rnd Rinex3NavData
@@ -347,6 +391,48 @@ namespace gpstk
       /// otherwise it will throw (default false)
       bool onlyHealthy;
 
+      /// One entry of the index of a satellite, see buildIndex()
+      struct ValidityInterval
+      {
+         CommonTime key;         ///< key of the OrbitEph in its table
+         CommonTime begin;       ///< beginValid of the OrbitEph
+         CommonTime end;         ///< endValid of the OrbitEph
+         const OrbitEph* eph;
+      };
+
+      /// Validity intervals of one satellite, sorted by key
+      struct SatIndex
+      {
+         std::vector<ValidityInterval> intervals;
+      };
+
+      typedef std::map<SatID, SatIndex> SatIndexMap;
+
+      /// The index of every satellite, valid only if 'indexed' is true
+      SatIndexMap satIndex;
+
+      /// flag indicating the index is built and maintained
+      bool indexed;
+
+      /// Insert a clone of eph in its TimeOrbitEphTable, the work of
+      /// addEphemeris() apart from the index maintenance.
+      OrbitEph* insertEphemeris(const OrbitEph* eph);
+
+      /// (Re)build the index of one satellite from its TimeOrbitEphTable
+      void buildIndex(const SatID& sat);
+
+      /// Return the position in si.intervals of the last key strictly before
+      /// t, or -1 if there is none.
+      int locate(const SatIndex& si, const CommonTime& t) const;
+
+      /// Copy the settings of right and clones of its OrbitEphs, rebuilding
+      /// the index if right has one. The tables must be empty.
+      void copyFrom(const OrbitEphStore& right);
+
+      /// Delete the OrbitEphs, which the store owns (see addEphemeris() and
+      /// edit()), and clear the tables
+      void deleteEphemerides(void);
+
       /// Convenience routines
       void updateTimeLimits(const OrbitEph* eph)
       {
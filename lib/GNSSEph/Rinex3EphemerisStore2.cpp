@@ -106,6 +106,10 @@ namespace gpstk
          }
          strm.exceptions(ios::failbit);
 
+         // records of a file are not time-sorted per satellite; rebuilding
+         // the index once at the end is cheaper than maintaining it
+         clearIndex();
+
          try { strm >> Rhead; }
          catch(Exception& e) {
             what = string("Failed to read header of file ") + filename
@@ -156,6 +160,8 @@ namespace gpstk
             }
          }
 
+         buildIndex();
+
          return nread;
       }
       catch(Exception& e) {
@@ -274,6 +280,50 @@ namespace gpstk
       catch(InvalidRequest& ir) { GPSTK_RETHROW(ir); }
    }
 
+   // Batched getXvt(), split by satellite system.
+   int Rinex3EphemerisStore2::getXvt( const vector<SatID>& sats,
+                                      const vector<CommonTime>& ttags,
+                                      vector<Xvt>& xvt,
+                                      vector<bool>& valid ) const
+   {
+      if(sats.size() != ttags.size())
+         GPSTK_THROW(InvalidParameter("Sizes of satellites and times differ"));
+
+      const int n = sats.size();
+      xvt.assign(n, Xvt());
+      valid.assign(n, false);
+
+      const SatID::SatelliteSystem systems[3] =
+         { SatID::systemGPS, SatID::systemGalileo, SatID::systemBDS };
+      const TimeSystem tsystems[3] =
+         { TimeSystem::GPS, TimeSystem::GAL, TimeSystem::BDT };
+      const OrbitEphStore* stores[3] = { &gpsStore, &galStore, &bdsStore };
+
+      int nvalid(0);
+      for(int s=0; s<3; s++) {
+         vector<int> index;
+         vector<SatID> ssats;
+         vector<CommonTime> sttags;
+         for(int i=0; i<n; i++) {
+            if(sats[i].system != systems[s]) continue;
+            index.push_back(i);
+            ssats.push_back(sats[i]);
+            sttags.push_back(correctTimeSystem(ttags[i], tsystems[s]));
+         }
+         if(index.empty()) continue;
+
+         vector<Xvt> sxvt;
+         vector<bool> svalid;
+         nvalid += stores[s]->getXvt(ssats, sttags, sxvt, svalid);
+         for(size_t j=0; j<index.size(); j++) {
+            xvt[index[j]] = sxvt[j];
+            valid[index[j]] = svalid[j];
+         }
+      }
+
+      return nvalid;
+   }
+
    // Dump information about the store to an ostream.
    // @param[in] os ostream to receive the output; defaults to cout
    // @param[in] detail integer level of detail to provide; allowed values are
@@ -45,6 +45,7 @@
 #include <string>
 #include <list>
 #include <map>
+#include <vector>
 #include <algorithm>
 
 #include "Exception.hpp"
@@ -114,13 +115,13 @@ namespace gpstk
       { }
 
 
-      GPSEphemerisStore getGPSEphemerisStore() const
+      const GPSEphemerisStore& getGPSEphemerisStore() const
       { return gpsStore; }
 
-      GalEphemerisStore getGalEphemerisStore() const
+      const GalEphemerisStore& getGalEphemerisStore() const
       { return galStore; }
 
-      BDSEphemerisStore getBDSEphemerisStore() const
+      const BDSEphemerisStore& getBDSEphemerisStore() const
       { return bdsStore; }
 
 
@@ -136,6 +137,17 @@ namespace gpstk
       ///    information as to why the request failed.
       virtual Xvt getXvt(const SatID& sat, const CommonTime& ttag) const;
 
+      /// Batched version of getXvt(): xvt[i] is the state of sats[i] at
+      /// ttags[i]. Requests are split by system, converted to the system time
+      /// and evaluated in one batch per system (see OrbitEphStore::getXvt()).
+      /// Requests that cannot be computed get valid[i] = false.
+      /// @return the number of valid requests
+      /// @throw InvalidParameter if sats and ttags differ in size.
+      virtual int getXvt( const std::vector<SatID>& sats,
+                          const std::vector<CommonTime>& ttags,
+                          std::vector<Xvt>& xvt,
+                          std::vector<bool>& valid ) const;
+
       /// Dump information about the store to an ostream.
       /// @param[in] os ostream to receive the output; defaults to std::cout
       /// @param[in] detail integer level of detail to provide; allowed values are
@@ -395,6 +407,23 @@ namespace gpstk
          bdsStore.setOnlyHealthyFlag(flag);
       }
 
+      /// Build the time-sorted ephemeris index of each system store (see
+      /// OrbitEphStore::buildIndex()). loadFile() does it after every file.
+      void buildIndex(void)
+      {
+         gpsStore.buildIndex();
+         galStore.buildIndex();
+         bdsStore.buildIndex();
+      }
+
+      /// Drop the ephemeris index of each system store
+      void clearIndex(void)
+      {
+         gpsStore.clearIndex();
+         galStore.clearIndex();
+         bdsStore.clearIndex();
+      }
+
       /// use findNearEphemeris() in the getSat...() routines (Orbit-based systems)
       void SearchNear(void)
       {
@@ -0,0 +1,549 @@
+/// @file RollingSatStore.hpp
+/// Rolling (sliding time window) stores of satellite orbits and clocks, that
+/// one writer thread updates while other threads read them without locks.
+
+//============================================================================
+//
+//  This file is part of GPSTk, the GPS Toolkit.
+//
+//  The GPSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 2.1 of the License, or
+//  any later version.
+//
+//  The GPSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GPSTk; if not, write to the Free Software Foundation,
+//  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+//
+//============================================================================
+
+#ifndef GPSTK_ROLLINGSATSTORE_HPP
+#define GPSTK_ROLLINGSATSTORE_HPP
+
+#include <iostream>
+#include <map>
+#include <vector>
+
+#include "Exception.hpp"
+#include "SatID.hpp"
+#include "CommonTime.hpp"
+#include "Xvt.hpp"
+#include "XvtStore.hpp"
+#include "EpochReclaimer.hpp"
+
+namespace gpstk
+{
+   /** @addtogroup ephemstore */
+   //@{
+
+   /// A store of orbits and/or clocks of type Store (SP3EphemerisStore,
+   /// Rinex3EphemerisStore2, ClockSatStore, ...) that keeps only the data of
+   /// a sliding time window, for real-time services that run for days.
+   ///
+   /// Each satellite has its own Store, holding only that satellite, which
+   /// is never modified once published. A writer thread gets a private copy
+   /// of the Store of a satellite from update(), adds records to it with
+   /// the usual Store methods, and makes all its copies visible at once with
+   /// publish(). publish() also drops the data older than the window, and
+   /// the satellites without data in the window. Replaced Stores are deleted
+   /// by an EpochReclaimer once no reader can use them any more.
+   ///
+   /// @code
+   ///   SP3EphemerisStore proto;
+   ///   proto.rejectBadClocks(true);
+   ///   RollingSatStore<SP3EphemerisStore> rolling(proto, 6*3600.0);
+   ///
+   ///      // writer thread, for every epoch of the stream
+   ///   rolling.update(sat, t).addPositionData(sat, t, pos, sigma);
+   ///   ...
+   ///   rolling.publish(t);
+   ///
+   ///      // any other thread
+   ///   Xvt xvt = rolling.getXvt(sat, t);
+   /// @endcode
+   ///
+   /// Readers (getXvt(), getClockBias(), ReadGuard, ...) take no lock and
+   /// never wait for the writer. All the other methods are for one writer
+   /// thread. Every copy costs the records of one satellite in the window,
+   /// so the writer should add a whole epoch (or more) before publish().
+   ///
+   /// Store must be copyable and provide edit(tmin, tmax); getXvt(),
+   /// getClockBias() and getClockDrift() are only available when Store has
+   /// them.
+   template <class Store>
+   class RollingSatStore
+   {
+   public:
+
+      /// Constructor.
+      /// @param proto      empty Store with the settings (interpolation,
+      ///                   rejection flags, ...) given to new satellites
+      /// @param window     length of the window (s)
+      /// @param maxReaders number of threads that can read at the same time
+      RollingSatStore( const Store& proto = Store(),
+                       double window = 86400.0,
+                       int maxReaders = 128 )
+         : prototype(proto), windowLength(window), evictSlack(window/8.0),
+           reclaimer(maxReaders)
+      {
+         table = new Snapshot* volatile[NumIndex];
+         for(int i = 0; i < NumIndex; i++) table[i] = 0;
+      }
+
+      /// Destructor. No reader may be active.
+      virtual ~RollingSatStore()
+      {
+         discardPending();
+         for(int i = 0; i < NumIndex; i++) delete table[i];
+         delete [] table;
+      }
+
+      /// Gives a read access to the Stores, valid until it is destroyed.
+      /// The pointers returned by find() must not be kept after that.
+      class ReadGuard
+      {
+      public:
+
+         explicit ReadGuard(const RollingSatStore& s)
+            : store(s), slot(s.reclaimer.enter())
+         {}
+
+         ~ReadGuard()
+         { store.reclaimer.leave(slot); }
+
+         /// Store of the satellite, or NULL if there is none
+         const Store* find(const SatID& sat) const
+         {
+            int idx(indexOf(sat));
+            if(idx < 0) return 0;
+            const Snapshot* s(store.table[idx]);
+            return (s ? &s->store : 0);
+         }
+
+      private:
+
+         const RollingSatStore& store;
+         int slot;
+
+         ReadGuard(const ReadGuard&);
+         ReadGuard& operator=(const ReadGuard&);
+      };
+
+      //---------------------------------------------------------------
+      // Readers
+      //---------------------------------------------------------------
+
+      /// Return the Xvt of the satellite at time t, from its Store.
+      /// @throw InvalidRequest if the satellite is not in the store, or if
+      ///        the Store cannot compute it.
+      Xvt getXvt(const SatID& sat, const CommonTime& t) const
+      {
+         ReadGuard guard(*this);
+         return storeOf(guard, sat).getXvt(sat, t);
+      }
+
+      /// Return the clock bias of the satellite at time t, from its Store.
+      /// @throw InvalidRequest as getXvt()
+      double getClockBias(const SatID& sat, const CommonTime& t) const
+      {
+         ReadGuard guard(*this);
+         return storeOf(guard, sat).getClockBias(sat, t);
+      }
+
+      /// Return the clock drift of the satellite at time t, from its Store.
+      /// @throw InvalidRequest as getXvt()
+      double getClockDrift(const SatID& sat, const CommonTime& t) const
+      {
+         ReadGuard guard(*this);
+         return storeOf(guard, sat).getClockDrift(sat, t);
+      }
+
+      /// Return true if the satellite has data in the store
+      bool isPresent(const SatID& sat) const
+      {
+         ReadGuard guard(*this);
+         return (guard.find(sat) != 0);
+      }
+
+      /// Return the satellites having data in the store
+      std::vector<SatID> getSatList(void) const
+      {
+         std::vector<SatID> sats;
+         ReadGuard guard(*this);
+         for(int i = 0; i < NumIndex; i++) {
+            const Snapshot* s(table[i]);
+            if(s) sats.push_back(s->sat);
+         }
+         return sats;
+      }
+
+      /// Return the time of the earliest record in the store, or
+      /// END_OF_TIME if it is empty. After an eviction, this is the start
+      /// of the window even if a record before it was kept for the
+      /// interpolation.
+      CommonTime getInitialTime(void) const
+      {
+         CommonTime t(CommonTime::END_OF_TIME);
+         ReadGuard guard(*this);
+         for(int i = 0; i < NumIndex; i++) {
+            const Snapshot* s(table[i]);
+            if(s && s->first < t) t = s->first;
+         }
+         return t;
+      }
+
+      /// Return the time of the latest record in the store, or
+      /// BEGINNING_OF_TIME if it is empty.
+      CommonTime getFinalTime(void) const
+      {
+         CommonTime t(CommonTime::BEGINNING_OF_TIME);
+         ReadGuard guard(*this);
+         for(int i = 0; i < NumIndex; i++) {
+            const Snapshot* s(table[i]);
+            if(s && s->last > t) t = s->last;
+         }
+         return t;
+      }
+
+      //---------------------------------------------------------------
+      // Writer
+      //---------------------------------------------------------------
+
+      /// Return the private copy of the Store of the satellite, to add
+      /// records of time ttag to it. The copy is made on the first call
+      /// after publish(); it is invisible to readers until the next
+      /// publish().
+      /// @throw InvalidRequest if the SatID cannot be stored
+      Store& update(const SatID& sat, const CommonTime& ttag)
+      {
+         int idx(indexOf(sat));
+         if(idx < 0) {
+            InvalidRequest e("Satellite " + StringUtils::asString(sat)
+                             + " cannot be stored in a RollingSatStore");
+            GPSTK_THROW(e);
+         }
+
+         Snapshot* s(workCopy(idx, sat));
+         if(ttag < s->first) s->first = ttag;
+         if(ttag > s->last) s->last = ttag;
+
+         return s->store;
+      }
+
+      /// Make the updates visible to readers, and remove the data older
+      /// than (now - window). The Stores of the satellites that were not
+      /// updated are only copied and edited when their oldest data is more
+      /// than evictionSlack() older than the window, or removed when all
+      /// their data is.
+      void publish(const CommonTime& now)
+      {
+         CommonTime tmin(now), tcut(now);
+         tmin -= windowLength;
+         tcut -= (windowLength + evictSlack);
+
+         for(int i = 0; i < NumIndex; i++) {
+            const Snapshot* cur(table[i]);
+            if(cur && pending.find(i) == pending.end() &&
+               (cur->last < tmin || cur->first < tcut))
+               workCopy(i, cur->sat);
+         }
+
+         std::vector< std::pair<int, Snapshot*> > fresh;
+         for(typename PendingMap::iterator it = pending.begin();
+             it != pending.end(); ++it)
+         {
+            Snapshot* s(it->second);
+            if(s->last < tmin) {
+               delete s;
+               s = 0;
+            }
+            else if(s->first < tcut) {
+               s->store.edit(tmin, CommonTime::END_OF_TIME);
+               s->first = tmin;
+            }
+            fresh.push_back(std::make_pair(it->first, s));
+         }
+         pending.clear();
+
+         swap(fresh);
+      }
+
+      /// Remove the data outside [tmin, tmax] from every Store, and make
+      /// all the pending updates visible.
+      void edit( const CommonTime& tmin,
+                 const CommonTime& tmax = CommonTime::END_OF_TIME )
+      {
+         for(int i = 0; i < NumIndex; i++) {
+            const Snapshot* cur(table[i]);
+            if(cur) workCopy(i, cur->sat);
+         }
+
+         std::vector< std::pair<int, Snapshot*> > fresh;
+         for(typename PendingMap::iterator it = pending.begin();
+             it != pending.end(); ++it)
+         {
+            Snapshot* s(it->second);
+            if(s->last < tmin || s->first > tmax) {
+               delete s;
+               s = 0;
+            }
+            else {
+               s->store.edit(tmin, tmax);
+               if(s->first < tmin) s->first = tmin;
+               if(s->last > tmax) s->last = tmax;
+            }
+            fresh.push_back(std::make_pair(it->first, s));
+         }
+         pending.clear();
+
+         swap(fresh);
+      }
+
+      /// Remove every satellite, including the pending updates
+      void clear(void)
+      {
+         discardPending();
+
+         std::vector< std::pair<int, Snapshot*> > fresh;
+         for(int i = 0; i < NumIndex; i++)
+            if(table[i]) fresh.push_back(std::make_pair(i, (Snapshot*)0));
+
+         swap(fresh);
+      }
+
+      /// Delete the replaced Stores that readers have left. publish() does
+      /// it, but a writer that seldom publishes may call it meanwhile.
+      /// @return the number of Stores deleted
+      size_t collect(void)
+      { return reclaimer.collect(); }
+
+      /// Number of replaced Stores not deleted yet
+      size_t numRetired(void) const
+      { return reclaimer.pending(); }
+
+      /// Length of the window (s)
+      double getWindow(void) const
+      { return windowLength; }
+
+      /// Set the length of the window (s), and the eviction slack to 1/8 of
+      /// it. Takes effect at the next publish().
+      void setWindow(double window)
+      { windowLength = window; evictSlack = window/8.0; }
+
+      /// Extra age (s) of the oldest data of a satellite before it is
+      /// evicted, so that Stores are not copied for every new record
+      double evictionSlack(void) const
+      { return evictSlack; }
+
+      /// Set the eviction slack (s)
+      void setEvictionSlack(double slack)
+      { evictSlack = slack; }
+
+      /// The Store given to new satellites
+      const Store& getPrototype(void) const
+      { return prototype; }
+
+      /// Dump the window, the satellites and their time spans; with
+      /// detail > 0, also the dump of each Store at detail-1.
+      void dump(std::ostream& os = std::cout, short detail = 0) const
+      {
+         ReadGuard guard(*this);
+         int n(0);
+         for(int i = 0; i < NumIndex; i++) if(table[i]) n++;
+
+         os << "Dump of RollingSatStore(" << detail << "):\n"
+            << " Window " << windowLength << " s, eviction slack "
+            << evictSlack << " s, " << n << " satellites, "
+            << reclaimer.pending() << " retired stores" << std::endl;
+
+         for(int i = 0; i < NumIndex; i++) {
+            const Snapshot* s(table[i]);
+            if(!s) continue;
+            os << " " << s->sat << " " << s->first << " - " << s->last
+               << std::endl;
+            if(detail > 0) s->store.dump(os, detail-1);
+         }
+
+         os << "End dump of RollingSatStore.\n";
+      }
+
+   protected:
+
+      /// The Store of one satellite, with the time span of its records
+      struct Snapshot
+      {
+         Snapshot(const Store& s, const SatID& id)
+            : store(s), sat(id),
+              first(CommonTime::END_OF_TIME),
+              last(CommonTime::BEGINNING_OF_TIME)
+         {}
+
+         Store store;
+         SatID sat;
+         CommonTime first;
+         CommonTime last;
+      };
+
+      typedef std::map<int, Snapshot*> PendingMap;
+
+      /// Largest satellite number, plus one
+      static const int MaxSatNumber = 256;
+
+      /// Size of the table, one entry per system and satellite number
+      static const int NumIndex = SatID::systemUnknown * MaxSatNumber;
+
+      /// Position of the satellite in the table, or -1 if out of range
+      static int indexOf(const SatID& sat)
+      {
+         if(sat.system < 1 || sat.system > SatID::systemUnknown ||
+            sat.id < 0 || sat.id >= MaxSatNumber) return -1;
+         return (sat.system - 1) * MaxSatNumber + sat.id;
+      }
+
+      /// Return the Store of the satellite from a read guard
+      /// @throw InvalidRequest if there is none
+      static const Store& storeOf(const ReadGuard& guard, const SatID& sat)
+      {
+         const Store* s(guard.find(sat));
+         if(!s) {
+            InvalidRequest e("Satellite " + StringUtils::asString(sat)
+                             + " not found.");
+            GPSTK_THROW(e);
+         }
+         return *s;
+      }
+
+      /// Return the pending copy of entry idx, making it if needed
+      Snapshot* workCopy(int idx, const SatID& sat)
+      {
+         typename PendingMap::iterator it(pending.find(idx));
+         if(it != pending.end()) return it->second;
+
+         const Snapshot* cur(table[idx]);
+         Snapshot* s(cur ? new Snapshot(*cur) : new Snapshot(prototype, sat));
+         pending[idx] = s;
+         return s;
+      }
+
+      /// Publish the given entries and retire the ones they replace
+      void swap(const std::vector< std::pair<int, Snapshot*> >& fresh)
+      {
+         // the new Stores must be complete before readers can see them
+#ifdef USE_OPENMP
+   #pragma omp flush
+#endif
+         std::vector<Snapshot*> old(fresh.size());
+         for(size_t i = 0; i < fresh.size(); i++) {
+            old[i] = table[fresh[i].first];
+            table[fresh[i].first] = fresh[i].second;
+         }
+
+         for(size_t i = 0; i < old.size(); i++)
+            reclaimer.retire(old[i], &deleteSnapshot);
+         reclaimer.collect();
+      }
+
+      /// Delete the pending copies
+      void discardPending(void)
+      {
+         for(typename PendingMap::iterator it = pending.begin();
+             it != pending.end(); ++it)
+            delete it->second;
+         pending.clear();
+      }
+
+      static void deleteSnapshot(void* p)
+      { delete static_cast<Snapshot*>(p); }
+
+      /// The published Stores, read by the readers
+      Snapshot* volatile* table;
+
+      /// The copies being updated by the writer, by table position
+      PendingMap pending;
+
+      Store prototype;
+
+      double windowLength;
+
+      double evictSlack;
+
+      mutable EpochReclaimer reclaimer;
+
+   private:
+
+      RollingSatStore(const RollingSatStore&);
+      RollingSatStore& operator=(const RollingSatStore&);
+
+   }; // End of class 'RollingSatStore'
+
+
+   /// A RollingSatStore seen as an XvtStore, so that the processing classes
+   /// (BasicModel, ComputeSatPCenter, ...) can read it while it is updated.
+   /// Store must be an XvtStore<SatID>, e.g. SP3EphemerisStore or
+   /// Rinex3EphemerisStore2.
+   template <class Store>
+   class RollingXvtStore : public XvtStore<SatID>,
+                           public RollingSatStore<Store>
+   {
+   public:
+
+      /// Constructor, see RollingSatStore
+      RollingXvtStore( const Store& proto = Store(),
+                       double window = 86400.0,
+                       int maxReaders = 128 )
+         : RollingSatStore<Store>(proto, window, maxReaders)
+      {}
+
+      virtual ~RollingXvtStore()
+      {}
+
+      virtual Xvt getXvt(const SatID& sat, const CommonTime& t) const
+      { return RollingSatStore<Store>::getXvt(sat, t); }
+
+      virtual void dump(std::ostream& s = std::cout, short detail = 0) const
+      { RollingSatStore<Store>::dump(s, detail); }
+
+      /// Writer only
+      virtual void edit( const CommonTime& tmin,
+                         const CommonTime& tmax = CommonTime::END_OF_TIME )
+      { RollingSatStore<Store>::edit(tmin, tmax); }
+
+      /// Writer only
+      virtual void clear(void)
+      { RollingSatStore<Store>::clear(); }
+
+      virtual TimeSystem getTimeSystem(void) const
+      { return this->prototype.getTimeSystem(); }
+
+      virtual CommonTime getInitialTime(void) const
+      { return RollingSatStore<Store>::getInitialTime(); }
+
+      virtual CommonTime getFinalTime(void) const
+      { return RollingSatStore<Store>::getFinalTime(); }
+
+      /// True if the Store of any satellite has velocities
+      virtual bool hasVelocity(void) const
+      {
+         typename RollingSatStore<Store>::ReadGuard guard(*this);
+         for(int i = 0; i < RollingSatStore<Store>::NumIndex; i++) {
+            const typename RollingSatStore<Store>::Snapshot* s(this->table[i]);
+            if(s && s->store.hasVelocity()) return true;
+         }
+         return false;
+      }
+
+      virtual bool isPresent(const SatID& sat) const
+      { return RollingSatStore<Store>::isPresent(sat); }
+
+   }; // End of class 'RollingXvtStore'
+
+   //@}
+
+}  // End of namespace gpstk
+
+#endif   // GPSTK_ROLLINGSATSTORE_HPP
@@ -43,6 +43,7 @@
 /// interpolation algorithm.
 
 #include <iostream>
+#include <iomanip>
 
 #include "Exception.hpp"
 #include "SatID.hpp"
@@ -62,6 +63,11 @@
 #include "PositionSatStore.hpp"
 
 #include "SP3EphemerisStore.hpp"
+#include "Counter.hpp"
+
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
 
 using namespace std;
 
@@ -69,7 +75,6 @@ namespace gpstk
 {
    using namespace StringUtils;
 
-
       // Returns the position, velocity, and clock offset of the indicated
       // object in ECEF coordinates (meters) at the indicated time.
       // param[in] sat the satellite of interest
@@ -242,6 +247,31 @@ namespace gpstk
    {
       try
       {
+         FileTable table;
+         parseSP3File(filename, fillClockStore, table);
+
+         LoadStats stats;
+         mergeFileTable(table, false, stats);
+      }
+      catch (Exception& e)
+      {
+         GPSTK_RETHROW(e);
+      }
+   }
+
+      // Parse an SP3 file into a table of records, without touching the stores.
+   void SP3EphemerisStore::parseSP3File(const string& filename,
+                                        bool fillClockStore,
+                                        FileTable& table) const
+      throw(Exception)
+   {
+      try
+      {
+         table.filename = filename;
+         table.isSP3 = true;
+         table.records.clear();
+         table.numRejected = 0;
+
             // open the input stream
          SP3Stream strm(filename.c_str());
          if (!strm)
@@ -253,7 +283,7 @@ namespace gpstk
             //cout << "Opened file " << filename << endl;
 
             // declare header and data
-         SP3Header head;
+         SP3Header& head(table.sp3Head);
 
             // read the SP3 ephemeris header
          try
@@ -267,50 +297,19 @@ namespace gpstk
          }
             //cout << "Read header" << endl; head.dump();
 
-            // check/save TimeSystem to storeTimeSystem
-         if(head.timeSystem != TimeSystem::Any &&
-            head.timeSystem != TimeSystem::Unknown)
-         {
-               // if store time system has not been set, do so
-            if(storeTimeSystem == TimeSystem::Any)
-            {
-                  // NB. store-, pos- and clk- TimeSystems must always be the same
-               storeTimeSystem = head.timeSystem;
-               posStore.setTimeSystem(head.timeSystem);
-               clkStore.setTimeSystem(head.timeSystem);
-            }
-
-               // if store system has been set, and it doesn't agree, throw
-            else if(storeTimeSystem != head.timeSystem)
-            {
-               InvalidRequest ir("Time system of file " + filename
-                                 + " (" + head.timeSystem.asString()
-                                 + ") is incompatible with store time system ("
-                                 + storeTimeSystem.asString() + ").");
-               GPSTK_THROW(ir);
-            }
-         }  // end if header time system is set
-
-            // save in FileStore
-         SP3Files.addFile(filename, head);
-
             // read data
          bool isC(head.version==SP3Header::SP3c);
          bool goNext,haveP,haveV,haveEP,haveEV,predP,predC;
          int i;
-         CommonTime ttag;
-         SatID sat;
          SP3Data data;
-         PositionRecord prec;
-         ClockRecord crec;
+         FileRecord rec;
+         PositionRecord& prec(rec.prec);
+         ClockRecord& crec(rec.crec);
 
          prec.Pos = prec.sigPos = prec.Vel = prec.sigVel = prec.Acc = prec.sigAcc
             = Triple(0,0,0);
-         if(fillClockStore)
-         {
-            crec.bias = crec.drift = crec.sig_bias = crec.sig_drift = 0.0;
-            crec.accel = crec.sig_accel = 0.0;
-         }
+         crec.bias = crec.drift = crec.sig_bias = crec.sig_drift = 0.0;
+         crec.accel = crec.sig_accel = 0.0;
 
          try
          {
@@ -339,7 +338,7 @@ namespace gpstk
                         goNext = false;
                      else
                      {
-                        ttag = data.time;
+                        rec.ttag = data.time;
                         goNext = true;
                      }
                   }
@@ -351,7 +350,7 @@ namespace gpstk
                         goNext = false;
                      else
                      {
-                        sat = data.sat;
+                        rec.sat = data.sat;
                         for(i=0; i<3; i++)
                         {
                            prec.Pos[i] = data.x[i]; // km
@@ -467,26 +466,27 @@ namespace gpstk
                   {
                         //cout << "Bad position" << endl;
                      haveP = haveV = haveEV = haveEP = false; // bad position record
+                     table.numRejected++;
                   }
                   else if(fillClockStore && rejectBadClockFlag
                           && crec.bias >= 999999.)
                   {
                         //cout << "Bad clock" << endl;
                      haveP = haveV = haveEV = haveEP = false; // bad clock record
+                     table.numRejected++;
                   }
                   else
                   {
                         //cout << "Add rec: " << sat << " " << ttag << " " << prec<<endl;
-                     if(!rejectPredPosFlag || !predP)
-                        posStore.addPositionRecord(sat,ttag,prec);
-                     if(fillClockStore && (!rejectPredClockFlag || !predC))
-                        clkStore.addClockRecord(sat,ttag,crec);
+                     rec.addPos = (!rejectPredPosFlag || !predP);
+                     rec.addClock = (fillClockStore && (!rejectPredClockFlag || !predC));
+                     if(rec.addPos || rec.addClock)
+                        table.records.push_back(rec);
 
                         // prepare for next
                      haveP = haveV = haveEP = haveEV = predP = predC = false;
                      prec.Pos = prec.Vel = prec.sigPos = prec.sigVel = Triple(0,0,0);
-                     if(fillClockStore)
-                        crec.bias = crec.drift = crec.sig_bias = crec.sig_drift = 0.0;
+                     crec.bias = crec.drift = crec.sig_bias = crec.sig_drift = 0.0;
                   }
 
                   goNext = true;
@@ -502,20 +502,20 @@ namespace gpstk
                    prec.Pos[2]==0.0) )
                {
                      //cout << "Bad last rec: position" << endl;
-                  ;
+                  table.numRejected++;
                }
                else if(fillClockStore && rejectBadClockFlag && crec.bias >= 999999.)
                {
                      //cout << "Bad last rec: clock" << endl;
-                  ;
+                  table.numRejected++;
                }
                else
                {
                      //cout << "Add last rec: "<< sat <<" "<< ttag <<" "<< prec << endl;
-                  if(!rejectPredPosFlag || !predP)
-                     posStore.addPositionRecord(sat,ttag,prec);
-                  if(fillClockStore && (!rejectPredClockFlag || !predC))
-                     clkStore.addClockRecord(sat,ttag,crec);
+                  rec.addPos = (!rejectPredPosFlag || !predP);
+                  rec.addClock = (fillClockStore && (!rejectPredClockFlag || !predC));
+                  if(rec.addPos || rec.addClock)
+                     table.records.push_back(rec);
                }
             }
          }
@@ -545,6 +545,199 @@ namespace gpstk
       }
    }
 
+      // Parse a RINEX clock file into a table of records, without touching the
+      // stores.
+   void SP3EphemerisStore::parseRinexClockFile(const string& filename,
+                                               FileTable& table) const
+      throw(Exception)
+   {
+      try
+      {
+         table.filename = filename;
+         table.isSP3 = false;
+         table.records.clear();
+         table.numRejected = 0;
+
+            // open the input stream
+         Rinex3ClockStream strm(filename.c_str());
+         if(!strm.is_open())
+         {
+            Exception e("File " + filename + " could not be opened");
+            GPSTK_THROW(e);
+         }
+         strm.exceptions(std::ios::failbit);
+
+            // declare header and data
+         Rinex3ClockHeader& head(table.clkHead);
+         Rinex3ClockData data;
+
+            // read the RINEX clock header
+         try
+         {
+            strm >> head;
+         }
+         catch(Exception& e)
+         {
+            e.addText("Error reading header of file " + filename);
+            GPSTK_RETHROW(e);
+         }
+
+            // there is no way to determine the time system....this is a problem TD
+         TimeSystem ts(head.timeSystem);
+         if(ts == TimeSystem::Any || ts == TimeSystem::Unknown)
+            ts = TimeSystem::GPS;
+
+            // read data
+         try
+         {
+            FileRecord rec;
+            rec.addPos = false;
+            rec.addClock = true;
+
+            while(strm >> data)
+            {
+               if(data.datatype == std::string("AS"))
+               {
+                  rec.sat = data.sat;
+                  rec.ttag = data.time;
+                  rec.ttag.setTimeSystem(ts);
+                  rec.crec.bias = data.bias;
+                  rec.crec.sig_bias = data.sig_bias;
+                  rec.crec.drift = data.drift;
+                  rec.crec.sig_drift = data.sig_drift;
+                  rec.crec.accel = data.accel;
+                  rec.crec.sig_accel = data.sig_accel;
+                  table.records.push_back(rec);
+               }
+            }
+         }
+         catch(Exception& e)
+         {
+            e.addText("Error reading data of file " + filename);
+            GPSTK_RETHROW(e);
+         }
+
+         strm.close();
+
+      }
+      catch(Exception& e)
+      {
+         GPSTK_RETHROW(e);
+      }
+   }
+
+      // Add a parsed SP3 or RINEX clock file to the stores.
+   void SP3EphemerisStore::mergeFileTable(const FileTable& table,
+                                          bool skipDuplicates,
+                                          LoadStats& stats)
+      throw(Exception)
+   {
+      try
+      {
+         TimeSystem ts(table.isSP3 ? table.sp3Head.timeSystem
+                                   : table.clkHead.timeSystem);
+
+            // check/save TimeSystem to storeTimeSystem
+         if(ts != TimeSystem::Any && ts != TimeSystem::Unknown)
+         {
+               // if store time system has not been set, do so
+            if(storeTimeSystem == TimeSystem::Any)
+            {
+                  // NB. store-, pos- and clk- TimeSystems must always be the same
+               storeTimeSystem = ts;
+               posStore.setTimeSystem(ts);
+               clkStore.setTimeSystem(ts);
+            }
+
+               // if store system has been set, and it doesn't agree, throw
+            else if(storeTimeSystem != ts)
+            {
+               InvalidRequest ir("Time system of file " + table.filename
+                                 + " (" + ts.asString()
+                                 + ") is incompatible with store time system ("
+                                 + storeTimeSystem.asString() + ").");
+               GPSTK_THROW(ir);
+            }
+         }  // end if header time system is set
+
+            // RINEX clock files with no time system are taken as GPS
+         else if(!table.isSP3)
+         {
+            storeTimeSystem = TimeSystem::GPS;
+            posStore.setTimeSystem(storeTimeSystem);
+            clkStore.setTimeSystem(storeTimeSystem);
+         }
+
+            // save in FileStore
+         if(table.isSP3)
+         {
+            SP3Header head(table.sp3Head);
+            SP3Files.addFile(table.filename, head);
+         }
+         else
+         {
+            Rinex3ClockHeader head(table.clkHead);
+            if(ts == TimeSystem::Any || ts == TimeSystem::Unknown)
+               head.timeSystem = TimeSystem::GPS;
+            clkFiles.addFile(table.filename, head);
+         }
+
+         stats.numRejected += table.numRejected;
+
+            // duplicates can only be up to the last epochs of the stores
+            // before this file, where the file overlaps them
+         bool checkPos(false), checkClock(false);
+         CommonTime lastPos, lastClock;
+         if(skipDuplicates)
+         {
+            lastPos = posStore.getFinalTime();
+            lastClock = clkStore.getFinalTime();
+         }
+
+         for(size_t i = 0; i < table.records.size(); i++)
+         {
+            const FileRecord& rec(table.records[i]);
+
+            if(skipDuplicates)
+            {
+               checkPos = (rec.ttag <= lastPos);
+               checkClock = (rec.ttag <= lastClock);
+            }
+
+            if(rec.addPos)
+            {
+               if(checkPos && posStore.hasRecord(rec.sat, rec.ttag))
+               {
+                  stats.numDuplicates++;
+               }
+               else
+               {
+                  posStore.addPositionRecord(rec.sat, rec.ttag, rec.prec);
+                  stats.numPosRecords++;
+               }
+            }
+
+            if(rec.addClock)
+            {
+               if(checkClock && clkStore.hasRecord(rec.sat, rec.ttag))
+               {
+                  stats.numDuplicates++;
+               }
+               else
+               {
+                  clkStore.addClockRecord(rec.sat, rec.ttag, rec.crec);
+                  stats.numClockRecords++;
+               }
+            }
+         }
+      }
+      catch(Exception& e)
+      {
+         GPSTK_RETHROW(e);
+      }
+   }
+
+
       // Load an SP3 ephemeris file; if the clock store uses RINEX clock files,
       // this routine will also accept that file type and load the data into the
       // clock store. This routine will may set the velocity, acceleration, bias
@@ -617,99 +810,104 @@ namespace gpstk
       {
          if(useSP3clock) useRinexClockData();
 
-            // open the input stream
-         Rinex3ClockStream strm(filename.c_str());
-         if(!strm.is_open())
-         {
-            Exception e("File " + filename + " could not be opened");
-            GPSTK_THROW(e);
-         }
-         strm.exceptions(std::ios::failbit);
-            //cout << "Opened file " << filename << endl;
+         FileTable table;
+         parseRinexClockFile(filename, table);
 
-            // declare header and data
-         Rinex3ClockHeader head;
-         Rinex3ClockData data;
+         LoadStats stats;
+         mergeFileTable(table, false, stats);
+      }
+      catch(Exception& e)
+      {
+         GPSTK_RETHROW(e);
+      }
+   }
 
-            // read the RINEX clock header
-         try
-         {
-            strm >> head;
-         }
-         catch(Exception& e)
-         {
-            e.addText("Error reading header of file " + filename);
-            GPSTK_RETHROW(e);
-         }
-            //cout << "Read header" << endl; head.dump();
+      // Load many SP3 and RINEX clock files: parse them concurrently, then add
+      // them to the stores in time order, leaving out the duplicated epochs.
+   SP3EphemerisStore::LoadStats SP3EphemerisStore::loadFiles(
+                                             const vector<string>& sp3Files,
+                                             const vector<string>& clockFiles)
+      throw(Exception)
+   {
+      try
+      {
+         LoadStats stats;
 
-            // check/save TimeSystem to storeTimeSystem
-         if(head.timeSystem != TimeSystem::Any &&
-            head.timeSystem != TimeSystem::Unknown)
+         if(!clockFiles.empty() && useSP3clock) useRinexClockData();
+
+         const int numSP3(sp3Files.size());
+         const int numFiles(numSP3 + clockFiles.size());
+         stats.numFiles = numFiles;
+
+         vector<FileTable> tables(numFiles);
+         vector<string> errors(numFiles);
+         const bool fillClockStore(useSP3clock);
+
+         double t0(Counter::now());
+
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+         for(int i = 0; i < numFiles; i++)
          {
-               // if store time system has not been set, do so
-            if(storeTimeSystem == TimeSystem::Any)
+            try
             {
-                  // NB. store-, pos- and clk- TimeSystems must always be the same
-               storeTimeSystem = head.timeSystem;
-               posStore.setTimeSystem(head.timeSystem);
-               clkStore.setTimeSystem(head.timeSystem);
+               if(i < numSP3)
+                  parseSP3File(sp3Files[i], fillClockStore, tables[i]);
+               else
+                  parseRinexClockFile(clockFiles[i-numSP3], tables[i]);
             }
-
-               // if store system has been set, and it doesn't agree, throw
-            else if(storeTimeSystem != head.timeSystem)
+            catch(Exception& e)
             {
-               InvalidRequest ir("Time system of file " + filename
-                                 + " (" + head.timeSystem.asString()
-                                 + ") is incompatible with store time system ("
-                                 + storeTimeSystem.asString() + ").");
-               GPSTK_THROW(ir);
+               errors[i] = e.getText();
+               if(errors[i].empty()) errors[i] = "unknown error";
+               tables[i].records.clear();
             }
-         }  // end if header time system is set
-
-            // there is no way to determine the time system....this is a problem TD
-            // TD SP3EphemerisStore::fixTimeSystem() ??
-         else
-         {
-            head.timeSystem = TimeSystem::GPS;
-            storeTimeSystem = head.timeSystem;
-            posStore.setTimeSystem(head.timeSystem);
-            clkStore.setTimeSystem(head.timeSystem);
          }
 
-            // save in FileStore
-         clkFiles.addFile(filename, head);
+         double t1(Counter::now());
+         stats.parseSeconds = t1 - t0;
 
-            // read data
-         try
+            // sort the files by their first epoch
+         vector< pair<CommonTime, int> > order;
+         for(int i = 0; i < numFiles; i++)
          {
-            while(strm >> data)
+            if(errors[i].empty())
             {
-                  //data.dump(cout);
-
-               if(data.datatype == std::string("AS"))
-               {
-                  data.time.setTimeSystem(head.timeSystem);
-                  // add this data
-                  ClockRecord rec;
-                  rec.bias = data.bias;
-                  rec.sig_bias = data.sig_bias;
-                  rec.drift = data.drift;
-                  rec.sig_drift = data.sig_drift;
-                  rec.accel = data.accel;
-                  rec.sig_accel = data.sig_accel;
-                  clkStore.addClockRecord(data.sat, data.time, rec);
-               }
+               order.push_back( make_pair( tables[i].records.empty() ?
+                                              CommonTime::END_OF_TIME :
+                                              tables[i].records[0].ttag, i ) );
+            }
+            else
+            {
+               stats.numFailed++;
+               stats.failedFiles.push_back(
+                  (i < numSP3 ? sp3Files[i] : clockFiles[i-numSP3])
+                  + ": " + errors[i]);
             }
          }
-         catch(Exception& e)
+         sort(order.begin(), order.end());
+
+         for(size_t k = 0; k < order.size(); k++)
          {
-            e.addText("Error reading data of file " + filename);
-            GPSTK_RETHROW(e);
+            FileTable& table(tables[order[k].second]);
+            try
+            {
+               mergeFileTable(table, true, stats);
+            }
+            catch(Exception& e)
+            {
+               stats.numFailed++;
+               stats.failedFiles.push_back(table.filename + ": " + e.getText());
+            }
+
+               // free the memory of this file at once
+            vector<FileRecord>().swap(table.records);
          }
 
-         strm.close();
+         stats.mergeSeconds = Counter::now() - t1;
 
+         return stats;
       }
       catch(Exception& e)
       {
@@ -717,6 +915,25 @@ namespace gpstk
       }
    }
 
+      // Print the statistics of loadFiles()
+   void SP3EphemerisStore::LoadStats::dump(ostream& os) const
+   {
+      os << "Loaded " << (numFiles - numFailed) << " of " << numFiles
+         << " files: " << numPosRecords << " position and "
+         << numClockRecords << " clock records, "
+         << numDuplicates << " duplicates and "
+         << numRejected << " bad records left out" << endl;
+      ios::fmtflags oldFlags(os.flags());
+      streamsize oldPrecision(os.precision());
+      os << fixed << setprecision(3)
+         << "Parsing " << parseSeconds << " s, merging "
+         << mergeSeconds << " s" << endl;
+      os.flags(oldFlags);
+      os.precision(oldPrecision);
+      for(size_t i = 0; i < failedFiles.size(); i++)
+         os << "Failed " << failedFiles[i] << endl;
+   }
+
       //@}
 
 }  // End of namespace gpstk
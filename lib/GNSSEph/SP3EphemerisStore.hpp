@@ -76,6 +76,31 @@ namespace gpstk
    class SP3EphemerisStore : public XvtStore<SatID>
    {
 
+   public:
+
+         /// Statistics of loadFiles()
+      struct LoadStats
+      {
+         LoadStats() : numFiles(0), numFailed(0), numPosRecords(0),
+                       numClockRecords(0), numDuplicates(0), numRejected(0),
+                       parseSeconds(0.0), mergeSeconds(0.0)
+         { }
+
+         int numFiles;            ///< files given
+         int numFailed;           ///< files which could not be loaded
+         long numPosRecords;      ///< position records added
+         long numClockRecords;    ///< clock records added
+         long numDuplicates;      ///< records of a satellite and epoch
+                                  ///< given by an earlier file, left out
+         long numRejected;        ///< bad positions or clocks left out
+         double parseSeconds;     ///< wall time parsing the files
+         double mergeSeconds;     ///< wall time adding them to the stores
+         std::vector<std::string> failedFiles;   ///< "file: error"
+
+            /// Print the statistics
+         void dump(std::ostream& os = std::cout) const;
+      };
+
          // member data
    private:
          /** Time system for this store. Must set, and keep
@@ -132,6 +157,55 @@ namespace gpstk
       void loadSP3Store(const std::string& filename, bool fillClockStore)
          throw(Exception);
 
+         /// One record of an SP3 or RINEX clock file, parsed before being
+         /// added to the stores.
+      struct FileRecord
+      {
+         SatID sat;
+         CommonTime ttag;
+         PositionRecord prec;
+         ClockRecord crec;
+         bool addPos;      ///< whether prec goes to the position store
+         bool addClock;    ///< whether crec goes to the clock store
+      };
+
+         /// All the records of one SP3 or RINEX clock file.
+      struct FileTable
+      {
+         std::string filename;
+         bool isSP3;
+         SP3Header sp3Head;
+         Rinex3ClockHeader clkHead;
+         std::vector<FileRecord> records;
+         long numRejected;   ///< bad positions or clocks left out
+      };
+
+         /** Parse an SP3 file into a table, without touching the
+          * stores, so several files may be parsed at once. */
+      void parseSP3File(const std::string& filename, bool fillClockStore,
+                        FileTable& table) const
+         throw(Exception);
+
+         /** Parse a RINEX clock file into a table, without touching the
+          * stores, so several files may be parsed at once. */
+      void parseRinexClockFile(const std::string& filename,
+                               FileTable& table) const
+         throw(Exception);
+
+         /** Add a parsed file to the stores: check the time system, save
+          * the header in the FileStore and add the records.
+          * @param table parsed file
+          * @param skipDuplicates if true, records of a satellite and
+          *    epoch the store already has are duplicates and left out.
+          *    Only the records up to the last epoch of the store, where
+          *    the file overlaps it, are looked up.
+          * @param stats incremented with the records added, left out
+          *    as duplicates and rejected */
+      void mergeFileTable(const FileTable& table,
+                          bool skipDuplicates,
+                          LoadStats& stats)
+         throw(Exception);
+
    public:
 
          /// Default constructor
@@ -552,6 +626,25 @@ namespace gpstk
           * @throw if time step is inconsistent with previous value */
       void loadRinexClockFile(const std::string& filename) throw(Exception);
 
+         /** Load many SP3 and RINEX clock files, e.g. a week of orbits,
+          * 30 s and high-rate clocks. The files are parsed concurrently
+          * (with OpenMP) into separate tables, which are then added to the
+          * stores in time order. A record whose satellite and epoch the
+          * same store already has, from an earlier file (e.g. 24:00 of one
+          * day and 00:00 of the next) or loaded before, is left out, the
+          * earlier one being kept; records of other epochs, like the
+          * high-rate clocks of a file overlapping a 30 s one, are all
+          * added. If any
+          * clock file is given, the clock store uses RINEX clock data, as
+          * in loadRinexClockFile(). Files which can not be loaded are
+          * reported in the statistics, and do not stop the others.
+          * @param sp3Files names of the SP3 files
+          * @param clockFiles names of the RINEX clock files
+          * @return load statistics */
+      LoadStats loadFiles(const std::vector<std::string>& sp3Files,
+                          const std::vector<std::string>& clockFiles)
+         throw(Exception);
+
 
          /** Add a complete PositionRecord to the store; this is the
           * preferred method of adding data to the tables.
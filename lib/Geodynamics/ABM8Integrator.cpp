@@ -0,0 +1,479 @@
+//============================================================================
+//
+//  This file is part of GPSTk, the GPS Toolkit.
+//
+//  The GPSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 3.0 of the License, or
+//  any later version.
+//
+//  The GPSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GPSTk; if not, write to the Free Software Foundation,
+//  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+//
+//============================================================================
+
+/**
+ * @file ABM8Integrator.cpp
+ * Adams-Bashforth-Moulton 8-th order integrator with per-satellite
+ * history, automatic RKF78 startup and dense output.
+ */
+
+#include <cmath>
+
+#include "ABM8Integrator.hpp"
+#include "AdamsIntegrator.hpp"
+#include "RKF78Integrator.hpp"
+
+using namespace std;
+
+namespace gpstk
+{
+
+    // Default constructor
+    ABM8Integrator::ABM8Integrator(double step)
+        : Integrator(step),
+          direction(1.0),
+          startupSubsteps(5),
+          errorTol(1e-6),
+          restartThreshold(1e-5),
+          head(0)
+    {
+        // Lagrange polynomials on the nodes u_k = -k, k = 0..8,
+        // coefficients in increasing powers of u
+        for(int j=0; j<9; ++j)
+        {
+            double p[9] = { 1.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+            int deg(0);
+
+            for(int k=0; k<9; ++k)
+            {
+                if(k == j) continue;
+
+                // p *= (u + k)/(k - j)
+                double scale( 1.0/double(k - j) );
+                ++deg;
+                for(int c=deg; c>=0; --c)
+                {
+                    double lower( (c > 0) ? p[c-1] : 0.0 );
+                    p[c] = (lower + k*p[c])*scale;
+                }
+            }
+
+            for(int c=0; c<9; ++c) lagrange[j][c] = p[c];
+        }
+
+    }  // End of constructor 'ABM8Integrator::ABM8Integrator()'
+
+
+    // Add satellites, starting them with RKF78.
+    ABM8Integrator& ABM8Integrator::addSatellites( const CommonTime& time,
+                                                   const satVectorMap& states )
+    {
+        if( !states.empty() ) startup(time, states);
+
+        return (*this);
+
+    }  // End of method 'ABM8Integrator::addSatellites()'
+
+
+    // Remove a satellite
+    ABM8Integrator& ABM8Integrator::removeSatellite(const SatID& sat)
+    {
+        satHistory.erase(sat);
+
+        return (*this);
+
+    }  // End of method 'ABM8Integrator::removeSatellite()'
+
+
+    // Get the satellites being integrated
+    SatIDSet ABM8Integrator::getSatellites() const
+    {
+        SatIDSet sats;
+
+        for(map<SatID,SatHistory>::const_iterator it = satHistory.begin();
+            it != satHistory.end();
+            ++it)
+        {
+            sats.insert(it->first);
+        }
+
+        return sats;
+
+    }  // End of method 'ABM8Integrator::getSatellites()'
+
+
+    // Get the states at the current grid point
+    satVectorMap ABM8Integrator::getCurrentState() const
+    {
+        satVectorMap states;
+
+        for(map<SatID,SatHistory>::const_iterator it = satHistory.begin();
+            it != satHistory.end();
+            ++it)
+        {
+            const SatHistory& sh(it->second);
+
+            Vector<double> y(sh.n);
+            for(int c=0; c<sh.n; ++c) y[c] = sh.y[c];
+
+            states[it->first] = y;
+        }
+
+        return states;
+
+    }  // End of method 'ABM8Integrator::getCurrentState()'
+
+
+    // Step the grid until it covers 't_next', and return the states
+    // of all the satellites interpolated at 't_next'.
+    satVectorMap ABM8Integrator::integrateTo(const CommonTime& t_next)
+    {
+        if( satHistory.empty() )
+        {
+            t_curr = t_next;
+            return satVectorMap();
+        }
+
+        while( direction*(t_next - t_curr) > 0.0 )
+        {
+            step();
+        }
+
+        return getState(t_next);
+
+    }  // End of method 'ABM8Integrator::integrateTo()'
+
+
+    // Get the states interpolated at a time within the last 8 steps,
+    // without stepping.
+    satVectorMap ABM8Integrator::getState(const CommonTime& time) const
+        throw(InvalidRequest)
+    {
+        double h( direction*stepSize );
+        double s( (time - t_curr)/h );
+
+        if( s > 1e-9 || s < -8.0-1e-9 )
+        {
+            InvalidRequest e("ABM8Integrator: time out of the history.");
+            GPSTK_THROW(e);
+        }
+
+        double w[9];
+        denseWeights(s, w);
+
+        satVectorMap states;
+
+        for(map<SatID,SatHistory>::const_iterator it = satHistory.begin();
+            it != satHistory.end();
+            ++it)
+        {
+            const SatHistory& sh(it->second);
+            const int n(sh.n);
+
+            Vector<double> y(n);
+            for(int c=0; c<n; ++c) y[c] = sh.y[c];
+
+            for(int j=0; j<9; ++j)
+            {
+                const double* fj( &sh.f[ ((head-j+9)%9)*n ] );
+                double hw( h*w[j] );
+                for(int c=0; c<n; ++c) y[c] += hw*fj[c];
+            }
+
+            states[it->first] = y;
+        }
+
+        return states;
+
+    }  // End of method 'ABM8Integrator::getState()'
+
+
+    // Advance all the satellites one step
+    void ABM8Integrator::step()
+    {
+        const double h( direction*stepSize );
+        const double hc( h/3628800.0 );
+
+        CommonTime t_prev(t_curr);
+        CommonTime t_next(t_curr + h);
+
+        // Prediction
+        satVectorMap yp;
+
+        for(map<SatID,SatHistory>::const_iterator it = satHistory.begin();
+            it != satHistory.end();
+            ++it)
+        {
+            const SatHistory& sh(it->second);
+            const int n(sh.n);
+
+            Vector<double> y(n);
+            for(int c=0; c<n; ++c) y[c] = sh.y[c];
+
+            for(int i=0; i<9; ++i)
+            {
+                const double* fi( &sh.f[ ((head-i+9)%9)*n ] );
+                double ci( hc*AdamsIntegrator::cb[i] );
+                for(int c=0; c<n; ++c) y[c] += ci*fi[c];
+            }
+
+            yp[it->first] = y;
+        }
+
+        // Derivatives at t(n+1), computed with yp
+        satVectorMap fp( pEOM->getDerivatives(t_next, yp) );
+
+        // Correction
+        satVectorMap yc;
+        satVectorMap restart;
+
+        for(map<SatID,SatHistory>::const_iterator it = satHistory.begin();
+            it != satHistory.end();
+            ++it)
+        {
+            const SatID& sat(it->first);
+            const SatHistory& sh(it->second);
+            const int n(sh.n);
+
+            Vector<double> y(n);
+            for(int c=0; c<n; ++c) y[c] = sh.y[c];
+
+            const Vector<double>& f1( fp[sat] );
+            y += (hc*AdamsIntegrator::cm[0])*f1;
+
+            for(int i=1; i<9; ++i)
+            {
+                const double* fi( &sh.f[ ((head-i+1+9)%9)*n ] );
+                double ci( hc*AdamsIntegrator::cm[i] );
+                for(int c=0; c<n; ++c) y[c] += ci*fi[c];
+            }
+
+            const Vector<double>& pred( yp[sat] );
+            double dx( y[0]-pred[0] ), dy( y[1]-pred[1] ), dz( y[2]-pred[2] );
+
+            if( std::sqrt(dx*dx + dy*dy + dz*dz) > restartThreshold )
+            {
+                Vector<double> y0(n);
+                for(int c=0; c<n; ++c) y0[c] = sh.y[c];
+                restart[sat] = y0;
+            }
+
+            yc[sat] = y;
+        }
+
+        // Derivatives at t(n+1), computed with yc
+        satVectorMap fc( pEOM->getDerivatives(t_next, yc) );
+
+        head = (head+1)%9;
+
+        for(map<SatID,SatHistory>::iterator it = satHistory.begin();
+            it != satHistory.end();
+            ++it)
+        {
+            SatHistory& sh(it->second);
+            const int n(sh.n);
+
+            const Vector<double>& y( yc[it->first] );
+            const Vector<double>& f( fc[it->first] );
+
+            double* fh( &sh.f[head*n] );
+            for(int c=0; c<n; ++c)
+            {
+                sh.y[c] = y[c];
+                fh[c] = f[c];
+            }
+        }
+
+        t_curr = t_next;
+
+        // Satellites with a bad prediction start again from t(n)
+        if( !restart.empty() ) startup(t_prev, restart);
+
+    }  // End of method 'ABM8Integrator::step()'
+
+
+    // Start satellites: integrate them to 't_curr' and fill their
+    // derivative history.
+    void ABM8Integrator::startup( const CommonTime& time,
+                                  const satVectorMap& states )
+    {
+        if( satHistory.empty() )
+        {
+            t_curr = time;
+            head = 0;
+        }
+
+        satVectorMap y( rkfPropagate(time, states, t_curr) );
+
+        // Derivative history, integrating backwards from t_curr
+        CommonTime tb(t_curr);
+
+        for(int j=0; j<9; ++j)
+        {
+            if(j > 0)
+            {
+                CommonTime tn( tb - direction*stepSize );
+                y = rkfPropagate(tb, y, tn);
+                tb = tn;
+            }
+
+            satVectorMap f( pEOM->getDerivatives(tb, y) );
+
+            const int slot( (head-j+9)%9 );
+
+            for(satVectorMap::const_iterator it = f.begin();
+                it != f.end();
+                ++it)
+            {
+                SatHistory& sh( satHistory[it->first] );
+                const Vector<double>& fj(it->second);
+
+                if(j == 0)
+                {
+                    const Vector<double>& yj( y[it->first] );
+
+                    sh.n = yj.size();
+                    sh.y.assign( yj.begin(), yj.end() );
+                    sh.f.assign( 9*sh.n, 0.0 );
+                }
+
+                for(int c=0; c<sh.n; ++c) sh.f[slot*sh.n + c] = fj[c];
+            }
+        }
+
+    }  // End of method 'ABM8Integrator::startup()'
+
+
+    // Integrate with RKF78, in substeps, from t0 to t1
+    satVectorMap ABM8Integrator::rkfPropagate( const CommonTime& t0,
+                                               const satVectorMap& y0,
+                                               const CommonTime& t1 )
+    {
+        double span(t1 - t0);
+
+        if(span == 0.0) return y0;
+
+        double sub( stepSize/startupSubsteps );
+        int ns( int( std::ceil(std::abs(span)/sub - 1e-9) ) );
+        if(ns < 1) ns = 1;
+
+        double h(span/ns);
+
+        satVectorMap y(y0);
+        CommonTime t(t0);
+
+        for(int i=0; i<ns; ++i)
+        {
+            y = rkfStep(t, y, h);
+            t = t0 + (i+1)*h;
+        }
+
+        return y;
+
+    }  // End of method 'ABM8Integrator::rkfPropagate()'
+
+
+    // One RKF78 step of size h, halved while the error is too big
+    satVectorMap ABM8Integrator::rkfStep( const CommonTime& t,
+                                          const satVectorMap& y,
+                                          double h )
+    {
+        const double (&a)[13] = RKF78Integrator::a;
+        const double (&b)[13][12] = RKF78Integrator::b;
+        const double (&c1)[13] = RKF78Integrator::c1;
+        const double (&c2)[13] = RKF78Integrator::c2;
+
+        satVectorMap k[13];
+
+        k[0] = pEOM->getDerivatives(t, y);
+
+        for(int i=1; i<13; ++i)
+        {
+            satVectorMap yi(y);
+
+            for(satVectorMap::iterator it = yi.begin();
+                it != yi.end();
+                ++it)
+            {
+                for(int j=0; j<i; ++j)
+                {
+                    if(b[i][j] != 0.0)
+                    {
+                        it->second += (h*b[i][j])*(k[j])[it->first];
+                    }
+                }
+            }
+
+            k[i] = pEOM->getDerivatives(t + a[i]*h, yi);
+        }
+
+        // Error of the 7-th order solution
+        double err(0.0);
+
+        for(satVectorMap::const_iterator it = y.begin();
+            it != y.end();
+            ++it)
+        {
+            const SatID& sat(it->first);
+
+            for(int c=0; c<3; ++c)
+            {
+                double e( c1[0]*h*( (k[0])[sat][c] + (k[10])[sat][c]
+                                  - (k[11])[sat][c] - (k[12])[sat][c] ) );
+                err = std::max( err, std::abs(e) );
+            }
+        }
+
+        if( err > errorTol && std::abs(h) > 1.0 )
+        {
+            satVectorMap yh( rkfStep(t, y, 0.5*h) );
+            return rkfStep(t + 0.5*h, yh, 0.5*h);
+        }
+
+        satVectorMap y_next(y);
+
+        for(satVectorMap::iterator it = y_next.begin();
+            it != y_next.end();
+            ++it)
+        {
+            for(int i=0; i<13; ++i)
+            {
+                if(c2[i] != 0.0)
+                {
+                    it->second += (h*c2[i])*(k[i])[it->first];
+                }
+            }
+        }
+
+        return y_next;
+
+    }  // End of method 'ABM8Integrator::rkfStep()'
+
+
+    // Weights of the derivative history to integrate from 't_curr'
+    // to 't_curr + s*h'
+    void ABM8Integrator::denseWeights(double s, double w[9]) const
+    {
+        for(int j=0; j<9; ++j)
+        {
+            double sum(0.0), sp(s);
+
+            for(int c=0; c<9; ++c)
+            {
+                sum += lagrange[j][c]*sp/(c+1);
+                sp *= s;
+            }
+
+            w[j] = sum;
+        }
+
+    }  // End of method 'ABM8Integrator::denseWeights()'
+
+}  // End of 'namespace gpstk'
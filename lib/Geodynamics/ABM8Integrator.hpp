@@ -0,0 +1,233 @@
+//============================================================================
+//
+//  This file is part of GPSTk, the GPS Toolkit.
+//
+//  The GPSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 3.0 of the License, or
+//  any later version.
+//
+//  The GPSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GPSTk; if not, write to the Free Software Foundation,
+//  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+//
+//============================================================================
+
+/**
+ * @file ABM8Integrator.hpp
+ * Adams-Bashforth-Moulton 8-th order integrator with per-satellite
+ * history, automatic RKF78 startup and dense output.
+ */
+
+#ifndef ABM8_INTEGRATOR_HPP
+#define ABM8_INTEGRATOR_HPP
+
+#include <vector>
+#include <map>
+
+#include "Integrator.hpp"
+#include "Exception.hpp"
+
+
+namespace gpstk
+{
+
+    /** @addtogroup GeoDynamics */
+    //@{
+
+    /** This class implements the Adams-Bashforth-Moulton 8-th order
+     *  algorithm of AdamsIntegrator, managing the start points itself.
+     *
+     * All the satellites share a fixed grid of steps, so the equation of
+     * motion is evaluated for all of them at once. Every satellite keeps
+     * its state and the derivatives of the last 9 grid points in its own
+     * contiguous buffer.
+     *
+     * Satellites are added with 'addSatellites()' at any time: their
+     * state is integrated with RKF78 to the current grid point, and then
+     * 8 steps backwards to get their derivative history, so they join
+     * the next step without waiting and without touching the other
+     * satellites. 'removeSatellite()' just drops the buffer of one
+     * satellite. A satellite whose predictor and corrector differ by more
+     * than the restart threshold (e.g. at a shadow boundary) is restarted
+     * the same way from its previous state.
+     *
+     * 'integrateTo()' steps the grid until it covers the requested time,
+     * and returns the states there interpolated with the derivative
+     * history (dense output), so the step size is independent of the
+     * observation epochs. Since the state includes the variational
+     * partials, they are interpolated too.
+     *
+     * @code
+     *   ABM8Integrator abm(300.0);
+     *   abm.setEquationOfMotion(gnssOrbit);
+     *   abm.addSatellites(t0, satOrbit0);
+     *
+     *   while( ... )
+     *   {
+     *       satVectorMap satOrbit( abm.integrateTo(t) );
+     *       ...
+     *       abm.addSatellites(t, newSatOrbits);    // rising satellites
+     *       abm.removeSatellite(sat);              // setting satellites
+     *   }
+     * @endcode
+     *
+     * @sa AdamsIntegrator.hpp, RKF78Integrator.hpp.
+     */
+    class ABM8Integrator : public Integrator
+    {
+    public:
+
+        /// Default constructor
+        ABM8Integrator(double step = 300.0);
+
+        /// Default destructor
+        virtual ~ABM8Integrator() {};
+
+
+        /// Set whether to integrate backwards. Set it, and the step size,
+        /// before adding satellites.
+        inline ABM8Integrator& setBackward(bool backward)
+        { direction = backward ? -1.0 : 1.0; return (*this); };
+
+        /// Get whether to integrate backwards
+        inline bool getBackward() const
+        { return (direction < 0.0); };
+
+
+        /// Set number of RKF78 substeps in every step of the startup
+        inline ABM8Integrator& setStartupSubsteps(int substeps)
+        { startupSubsteps = (substeps > 0) ? substeps : 1; return (*this); };
+
+        /// Get number of RKF78 substeps in every step of the startup
+        inline int getStartupSubsteps() const
+        { return startupSubsteps; };
+
+
+        /// Set error tolerance of the RKF78 startup, in meters
+        inline ABM8Integrator& setErrorTolerance(double tol)
+        { errorTol = tol; return (*this); };
+
+        /// Get error tolerance of the RKF78 startup, in meters
+        inline double getErrorTolerance() const
+        { return errorTol; };
+
+
+        /// Set the predictor-corrector difference, in meters, above which
+        /// a satellite is restarted
+        inline ABM8Integrator& setRestartThreshold(double threshold)
+        { restartThreshold = threshold; return (*this); };
+
+        /// Get the predictor-corrector difference, in meters, above which
+        /// a satellite is restarted
+        inline double getRestartThreshold() const
+        { return restartThreshold; };
+
+
+        /** Add satellites, starting them with RKF78.
+         *
+         * @param time      epoch of the states.
+         * @param states    states of the satellites.
+         */
+        virtual ABM8Integrator& addSatellites( const CommonTime& time,
+                                               const satVectorMap& states );
+
+        /// Remove a satellite
+        virtual ABM8Integrator& removeSatellite(const SatID& sat);
+
+        /// Get the satellites being integrated
+        virtual SatIDSet getSatellites() const;
+
+
+        /// Get the time of the current grid point
+        inline CommonTime getCurrentTime() const
+        { return t_curr; };
+
+        /// Get the states at the current grid point
+        virtual satVectorMap getCurrentState() const;
+
+
+        /// Step the grid until it covers 't_next', and return the states
+        /// of all the satellites interpolated at 't_next'.
+        virtual satVectorMap integrateTo(const CommonTime& t_next);
+
+
+        /** Get the states interpolated at a time within the last 8 steps,
+         *  without stepping.
+         *
+         * @param time      epoch of the states.
+         */
+        virtual satVectorMap getState(const CommonTime& time) const
+            throw(InvalidRequest);
+
+
+    private:
+
+        /// State and derivative history of a satellite
+        struct SatHistory
+        {
+            int n;                      ///< Size of the state
+            std::vector<double> y;      ///< State at 't_curr'
+            std::vector<double> f;      ///< Derivatives, 9 x n, ring
+        };
+
+
+        /// Advance all the satellites one step
+        void step();
+
+        /** Start satellites: integrate them to 't_curr' and fill their
+         *  derivative history.
+         */
+        void startup(const CommonTime& time, const satVectorMap& states);
+
+        /// Integrate with RKF78, in substeps, from t0 to t1
+        satVectorMap rkfPropagate( const CommonTime& t0,
+                                   const satVectorMap& y0,
+                                   const CommonTime& t1 );
+
+        /// One RKF78 step of size h, halved while the error is too big
+        satVectorMap rkfStep( const CommonTime& t,
+                              const satVectorMap& y,
+                              double h );
+
+        /// Weights of the derivative history to integrate from 't_curr'
+        /// to 't_curr + s*h'
+        void denseWeights(double s, double w[9]) const;
+
+
+        /// Coefficients of the Lagrange polynomials on the nodes 0..-8
+        double lagrange[9][9];
+
+        /// Direction of integration, +1 or -1
+        double direction;
+
+        /// Number of RKF78 substeps in every step of the startup
+        int startupSubsteps;
+
+        /// Error tolerance of the RKF78 startup
+        double errorTol;
+
+        /// Predictor-corrector difference restarting a satellite
+        double restartThreshold;
+
+        /// Time of the current grid point
+        CommonTime t_curr;
+
+        /// Ring slot of the derivatives at 't_curr'
+        int head;
+
+        /// Satellites being integrated
+        std::map<SatID, SatHistory> satHistory;
+
+    }; // End of class 'ABM8Integrator'
+
+    // @}
+
+}  // End of namespace 'gpstk'
+
+#endif // ABM8_INTEGRATOR_HPP
@@ -83,14 +83,15 @@ namespace gpstk
         virtual satVectorMap integrateTo(const CommonTime& t_next);
 
 
-    private:
-
         /// Coefficients of Adams-Bashforth
         const static double cb[9];
 
         /// Coefficients of Adams-Moulton
         const static double cm[9];
 
+
+    private:
+
         /// Current Time
         std::vector<CommonTime> t_curr;
 
@@ -69,7 +69,7 @@ namespace gpstk
 
         /// Set EquationOfMotion
         inline Integrator& setEquationOfMotion(EquationOfMotion& EOM)
-        { pEOM = &EOM; };
+        { pEOM = &EOM; return (*this); };
 
         /// Get EquationOfMotion
         inline EquationOfMotion* getEquationOfMotion() const
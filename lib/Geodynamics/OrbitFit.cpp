@@ -0,0 +1,397 @@
+//============================================================================
+//
+//  This file is part of GPSTk, the GPS Toolkit.
+//
+//  The GPSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 3.0 of the License, or
+//  any later version.
+//
+//  The GPSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GPSTk; if not, write to the Free Software Foundation,
+//  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+//
+//============================================================================
+
+/**
+ * @file OrbitFit.cpp
+ * Class to fit integrated orbits to reference positions, solving the
+ * initial state and SRP parameters of every satellite.
+ */
+
+#include <cmath>
+#include <algorithm>
+
+#include "OrbitFit.hpp"
+
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
+
+using namespace std;
+
+namespace gpstk
+{
+
+    // Set number of SRP parameters. It clears the arcs.
+    OrbitFit& OrbitFit::setNumSRPParams(int numSRP)
+    {
+        if(numSRP < 0)
+        {
+            InvalidRequest e("Negative number of SRP parameters.");
+            GPSTK_THROW(e);
+        }
+
+        numSRPParams = numSRP;
+        satArcs.clear();
+
+        return (*this);
+
+    }  // End of method 'OrbitFit::setNumSRPParams()'
+
+
+    // Add the equations of one epoch.
+    void OrbitFit::addObservation( const SatID&          sat,
+                                   const CommonTime&     time,
+                                   const Vector<double>& rObs,
+                                   const Vector<double>& state )
+    {
+        if(rObs.size() != 3 || state.size() != size_t(42+6*numSRPParams))
+        {
+            InvalidRequest e("Size of position or state vector error.");
+            GPSTK_THROW(e);
+        }
+
+        SatArc& arc( satArcs[sat] );
+
+        // if epoch exists, ignore it
+        if(arc.epochIndex.find(time) != arc.epochIndex.end()) return;
+
+        arc.epochIndex[time] = arc.used.size();
+        arc.used.push_back(1);
+
+        for(int m=0; m<3; ++m)
+        {
+            arc.omc.push_back( rObs(m) - state(m) );
+
+            // dr/dr0, dr/dv0, dr/dp0
+            for(int n=0; n<3; ++n) arc.design.push_back( state( 6+3*m+n) );
+            for(int n=0; n<3; ++n) arc.design.push_back( state(15+3*m+n) );
+            for(int n=0; n<numSRPParams; ++n)
+            {
+                arc.design.push_back( state(42+numSRPParams*m+n) );
+            }
+        }
+
+        for(int i=0; i<6; ++i) arc.rv.push_back( state(i) );
+
+        arc.stats.valid = false;
+        arc.stats.numEpochs = arc.used.size();
+
+    }  // End of method 'OrbitFit::addObservation()'
+
+
+    // Solve all the arcs. Returns the number of valid solutions.
+    int OrbitFit::fit()
+    {
+        std::vector<SatArc*> arcs;
+        for(std::map<SatID,SatArc>::iterator it = satArcs.begin();
+            it != satArcs.end();
+            ++it)
+        {
+            arcs.push_back( &(it->second) );
+        }
+
+        const int numArcs( arcs.size() );
+
+        // the arcs are independent, and their sizes differ
+#ifdef USE_OPENMP
+    #pragma omp parallel for schedule(dynamic)
+#endif
+        for(int i=0; i<numArcs; ++i)
+        {
+            try
+            {
+                fitArc( *arcs[i] );
+            }
+            catch(...)
+            {
+                arcs[i]->stats.valid = false;
+            }
+        }
+
+        int numValid(0);
+        for(int i=0; i<numArcs; ++i)
+        {
+            if(arcs[i]->stats.valid) ++numValid;
+        }
+
+        return numValid;
+
+    }  // End of method 'OrbitFit::fit()'
+
+
+    // Solve one arc
+    void OrbitFit::fitArc(SatArc& arc) const
+    {
+        const int np( 6 + numSRPParams );
+        const int ne( arc.used.size() );
+
+        FitStats& stats( arc.stats );
+        stats = FitStats();
+        stats.numEpochs = ne;
+
+        arc.dx.resize(0);
+        arc.cov.resize(0,0);
+
+        std::fill(arc.used.begin(), arc.used.end(), 1);
+
+        std::vector<double> res(3*ne, 0.0);
+        Vector<double> dx(np, 0.0);
+        Matrix<double> Q(np, np, 0.0);
+
+        for(int iter=0; iter<maxIterations; ++iter)
+        {
+            int nu( std::count(arc.used.begin(), arc.used.end(), 1) );
+
+            // not enough redundancy
+            if(3*nu <= np) return;
+
+            // normal equations, upper triangle
+            std::vector<double> N(np*np, 0.0);
+            std::vector<double> b(np, 0.0);
+
+            for(int e=0; e<ne; ++e)
+            {
+                if(!arc.used[e]) continue;
+
+                for(int m=0; m<3; ++m)
+                {
+                    const double* row( &arc.design[(3*e+m)*np] );
+                    const double  l( arc.omc[3*e+m] );
+
+                    for(int i=0; i<np; ++i)
+                    {
+                        double ri( row[i] );
+                        double* Ni( &N[i*np] );
+                        for(int j=i; j<np; ++j)
+                        {
+                            Ni[j] += ri*row[j];
+                        }
+                        b[i] += ri*l;
+                    }
+                }
+            }
+
+            // scale the columns, position and velocity partials differ by
+            // orders of magnitude
+            std::vector<double> d(np, 0.0);
+            for(int i=0; i<np; ++i)
+            {
+                if(N[i*np+i] <= 0.0) return;
+                d[i] = 1.0/std::sqrt(N[i*np+i]);
+            }
+
+            Matrix<double> Ns(np, np, 0.0);
+            for(int i=0; i<np; ++i)
+            {
+                for(int j=i; j<np; ++j)
+                {
+                    Ns(i,j) = Ns(j,i) = N[i*np+j]*d[i]*d[j];
+                }
+            }
+
+            Ns = inverseChol(Ns);
+
+            for(int i=0; i<np; ++i)
+            {
+                for(int j=0; j<np; ++j)
+                {
+                    Q(i,j) = Ns(i,j)*d[i]*d[j];
+                }
+            }
+
+            for(int i=0; i<np; ++i)
+            {
+                double sum(0.0);
+                for(int j=0; j<np; ++j) sum += Q(i,j)*b[j];
+                dx(i) = sum;
+            }
+
+            // postfit residuals of all the epochs
+            double vtv(0.0);
+            for(int e=0; e<ne; ++e)
+            {
+                for(int m=0; m<3; ++m)
+                {
+                    const double* row( &arc.design[(3*e+m)*np] );
+                    double v( arc.omc[3*e+m] );
+                    for(int j=0; j<np; ++j) v -= row[j]*dx(j);
+
+                    res[3*e+m] = v;
+                    if(arc.used[e]) vtv += v*v;
+                }
+            }
+
+            stats.numIter = iter + 1;
+            stats.numUsed = nu;
+            stats.sigma   = std::sqrt( vtv/(3*nu - np) );
+
+            // the used-set must stay the one of the last solution
+            if(outlierFactor <= 0.0 || iter+1 >= maxIterations) break;
+
+            // reject epochs with large residuals, and take back the ones
+            // rejected before which fit the new solution
+            double limit( outlierFactor*stats.sigma );
+            if(limit < outlierMinimum) limit = outlierMinimum;
+
+            bool changed(false);
+            for(int e=0; e<ne; ++e)
+            {
+                char ok(1);
+                for(int m=0; m<3; ++m)
+                {
+                    if(std::abs(res[3*e+m]) > limit) ok = 0;
+                }
+
+                if(ok != arc.used[e])
+                {
+                    arc.used[e] = ok;
+                    changed = true;
+                }
+            }
+
+            if(!changed) break;
+
+        }  // End of 'for(int iter=0; ...)'
+
+        if(stats.numIter == 0) return;
+
+
+        // radial, along-track and cross-track RMS
+        double sumR(0.0), sumT(0.0), sumN(0.0);
+        int nu(0);
+        for(int e=0; e<ne; ++e)
+        {
+            if(!arc.used[e]) continue;
+
+            const double* r( &arc.rv[6*e] );
+            const double* v( &arc.rv[6*e+3] );
+
+            double rn( std::sqrt(r[0]*r[0] + r[1]*r[1] + r[2]*r[2]) );
+            double eR[3] = { r[0]/rn, r[1]/rn, r[2]/rn };
+
+            double eN[3] = { r[1]*v[2] - r[2]*v[1],
+                             r[2]*v[0] - r[0]*v[2],
+                             r[0]*v[1] - r[1]*v[0] };
+            double nn( std::sqrt(eN[0]*eN[0] + eN[1]*eN[1] + eN[2]*eN[2]) );
+            eN[0] /= nn; eN[1] /= nn; eN[2] /= nn;
+
+            double eT[3] = { eN[1]*eR[2] - eN[2]*eR[1],
+                             eN[2]*eR[0] - eN[0]*eR[2],
+                             eN[0]*eR[1] - eN[1]*eR[0] };
+
+            const double* dr( &res[3*e] );
+            double vR( dr[0]*eR[0] + dr[1]*eR[1] + dr[2]*eR[2] );
+            double vT( dr[0]*eT[0] + dr[1]*eT[1] + dr[2]*eT[2] );
+            double vN( dr[0]*eN[0] + dr[1]*eN[1] + dr[2]*eN[2] );
+
+            sumR += vR*vR; sumT += vT*vT; sumN += vN*vN;
+            ++nu;
+        }
+
+        stats.numUsed = nu;
+        stats.rmsR = std::sqrt(sumR/nu);
+        stats.rmsT = std::sqrt(sumT/nu);
+        stats.rmsN = std::sqrt(sumN/nu);
+
+        arc.dx  = dx;
+        arc.cov = Q * (stats.sigma*stats.sigma);
+
+        stats.valid = (maxSigma <= 0.0 || stats.sigma <= maxSigma);
+
+    }  // End of method 'OrbitFit::fitArc()'
+
+
+    // Get arc of a satellite
+    const OrbitFit::SatArc& OrbitFit::getArc(const SatID& sat) const
+    {
+        std::map<SatID,SatArc>::const_iterator it( satArcs.find(sat) );
+
+        if(it == satArcs.end() || it->second.dx.size() == 0)
+        {
+            InvalidRequest e("No solution for satellite.");
+            GPSTK_THROW(e);
+        }
+
+        return it->second;
+
+    }  // End of method 'OrbitFit::getArc()'
+
+
+    // Get satellites with arcs
+    SatIDSet OrbitFit::getSatellites() const
+    {
+        SatIDSet sats;
+        for(std::map<SatID,SatArc>::const_iterator it = satArcs.begin();
+            it != satArcs.end();
+            ++it)
+        {
+            sats.insert(it->first);
+        }
+
+        return sats;
+
+    }  // End of method 'OrbitFit::getSatellites()'
+
+
+    // Get corrections to (r0, v0, p0) of one satellite
+    Vector<double> OrbitFit::getCorrection(const SatID& sat) const
+    {
+        return getArc(sat).dx;
+    }
+
+
+    // Get covariance of the corrections of one satellite
+    Matrix<double> OrbitFit::getCovariance(const SatID& sat) const
+    {
+        return getArc(sat).cov;
+    }
+
+
+    // Get post-fit statistics of one satellite
+    OrbitFit::FitStats OrbitFit::getStats(const SatID& sat) const
+    {
+        std::map<SatID,SatArc>::const_iterator it( satArcs.find(sat) );
+
+        if(it == satArcs.end()) return FitStats();
+
+        return it->second.stats;
+    }
+
+
+    // Get corrections of all the satellites with valid solutions
+    satVectorMap OrbitFit::getCorrections() const
+    {
+        satVectorMap corrections;
+        for(std::map<SatID,SatArc>::const_iterator it = satArcs.begin();
+            it != satArcs.end();
+            ++it)
+        {
+            if(it->second.stats.valid)
+            {
+                corrections[it->first] = it->second.dx;
+            }
+        }
+
+        return corrections;
+
+    }  // End of method 'OrbitFit::getCorrections()'
+
+
+}  // End of namespace 'gpstk'
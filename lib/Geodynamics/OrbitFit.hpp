@@ -0,0 +1,258 @@
+//============================================================================
+//
+//  This file is part of GPSTk, the GPS Toolkit.
+//
+//  The GPSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 3.0 of the License, or
+//  any later version.
+//
+//  The GPSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GPSTk; if not, write to the Free Software Foundation,
+//  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+//
+//============================================================================
+
+/**
+ * @file OrbitFit.hpp
+ * Class to fit integrated orbits to reference positions, solving the
+ * initial state and SRP parameters of every satellite.
+ */
+
+#ifndef ORBIT_FIT_HPP
+#define ORBIT_FIT_HPP
+
+#include <vector>
+#include <map>
+
+#include "CommonTime.hpp"
+#include "DataStructures.hpp"
+
+
+namespace gpstk
+{
+
+    /** @addtogroup GeoDynamics */
+    //@{
+
+    /** Class to fit integrated orbits to reference positions (e.g. SP3),
+     *  solving the initial state and SRP parameters of every satellite.
+     *
+     * The state vectors are those integrated by RKF78Integrator and
+     * AdamsIntegrator with GNSSOrbit:
+     *
+     *    (r, v, dr/dr0, dr/dv0, dv/dr0, dv/dv0, dr/dp0, dv/dp0)
+     *
+     * with 42 + 6*numSRP elements. Each call to 'addObservation()' adds
+     * the three equations 'rObs - r = dr/d(r0,v0,p0) * dx' of one epoch to
+     * the arc of the satellite; 'fit()' then solves the (6 + numSRP)
+     * parameters of all the satellites, in parallel when OpenMP is
+     * enabled, since the arcs are independent.
+     *
+     * With 'setOutlierFactor()', the fit of every satellite is iterated:
+     * epochs with any residual larger than 'outlierFactor' times the
+     * post-fit sigma are rejected and the arc is solved again, until no
+     * epoch changes state or 'maxIterations' solutions are computed. The
+     * rejection is off by default. Post-fit sigma and radial, along-track
+     * and cross-track RMS are then available with 'getStats()'.
+     *
+     * A typical way to use this class follows:
+     *
+     * @code
+     *   OrbitFit orbitFit(numSRP);
+     *
+     *   while( ... )      // integrate the arc
+     *   {
+     *      satOrbit = adams.integrateTo(tt);
+     *      for(...)       // every satellite with SP3 position
+     *         orbitFit.addObservation(sat, gps, r_obs, satOrbit[sat]);
+     *   }
+     *
+     *   orbitFit.fit();
+     *   satVectorMap dx( orbitFit.getCorrections() );
+     * @endcode
+     *
+     * The corrections are added to the a priori (r0, v0, p0), and the arc
+     * is integrated and fitted again if needed.
+     */
+    class OrbitFit
+    {
+    public:
+
+        /// Post-fit statistics of one satellite
+        struct FitStats
+        {
+            FitStats()
+                : valid(false), numEpochs(0), numUsed(0), numIter(0),
+                  sigma(0.0), rmsR(0.0), rmsT(0.0), rmsN(0.0)
+            {};
+
+            bool   valid;       ///< Whether the solution is valid
+            int    numEpochs;   ///< Number of epochs of the arc
+            int    numUsed;     ///< Number of epochs not rejected
+            int    numIter;     ///< Number of solutions computed
+            double sigma;       ///< Post-fit sigma (m)
+            double rmsR;        ///< Post-fit radial RMS (m)
+            double rmsT;        ///< Post-fit along-track RMS (m)
+            double rmsN;        ///< Post-fit cross-track RMS (m)
+        };
+
+
+        /// Default constructor
+        OrbitFit(int numSRP = 5)
+            : numSRPParams(numSRP), maxIterations(5),
+              outlierFactor(0.0), outlierMinimum(0.0), maxSigma(0.0)
+        {};
+
+        /// Default destructor
+        virtual ~OrbitFit() {};
+
+
+        /// Set number of SRP parameters. It clears the arcs.
+        OrbitFit& setNumSRPParams(int numSRP);
+
+        /// Get number of SRP parameters
+        inline int getNumSRPParams() const
+        { return numSRPParams; };
+
+
+        /// Set maximum number of solutions of each arc
+        inline OrbitFit& setMaxIterations(int maxIter)
+        { maxIterations = (maxIter > 0) ? maxIter : 1; return (*this); };
+
+        /// Get maximum number of solutions of each arc
+        inline int getMaxIterations() const
+        { return maxIterations; };
+
+
+        /// Set outlier factor (times sigma). Zero disables the rejection.
+        inline OrbitFit& setOutlierFactor(double factor)
+        { outlierFactor = factor; return (*this); };
+
+        /// Get outlier factor
+        inline double getOutlierFactor() const
+        { return outlierFactor; };
+
+
+        /// Set minimum outlier threshold (m), for very small sigmas
+        inline OrbitFit& setOutlierMinimum(double minimum)
+        { outlierMinimum = minimum; return (*this); };
+
+        /// Get minimum outlier threshold (m)
+        inline double getOutlierMinimum() const
+        { return outlierMinimum; };
+
+
+        /// Set maximum post-fit sigma (m) of a valid solution. Zero
+        /// disables the check.
+        inline OrbitFit& setMaxSigma(double sigma)
+        { maxSigma = sigma; return (*this); };
+
+        /// Get maximum post-fit sigma (m) of a valid solution
+        inline double getMaxSigma() const
+        { return maxSigma; };
+
+
+        /** Add the equations of one epoch.
+         *
+         * @param sat       satellite
+         * @param time      epoch, repeated epochs are ignored
+         * @param rObs      reference position (m), in the frame of the state
+         * @param state     integrated state with variational partials
+         */
+        void addObservation( const SatID&          sat,
+                             const CommonTime&     time,
+                             const Vector<double>& rObs,
+                             const Vector<double>& state );
+
+
+        /// Solve all the arcs. Returns the number of valid solutions.
+        int fit();
+
+
+        /// Get satellites with arcs
+        SatIDSet getSatellites() const;
+
+
+        /// Get corrections to (r0, v0, p0) of one satellite
+        Vector<double> getCorrection(const SatID& sat) const;
+
+        /// Get covariance of the corrections of one satellite
+        Matrix<double> getCovariance(const SatID& sat) const;
+
+        /// Get post-fit statistics of one satellite
+        FitStats getStats(const SatID& sat) const;
+
+        /// Get corrections of all the satellites with valid solutions
+        satVectorMap getCorrections() const;
+
+
+        /// Remove all the arcs
+        inline void reset()
+        { satArcs.clear(); };
+
+
+    private:
+
+        /// Equations and solution of one satellite
+        struct SatArc
+        {
+            /// Index of every epoch in the arrays below
+            std::map<CommonTime, int> epochIndex;
+
+            /// Observed minus computed, 3 per epoch
+            std::vector<double> omc;
+
+            /// Design matrix, 3 x (6 + numSRP) per epoch, row-major
+            std::vector<double> design;
+
+            /// Integrated position and velocity, 6 per epoch
+            std::vector<double> rv;
+
+            /// Whether each epoch is used
+            std::vector<char> used;
+
+            /// Solution
+            Vector<double> dx;
+            Matrix<double> cov;
+            FitStats stats;
+        };
+
+
+        /// Solve one arc
+        void fitArc(SatArc& arc) const;
+
+        /// Get arc of a satellite
+        const SatArc& getArc(const SatID& sat) const;
+
+
+        /// Number of SRP parameters
+        int numSRPParams;
+
+        /// Maximum number of solutions of each arc
+        int maxIterations;
+
+        /// Outlier factor (times sigma)
+        double outlierFactor;
+
+        /// Minimum outlier threshold (m)
+        double outlierMinimum;
+
+        /// Maximum post-fit sigma (m)
+        double maxSigma;
+
+        /// Arcs of all the satellites
+        std::map<SatID, SatArc> satArcs;
+
+    }; // End of class 'OrbitFit'
+
+    // @}
+
+}  // End of namespace 'gpstk'
+
+#endif   // ORBIT_FIT_HPP
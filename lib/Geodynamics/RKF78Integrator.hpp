@@ -87,12 +87,14 @@ namespace gpstk
         virtual satVectorMap integrateTo( const CommonTime& t_next );
 
 
-    private:
         /// Coefficients of RKF78
         const static double a[13];
         const static double b[13][12];
         const static double c1[13], c2[13];
 
+
+    private:
+
         /// Error Tolerance
         double errorTol;
 
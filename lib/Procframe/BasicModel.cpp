@@ -34,6 +34,9 @@
 #include "Rinex3EphemerisStore2.hpp"
 #include "YDSTime.hpp"
 #include "constants.hpp"
+#include "GPSEllipsoid.hpp"
+#include <algorithm>
+#include <cmath>
 
 using namespace std;
 
@@ -83,6 +86,8 @@ namespace gpstk
         useTGDOfGPS = false;
         useTGDOfGAL = false;
         useTGDOfBDS = false;
+        networkGeometry = true;
+        bucketWidth = 0.05;
 
     }  // End of 'BasicModel::BasicModel()'
 
@@ -102,6 +107,8 @@ namespace gpstk
         useTGDOfGPS = false;
         useTGDOfGAL = false;
         useTGDOfBDS = false;
+        networkGeometry = true;
+        bucketWidth = 0.05;
 
     }  // End of 'BasicModel::BasicModel()'
 
@@ -139,6 +146,8 @@ namespace gpstk
         useTGDOfGPS = applyTGDOfGPS;
         useTGDOfGAL = applyTGDOfGAL;
         useTGDOfBDS = applyTGDOfBDS;
+        networkGeometry = true;
+        bucketWidth = 0.05;
 
     }  // End of 'BasicModel::BasicModel()'
 
@@ -300,10 +309,31 @@ namespace gpstk
     {
         SourceIDSet sourceRejectedSet;
 
+        if(networkGeometry)
+        {
+            // All the stations of an epoch at once, even if they are in
+            // different entries of the gnssDataMap
+            gnssDataMap::iterator gdmIt( gData.begin() );
+            while( gdmIt != gData.end() )
+            {
+                gnssDataMap::iterator gdmEnd( gData.upper_bound(gdmIt->first) );
+
+                processNetwork( gdmIt->first, gdmIt, gdmEnd,
+                                sourceRejectedSet );
+
+                gdmIt = gdmEnd;
+            }
+
+            gData.removeSourceID( sourceRejectedSet );
+
+            return gData;
+        }
+
         for( gnssDataMap::iterator gdmIt = gData.begin();
              gdmIt != gData.end();
              ++gdmIt )
         {
+
             CommonTime epoch( gdmIt->first );
             epoch.setTimeSystem( TimeSystem::Unknown );
 
@@ -346,4 +376,336 @@ namespace gpstk
 
     }  // End of method 'BasicModel::Process()'
 
+
+      /* Compute the model of all the stations of an epoch at once.
+       *
+       * The light-time equation is solved as in ComputeAtTransmitTime() of
+       * CorrectedEphemerisRange: the satellite state is taken at the
+       * transmit time given by the pseudorange, corrected with the clock
+       * bias and relativity found there, and then rotated with the Earth
+       * during the time of flight. Instead of two ephemeris look-ups per
+       * station and satellite, the state is looked up once per satellite
+       * and bucket of transmit times, and extrapolated to every station
+       * with a second order Taylor series. The acceleration is the two-body
+       * one in the Earth fixed frame, whose error over the spread of the
+       * transmit times (some tens of ms) is far below 1 mm.
+       *
+       * @param time      Epoch.
+       * @param first     First entry of the epoch in the gnssDataMap.
+       * @param last      Entry after the last one of the epoch.
+       * @param sourceRejectedSet  Stations with no coordinates.
+       */
+    void BasicModel::processNetwork( const CommonTime& time,
+                                     gnssDataMap::iterator first,
+                                     gnssDataMap::iterator last,
+                                     SourceIDSet& sourceRejectedSet )
+    {
+        GPSEllipsoid ell;
+        const double c( ell.c() );
+        const double we( ell.angVelocity() );
+        const double gm( ell.gm() );
+
+        CommonTime epoch( time );
+        epoch.setTimeSystem( TimeSystem::Unknown );
+
+        // Stations: position and local North, East and Up vectors
+        std::vector<satTypeValueMap*> staData;
+        std::vector<double> staPos, staNEU;
+
+        for( gnssDataMap::iterator gdmIt = first; gdmIt != last; ++gdmIt )
+        {
+            for( sourceDataMap::iterator sdmIt = gdmIt->second.begin();
+                 sdmIt != gdmIt->second.end();
+                 ++sdmIt )
+            {
+                if(pMSCStore == NULL)
+                {
+                    sourceRejectedSet.insert( sdmIt->first );
+                    continue;
+                }
+
+                MSCData mscData;
+
+                try
+                {
+                    mscData = pMSCStore->findMSC( sdmIt->first.sourceName,
+                                                  epoch );
+                }
+                catch(...)
+                {
+                    sourceRejectedSet.insert( sdmIt->first );
+                    continue;
+                }
+
+                nominalPos = mscData.coordinates;
+
+                double lat( nominalPos.getGeodeticLatitude()*DEG_TO_RAD );
+                double lon( nominalPos.getLongitude()*DEG_TO_RAD );
+                double slat( std::sin(lat) ), clat( std::cos(lat) );
+                double slon( std::sin(lon) ), clon( std::cos(lon) );
+
+                staData.push_back( &sdmIt->second );
+
+                staPos.push_back( nominalPos.X() );
+                staPos.push_back( nominalPos.Y() );
+                staPos.push_back( nominalPos.Z() );
+
+                staNEU.push_back( -slat*clon );
+                staNEU.push_back( -slat*slon );
+                staNEU.push_back( clat );
+                staNEU.push_back( -slon );
+                staNEU.push_back( clon );
+                staNEU.push_back( 0.0 );
+                staNEU.push_back( clat*clon );
+                staNEU.push_back( clat*slon );
+                staNEU.push_back( slat );
+            }
+        }
+
+        const int numSta( staData.size() );
+
+        // Station-satellite pairs, grouped by satellite
+        std::map<SatID, std::vector< std::pair<double,int> > > satPairs;
+        std::vector<int> pairSta;
+        std::vector<SatID> pairSat;
+        std::vector<double> pairTau;
+
+        std::vector<SatIDSet> satRejectedSet(numSta);
+
+        for(int s = 0; s < numSta; ++s)
+        {
+            for( satTypeValueMap::iterator stv = staData[s]->begin();
+                 stv != staData[s]->end();
+                 ++stv )
+            {
+                const SatID& sat( stv->first );
+
+                TypeID defaultObs;
+                if(sat.system == SatID::systemGPS)
+                    defaultObs = defaultObsOfGPS;
+                else if(sat.system == SatID::systemGalileo)
+                    defaultObs = defaultObsOfGAL;
+                else if(sat.system == SatID::systemBDS)
+                    defaultObs = defaultObsOfBDS;
+
+                typeValueMap::const_iterator itObs(
+                                                stv->second.find(defaultObs) );
+                if( itObs == stv->second.end() )
+                {
+                    satRejectedSet[s].insert( sat );
+                    continue;
+                }
+
+                double tau( itObs->second/c );
+
+                satPairs[sat].push_back(
+                                std::make_pair(tau, int(pairTau.size())) );
+                pairSta.push_back( s );
+                pairSat.push_back( sat );
+                pairTau.push_back( tau );
+            }
+        }
+
+        const int numPairs( pairTau.size() );
+
+        // Satellite state at transmit time, as dense arrays. The times are
+        // offsets to 'time', in seconds.
+        std::vector<double> px(numPairs), py(numPairs), pz(numPairs);
+        std::vector<double> vx(numPairs), vy(numPairs), vz(numPairs);
+        std::vector<double> clk(numPairs);
+        std::vector<char> valid(numPairs, 0);
+
+        for( std::map<SatID, std::vector< std::pair<double,int> > >::iterator
+                it = satPairs.begin();
+             it != satPairs.end();
+             ++it )
+        {
+            const SatID& sat( it->first );
+            std::vector< std::pair<double,int> >& pairs( it->second );
+            std::sort( pairs.begin(), pairs.end() );
+
+            size_t first(0);
+            while(first < pairs.size())
+            {
+                // Bucket of transmit times
+                size_t last(first);
+                while( last+1 < pairs.size() &&
+                       pairs[last+1].first - pairs[first].first < bucketWidth )
+                {
+                    ++last;
+                }
+
+                double tauRef( 0.5*(pairs[first].first + pairs[last].first) );
+
+                // Reference state: the light-time equation of the bucket
+                // center
+                Xvt xvt;
+                double tRef(-tauRef);
+
+                try
+                {
+                    CommonTime tt( time );
+                    tt -= tauRef;
+                    xvt = pEphStore->getXvt(sat, tt);
+
+                    tRef = -tauRef - (xvt.clkbias + xvt.relcorr);
+
+                    tt = time;
+                    tt += tRef;
+                    xvt = pEphStore->getXvt(sat, tt);
+                }
+                catch(InvalidRequest& e)
+                {
+                    first = last + 1;
+                    continue;
+                }
+
+                double x0(xvt.x[0]), y0(xvt.x[1]), z0(xvt.x[2]);
+                double vx0(xvt.v[0]), vy0(xvt.v[1]), vz0(xvt.v[2]);
+                double r3( std::pow(x0*x0 + y0*y0 + z0*z0, 1.5) );
+                double ax0( -gm*x0/r3 + we*we*x0 + 2.0*we*vy0 );
+                double ay0( -gm*y0/r3 + we*we*y0 - 2.0*we*vx0 );
+                double az0( -gm*z0/r3 );
+
+                for(size_t k = first; k <= last; ++k)
+                {
+                    int p( pairs[k].second );
+
+                    // State at the nominal transmit time
+                    double dt( -pairs[k].first - tRef );
+                    double x( x0 + (vx0 + 0.5*ax0*dt)*dt );
+                    double y( y0 + (vy0 + 0.5*ay0*dt)*dt );
+                    double z( z0 + (vz0 + 0.5*az0*dt)*dt );
+                    double dtr( -2.0*( (x/c)*((vx0 + ax0*dt)/c)
+                                     + (y/c)*((vy0 + ay0*dt)/c)
+                                     + (z/c)*((vz0 + az0*dt)/c) ) );
+                    double dts( xvt.clkbias + xvt.clkdrift*dt );
+
+                    // State at the transmit time corrected with the
+                    // clock bias and relativity
+                    dt = -pairs[k].first - (dts + dtr) - tRef;
+
+                    px[p] = x0 + (vx0 + 0.5*ax0*dt)*dt;
+                    py[p] = y0 + (vy0 + 0.5*ay0*dt)*dt;
+                    pz[p] = z0 + (vz0 + 0.5*az0*dt)*dt;
+                    vx[p] = vx0 + ax0*dt;
+                    vy[p] = vy0 + ay0*dt;
+                    vz[p] = vz0 + az0*dt;
+                    clk[p] = xvt.clkbias + xvt.clkdrift*dt;
+                    valid[p] = 1;
+                }
+
+                first = last + 1;
+            }
+        }
+
+        // Earth rotation during the time of flight, range, direction
+        // cosines, relativity, elevation and azimuth of all the pairs
+        std::vector<double> rho(numPairs), rel(numPairs);
+        std::vector<double> cx(numPairs), cy(numPairs), cz(numPairs);
+        std::vector<double> cosUp(numPairs), cosN(numPairs), cosE(numPairs);
+
+        for(int p = 0; p < numPairs; ++p)
+        {
+            const double* R( &staPos[3*pairSta[p]] );
+            const double* NEU( &staNEU[9*pairSta[p]] );
+
+            double dx( px[p] - R[0] ), dy( py[p] - R[1] ), dz( pz[p] - R[2] );
+            double wt( we*std::sqrt(dx*dx + dy*dy + dz*dz)/c );
+            double cw( std::cos(wt) ), sw( std::sin(wt) );
+
+            double x(  cw*px[p] + sw*py[p] );
+            double y( -sw*px[p] + cw*py[p] );
+            px[p] = x;
+            py[p] = y;
+            x =  cw*vx[p] + sw*vy[p];
+            y = -sw*vx[p] + cw*vy[p];
+            vx[p] = x;
+            vy[p] = y;
+
+            dx = px[p] - R[0];
+            dy = py[p] - R[1];
+            rho[p] = std::sqrt(dx*dx + dy*dy + dz*dz);
+
+            cx[p] = -dx/rho[p];
+            cy[p] = -dy/rho[p];
+            cz[p] = -dz/rho[p];
+
+            rel[p] = -2.0*( (px[p]/c)*(vx[p]/c)
+                          + (py[p]/c)*(vy[p]/c)
+                          + (pz[p]/c)*(vz[p]/c) ) * c;
+
+            cosN[p] = -(cx[p]*NEU[0] + cy[p]*NEU[1] + cz[p]*NEU[2]);
+            cosE[p] = -(cx[p]*NEU[3] + cy[p]*NEU[4] + cz[p]*NEU[5]);
+            cosUp[p] = -(cx[p]*NEU[6] + cy[p]*NEU[7] + cz[p]*NEU[8]);
+        }
+
+        // Write the model into the GDS
+        for(int p = 0; p < numPairs; ++p)
+        {
+            int s( pairSta[p] );
+            const SatID& sat( pairSat[p] );
+
+            if(!valid[p])
+            {
+                satRejectedSet[s].insert( sat );
+                continue;
+            }
+
+            double elev( 90.0 - std::acos(cosUp[p])*RAD_TO_DEG );
+
+            if(elev < minElev)
+            {
+                satRejectedSet[s].insert( sat );
+                continue;
+            }
+
+            double azim(0.0);
+            if( std::fabs(cosN[p]) + std::fabs(cosE[p]) >= 1.0e-16 )
+            {
+                azim = std::atan2(cosE[p], cosN[p])*RAD_TO_DEG;
+                if(azim < 0.0) azim += 360.0;
+            }
+
+            if(satClock.find(sat) == satClock.end())
+                satClock[sat] = clk[p]*c;
+
+            typeValueMap& tvMap( (*staData[s])[sat] );
+
+            tvMap[TypeID::rho] = rho[p];
+            tvMap[TypeID::relativity] = -rel[p];
+            tvMap[TypeID::elevation] = elev;
+            tvMap[TypeID::azimuth] = azim;
+
+            tvMap[TypeID::satX] = px[p];
+            tvMap[TypeID::satY] = py[p];
+            tvMap[TypeID::satZ] = pz[p];
+
+            tvMap[TypeID::satVX] = vx[p];
+            tvMap[TypeID::satVY] = vy[p];
+            tvMap[TypeID::satVZ] = vz[p];
+
+            tvMap[TypeID::cdtSat] = clk[p]*c;
+
+            tvMap[TypeID::staX] = staPos[3*s];
+            tvMap[TypeID::staY] = staPos[3*s+1];
+            tvMap[TypeID::staZ] = staPos[3*s+2];
+
+            tvMap[TypeID::dSatX] = -cx[p];
+            tvMap[TypeID::dSatY] = -cy[p];
+            tvMap[TypeID::dSatZ] = -cz[p];
+
+            tvMap[TypeID::dStaX] = cx[p];
+            tvMap[TypeID::dStaY] = cy[p];
+            tvMap[TypeID::dStaZ] = cz[p];
+        }
+
+        // Remove satellites with missing data
+        for(int s = 0; s < numSta; ++s)
+        {
+            staData[s]->removeSatID( satRejectedSet[s] );
+        }
+
+    }  // End of method 'BasicModel::processNetwork()'
+
 }  // End of namespace gpstk
@@ -101,7 +101,8 @@ namespace gpstk
             : minElev(10.0), pEphStore(NULL), pMSCStore(NULL),
               defaultObsOfGPS(TypeID::C1), useTGDOfGPS(false),
               defaultObsOfGAL(TypeID::C1), useTGDOfGAL(false),
-              defaultObsOfBDS(TypeID::C2), useTGDOfBDS(false)
+              defaultObsOfBDS(TypeID::C2), useTGDOfBDS(false),
+              networkGeometry(true), bucketWidth(0.05)
         {
             nominalPos = Position(0.0,0.0,0.0,Position::Cartesian,NULL);
         };
@@ -314,6 +315,38 @@ namespace gpstk
         { pMSCStore = &msc; return (*this); };
 
 
+         /** Method to set whether the geometry of all the stations of an
+          *  epoch of a gnssDataMap is computed at once. By default, it is
+          *  set to true.
+          *
+          * The satellite states at transmit time are then interpolated
+          * from the ephemeris only once per satellite and bucket of
+          * transmit times, and extrapolated to every station with their
+          * velocity and acceleration. The ranges, direction cosines,
+          * elevations and azimuths of all the station-satellite pairs are
+          * computed as dense arrays, and then written into the GDS.
+          */
+        virtual BasicModel& setNetworkGeometry(bool network)
+        { networkGeometry = network; return (*this); };
+
+         /// Method to get whether the geometry of all the stations of an
+         /// epoch of a gnssDataMap is computed at once.
+        virtual bool getNetworkGeometry() const
+        { return networkGeometry; };
+
+         /** Method to set the width of the buckets of transmit times,
+          *  in seconds, sharing the satellite state interpolated from the
+          *  ephemeris. By default, it is set to 0.05 s, so a satellite is
+          *  usually interpolated only once per epoch.
+          */
+        virtual BasicModel& setBucketWidth(double width)
+        { bucketWidth = width; return (*this); };
+
+         /// Method to get the width of the buckets of transmit times.
+        virtual double getBucketWidth() const
+        { return bucketWidth; };
+
+
         /// Get satellite clock map.
         virtual satValueMap getSatClock() const
         { return satClock; };
@@ -357,6 +390,27 @@ namespace gpstk
         bool useTGDOfGAL;
         bool useTGDOfBDS;
 
+         /// Whether the geometry of all the stations is computed at once
+        bool networkGeometry;
+
+         /// Width of the buckets of transmit times, in seconds
+        double bucketWidth;
+
+
+    private:
+
+         /** Compute the model of all the stations of an epoch at once.
+          *
+          * @param time      Epoch.
+          * @param first     First entry of the epoch in the gnssDataMap.
+          * @param last      Entry after the last one of the epoch.
+          * @param sourceRejectedSet  Stations with no coordinates.
+          */
+        void processNetwork( const CommonTime& time,
+                             gnssDataMap::iterator first,
+                             gnssDataMap::iterator last,
+                             SourceIDSet& sourceRejectedSet );
+
     }; // End of class 'BasicModel'
 
       //@}
@@ -0,0 +1,698 @@
+#pragma ident "$Id$"
+
+/**
+ * @file BatchNEQSolver.cpp
+ * Batch least squares solver accumulating normal equations over many
+ * epochs, with pre-elimination of epoch-wise parameters.
+ */
+
+//============================================================================
+//
+//  This file is part of GPSTk, the GPS Toolkit.
+//
+//  The GPSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 2.1 of the License, or
+//  any later version.
+//
+//  The GPSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GPSTk; if not, write to the Free Software Foundation,
+//  Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//============================================================================
+
+
+#include <cmath>
+#include <algorithm>
+
+#include "BatchNEQSolver.hpp"
+
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
+
+using namespace std;
+
+namespace gpstk
+{
+
+    namespace
+    {
+        // Equation of one epoch: weight, prefit, and local index and
+        // coefficient of the epoch-wise and the other parameters
+        struct EpochRow
+        {
+            double w, l;
+            std::vector<int> ei, ki;
+            std::vector<double> ec, kc;
+        };
+    }
+
+
+    // Default constructor.
+    BatchNEQSolver::BatchNEQSolver()
+        : lPl(0.0), numObs(0), numEliminated(0), sigma0(0.0)
+    {
+        epochTypes.insert(TypeID::dcdtSta);
+        epochTypes.insert(TypeID::dcdtSat);
+
+        arcTypes.insert(TypeID::BL1);
+        arcTypes.insert(TypeID::BL2);
+        arcTypes.insert(TypeID::BLC);
+        arcTypes.insert(TypeID::BWL);
+
+        equSystem.setStateStore(stateStore);
+        equSystem.setIncremental(true);
+
+    }  // End of constructor 'BatchNEQSolver::BatchNEQSolver()'
+
+
+    // Remove all the normal equations
+    BatchNEQSolver& BatchNEQSolver::reset()
+    {
+        params.clear();
+        paramIndex.clear();
+        arcParams.clear();
+        globalParams.clear();
+
+        arcRows.clear();
+        arcFirst.clear();
+        globalArcRows.clear();
+        globalRows.clear();
+        rhs.clear();
+
+        lPl = 0.0;
+        numObs = 0;
+        numEliminated = 0;
+
+        solution.resize(0);
+        globalCov.resize(0,0);
+        sigma0 = 0.0;
+
+        return (*this);
+
+    }  // End of method 'BatchNEQSolver::reset()'
+
+
+    // Get the index of a parameter, adding it if new
+    int BatchNEQSolver::getParameter( const Variable& var, int arc )
+    {
+        std::pair<int,int> key( var.getID(), arc );
+
+        std::map<std::pair<int,int>, int>::const_iterator it(
+                                                    paramIndex.find(key) );
+        if( it != paramIndex.end() ) return it->second;
+
+        Parameter par;
+        par.var = var;
+        par.arc = arc;
+        par.global = ( arcTypes.find(var.getType()) == arcTypes.end() );
+
+        int p( params.size() );
+
+        if( par.global )
+        {
+            par.index = globalParams.size();
+            globalParams.push_back(p);
+            globalRows.push_back( std::vector<double>(par.index+1, 0.0) );
+            globalArcRows.push_back( std::vector<double>() );
+        }
+        else
+        {
+            par.index = arcParams.size();
+            arcParams.push_back(p);
+            arcRows.push_back( std::vector<double>(1, 0.0) );
+            arcFirst.push_back(par.index);
+        }
+
+        params.push_back(par);
+        rhs.push_back(0.0);
+        paramIndex[key] = p;
+
+        // a priori constraint to zero
+        addNormal( p, p, 1.0/var.getInitialVariance() );
+
+        return p;
+
+    }  // End of method 'BatchNEQSolver::getParameter()'
+
+
+    // Add 'value' to the element (i,j) of the reduced normal matrix
+    void BatchNEQSolver::addNormal( int i, int j, double value )
+    {
+        const Parameter& pi( params[i] );
+        const Parameter& pj( params[j] );
+
+        if( !pi.global && !pj.global )
+        {
+            int r( std::max(pi.index, pj.index) );
+            int c( std::min(pi.index, pj.index) );
+
+            if( c < arcFirst[r] )
+            {
+                arcRows[r].insert( arcRows[r].begin(), arcFirst[r]-c, 0.0 );
+                arcFirst[r] = c;
+            }
+
+            arcRows[r][c - arcFirst[r]] += value;
+        }
+        else if( pi.global && pj.global )
+        {
+            int r( std::max(pi.index, pj.index) );
+            int c( std::min(pi.index, pj.index) );
+
+            globalRows[r][c] += value;
+        }
+        else
+        {
+            const Parameter& g( pi.global ? pi : pj );
+            const Parameter& a( pi.global ? pj : pi );
+
+            std::vector<double>& row( globalArcRows[g.index] );
+            if( a.index >= int(row.size()) )
+            {
+                row.resize( arcParams.size(), 0.0 );
+            }
+
+            row[a.index] += value;
+        }
+
+    }  // End of method 'BatchNEQSolver::addNormal()'
+
+
+    // Add the normal equations of one epoch, after pre-eliminating its
+    // epoch-wise parameters.
+    BatchNEQSolver& BatchNEQSolver::addEpoch( gnssDataMap& gdsMap )
+        throw(InvalidSolver)
+    {
+        equSystem.Prepare( gdsMap );
+
+        EquationList equList( equSystem.getCurrentEquationsList() );
+
+        // Epoch-wise parameters of this epoch, by Variable ID
+        std::map<int, int> epochLocal;
+        std::vector<double> epochVariance;
+
+        // Other parameters of this epoch
+        std::map<int, int> paramLocal;
+        std::vector<int> localParams;
+
+        std::vector<EpochRow> rows;
+        rows.reserve( equList.size() );
+
+        for( EquationList::const_iterator itEqu = equList.begin();
+             itEqu != equList.end();
+             ++itEqu )
+        {
+            const typeValueMap& tData( (*itEqu).header.typeValueData );
+
+            TypeID indepType( (*itEqu).header.indTerm.getType() );
+
+            typeValueMap::const_iterator itPrefit( tData.find(indepType) );
+            if( itPrefit == tData.end() ) continue;
+
+            // Weight, as in 'MeasUpdate'
+            double weight( (*itEqu).header.constWeight );
+
+            if( indepType == TypeID::prefitC )
+            {
+                typeValueMap::const_iterator it( tData.find(TypeID::weightC) );
+                if( it != tData.end() ) weight *= it->second;
+            }
+            else if( indepType == TypeID::prefitL )
+            {
+                typeValueMap::const_iterator it( tData.find(TypeID::weightL) );
+                if( it != tData.end() ) weight *= it->second;
+            }
+
+            if( weight <= 0.0 ) continue;
+
+            int arc(0);
+            typeValueMap::const_iterator itArc( tData.find(TypeID::satArc) );
+            if( itArc != tData.end() ) arc = int( itArc->second );
+
+            rows.push_back( EpochRow() );
+            EpochRow& row( rows.back() );
+            row.w = weight;
+            row.l = itPrefit->second;
+
+            for( VarCoeffMap::const_iterator vcmIter = (*itEqu).body.begin();
+                 vcmIter != (*itEqu).body.end();
+                 ++vcmIter )
+            {
+                const Variable& var( (*vcmIter).first );
+                const Coefficient& coef( (*vcmIter).second );
+
+                double tempCoef( coef.defaultCoefficient );
+
+                if( !coef.forceDefault )
+                {
+                    typeValueMap::const_iterator it( tData.find(var.getType()) );
+                    if( it != tData.end() ) tempCoef = it->second;
+                }
+
+                if( epochTypes.find(var.getType()) != epochTypes.end() )
+                {
+                    std::map<int,int>::iterator it( epochLocal.find(var.getID()) );
+                    if( it == epochLocal.end() )
+                    {
+                        it = epochLocal.insert(
+                            std::make_pair(var.getID(), int(epochLocal.size())) ).first;
+                        epochVariance.push_back( var.getInitialVariance() );
+                    }
+
+                    row.ei.push_back( it->second );
+                    row.ec.push_back( tempCoef );
+                }
+                else
+                {
+                    bool isArc( arcTypes.find(var.getType()) != arcTypes.end() );
+                    int p( getParameter(var, isArc ? arc : 0) );
+
+                    std::map<int,int>::iterator it( paramLocal.find(p) );
+                    if( it == paramLocal.end() )
+                    {
+                        it = paramLocal.insert(
+                            std::make_pair(p, int(localParams.size())) ).first;
+                        localParams.push_back(p);
+                    }
+
+                    row.ki.push_back( it->second );
+                    row.kc.push_back( tempCoef );
+                }
+            }
+
+        }  // End of 'for( EquationList::const_iterator itEqu = ...'
+
+
+        const int ne( epochVariance.size() );
+        const int nk( localParams.size() );
+
+        // Normal equations of the epoch: the epoch-wise block, the
+        // epoch-wise x other block, and the other block directly into the
+        // accumulated normal equations
+        std::vector<double> Nee( ne*ne, 0.0 );
+        std::vector<double> Nek( ne*nk, 0.0 );      // column-major
+        std::vector<double> be( ne, 0.0 );
+
+        for(int i=0; i<ne; ++i) Nee[i*ne+i] = 1.0/epochVariance[i];
+
+        for(size_t r=0; r<rows.size(); ++r)
+        {
+            const EpochRow& row( rows[r] );
+
+            for(size_t a=0; a<row.ei.size(); ++a)
+            {
+                double wa( row.w*row.ec[a] );
+                for(size_t b=0; b<row.ei.size(); ++b)
+                {
+                    Nee[ row.ei[a]*ne + row.ei[b] ] += wa*row.ec[b];
+                }
+                for(size_t b=0; b<row.ki.size(); ++b)
+                {
+                    Nek[ row.ki[b]*ne + row.ei[a] ] += wa*row.kc[b];
+                }
+                be[ row.ei[a] ] += wa*row.l;
+            }
+
+            for(size_t a=0; a<row.ki.size(); ++a)
+            {
+                int pa( localParams[row.ki[a]] );
+                double wa( row.w*row.kc[a] );
+                for(size_t b=0; b<=a; ++b)
+                {
+                    addNormal( pa, localParams[row.ki[b]], wa*row.kc[b] );
+                }
+                rhs[pa] += wa*row.l;
+            }
+
+            lPl += row.w*row.l*row.l;
+        }
+
+        numObs += rows.size();
+        numEliminated += ne;
+
+
+        // Pre-elimination: Nee = L*L', C = inverse(L)*Nek, d = inverse(L)*be
+        for(int j=0; j<ne; ++j)
+        {
+            double* Lj( &Nee[j*ne] );
+
+            double s( Lj[j] );
+            for(int k=0; k<j; ++k) s -= Lj[k]*Lj[k];
+
+            if( !(s > 0.0) )
+            {
+                InvalidSolver e("Normal equations of epoch-wise parameters "
+                                "are singular.");
+                GPSTK_THROW(e);
+            }
+
+            Lj[j] = std::sqrt(s);
+
+            for(int i=j+1; i<ne; ++i)
+            {
+                double* Li( &Nee[i*ne] );
+                double t( Li[j] );
+                for(int k=0; k<j; ++k) t -= Li[k]*Lj[k];
+                Li[j] = t/Lj[j];
+            }
+        }
+
+        std::vector<char> nonZero( nk, 0 );
+        for(int k=0; k<nk; ++k)
+        {
+            double* c( &Nek[k*ne] );
+            for(int i=0; i<ne; ++i)
+            {
+                const double* Li( &Nee[i*ne] );
+                double t( c[i] );
+                for(int m=0; m<i; ++m) t -= Li[m]*c[m];
+                c[i] = t/Li[i];
+                if( c[i] != 0.0 ) nonZero[k] = 1;
+            }
+        }
+
+        for(int i=0; i<ne; ++i)
+        {
+            const double* Li( &Nee[i*ne] );
+            double t( be[i] );
+            for(int m=0; m<i; ++m) t -= Li[m]*be[m];
+            be[i] = t/Li[i];
+            lPl -= be[i]*be[i];
+        }
+
+        for(int k=0; k<nk; ++k)
+        {
+            if( !nonZero[k] ) continue;
+
+            const double* c( &Nek[k*ne] );
+            double t(0.0);
+            for(int i=0; i<ne; ++i) t += c[i]*be[i];
+            rhs[ localParams[k] ] -= t;
+        }
+
+        // Grow the envelope and the border before updating them in
+        // parallel, so 'addNormal()' does not resize any row
+        int minArc( arcParams.size() );
+        for(int k=0; k<nk; ++k)
+        {
+            const Parameter& par( params[localParams[k]] );
+            if( nonZero[k] && !par.global ) minArc = std::min(minArc, par.index);
+        }
+
+        for(int k=0; k<nk; ++k)
+        {
+            if( !nonZero[k] ) continue;
+
+            int p( localParams[k] );
+            const Parameter& par( params[p] );
+            if( par.global )
+            {
+                globalArcRows[par.index].resize( arcParams.size(), 0.0 );
+            }
+            else if( minArc < arcFirst[par.index] )
+            {
+                std::vector<double>& row( arcRows[par.index] );
+                row.insert( row.begin(), arcFirst[par.index]-minArc, 0.0 );
+                arcFirst[par.index] = minArc;
+            }
+        }
+
+        // Schur complement: N_kk -= C'*C
+#ifdef USE_OPENMP
+    #pragma omp parallel for schedule(dynamic)
+#endif
+        for(int a=0; a<nk; ++a)
+        {
+            if( !nonZero[a] ) continue;
+
+            const double* ca( &Nek[a*ne] );
+
+            for(int b=0; b<=a; ++b)
+            {
+                if( !nonZero[b] ) continue;
+
+                const double* cb( &Nek[b*ne] );
+                double t(0.0);
+                for(int i=0; i<ne; ++i) t += ca[i]*cb[i];
+
+                if( t != 0.0 ) addNormal( localParams[a], localParams[b], -t );
+            }
+        }
+
+        return (*this);
+
+    }  // End of method 'BatchNEQSolver::addEpoch()'
+
+
+    // Solve the accumulated normal equations.
+    BatchNEQSolver& BatchNEQSolver::solve()
+        throw(InvalidSolver)
+    {
+        const int nA( arcParams.size() );
+        const int nG( globalParams.size() );
+
+        // Work on copies, so more epochs may be added later
+        std::vector< std::vector<double> > L( arcRows );
+        std::vector< std::vector<double> > Y( globalArcRows );
+        for(int g=0; g<nG; ++g) Y[g].resize( nA, 0.0 );
+
+        // Envelope Cholesky factorization of the arc-wise block
+        for(int i=0; i<nA; ++i)
+        {
+            std::vector<double>& Li( L[i] );
+            const int fi( arcFirst[i] );
+
+            for(int j=fi; j<i; ++j)
+            {
+                const std::vector<double>& Lj( L[j] );
+                const int fj( arcFirst[j] );
+
+                double s( Li[j-fi] );
+                for(int k=std::max(fi,fj); k<j; ++k) s -= Li[k-fi]*Lj[k-fj];
+                Li[j-fi] = s/Lj[j-fj];
+            }
+
+            double d( Li[i-fi] );
+            for(int k=fi; k<i; ++k) d -= Li[k-fi]*Li[k-fi];
+
+            if( !(d > 0.0) )
+            {
+                InvalidSolver e("Normal matrix of arc-wise parameters is "
+                                "not positive definite.");
+                GPSTK_THROW(e);
+            }
+
+            Li[i-fi] = std::sqrt(d);
+        }
+
+        // Y = inverse(L) * (global x arc-wise block)'
+#ifdef USE_OPENMP
+    #pragma omp parallel for schedule(dynamic)
+#endif
+        for(int g=0; g<nG; ++g)
+        {
+            std::vector<double>& y( Y[g] );
+            for(int j=0; j<nA; ++j)
+            {
+                const std::vector<double>& Lj( L[j] );
+                const int fj( arcFirst[j] );
+
+                double s( y[j] );
+                for(int k=fj; k<j; ++k) s -= Lj[k-fj]*y[k];
+                y[j] = s/Lj[j-fj];
+            }
+        }
+
+        // Schur complement of the global block, S = N_gg - Y*Y'
+        std::vector<double> S( nG*nG, 0.0 );
+
+#ifdef USE_OPENMP
+    #pragma omp parallel for schedule(dynamic)
+#endif
+        for(int a=0; a<nG; ++a)
+        {
+            for(int b=0; b<=a; ++b)
+            {
+                double s( globalRows[a][b] );
+                const std::vector<double>& ya( Y[a] );
+                const std::vector<double>& yb( Y[b] );
+                for(int k=0; k<nA; ++k) s -= ya[k]*yb[k];
+                S[a*nG+b] = s;
+            }
+        }
+
+        // S = Ls*Ls'
+        for(int j=0; j<nG; ++j)
+        {
+            double* Lj( &S[j*nG] );
+
+            double d( Lj[j] );
+            for(int k=0; k<j; ++k) d -= Lj[k]*Lj[k];
+
+            if( !(d > 0.0) )
+            {
+                InvalidSolver e("Normal matrix of global parameters is "
+                                "not positive definite.");
+                GPSTK_THROW(e);
+            }
+
+            Lj[j] = std::sqrt(d);
+
+            for(int i=j+1; i<nG; ++i)
+            {
+                double* Li( &S[i*nG] );
+                double t( Li[j] );
+                for(int k=0; k<j; ++k) t -= Li[k]*Lj[k];
+                Li[j] = t/Lj[j];
+            }
+        }
+
+        // Forward substitution
+        std::vector<double> zA( nA ), zG( nG );
+        for(int j=0; j<nA; ++j) zA[j] = rhs[ arcParams[j] ];
+        for(int g=0; g<nG; ++g) zG[g] = rhs[ globalParams[g] ];
+
+        for(int j=0; j<nA; ++j)
+        {
+            const std::vector<double>& Lj( L[j] );
+            const int fj( arcFirst[j] );
+
+            double s( zA[j] );
+            for(int k=fj; k<j; ++k) s -= Lj[k-fj]*zA[k];
+            zA[j] = s/Lj[j-fj];
+        }
+
+        for(int g=0; g<nG; ++g)
+        {
+            double s( zG[g] );
+            for(int k=0; k<nA; ++k) s -= Y[g][k]*zA[k];
+            for(int k=0; k<g; ++k) s -= S[g*nG+k]*zG[k];
+            zG[g] = s/S[g*nG+g];
+        }
+
+        // Back substitution
+        std::vector<double> xG( nG ), xA( zA );
+        for(int g=nG-1; g>=0; --g)
+        {
+            double s( zG[g] );
+            for(int k=g+1; k<nG; ++k) s -= S[k*nG+g]*xG[k];
+            xG[g] = s/S[g*nG+g];
+        }
+
+        for(int g=0; g<nG; ++g)
+        {
+            for(int k=0; k<nA; ++k) xA[k] -= Y[g][k]*xG[g];
+        }
+
+        for(int j=nA-1; j>=0; --j)
+        {
+            const std::vector<double>& Lj( L[j] );
+            const int fj( arcFirst[j] );
+
+            xA[j] /= Lj[j-fj];
+            for(int k=fj; k<j; ++k) xA[k] -= Lj[k-fj]*xA[j];
+        }
+
+        solution.resize( params.size(), 0.0 );
+        for(int j=0; j<nA; ++j) solution( arcParams[j] ) = xA[j];
+        for(int g=0; g<nG; ++g) solution( globalParams[g] ) = xG[g];
+
+        // Covariance of the global parameters, inverse(S)
+        std::vector<double> Li( nG*nG, 0.0 );
+        for(int i=0; i<nG; ++i)
+        {
+            Li[i*nG+i] = 1.0/S[i*nG+i];
+            for(int j=0; j<i; ++j)
+            {
+                double s(0.0);
+                for(int k=j; k<i; ++k) s -= S[i*nG+k]*Li[k*nG+j];
+                Li[i*nG+j] = s/S[i*nG+i];
+            }
+        }
+
+        globalCov.resize( nG, nG, 0.0 );
+        for(int a=0; a<nG; ++a)
+        {
+            for(int b=0; b<=a; ++b)
+            {
+                double s(0.0);
+                for(int k=a; k<nG; ++k) s += Li[k*nG+a]*Li[k*nG+b];
+                globalCov(a,b) = globalCov(b,a) = s;
+            }
+        }
+
+        // A posteriori sigma of unit weight
+        double vtpv( lPl );
+        for(size_t p=0; p<params.size(); ++p) vtpv -= rhs[p]*solution(p);
+
+        int dof( numObs - int(params.size()) - numEliminated );
+        sigma0 = ( dof > 0 && vtpv > 0.0 ) ? std::sqrt(vtpv/dof) : 0.0;
+
+        return (*this);
+
+    }  // End of method 'BatchNEQSolver::solve()'
+
+
+    // Get the arc-wise and global parameters, in solution order
+    std::vector<Variable> BatchNEQSolver::getParameters() const
+    {
+        std::vector<Variable> vars;
+        for(size_t p=0; p<params.size(); ++p) vars.push_back( params[p].var );
+
+        return vars;
+
+    }  // End of method 'BatchNEQSolver::getParameters()'
+
+
+    // Get the arc of every parameter, 0 for global ones
+    std::vector<int> BatchNEQSolver::getParameterArcs() const
+    {
+        std::vector<int> arcs;
+        for(size_t p=0; p<params.size(); ++p) arcs.push_back( params[p].arc );
+
+        return arcs;
+
+    }  // End of method 'BatchNEQSolver::getParameterArcs()'
+
+
+    // Get the global parameters, in the order of 'getCovariance()'
+    std::vector<Variable> BatchNEQSolver::getGlobalParameters() const
+    {
+        std::vector<Variable> vars;
+        for(size_t g=0; g<globalParams.size(); ++g)
+        {
+            vars.push_back( params[ globalParams[g] ].var );
+        }
+
+        return vars;
+
+    }  // End of method 'BatchNEQSolver::getGlobalParameters()'
+
+
+    // Get the solution of one parameter.
+    double BatchNEQSolver::getSolution( const Variable& var, int arc ) const
+        throw(InvalidRequest)
+    {
+        std::map<std::pair<int,int>, int>::const_iterator it(
+                          paramIndex.find( std::make_pair(var.getID(), arc) ) );
+
+        if( it == paramIndex.end() || it->second >= int(solution.size()) )
+        {
+            InvalidRequest e("Parameter not solved: "
+                             + StringUtils::asString(var));
+            GPSTK_THROW(e);
+        }
+
+        return solution( it->second );
+
+    }  // End of method 'BatchNEQSolver::getSolution()'
+
+
+}  // End of namespace gpstk
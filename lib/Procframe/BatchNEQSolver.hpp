@@ -0,0 +1,285 @@
+#pragma ident "$Id$"
+
+/**
+ * @file BatchNEQSolver.hpp
+ * Batch least squares solver accumulating normal equations over many
+ * epochs, with pre-elimination of epoch-wise parameters.
+ */
+
+#ifndef GPSTK_BATCHNEQSOLVER_HPP
+#define GPSTK_BATCHNEQSOLVER_HPP
+
+//============================================================================
+//
+//  This file is part of GPSTk, the GPS Toolkit.
+//
+//  The GPSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 2.1 of the License, or
+//  any later version.
+//
+//  The GPSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GPSTk; if not, write to the Free Software Foundation,
+//  Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//============================================================================
+
+
+#include <vector>
+#include <map>
+
+#include "SolverBase.hpp"
+#include "EquationSystemEx.hpp"
+
+
+namespace gpstk
+{
+
+    /** @addtogroup GPSsolutions */
+    /// @ingroup math
+
+    //@{
+
+    /** This class computes batch least squares solutions of the equation
+     *  systems of 'EquationSystemEx' over many epochs, e.g. daily network
+     *  solutions of orbits, clocks and station parameters.
+     *
+     * Parameters are of three kinds:
+     *
+     *    \li Epoch-wise parameters, whose TypeID's are given with
+     *        'setEpochTypes()' (by default receiver and satellite clocks).
+     *        They are pre-eliminated epoch by epoch: the normal equations
+     *        of the epoch are reduced by their Schur complement before
+     *        being added to the accumulated ones.
+     *    \li Arc-wise parameters, whose TypeID's are given with
+     *        'setArcTypes()' (by default the ambiguities). A new parameter
+     *        is set up for every arc, i.e. every value of 'TypeID::satArc'
+     *        in the data of the equation.
+     *    \li Global parameters, all the other ones.
+     *
+     * Each parameter is constrained to zero with the initial variance of
+     * its Variable, as a Kalman filter starting from scratch would do.
+     *
+     * Arc-wise parameters are numbered as they appear, so the reduced
+     * system is stored as an envelope (profile) matrix: the row of every
+     * arc parameter only spans the parameters which were active at the
+     * same time. Global parameters are kept in a dense border. The solution
+     * factors the envelope in place, without fill-in outside it, and then
+     * the dense Schur complement of the global parameters, so the cost
+     * grows with the number of arcs times the square of the number of
+     * simultaneous arcs, instead of the cube of all the parameters.
+     *
+     * @code
+     *   BatchNEQSolver batch;
+     *   batch.addEquation2Source( equPC, source );
+     *   batch.addEquation2Source( equLC, source );
+     *
+     *   while( ... )       // all the epochs of the day
+     *   {
+     *      batch.addEpoch( gdsMap );
+     *   }
+     *
+     *   batch.solve();
+     *   Vector<double> x( batch.getSolution() );
+     * @endcode
+     *
+     * @sa EquationSystemEx.hpp, MeasUpdate.hpp.
+     */
+    class BatchNEQSolver
+    {
+    public:
+
+        /// Default constructor.
+        BatchNEQSolver();
+
+
+        /** Add a new equation to the equation system.
+         *
+         * @param equation      the Equation object to be added.
+         * @param source        the SourceID relative to.
+         */
+        virtual BatchNEQSolver& addEquation2Source( const Equation& equation,
+                                                    const SourceID& source )
+        { equSystem.addEquation2Source( equation, source ); return (*this); };
+
+
+        /// Set the TypeID's of the epoch-wise parameters
+        virtual BatchNEQSolver& setEpochTypes( const TypeIDSet& types )
+        { epochTypes = types; return (*this); };
+
+
+        /// Get the TypeID's of the epoch-wise parameters
+        virtual TypeIDSet getEpochTypes() const
+        { return epochTypes; };
+
+
+        /// Set the TypeID's of the arc-wise parameters
+        virtual BatchNEQSolver& setArcTypes( const TypeIDSet& types )
+        { arcTypes = types; return (*this); };
+
+
+        /// Get the TypeID's of the arc-wise parameters
+        virtual TypeIDSet getArcTypes() const
+        { return arcTypes; };
+
+
+        /** Add the normal equations of one epoch, after pre-eliminating
+         *  its epoch-wise parameters.
+         *
+         * @param gdsMap    Data of the epoch.
+         */
+        virtual BatchNEQSolver& addEpoch( gnssDataMap& gdsMap )
+            throw(InvalidSolver);
+
+
+        /// Solve the accumulated normal equations.
+        virtual BatchNEQSolver& solve()
+            throw(InvalidSolver);
+
+
+        /// Get the number of arc-wise and global parameters
+        virtual int getNumParameters() const
+        { return params.size(); };
+
+
+        /// Get the number of observations added
+        virtual int getNumObservations() const
+        { return numObs; };
+
+
+        /// Get the number of epoch-wise parameters eliminated
+        virtual int getNumEliminated() const
+        { return numEliminated; };
+
+
+        /// Get the arc-wise and global parameters, in solution order
+        virtual std::vector<Variable> getParameters() const;
+
+
+        /// Get the arc of every parameter, 0 for global ones
+        virtual std::vector<int> getParameterArcs() const;
+
+
+        /// Get the solution, in the order of 'getParameters()'
+        virtual Vector<double> getSolution() const
+        { return solution; };
+
+
+        /** Get the solution of one parameter.
+         *
+         * @param var       Variable, with source and satellite set.
+         * @param arc       Arc, for arc-wise parameters.
+         */
+        virtual double getSolution( const Variable& var,
+                                    int arc = 0 ) const
+            throw(InvalidRequest);
+
+
+        /// Get the global parameters, in the order of 'getCovariance()'
+        virtual std::vector<Variable> getGlobalParameters() const;
+
+
+        /// Get the covariance of the global parameters
+        virtual Matrix<double> getCovariance() const
+        { return globalCov; };
+
+
+        /// Get the a posteriori sigma of unit weight
+        virtual double getSigma0() const
+        { return sigma0; };
+
+
+        /// Remove all the normal equations
+        virtual BatchNEQSolver& reset();
+
+
+        /// Destructor.
+        virtual ~BatchNEQSolver() {};
+
+
+    private:
+
+        /// Parameter of the reduced normal equations
+        struct Parameter
+        {
+            Variable var;       ///< Variable
+            int arc;            ///< Arc, 0 for global parameters
+            bool global;        ///< Whether it is a global parameter
+            int index;          ///< Index in the arc or global block
+        };
+
+
+        /// Get the index of a parameter, adding it if new
+        int getParameter( const Variable& var, int arc );
+
+
+        /// Add 'value' to the element (i,j) of the reduced normal matrix
+        void addNormal( int i, int j, double value );
+
+
+        /// Equation system
+        EquationSystemEx equSystem;
+
+        /// Empty state store needed by the equation system
+        StateStore stateStore;
+
+        /// TypeID's of the epoch-wise parameters
+        TypeIDSet epochTypes;
+
+        /// TypeID's of the arc-wise parameters
+        TypeIDSet arcTypes;
+
+
+        /// Arc-wise and global parameters, in the order they appear
+        std::vector<Parameter> params;
+
+        /// Index of every (Variable ID, arc) in 'params'
+        std::map<std::pair<int,int>, int> paramIndex;
+
+        /// Parameter of every arc-wise index, and of every global index
+        std::vector<int> arcParams, globalParams;
+
+
+        /// Envelope of the arc-wise block: row i spans [arcFirst[i], i]
+        std::vector< std::vector<double> > arcRows;
+        std::vector<int> arcFirst;
+
+        /// Global x arc-wise block, one row per global parameter
+        std::vector< std::vector<double> > globalArcRows;
+
+        /// Global block, lower triangle, row i has i+1 elements
+        std::vector< std::vector<double> > globalRows;
+
+        /// Right hand side, in the order of 'params'
+        std::vector<double> rhs;
+
+        /// Reduced l'Pl
+        double lPl;
+
+        /// Number of observations and eliminated parameters
+        int numObs;
+        int numEliminated;
+
+
+        /// Solution, in the order of 'params'
+        Vector<double> solution;
+
+        /// Covariance of the global parameters
+        Matrix<double> globalCov;
+
+        /// A posteriori sigma of unit weight
+        double sigma0;
+
+
+    }; // End of class 'BatchNEQSolver'
+
+    //@}
+
+}  // End of namespace gpstk
+
+#endif   // GPSTK_BATCHNEQSOLVER_HPP
@@ -0,0 +1,952 @@
+#pragma ident "$Id$"
+
+/**
+ * @file BinaryObsCache.cpp
+ * Binary, indexed cache of a RINEX observation file, with the observations
+ * stored by columns.
+ */
+
+//============================================================================
+//
+//  This file is part of GPSTk, the GPS Toolkit.
+//
+//  The GPSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 2.1 of the License, or
+//  any later version.
+//
+//  The GPSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GPSTk; if not, write to the Free Software Foundation,
+//  Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//============================================================================
+
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include "BinaryObsCache.hpp"
+#include "Rinex3ObsStream.hpp"
+#include "EpochArena.hpp"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#if !defined(_MSC_VER)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+using namespace std;
+
+
+namespace gpstk
+{
+
+      // Identification and version of the format
+    static const char cacheMagic[8] = { 'R','O','C','K','E','T','O','C' };
+    static const unsigned long cacheVersion = 1;
+
+      // Encodings of a column of observations
+    static const unsigned char encodeRaw = 0;
+    static const unsigned char encodeFirstDiff = 1;
+    static const unsigned char encodeSecondDiff = 2;
+    static const unsigned char encodeFlags = 0x80;
+
+
+      // Append an unsigned integer of 'n' bytes, little endian
+    static void putFixed(std::string& out, unsigned long long value, int n)
+    {
+        for(int i = 0; i < n; ++i)
+        {
+            out += static_cast<char>( (value >> (8*i)) & 0xff );
+        }
+    }
+
+      // Append a double, little endian
+    static void putDouble(std::string& out, double value)
+    {
+        unsigned long long bits;
+        memcpy(&bits, &value, sizeof(bits));
+        putFixed(out, bits, 8);
+    }
+
+      // Append an unsigned variable length integer, 7 bits per byte
+    static void putVarint(std::string& out, unsigned long long value)
+    {
+        while(value >= 0x80)
+        {
+            out += static_cast<char>( (value & 0x7f) | 0x80 );
+            value >>= 7;
+        }
+        out += static_cast<char>(value);
+    }
+
+      // Append a signed variable length integer, zigzag encoded
+    static void putSigned(std::string& out, long long value)
+    {
+        putVarint( out, (static_cast<unsigned long long>(value) << 1)
+                        ^ static_cast<unsigned long long>(value >> 63) );
+    }
+
+      // Length of a signed variable length integer
+    static size_t signedSize(long long value)
+    {
+        unsigned long long u( (static_cast<unsigned long long>(value) << 1)
+                              ^ static_cast<unsigned long long>(value >> 63) );
+        size_t n(1);
+        while(u >= 0x80)
+        {
+            u >>= 7;
+            ++n;
+        }
+        return n;
+    }
+
+      // Append a string, after its length
+    static void putString(std::string& out, const std::string& str)
+    {
+        putVarint(out, str.size());
+        out += str;
+    }
+
+
+      // Reader of the data of the file, checking its limits
+    class ByteReader
+    {
+    public:
+
+        ByteReader(const unsigned char* begin, const unsigned char* end)
+            : p(begin), pEnd(end)
+        {};
+
+        const unsigned char* take(size_t n)
+        {
+            if( static_cast<size_t>(pEnd - p) < n )
+            {
+                Exception e("Truncated observation cache");
+                GPSTK_THROW(e);
+            }
+            const unsigned char* q(p);
+            p += n;
+            return q;
+        };
+
+        unsigned long long getFixed(int n)
+        {
+            const unsigned char* q( take(n) );
+            unsigned long long value(0);
+            for(int i = 0; i < n; ++i)
+            {
+                value |= static_cast<unsigned long long>(q[i]) << (8*i);
+            }
+            return value;
+        };
+
+        double getDouble()
+        {
+            unsigned long long bits( getFixed(8) );
+            double value;
+            memcpy(&value, &bits, sizeof(value));
+            return value;
+        };
+
+        unsigned long long getVarint()
+        {
+            unsigned long long value(0);
+            for(int shift = 0; shift < 64; shift += 7)
+            {
+                unsigned char b( *take(1) );
+                value |= static_cast<unsigned long long>(b & 0x7f) << shift;
+                if( !(b & 0x80) ) return value;
+            }
+
+            Exception e("Invalid integer in observation cache");
+            GPSTK_THROW(e);
+        };
+
+        long long getSigned()
+        {
+            unsigned long long u( getVarint() );
+            return static_cast<long long>(u >> 1)
+                   ^ -static_cast<long long>(u & 1);
+        };
+
+        std::string getString()
+        {
+            size_t n( getVarint() );
+            const unsigned char* q( take(n) );
+            return std::string(reinterpret_cast<const char*>(q), n);
+        };
+
+    private:
+
+        const unsigned char* p;
+        const unsigned char* pEnd;
+    };
+
+
+      // Value in thousandths, if it has no more than three decimals
+    static bool toThousandths(double value, long long& scaled)
+    {
+        if( !(std::fabs(value) < 9.0e15) ) return false;
+
+        scaled = static_cast<long long>( std::floor(value*1000.0 + 0.5) );
+
+        return ( scaled/1000.0 == value );
+    }
+
+
+      // Epoch of the observations, while converting
+    struct CacheEpoch
+    {
+        CommonTime time;
+        short flag;
+        Rinex3ObsData::DataMap obs;
+    };
+
+
+      // Append a block of epochs
+    static void putBlock( std::string& out,
+                          const std::vector<CacheEpoch>& epochs,
+                          std::map<RinexSatID, size_t>& satIndex,
+                          std::vector<RinexSatID>& satTable )
+    {
+        size_t n( epochs.size() );
+
+        // Satellites of the block, and the epochs they are in
+        std::map< RinexSatID, std::vector<size_t> > satEpochs;
+        for(size_t k = 0; k < n; ++k)
+        {
+            for( Rinex3ObsData::DataMap::const_iterator it =
+                                                    epochs[k].obs.begin();
+                 it != epochs[k].obs.end();
+                 ++it )
+            {
+                satEpochs[it->first].push_back(k);
+            }
+        }
+
+        putVarint(out, n);
+        putVarint(out, satEpochs.size());
+
+        for( std::map< RinexSatID, std::vector<size_t> >::const_iterator
+                it = satEpochs.begin();
+             it != satEpochs.end();
+             ++it )
+        {
+            const RinexSatID& sat(it->first);
+            const std::vector<size_t>& list(it->second);
+
+            std::map<RinexSatID, size_t>::iterator its( satIndex.find(sat) );
+            if( its == satIndex.end() )
+            {
+                its = satIndex.insert( make_pair(sat, satTable.size()) ).first;
+                satTable.push_back(sat);
+            }
+
+            putVarint(out, its->second);
+
+            // Bitmap of the epochs of the satellite
+            std::string bitmap( (n + 7)/8, '\0' );
+            for(size_t i = 0; i < list.size(); ++i)
+            {
+                bitmap[ list[i]/8 ] |= static_cast<char>( 1 << (list[i]%8) );
+            }
+            out += bitmap;
+
+            // Observations of the satellite, epoch by epoch
+            std::vector<const std::vector<RinexDatum>*> data;
+            size_t numColumns(0);
+            for(size_t i = 0; i < list.size(); ++i)
+            {
+                data.push_back( &(epochs[ list[i] ].obs.find(sat)->second) );
+                numColumns = std::max(numColumns, data.back()->size());
+            }
+
+            putVarint(out, numColumns);
+
+            std::vector<double> values( list.size() );
+            std::vector<long long> scaled( list.size() );
+            std::string flags( list.size(), '\0' );
+
+            for(size_t j = 0; j < numColumns; ++j)
+            {
+                bool haveFlags(false);
+                bool exact(true);
+
+                for(size_t i = 0; i < list.size(); ++i)
+                {
+                    const std::vector<RinexDatum>& datum( *data[i] );
+
+                    double value(0.0);
+                    short lli(0), ssi(0);
+                    if( j < datum.size() )
+                    {
+                        value = datum[j].data;
+                        lli = datum[j].lli;
+                        ssi = datum[j].ssi;
+                    }
+
+                    values[i] = value;
+                    flags[i] = static_cast<char>( (lli & 0x0f) | (ssi << 4) );
+                    if(lli != 0 || ssi != 0) haveFlags = true;
+
+                    if( exact && !toThousandths(value, scaled[i]) )
+                    {
+                        exact = false;
+                    }
+                }
+
+                std::string column;
+                unsigned char encoding(encodeRaw);
+
+                if(exact)
+                {
+                    // First and second differences, whichever are shorter
+                    size_t size1(0), size2(0);
+                    for(size_t i = 0; i < list.size(); ++i)
+                    {
+                        long long d1( (i > 0) ? scaled[i] - scaled[i-1]
+                                              : scaled[i] );
+                        long long d2( d1 );
+                        if(i > 1) d2 = d1 - (scaled[i-1] - scaled[i-2]);
+                        size1 += signedSize(d1);
+                        size2 += signedSize(d2);
+                    }
+
+                    encoding = (size2 < size1) ? encodeSecondDiff
+                                               : encodeFirstDiff;
+
+                    for(size_t i = 0; i < list.size(); ++i)
+                    {
+                        long long d( (i > 0) ? scaled[i] - scaled[i-1]
+                                             : scaled[i] );
+                        if( encoding == encodeSecondDiff && i > 1 )
+                        {
+                            d -= scaled[i-1] - scaled[i-2];
+                        }
+                        putSigned(column, d);
+                    }
+                }
+                else
+                {
+                    for(size_t i = 0; i < list.size(); ++i)
+                    {
+                        putDouble(column, values[i]);
+                    }
+                }
+
+                if(haveFlags) encoding |= encodeFlags;
+
+                out += static_cast<char>(encoding);
+                putVarint(out, column.size());
+                out += column;
+
+                if(haveFlags) out += flags;
+            }
+        }
+
+    }  // End of function 'putBlock()'
+
+
+
+      // Common constructor, opening a cache.
+    BinaryObsCache::BinaryObsCache(const std::string& file)
+        throw(Exception)
+        : pData(NULL), dataSize(0), mapped(false), epochsPerBlock(0),
+          currentBlock(-1), nextEpoch(0)
+    {
+        open(file);
+
+    }  // End of constructor 'BinaryObsCache::BinaryObsCache()'
+
+
+
+      // Convert a RINEX observation file to a cache.
+    size_t BinaryObsCache::convert( const std::string& rinexFile,
+                                    const std::string& cacheFile,
+                                    size_t epochsPerBlock )
+        throw(Exception)
+    {
+        if(epochsPerBlock == 0) epochsPerBlock = 1;
+
+        Rinex3ObsStream rin;
+        Rinex3ObsHeader hdr;
+
+        try
+        {
+            rin.exceptions(std::ios::failbit);
+            rin.open(rinexFile.c_str(), std::ios::in);
+            rin >> hdr;
+        }
+        catch(...)
+        {
+            Exception e("Can not read the header of " + rinexFile);
+            GPSTK_THROW(e);
+        }
+
+        std::ofstream out( cacheFile.c_str(),
+                           std::ios::out | std::ios::binary | std::ios::trunc );
+        if( !out )
+        {
+            Exception e("Can not create " + cacheFile);
+            GPSTK_THROW(e);
+        }
+
+        // Header, with a place for the offset of the index
+        std::string head(cacheMagic, sizeof(cacheMagic));
+        putFixed(head, cacheVersion, 4);
+        size_t indexPos( head.size() );
+        putFixed(head, 0, 8);
+
+        putVarint(head, epochsPerBlock);
+        putString(head, hdr.markerName);
+        putString(head, hdr.markerNumber);
+        putString(head, hdr.antType);
+        putDouble(head, hdr.antennaPosition[0]);
+        putDouble(head, hdr.antennaPosition[1]);
+        putDouble(head, hdr.antennaPosition[2]);
+        putVarint(head, hdr.fileSysSat.system);
+
+        putVarint(head, hdr.mapObsTypes.size());
+        for( std::map< std::string, std::vector<RinexObsID> >::const_iterator
+                it = hdr.mapObsTypes.begin();
+             it != hdr.mapObsTypes.end();
+             ++it )
+        {
+            putString(head, it->first);
+            putVarint(head, it->second.size());
+            for(size_t i = 0; i < it->second.size(); ++i)
+            {
+                putString(head, it->second[i].asString());
+            }
+        }
+
+        out.write(head.data(), head.size());
+        unsigned long long offset( head.size() );
+
+        // Blocks of observations
+        std::map<RinexSatID, size_t> satIndex;
+        std::vector<RinexSatID> satTable;
+        std::vector<CommonTime> times;
+        std::vector<short> flags;
+        std::vector<unsigned long long> blockOffsets;
+
+        std::vector<CacheEpoch> epochs;
+        std::string block;
+
+        rin.exceptions(std::ios::goodbit);
+
+        while(true)
+        {
+            Rinex3ObsData rod;
+            bool more( rin >> rod );
+
+            if(more)
+            {
+                epochs.push_back( CacheEpoch() );
+                epochs.back().time = rod.time;
+                epochs.back().flag = rod.epochFlag;
+                epochs.back().obs.swap(rod.obs);
+
+                times.push_back(rod.time);
+                flags.push_back(rod.epochFlag);
+            }
+
+            if( epochs.size() == epochsPerBlock
+                || ( !more && !epochs.empty() ) )
+            {
+                block.clear();
+                putBlock(block, epochs, satIndex, satTable);
+
+                out.write(block.data(), block.size());
+                blockOffsets.push_back(offset);
+                offset += block.size();
+
+                epochs.clear();
+            }
+
+            if(!more) break;
+        }
+
+        // Index of the satellites, epochs and blocks
+        std::string index;
+
+        putVarint(index, satTable.size());
+        for(size_t i = 0; i < satTable.size(); ++i)
+        {
+            putVarint(index, satTable[i].system);
+            putVarint(index, satTable[i].id);
+        }
+
+        putVarint(index, times.size());
+        for(size_t i = 0; i < times.size(); ++i)
+        {
+            long day, msod;
+            double fsod;
+            TimeSystem ts;
+            times[i].getInternal(day, msod, fsod, ts);
+
+            putVarint(index, day);
+            putVarint(index, msod);
+            putDouble(index, fsod);
+            putVarint(index, ts.getTimeSystem());
+            putVarint(index, flags[i]);
+        }
+
+        putVarint(index, blockOffsets.size());
+        for(size_t i = 0; i < blockOffsets.size(); ++i)
+        {
+            putVarint(index, blockOffsets[i]);
+        }
+
+        out.write(index.data(), index.size());
+
+        std::string pos;
+        putFixed(pos, offset, 8);
+        out.seekp(indexPos);
+        out.write(pos.data(), pos.size());
+
+        out.close();
+
+        if( !out )
+        {
+            Exception e("Can not write " + cacheFile);
+            GPSTK_THROW(e);
+        }
+
+        return times.size();
+
+    }  // End of method 'BinaryObsCache::convert()'
+
+
+
+      // Whether a cache exists for a RINEX file, and is not older than it.
+    bool BinaryObsCache::isUpToDate( const std::string& rinexFile,
+                                     const std::string& cacheFile )
+    {
+        struct stat rinexStat, cacheStat;
+
+        if( stat(cacheFile.c_str(), &cacheStat) != 0 ) return false;
+        if( stat(rinexFile.c_str(), &rinexStat) != 0 ) return true;
+
+        return ( cacheStat.st_mtime >= rinexStat.st_mtime );
+
+    }  // End of method 'BinaryObsCache::isUpToDate()'
+
+
+
+      // Open a cache.
+    void BinaryObsCache::open(const std::string& file)
+        throw(Exception)
+    {
+        close();
+
+#if !defined(_MSC_VER)
+        int fd( ::open(file.c_str(), O_RDONLY) );
+        if(fd >= 0)
+        {
+            struct stat st;
+            if( fstat(fd, &st) == 0 && st.st_size > 0 )
+            {
+                void* p( mmap( NULL, st.st_size, PROT_READ, MAP_PRIVATE,
+                               fd, 0 ) );
+                if(p != MAP_FAILED)
+                {
+                    pData = static_cast<const unsigned char*>(p);
+                    dataSize = st.st_size;
+                    mapped = true;
+                }
+            }
+            ::close(fd);
+        }
+#endif
+
+        // Where mapping is not possible, read the file at once
+        if(pData == NULL)
+        {
+            std::ifstream in( file.c_str(), std::ios::in | std::ios::binary );
+            if(in)
+            {
+                buffer.assign( std::istreambuf_iterator<char>(in),
+                               std::istreambuf_iterator<char>() );
+            }
+
+            if( buffer.empty() )
+            {
+                Exception e("Can not read " + file);
+                GPSTK_THROW(e);
+            }
+
+            pData = &buffer[0];
+            dataSize = buffer.size();
+        }
+
+        try
+        {
+            ByteReader head(pData, pData + dataSize);
+
+            if( memcmp( head.take(sizeof(cacheMagic)), cacheMagic,
+                        sizeof(cacheMagic) ) != 0 ||
+                head.getFixed(4) != cacheVersion )
+            {
+                Exception e("Not an observation cache of this version");
+                GPSTK_THROW(e);
+            }
+
+            size_t indexOffset( head.getFixed(8) );
+
+            epochsPerBlock = head.getVarint();
+
+            std::string markerName( head.getString() );
+            std::string markerNumber( head.getString() );
+            antennaType = head.getString();
+            antennaPosition[0] = head.getDouble();
+            antennaPosition[1] = head.getDouble();
+            antennaPosition[2] = head.getDouble();
+
+            SatID fileSys( -1, static_cast<SatID::SatelliteSystem>(
+                                                        head.getVarint() ) );
+
+            source.type = SatIDsystem2SourceIDtype(fileSys);
+            source.sourceName = markerName;
+            source.sourceNumber = markerNumber;
+
+            // Observation types, to compile the decoding plan
+            roh.mapObsTypes.clear();
+            size_t numSys( head.getVarint() );
+            for(size_t i = 0; i < numSys; ++i)
+            {
+                std::string sys( head.getString() );
+                std::vector<RinexObsID>& types( roh.mapObsTypes[sys] );
+
+                size_t numTypes( head.getVarint() );
+                for(size_t j = 0; j < numTypes; ++j)
+                {
+                    types.push_back( RinexObsID( sys + head.getString() ) );
+                }
+            }
+
+            plan.compile(roh);
+
+            // Index
+            if(indexOffset > dataSize)
+            {
+                Exception e("Invalid offset of the index");
+                GPSTK_THROW(e);
+            }
+
+            ByteReader index(pData + indexOffset, pData + dataSize);
+
+            size_t numSats( index.getVarint() );
+            for(size_t i = 0; i < numSats; ++i)
+            {
+                SatID::SatelliteSystem system(
+                    static_cast<SatID::SatelliteSystem>( index.getVarint() ) );
+                int id( index.getVarint() );
+                satTable.push_back( RinexSatID(id, system) );
+            }
+
+            size_t numEpochs( index.getVarint() );
+            epochTimes.reserve(numEpochs);
+            epochFlags.reserve(numEpochs);
+            for(size_t i = 0; i < numEpochs; ++i)
+            {
+                long day( index.getVarint() );
+                long msod( index.getVarint() );
+                double fsod( index.getDouble() );
+                TimeSystem ts( static_cast<int>( index.getVarint() ) );
+
+                CommonTime time;
+                time.setInternal(day, msod, fsod, ts);
+
+                epochTimes.push_back(time);
+                epochFlags.push_back( index.getVarint() );
+            }
+
+            size_t numBlocks( index.getVarint() );
+            for(size_t i = 0; i < numBlocks; ++i)
+            {
+                size_t offset( index.getVarint() );
+                if(offset >= indexOffset)
+                {
+                    Exception e("Invalid offset of a block");
+                    GPSTK_THROW(e);
+                }
+                blockOffsets.push_back(offset);
+            }
+
+            if( epochsPerBlock == 0 ||
+                numBlocks != (numEpochs + epochsPerBlock - 1)/epochsPerBlock )
+            {
+                Exception e("Invalid number of blocks");
+                GPSTK_THROW(e);
+            }
+        }
+        catch(Exception& u)
+        {
+            close();
+
+            Exception e("Invalid observation cache " + file + ": "
+                        + u.getText());
+            GPSTK_THROW(e);
+        }
+
+    }  // End of method 'BinaryObsCache::open()'
+
+
+
+      // Close the cache.
+    void BinaryObsCache::close()
+    {
+#if !defined(_MSC_VER)
+        if(mapped)
+        {
+            munmap( const_cast<unsigned char*>(pData), dataSize );
+        }
+#endif
+
+        pData = NULL;
+        dataSize = 0;
+        mapped = false;
+        std::vector<unsigned char>().swap(buffer);
+
+        satTable.clear();
+        epochTimes.clear();
+        epochFlags.clear();
+        blockOffsets.clear();
+        epochsPerBlock = 0;
+
+        currentBlock = -1;
+        blockBody.clear();
+
+        nextEpoch = 0;
+
+    }  // End of method 'BinaryObsCache::close()'
+
+
+
+      // Index of the first epoch not earlier than a time
+    size_t BinaryObsCache::lowerBound(const CommonTime& time) const
+    {
+        return std::lower_bound( epochTimes.begin(), epochTimes.end(), time )
+               - epochTimes.begin();
+
+    }  // End of method 'BinaryObsCache::lowerBound()'
+
+
+
+      // Index of the epoch closest to a time, within a tolerance.
+    long BinaryObsCache::findEpoch( const CommonTime& time,
+                                    double tolerance ) const
+    {
+        size_t i( lowerBound(time) );
+
+        long best(-1);
+        double bestDiff(tolerance);
+
+        if( i < epochTimes.size() )
+        {
+            double diff( std::fabs(epochTimes[i] - time) );
+            if(diff <= bestDiff)
+            {
+                best = i;
+                bestDiff = diff;
+            }
+        }
+
+        if( i > 0 )
+        {
+            double diff( std::fabs(epochTimes[i-1] - time) );
+            if(diff <= bestDiff) best = i - 1;
+        }
+
+        return best;
+
+    }  // End of method 'BinaryObsCache::findEpoch()'
+
+
+
+      // Read an epoch.
+    void BinaryObsCache::readEpoch(size_t index, gnssRinex& gRin)
+        throw(Exception)
+    {
+        if( index >= epochTimes.size() )
+        {
+            Exception e("Epoch out of the observation cache");
+            GPSTK_THROW(e);
+        }
+
+        size_t block( index/epochsPerBlock );
+        if( currentBlock != static_cast<long>(block) ) decodeBlock(block);
+
+        gRin.header.source = source;
+        gRin.header.antennaType = antennaType;
+        gRin.header.antennaPosition = antennaPosition;
+        gRin.header.epochFlag = epochFlags[index];
+        gRin.header.epoch = epochTimes[index];
+
+        gRin.body = blockBody[ index - block*epochsPerBlock ];
+
+    }  // End of method 'BinaryObsCache::readEpoch()'
+
+
+
+      // Read the epochs within a time span.
+    void BinaryObsCache::readEpochRange( const CommonTime& start,
+                                         const CommonTime& end,
+                                         std::vector<gnssRinex>& data )
+        throw(Exception)
+    {
+        data.clear();
+
+        for( size_t i = lowerBound(start);
+             i < epochTimes.size() && epochTimes[i] <= end;
+             ++i )
+        {
+            data.push_back( gnssRinex() );
+            readEpoch(i, data.back());
+        }
+
+    }  // End of method 'BinaryObsCache::readEpochRange()'
+
+
+
+      // Read the next epoch.
+    bool BinaryObsCache::readEpoch(gnssRinex& gRin)
+        throw(Exception)
+    {
+        if( nextEpoch >= epochTimes.size() ) return false;
+
+        readEpoch(nextEpoch, gRin);
+        ++nextEpoch;
+
+        return true;
+
+    }  // End of method 'BinaryObsCache::readEpoch()'
+
+
+
+      // Decode a block of epochs into 'blockBody'
+    void BinaryObsCache::decodeBlock(size_t block)
+        throw(Exception)
+    {
+        // The block is kept beyond the epoch, so it is not taken from the
+        // arena of the epoch
+        EpochArena::Scope heap(NULL);
+
+        currentBlock = -1;
+        blockBody.clear();
+
+        size_t end( (block + 1 < blockOffsets.size()) ? blockOffsets[block+1]
+                                                      : dataSize );
+
+        ByteReader in(pData + blockOffsets[block], pData + end);
+
+        size_t n( in.getVarint() );
+        size_t first( block*epochsPerBlock );
+        if( n != std::min(epochsPerBlock, epochTimes.size() - first) )
+        {
+            Exception e("Invalid number of epochs in a block");
+            GPSTK_THROW(e);
+        }
+
+        std::vector<Rinex3ObsData::DataMap> obs(n);
+
+        size_t numSats( in.getVarint() );
+        for(size_t s = 0; s < numSats; ++s)
+        {
+            size_t index( in.getVarint() );
+            if( index >= satTable.size() )
+            {
+                Exception e("Invalid satellite in a block");
+                GPSTK_THROW(e);
+            }
+
+            const RinexSatID& sat( satTable[index] );
+
+            const unsigned char* bitmap( in.take( (n + 7)/8 ) );
+
+            size_t numColumns( in.getVarint() );
+
+            std::vector< std::vector<RinexDatum>* > data;
+            for(size_t k = 0; k < n; ++k)
+            {
+                if( bitmap[k/8] & (1 << (k%8)) )
+                {
+                    std::vector<RinexDatum>& datum( obs[k][sat] );
+                    datum.resize(numColumns);
+                    data.push_back(&datum);
+                }
+            }
+
+            for(size_t j = 0; j < numColumns; ++j)
+            {
+                unsigned char encoding( *in.take(1) );
+                size_t size( in.getVarint() );
+
+                const unsigned char* pColumn( in.take(size) );
+                ByteReader column(pColumn, pColumn + size);
+
+                unsigned char kind( encoding & ~encodeFlags );
+
+                long long previous(0), difference(0);
+                for(size_t i = 0; i < data.size(); ++i)
+                {
+                    double value;
+
+                    if(kind == encodeRaw)
+                    {
+                        value = column.getDouble();
+                    }
+                    else
+                    {
+                        long long d( column.getSigned() );
+
+                        if(kind == encodeSecondDiff && i > 1)
+                            difference += d;
+                        else
+                            difference = d;
+
+                        previous += difference;
+                        value = previous/1000.0;
+                    }
+
+                    (*data[i])[j].data = value;
+                }
+
+                if(encoding & encodeFlags)
+                {
+                    const unsigned char* flags( in.take( data.size() ) );
+                    for(size_t i = 0; i < data.size(); ++i)
+                    {
+                        (*data[i])[j].lli = flags[i] & 0x0f;
+                        (*data[i])[j].ssi = flags[i] >> 4;
+                    }
+                }
+            }
+        }
+
+        // Decode the observations as 'operator>>' does
+        blockBody.resize(n);
+        for(size_t k = 0; k < n; ++k)
+        {
+            rod.obs.swap(obs[k]);
+            blockBody[k] = plan.decode(rod);
+        }
+
+        currentBlock = block;
+
+    }  // End of method 'BinaryObsCache::decodeBlock()'
+
+
+}  // End of namespace gpstk
@@ -0,0 +1,266 @@
+#pragma ident "$Id$"
+
+/**
+ * @file BinaryObsCache.hpp
+ * Binary, indexed cache of a RINEX observation file, with the observations
+ * stored by columns.
+ */
+
+#ifndef GPSTK_BINARYOBSCACHE_HPP
+#define GPSTK_BINARYOBSCACHE_HPP
+
+//============================================================================
+//
+//  This file is part of GPSTk, the GPS Toolkit.
+//
+//  The GPSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 2.1 of the License, or
+//  any later version.
+//
+//  The GPSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GPSTk; if not, write to the Free Software Foundation,
+//  Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//============================================================================
+
+
+#include <string>
+#include <vector>
+#include "DataStructures.hpp"
+#include "Rinex3ObsHeader.hpp"
+#include "Rinex3ObsData.hpp"
+
+
+namespace gpstk
+{
+
+    /// @ingroup DataStructures
+    //@{
+
+    /** This class converts a RINEX 2 or 3 observation file to a compact
+     *  binary cache, and reads the cache back as gnssRinex objects, the
+     *  same ones given by a Rinex3ObsStream.
+     *
+     * Reprocessing the same files many times, e.g. when the parameters of
+     * a solution are tuned, the text parsing of the RINEX files takes most
+     * of the time of every run. The cache is written once:
+     *
+     * @code
+     *   BinaryObsCache::convert("onsa0010.15o", "onsa0010.15o.obc");
+     * @endcode
+     *
+     * and then read in the runs, sequentially or by epoch:
+     *
+     * @code
+     *   BinaryObsCache cache("onsa0010.15o.obc");
+     *   cache.seek( CivilTime(2015,1,1,12,0,0.0, TimeSystem::GPS) );
+     *
+     *   gnssRinex gRin;
+     *   while( cache.readEpoch(gRin) )
+     *   {
+     *      // processing code here
+     *   }
+     * @endcode
+     *
+     * The cache holds the header fields used by the processing (marker,
+     * antenna and observation types) once, an index with the time tag and
+     * the flag of every epoch, and the observations in blocks of epochs.
+     * Within a block, the observations are stored by columns, one per
+     * satellite and observation type, after a bitmap of the epochs of the
+     * satellite: the values, in thousandths, are stored as the first or
+     * second differences along the column, whichever is shorter, in
+     * variable length integers; the LLI and SSI flags, only if any is set,
+     * in a byte each. Values with more than three decimals are stored as
+     * they are. The auxiliary headers of the event epochs are not kept.
+     *
+     * The file is mapped in memory (or read at once, where mapping is not
+     * supported), and a block is decoded when one of its epochs is first
+     * read. The observations are decoded with the same plan as in
+     * 'operator>>', so the data are exactly the same as read from the
+     * RINEX file.
+     *
+     * @sa NetworkObsCache, to read the caches of a network.
+     */
+    class BinaryObsCache
+    {
+    public:
+
+        /// Default constructor
+        BinaryObsCache()
+            : pData(NULL), dataSize(0), mapped(false), epochsPerBlock(0),
+              currentBlock(-1), nextEpoch(0)
+        {};
+
+        /// Common constructor, opening a cache.
+        explicit BinaryObsCache(const std::string& file)
+            throw(Exception);
+
+        /// Destructor
+        virtual ~BinaryObsCache()
+        { close(); };
+
+
+        /** Convert a RINEX observation file to a cache.
+         *
+         * @param rinexFile         RINEX 2 or 3 observation file.
+         * @param cacheFile         Cache to be written.
+         * @param epochsPerBlock    Epochs of every block of observations.
+         *
+         * @return  Number of epochs written.
+         */
+        static size_t convert( const std::string& rinexFile,
+                               const std::string& cacheFile,
+                               size_t epochsPerBlock = 120 )
+            throw(Exception);
+
+
+        /** Whether a cache exists for a RINEX file, and is not older than
+         *  it.
+         */
+        static bool isUpToDate( const std::string& rinexFile,
+                                const std::string& cacheFile );
+
+
+        /// Open a cache.
+        void open(const std::string& file)
+            throw(Exception);
+
+        /// Close the cache.
+        void close();
+
+        /// Whether a cache is open
+        bool isOpen() const
+        { return (pData != NULL); };
+
+
+        /// Source of the observations
+        const SourceID& getSource() const
+        { return source; };
+
+        /// Antenna type
+        const std::string& getAntennaType() const
+        { return antennaType; };
+
+        /// Antenna position
+        const Triple& getAntennaPosition() const
+        { return antennaPosition; };
+
+
+        /// Number of epochs
+        size_t getNumEpochs() const
+        { return epochTimes.size(); };
+
+        /// Time tag of an epoch
+        const CommonTime& getEpoch(size_t index) const
+        { return epochTimes[index]; };
+
+        /// Index of the first epoch not earlier than a time, or the number
+        /// of epochs if there is none.
+        size_t lowerBound(const CommonTime& time) const;
+
+        /** Index of the epoch closest to a time, within a tolerance.
+         *
+         * @return  Index of the epoch, or -1 if there is none.
+         */
+        long findEpoch( const CommonTime& time,
+                        double tolerance = 0.0 ) const;
+
+
+        /** Read an epoch.
+         *
+         * @param index     Index of the epoch.
+         * @param gRin      Object to hold the data.
+         */
+        void readEpoch(size_t index, gnssRinex& gRin)
+            throw(Exception);
+
+        /** Read the epochs within a time span.
+         *
+         * @param start     First time of the span.
+         * @param end       Last time of the span.
+         * @param data      Objects to hold the data, one per epoch.
+         */
+        void readEpochRange( const CommonTime& start,
+                             const CommonTime& end,
+                             std::vector<gnssRinex>& data )
+            throw(Exception);
+
+
+        /// Read the next epoch, as 'operator>>' does from a stream.
+        /// @return  Whether there was an epoch.
+        bool readEpoch(gnssRinex& gRin)
+            throw(Exception);
+
+        /// Make the first epoch not earlier than a time the next one to be
+        /// read.
+        void seek(const CommonTime& time)
+        { nextEpoch = lowerBound(time); };
+
+        /// Make an epoch the next one to be read.
+        void seekEpoch(size_t index)
+        { nextEpoch = index; };
+
+        /// Index of the next epoch to be read
+        size_t tell() const
+        { return nextEpoch; };
+
+
+    private:
+
+        /// Decode a block of epochs into 'blockBody'
+        void decodeBlock(size_t block)
+            throw(Exception);
+
+
+        /// Data of the file
+        const unsigned char* pData;
+        size_t dataSize;
+        bool mapped;
+        std::vector<unsigned char> buffer;
+
+        /// Header fields
+        SourceID source;
+        std::string antennaType;
+        Triple antennaPosition;
+
+        /// Header to compile the decoding plan
+        Rinex3ObsHeader roh;
+        Rinex3ObsDecodePlan plan;
+
+        /// Satellites of the file
+        std::vector<RinexSatID> satTable;
+
+        /// Epochs
+        std::vector<CommonTime> epochTimes;
+        std::vector<short> epochFlags;
+
+        /// Blocks
+        size_t epochsPerBlock;
+        std::vector<size_t> blockOffsets;
+
+        /// Block decoded, and its observations
+        long currentBlock;
+        std::vector<satTypeValueMap> blockBody;
+
+        /// Object to decode the observations of an epoch
+        Rinex3ObsData rod;
+
+        /// Next epoch to be read
+        size_t nextEpoch;
+
+        BinaryObsCache(const BinaryObsCache&);
+        BinaryObsCache& operator=(const BinaryObsCache&);
+
+    }; // End of class 'BinaryObsCache'
+
+    //@}
+
+}  // End of namespace gpstk
+
+#endif   // GPSTK_BINARYOBSCACHE_HPP
@@ -0,0 +1,883 @@
+#pragma ident "$Id$"
+
+/**
+ * @file CSDetectorBank.cpp
+ * This class runs the LI and Melbourne-Wubbena cycle slip tests and the
+ * satellite arc bookkeeping in a single pass over the data.
+ */
+
+//============================================================================
+//
+//  This file is part of GPSTk, the GPS Toolkit.
+//
+//  The GPSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 2.1 of the License, or
+//  any later version.
+//
+//  The GPSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GPSTk; if not, write to the Free Software Foundation,
+//  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+//
+//============================================================================
+
+
+#include <cmath>
+
+#include "CSDetectorBank.hpp"
+#include "constants.hpp"
+
+
+namespace gpstk
+{
+
+      // Returns a string identifying this object.
+   std::string CSDetectorBank::getClassName() const
+   { return "CSDetectorBank"; }
+
+
+      // Minimum buffer size of testLIFit. It is always set to 5
+   const int CSDetectorBank::minBufferSize = 5;
+
+
+   namespace
+   {
+         // LLI index values meaning 'loss of lock'
+      inline bool lliSlip(double lli)
+      {
+         return ( (lli==1.0) || (lli==3.0) || (lli==5.0) || (lli==7.0) );
+      }
+   }
+
+
+   CSDetectorBank::Diagnostics::Diagnostics()
+      : epoch(CommonTime::BEGINNING_OF_TIME), lliFlag(false), gapFlag(false),
+        arcNum(0.0), unstable(false)
+   {
+      for(int i = 0; i < numTests; ++i)
+      {
+         enabled[i] = false;
+         slip[i] = false;
+         value[i] = 0.0;
+         limit[i] = 0.0;
+      }
+   }
+
+
+   CSDetectorBank::SatState::SatState()
+      : formerEpoch(CommonTime::BEGINNING_OF_TIME),
+        liWindow(0), formerLI(0.0), formerBias(0.0), formerDeltaT(1.0),
+        arcNum(0.0), arcChangeTime(CommonTime::BEGINNING_OF_TIME),
+        arcNew(true)
+   {
+      for(int i = 0; i < 2; ++i)
+      {
+         mwWindow[i] = 0;
+         meanMW[i] = 0.0;
+         varMW[i] = 0.25*0.25;
+      }
+   }
+
+
+
+      // Default constructor, with the defaults of every detector.
+   CSDetectorBank::CSDetectorBank()
+      : deltaTMax(61.0), useLLI(true),
+        minThreshold(0.04), LIDrift(0.002),
+        satThreshold(0.08), timeConst(60.0), maxBufferSize(12),
+        maxNumLambdas(10.0), mwSigmaFactor(4.0),
+        deleteUnstableSats(false), unstablePeriod(31.0),
+        hashTable(256, -1), numChecked(0)
+   {
+
+      useTest[testLI] = true;
+      useTest[testLIFit] = false;
+      useTest[testMW] = true;
+      useTest[testMWSigma] = false;
+
+      resetCounters();
+
+   }  // End of constructor 'CSDetectorBank::CSDetectorBank()'
+
+
+
+      // Method to enable or disable one test.
+   CSDetectorBank& CSDetectorBank::setTest(TestType test, bool enable)
+   {
+
+      if( test >= testLI && test < numTests )
+      {
+         useTest[test] = enable;
+      }
+
+      return (*this);
+
+   }  // End of method 'CSDetectorBank::setTest()'
+
+
+
+      // Method to set the maximum interval of time allowed between two
+      // successive epochs, in seconds.
+   CSDetectorBank& CSDetectorBank::setDeltaTMax(const double& maxDelta)
+   {
+         // Don't allow delta times less than or equal to 0
+      deltaTMax = (maxDelta > 0.0) ? maxDelta : 61.0;
+      return (*this);
+   }
+
+
+      // Method to set the minimum threshold of testLI, in meters.
+   CSDetectorBank& CSDetectorBank::setMinThreshold(const double& mThr)
+   {
+         // Don't allow thresholds less than 0
+      minThreshold = (mThr < 0.0) ? 0.04 : mThr;
+      return (*this);
+   }
+
+
+      // Method to set the LI limit drift of testLI, in meters/second.
+   CSDetectorBank& CSDetectorBank::setLIDrift(const double& drift)
+   {
+         // Don't allow drift less than or equal to 0
+      LIDrift = (drift > 0.0) ? drift : 0.002;
+      return (*this);
+   }
+
+
+      // Method to set the saturation threshold of testLIFit, in meters.
+   CSDetectorBank& CSDetectorBank::setSatThreshold(const double& satThr)
+   {
+         // Don't allow saturation thresholds less than or equal to 0
+      satThreshold = (satThr > 0.0) ? satThr : 0.08;
+      return (*this);
+   }
+
+
+      // Method to set the threshold time constant of testLIFit, in seconds.
+   CSDetectorBank& CSDetectorBank::setTimeConst(const double& tc)
+   {
+         // Don't allow time constants less than or equal to 0
+      timeConst = (tc > 0.0) ? tc : 60.0;
+      return (*this);
+   }
+
+
+      // Method to set the maximum LI buffer size of testLIFit.
+   CSDetectorBank& CSDetectorBank::setMaxBufferSize(const int& maxBufSize)
+   {
+         // Don't allow buffer sizes less than minBufferSize
+      maxBufferSize = (maxBufSize >= minBufferSize) ? maxBufSize
+                                                    : minBufferSize;
+      return (*this);
+   }
+
+
+      // Method to set the limit of testMW, in wide-lane wavelengths.
+   CSDetectorBank& CSDetectorBank::setMaxNumLambdas(const double& mLambdas)
+   {
+         // Don't allow number of lambdas less than or equal to 0
+      maxNumLambdas = (mLambdas > 0.0) ? mLambdas : 10.0;
+      return (*this);
+   }
+
+
+      // Method to set the limit of testMWSigma, in MW sigmas.
+   CSDetectorBank& CSDetectorBank::setMWSigmaFactor(const double& factor)
+   {
+         // Don't allow factors less than or equal to 0
+      mwSigmaFactor = (factor > 0.0) ? factor : 4.0;
+      return (*this);
+   }
+
+
+      // Method to set the number of seconds since last arc change that a
+      // satellite will be considered as unstable.
+   CSDetectorBank& CSDetectorBank::setUnstablePeriod(const double unstableTime)
+   {
+      unstablePeriod = (unstableTime > 0.0) ? unstableTime : 0.0;
+      return (*this);
+   }
+
+
+      // Method to reset the slip counters.
+   CSDetectorBank& CSDetectorBank::resetCounters()
+   {
+      for(int i = 0; i < numTests; ++i)
+      {
+         numSlips[i] = 0;
+      }
+      numChecked = 0;
+
+      return (*this);
+   }
+
+
+
+      // Key of a (source index, satellite) pair
+   unsigned long CSDetectorBank::makeKey( unsigned long srcIdx,
+                                          const SatID& sat )
+   {
+      return ( (srcIdx << 16)
+               | ( (static_cast<unsigned long>(sat.system) & 0xFF) << 8 )
+               | ( static_cast<unsigned long>(sat.id) & 0xFF ) );
+   }
+
+
+   namespace
+   {
+         // Mix the bits of a key, so that all of them reach the low ones
+      inline unsigned long hashKey(unsigned long key)
+      {
+         key ^= (key >> 16);
+         key *= 0x45d9f3bUL;
+         key ^= (key >> 16);
+         return key;
+      }
+   }
+
+
+      // Index of the source, inserting it if needed
+   unsigned long CSDetectorBank::getSourceIndex(const SourceID& source)
+   {
+
+      std::map<SourceID, unsigned long>::const_iterator it =
+         sourceIndex.find(source);
+
+      if( it != sourceIndex.end() ) return it->second;
+
+      unsigned long idx( sourceIndex.size() );
+      sourceIndex[source] = idx;
+
+      return idx;
+
+   }  // End of method 'CSDetectorBank::getSourceIndex()'
+
+
+      // State of the given key, or 0 if there is none
+   const CSDetectorBank::SatState*
+   CSDetectorBank::findState(unsigned long key) const
+   {
+
+      const std::size_t mask( hashTable.size() - 1 );
+
+      for( std::size_t h = hashKey(key) & mask; ; h = (h + 1) & mask )
+      {
+         int idx( hashTable[h] );
+
+         if( idx < 0 ) return 0;
+
+         if( stateKeys[idx] == key ) return &states[idx];
+      }
+
+   }  // End of method 'CSDetectorBank::findState()'
+
+
+      // State of the given key, inserting it if needed
+   CSDetectorBank::SatState& CSDetectorBank::getState(unsigned long key)
+   {
+
+      std::size_t mask( hashTable.size() - 1 );
+
+      std::size_t h( hashKey(key) & mask );
+      for( ; hashTable[h] >= 0; h = (h + 1) & mask )
+      {
+         if( stateKeys[hashTable[h]] == key ) return states[hashTable[h]];
+      }
+
+         // Not found: keep the load factor under 1/2
+      if( 2*(states.size() + 1) > hashTable.size() )
+      {
+         rehash();
+
+         mask = hashTable.size() - 1;
+         for( h = hashKey(key) & mask;
+              hashTable[h] >= 0;
+              h = (h + 1) & mask ) ;
+      }
+
+      hashTable[h] = states.size();
+      stateKeys.push_back(key);
+      states.push_back( SatState() );
+
+      return states.back();
+
+   }  // End of method 'CSDetectorBank::getState()'
+
+
+      // Double the size of the hash table
+   void CSDetectorBank::rehash()
+   {
+
+      hashTable.assign( 2*hashTable.size(), -1 );
+
+      const std::size_t mask( hashTable.size() - 1 );
+
+      for(std::size_t i = 0; i < stateKeys.size(); ++i)
+      {
+         std::size_t h( hashKey(stateKeys[i]) & mask );
+         while( hashTable[h] >= 0 ) h = (h + 1) & mask;
+         hashTable[h] = i;
+      }
+
+   }  // End of method 'CSDetectorBank::rehash()'
+
+
+
+      // Method to get the results of the tests of the last epoch.
+   CSDetectorBank::Diagnostics
+   CSDetectorBank::getDiagnostics( const SourceID& source,
+                                   const SatID& sat ) const
+   {
+
+      std::map<SourceID, unsigned long>::const_iterator it =
+         sourceIndex.find(source);
+      if( it == sourceIndex.end() ) return Diagnostics();
+
+      const SatState* st( findState( makeKey(it->second, sat) ) );
+      if( st == 0 ) return Diagnostics();
+
+      return st->diag;
+
+   }  // End of method 'CSDetectorBank::getDiagnostics()'
+
+
+      // Method to get the arc changed epoch.
+   CommonTime CSDetectorBank::getArcChangedEpoch( const SourceID& source,
+                                                  const SatID& sat ) const
+   {
+
+      std::map<SourceID, unsigned long>::const_iterator it =
+         sourceIndex.find(source);
+      if( it == sourceIndex.end() ) return CommonTime::BEGINNING_OF_TIME;
+
+      const SatState* st( findState( makeKey(it->second, sat) ) );
+      if( st == 0 ) return CommonTime::BEGINNING_OF_TIME;
+
+      return st->arcChangeTime;
+
+   }  // End of method 'CSDetectorBank::getArcChangedEpoch()'
+
+
+
+      // Run testLI, as LICSDetector::getDetection() does.
+   bool CSDetectorBank::checkLI( SatState& st,
+                                 double deltaT,
+                                 double li,
+                                 bool reset )
+   {
+
+      bool reportCS(false);
+
+         // Current value of LI difference
+      double currentBias( li - st.formerLI );
+
+      ++st.liWindow;
+
+      if( reset )
+      {
+         st.liWindow = 0;
+         reportCS = true;
+      }
+
+      if( st.liWindow > 1 )
+      {
+         double deltaLimit( minThreshold + std::abs(LIDrift*deltaT) );
+
+            // LI_predicted - LI_current, from a linear interpolation
+         double delta( std::abs( currentBias -
+                                 st.formerBias*deltaT/st.formerDeltaT ) );
+
+         st.diag.value[testLI] = delta;
+         st.diag.limit[testLI] = deltaLimit;
+
+         if( delta > deltaLimit )
+         {
+            st.liWindow = 0;
+            reportCS = true;
+         }
+      }
+
+         // Let's prepare for the next time
+      st.formerLI = li;
+      st.formerBias = currentBias;
+      st.formerDeltaT = deltaT;
+
+      return reportCS;
+
+   }  // End of method 'CSDetectorBank::checkLI()'
+
+
+      // Run testLIFit, as LICSDetector2::getDetection() does.
+   bool CSDetectorBank::checkLIFit( SatState& st,
+                                    const CommonTime& epoch,
+                                    double deltaT,
+                                    double li,
+                                    bool reset )
+   {
+
+      bool reportCS(false);
+
+      if( reset )
+      {
+         st.fitEpoch.clear();
+         st.fitLI.clear();
+         reportCS = true;
+      }
+
+      const std::size_t s( st.fitEpoch.size() );
+
+      if( s >= std::size_t(minBufferSize) )
+      {
+            // Normal equations of the 2nd order fit, with respect to the
+            // OLDEST epoch in buffer
+         const CommonTime& firstEpoch( st.fitEpoch.front() );
+
+         double sumT[5] = { 0.0, 0.0, 0.0, 0.0, 0.0 };
+         double b[3] = { 0.0, 0.0, 0.0 };
+
+         for(std::size_t i = 0; i < s; ++i)
+         {
+            double dT( st.fitEpoch[i] - firstEpoch );
+            double y( st.fitLI[i] );
+            double p(1.0);
+            for(int k = 0; k < 5; ++k)
+            {
+               sumT[k] += p;
+               if( k < 3 ) b[k] += p*y;
+               p *= dT;
+            }
+         }
+
+            // Cholesky decomposition of the 3x3 normal matrix
+         double N[3][3];
+         for(int i = 0; i < 3; ++i)
+         {
+            for(int j = 0; j < 3; ++j)
+            {
+               N[i][j] = sumT[i+j];
+            }
+         }
+
+         bool singular(false);
+         for(int j = 0; j < 3 && !singular; ++j)
+         {
+            double d( N[j][j] );
+            for(int k = 0; k < j; ++k) d -= N[j][k]*N[j][k];
+
+            if( d <= 0.0 )
+            {
+               singular = true;
+               break;
+            }
+
+            N[j][j] = std::sqrt(d);
+            for(int i = j+1; i < 3; ++i)
+            {
+               double v( N[i][j] );
+               for(int k = 0; k < j; ++k) v -= N[i][k]*N[j][k];
+               N[i][j] = v / N[j][j];
+            }
+         }
+
+         if( singular )
+         {
+               // Serious problem with data: reset buffer and declare slip
+            st.fitEpoch.clear();
+            st.fitLI.clear();
+            reportCS = true;
+         }
+         else
+         {
+               // Forward and backward substitutions
+            double a[3];
+            for(int i = 0; i < 3; ++i)
+            {
+               double v( b[i] );
+               for(int k = 0; k < i; ++k) v -= N[i][k]*a[k];
+               a[i] = v / N[i][i];
+            }
+            for(int i = 2; i >= 0; --i)
+            {
+               double v( a[i] );
+               for(int k = i+1; k < 3; ++k) v -= N[k][i]*a[k];
+               a[i] = v / N[i][i];
+            }
+
+               // Maximum deviation from adjustment
+            double maxDeltaLI(0.0);
+            for(std::size_t i = 0; i < s; ++i)
+            {
+               double dT( st.fitEpoch[i] - firstEpoch );
+               double deltaLI( std::abs( a[0] + a[1]*dT + a[2]*dT*dT
+                                         - st.fitLI[i] ) );
+               if( deltaLI > maxDeltaLI ) maxDeltaLI = deltaLI;
+            }
+
+            double dT( epoch - firstEpoch );
+            double currentBias( std::abs( a[0] + a[1]*dT + a[2]*dT*dT - li ) );
+
+            double deltaLimit( satThreshold /
+                               ( 1.0 + ( 1.0/std::exp(deltaT/timeConst) ) ) );
+
+            st.diag.value[testLIFit] = currentBias;
+            st.diag.limit[testLIFit] = deltaLimit;
+
+               // Only trust the adjustment if it is NOT too noisy
+            if( (2.0*maxDeltaLI) < currentBias && currentBias > deltaLimit )
+            {
+               st.fitEpoch.clear();
+               st.fitLI.clear();
+               reportCS = true;
+            }
+         }
+      }
+      else
+      {
+            // If we don't have enough data, we report cycle slips
+         reportCS = true;
+      }
+
+         // Let's prepare for the next epoch
+      st.fitEpoch.push_back(epoch);
+      st.fitLI.push_back(li);
+
+      if( st.fitEpoch.size() > std::size_t(maxBufferSize) )
+      {
+         st.fitEpoch.pop_front();
+         st.fitLI.pop_front();
+      }
+
+      return reportCS;
+
+   }  // End of method 'CSDetectorBank::checkLIFit()'
+
+
+      // Run testMW (i = 0) or testMWSigma (i = 1), as the getDetection()
+      // methods of MWCSDetector and MWCSDetector2 do.
+   bool CSDetectorBank::checkMW( SatState& st,
+                                 int i,
+                                 double mw,
+                                 double lambda,
+                                 bool reset )
+   {
+
+      const int test( (i == 0) ? testMW : testMWSigma );
+
+      bool reportCS(false);
+
+         // Difference between current value of MW and average value
+      double currentBias( std::abs(mw - st.meanMW[i]) );
+
+      ++st.mwWindow[i];
+
+      if( reset )
+      {
+         st.mwWindow[i] = 1;
+         reportCS = true;
+      }
+
+      if( st.mwWindow[i] > 1 )
+      {
+         double limit( (i == 0) ? maxNumLambdas*lambda
+                                : mwSigmaFactor*std::sqrt(st.varMW[i]) );
+
+         st.diag.value[test] = currentBias;
+         st.diag.limit[test] = limit;
+
+         if( currentBias > limit )
+         {
+            st.mwWindow[i] = 1;
+            reportCS = true;
+         }
+      }
+
+         // Let's prepare for the next time
+      if( st.mwWindow[i] < 2 )
+      {
+         st.meanMW[i] = mw;
+         st.varMW[i] = 0.25*0.25;
+      }
+      else
+      {
+         double mwBias( mw - st.meanMW[i] );
+         double size( static_cast<double>(st.mwWindow[i]) );
+
+         st.meanMW[i] += mwBias / size;
+         st.varMW[i]  += ( mwBias*mwBias - st.varMW[i] ) / size;
+      }
+
+      return reportCS;
+
+   }  // End of method 'CSDetectorBank::checkMW()'
+
+
+
+      /* Returns a satTypeValueMap object of the given source, adding the
+       * new data generated when calling this object.
+       *
+       * @param epoch     Time of observations.
+       * @param source    Source of the data.
+       * @param gData     Data object holding the data.
+       * @param epochflag Epoch flag.
+       */
+   satTypeValueMap& CSDetectorBank::Process( const CommonTime& epoch,
+                                             const SourceID& source,
+                                             satTypeValueMap& gData,
+                                             const short& epochflag )
+      throw(ProcessingException)
+   {
+
+      try
+      {
+
+         const bool needLI( useTest[testLI] || useTest[testLIFit] );
+         const bool needMW( useTest[testMW] || useTest[testMWSigma] );
+
+         const unsigned long srcIdx( getSourceIndex(source) );
+
+         SatIDSet satRejectedSet;
+
+            // Loop through all the satellites
+         for( satTypeValueMap::iterator it = gData.begin();
+              it != gData.end();
+              ++it )
+         {
+            const SatID& sat( it->first );
+            typeValueMap& tvMap( it->second );
+
+               // Types of each system, as in the individual detectors
+            TypeID lliType1(TypeID::LLI1), lliType2(TypeID::LLI2);
+            TypeID resultType1(TypeID::CSL1), resultType2(TypeID::CSL2);
+            double lambdaWL(WL_WAVELENGTH_GPS);
+
+            if( sat.system == SatID::systemGalileo )
+            {
+               lliType2 = TypeID::LLI5;
+               resultType2 = TypeID::CSL5;
+               lambdaWL = WL_WAVELENGTH_GAL;
+            }
+            else if( sat.system == SatID::systemBDS )
+            {
+               lliType1 = TypeID::LLI2;
+               lliType2 = TypeID::LLI7;
+               resultType1 = TypeID::CSL2;
+               resultType2 = TypeID::CSL7;
+               lambdaWL = WL_WAVELENGTH_BDS;
+            }
+
+               // Observables needed by the enabled tests
+            double li(0.0), mw(0.0);
+            typeValueMap::const_iterator itType;
+
+            if( needLI )
+            {
+               itType = tvMap.find(TypeID::LI);
+               if( itType == tvMap.end() )
+               {
+                  satRejectedSet.insert(sat);
+                  continue;
+               }
+               li = itType->second;
+            }
+
+            if( needMW )
+            {
+               itType = tvMap.find(TypeID::MW);
+               if( itType == tvMap.end() )
+               {
+                  satRejectedSet.insert(sat);
+                  continue;
+               }
+               mw = itType->second;
+            }
+
+               // LLI indexes. If they are not found, they are set to zero
+            double lli1(0.0), lli2(0.0);
+            if( useLLI )
+            {
+               itType = tvMap.find(lliType1);
+               if( itType != tvMap.end() ) lli1 = itType->second;
+
+               itType = tvMap.find(lliType2);
+               if( itType != tvMap.end() ) lli2 = itType->second;
+            }
+
+
+            SatState& st( getState( makeKey(srcIdx, sat) ) );
+
+               // Difference between current and former epochs, in sec
+            double deltaT( epoch - st.formerEpoch );
+            st.formerEpoch = epoch;
+
+            Diagnostics& diag( st.diag );
+            diag = Diagnostics();
+            diag.epoch = epoch;
+            diag.lliFlag = lliSlip(lli1) || lliSlip(lli2);
+            diag.gapFlag = (deltaT > deltaTMax);
+
+            const bool reset( diag.lliFlag || diag.gapFlag );
+
+            if( useTest[testLI] )
+            {
+               diag.enabled[testLI] = true;
+               diag.slip[testLI] = checkLI(st, deltaT, li, reset);
+            }
+
+            if( useTest[testLIFit] )
+            {
+                  // LICSDetector2 also honors the RINEX epoch flag
+               bool resetFit( reset || (epochflag == 1) || (epochflag == 6) );
+
+               diag.enabled[testLIFit] = true;
+               diag.slip[testLIFit] =
+                  checkLIFit(st, epoch, deltaT, li, resetFit);
+            }
+
+            if( useTest[testMW] )
+            {
+               diag.enabled[testMW] = true;
+               diag.slip[testMW] = checkMW(st, 0, mw, lambdaWL, reset);
+            }
+
+            if( useTest[testMWSigma] )
+            {
+               diag.enabled[testMWSigma] = true;
+               diag.slip[testMWSigma] = checkMW(st, 1, mw, lambdaWL, reset);
+            }
+
+
+               // Concatenate with the incoming flag, as the chain does
+            double flag( tvMap[resultType1] );
+            for(int i = 0; i < numTests; ++i)
+            {
+               if( diag.slip[i] )
+               {
+                  ++numSlips[i];
+                  flag = 1.0;
+               }
+            }
+            ++numChecked;
+
+            if( flag > 1.0 ) flag = 1.0;
+
+            tvMap[resultType1] = flag;
+            tvMap[resultType2] = flag;
+
+
+               // Satellite arcs, as SatArcMarker does
+            double dt( std::abs(epoch - st.arcChangeTime) );
+            bool insideUnstable( dt <= unstablePeriod );
+
+               // Satellites can be new only once, and having at least once
+               // a flag <= 0.0 outside 'unstablePeriod' will make them old.
+            if( st.arcNew && !insideUnstable && flag <= 0.0 )
+            {
+               st.arcNew = false;
+            }
+
+            if( flag > 0.0 )
+            {
+               st.arcNum += 1.0;
+               st.arcChangeTime = epoch;
+
+               if( deleteUnstableSats && !st.arcNew )
+               {
+                  satRejectedSet.insert(sat);
+               }
+            }
+
+            if( insideUnstable && deleteUnstableSats && !st.arcNew )
+            {
+               satRejectedSet.insert(sat);
+            }
+
+            diag.arcNum = st.arcNum;
+            diag.unstable = insideUnstable || (flag > 0.0);
+
+            tvMap[TypeID::satArc] = st.arcNum;
+
+         }  // End of 'for( satTypeValueMap::iterator it = gData.begin(); ...'
+
+            // Remove satellites with missing data
+         gData.removeSatID(satRejectedSet);
+
+         return gData;
+
+      }
+      catch(Exception& u)
+      {
+            // Throw an exception if something unexpected happens
+         ProcessingException e( getClassName() + ":"
+                                + u.what() );
+
+         GPSTK_THROW(e);
+
+      }
+
+   }  // End of method 'CSDetectorBank::Process()'
+
+
+
+      /* Returns a gnssRinex object, adding the new data generated when
+       * calling this object.
+       *
+       * @param gData    Data object holding the data.
+       */
+   gnssRinex& CSDetectorBank::Process(gnssRinex& gData)
+      throw(ProcessingException)
+   {
+
+      try
+      {
+
+         Process(gData.header.epoch, gData.body, gData.header.epochFlag);
+
+         return gData;
+
+      }
+      catch(Exception& u)
+      {
+            // Throw an exception if something unexpected happens
+         ProcessingException e( getClassName() + ":"
+                                + u.what() );
+
+         GPSTK_THROW(e);
+
+      }
+
+   }  // End of method 'CSDetectorBank::Process()'
+
+
+
+      /* Returns a gnssDataMap object, adding the new data generated when
+       * calling this object.
+       *
+       * @param gData    Data object holding the data.
+       */
+   gnssDataMap& CSDetectorBank::Process(gnssDataMap& gData)
+      throw(ProcessingException)
+   {
+
+      for( gnssDataMap::iterator gdmIt = gData.begin();
+           gdmIt != gData.end();
+           ++gdmIt )
+      {
+         for( sourceDataMap::iterator sdmIt = gdmIt->second.begin();
+              sdmIt != gdmIt->second.end();
+              ++sdmIt )
+         {
+            Process( gdmIt->first, sdmIt->first, sdmIt->second );
+         }
+      }
+
+      return gData;
+
+   }  // End of method 'CSDetectorBank::Process()'
+
+
+}  // End of namespace gpstk
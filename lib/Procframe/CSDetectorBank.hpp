@@ -0,0 +1,515 @@
+#pragma ident "$Id$"
+
+/**
+ * @file CSDetectorBank.hpp
+ * This class runs the LI and Melbourne-Wubbena cycle slip tests and the
+ * satellite arc bookkeeping in a single pass over the data.
+ */
+
+#ifndef GPSTK_CSDETECTORBANK_HPP
+#define GPSTK_CSDETECTORBANK_HPP
+
+//============================================================================
+//
+//  This file is part of GPSTk, the GPS Toolkit.
+//
+//  The GPSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 2.1 of the License, or
+//  any later version.
+//
+//  The GPSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GPSTk; if not, write to the Free Software Foundation,
+//  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+//
+//============================================================================
+
+
+#include <deque>
+#include <vector>
+#include <map>
+
+#include "ProcessingClass.hpp"
+
+
+namespace gpstk
+{
+
+      /** @addtogroup GPSsolutions */
+      //@{
+
+
+      /** This class is a bank of cycle slip detectors. In one visit to
+       *  every satellite it does the job of the following chain:
+       *
+       * @code
+       *   gData >> LICSDetector >> LICSDetector2
+       *         >> MWCSDetector >> MWCSDetector2 >> SatArcMarker;
+       * @endcode
+       *
+       * The LI and MW observables, the LLI indexes and the incoming cycle
+       * slip flags of each satellite are read once, and the state of all the
+       * tests of a (source, satellite) pair lives in one record of a flat
+       * hash table, instead of one std::map per detector and per source.
+       *
+       * The tests are:
+       *
+       *    \li testLI: LI prediction from the last bias, as in LICSDetector
+       *        (minThreshold + LIDrift*dt).
+       *    \li testLIFit: LI prediction from a 2nd order fit over a buffer
+       *        of previous LI values, as in LICSDetector2 (satThreshold and
+       *        timeConst).
+       *    \li testMW: deviation of MW from its running mean larger than
+       *        'maxNumLambdas' wide-lane wavelengths, as in MWCSDetector.
+       *    \li testMWSigma: deviation of MW from its running mean larger
+       *        than 'mwSigmaFactor' times its running sigma, as in
+       *        MWCSDetector2.
+       *
+       * Each test can be enabled or disabled, and all of them honor the LLI
+       * indexes (if 'useLLI' is set) and the data gap limit 'deltaTMax'.
+       * The flags of all the enabled tests are OR-ed into CSL1/CSL2 (CSL1/
+       * CSL5 for Galileo, CSL2/CSL7 for BDS). Then 'TypeID::satArc' is
+       * updated as in SatArcMarker, optionally deleting the unstable
+       * satellites.
+       *
+       * A typical way to use this class follows:
+       *
+       * @code
+       *   CSDetectorBank markCS;
+       *   markCS.setDeltaTMax(2.0*interval);
+       *   markCS.setDeleteUnstableSats(true);
+       *
+       *   while( obsStreams.readEpochData(gData) )
+       *   {
+       *      gData >> ... >> getLI >> getMW >> markCS >> ...;
+       *   }
+       * @endcode
+       *
+       * The result of every test, with the value tested and its limit, is
+       * kept for the last epoch of each (source, satellite) and can be read
+       * with 'getDiagnostics()'; the total number of slips declared by each
+       * test is given by 'getNumSlips()'.
+       *
+       * Satellites missing any of the observables needed by the enabled
+       * tests are summarily deleted from the data structure.
+       *
+       * @sa LICSDetector.hpp, LICSDetector2.hpp, MWCSDetector.hpp,
+       * MWCSDetector2.hpp and SatArcMarker.hpp.
+       *
+       * \warning Cycle slip detectors are objets that store their internal
+       * state, so you MUST NOT use the SAME object to process DIFFERENT data
+       * streams.
+       */
+   class CSDetectorBank : public ProcessingClass
+   {
+   public:
+
+         /// Tests of the bank
+      enum TestType
+      {
+         testLI = 0,
+         testLIFit,
+         testMW,
+         testMWSigma,
+         numTests
+      };
+
+
+         /// Results of the tests of one satellite at one epoch
+      struct Diagnostics
+      {
+            /// Default constructor
+         Diagnostics();
+
+            /// Epoch of the results
+         CommonTime epoch;
+
+            /// Whether each test was run
+         bool enabled[numTests];
+
+            /// Whether each test declared a cycle slip
+         bool slip[numTests];
+
+            /// Value tested by each test (m)
+         double value[numTests];
+
+            /// Limit of each test (m)
+         double limit[numTests];
+
+            /// Whether a LLI index flagged a cycle slip
+         bool lliFlag;
+
+            /// Whether the data gap was larger than 'deltaTMax'
+         bool gapFlag;
+
+            /// Arc number after this epoch
+         double arcNum;
+
+            /// Whether the satellite is inside its unstable period
+         bool unstable;
+      };
+
+
+         /** Default constructor, with the defaults of every detector.
+          *
+          * testLI and testMW are enabled; testLIFit and testMWSigma must
+          * be enabled with 'setTest()'.
+          */
+      CSDetectorBank();
+
+
+         /** Method to enable or disable one test.
+          *
+          * @param test       Test to be enabled or disabled.
+          * @param enable     Whether the test will be used.
+          */
+      virtual CSDetectorBank& setTest(TestType test, bool enable = true);
+
+
+         /// Method to know whether one test is enabled.
+      virtual bool getTest(TestType test) const
+      { return useTest[test]; };
+
+
+         /// Method to set the maximum interval of time allowed between two
+         /// successive epochs, in seconds.
+      virtual CSDetectorBank& setDeltaTMax(const double& maxDelta);
+
+
+         /// Method to get the maximum interval of time allowed between two
+         /// successive epochs, in seconds.
+      virtual double getDeltaTMax() const
+      { return deltaTMax; };
+
+
+         /// Method to set whether the LLI indexes will be used as an aid.
+      virtual CSDetectorBank& setUseLLI(const bool& use)
+      { useLLI = use; return (*this); };
+
+
+         /// Method to know if the LLI check is enabled or disabled.
+      virtual bool getUseLLI() const
+      { return useLLI; };
+
+
+         /// Method to set the minimum threshold of testLI, in meters.
+      virtual CSDetectorBank& setMinThreshold(const double& mThr);
+
+
+         /// Method to get the minimum threshold of testLI, in meters.
+      virtual double getMinThreshold() const
+      { return minThreshold; };
+
+
+         /// Method to set the LI limit drift of testLI, in meters/second.
+      virtual CSDetectorBank& setLIDrift(const double& drift);
+
+
+         /// Method to get the LI limit drift of testLI, in meters/second.
+      virtual double getLIDrift() const
+      { return LIDrift; };
+
+
+         /// Method to set the saturation threshold of testLIFit, in meters.
+      virtual CSDetectorBank& setSatThreshold(const double& satThr);
+
+
+         /// Method to get the saturation threshold of testLIFit, in meters.
+      virtual double getSatThreshold() const
+      { return satThreshold; };
+
+
+         /// Method to set the threshold time constant of testLIFit, in
+         /// seconds.
+      virtual CSDetectorBank& setTimeConst(const double& tc);
+
+
+         /// Method to get the threshold time constant of testLIFit.
+      virtual double getTimeConst() const
+      { return timeConst; };
+
+
+         /// Method to set the maximum LI buffer size of testLIFit (>= 5).
+      virtual CSDetectorBank& setMaxBufferSize(const int& maxBufSize);
+
+
+         /// Method to get the maximum LI buffer size of testLIFit.
+      virtual int getMaxBufferSize() const
+      { return maxBufferSize; };
+
+
+         /// Method to set the limit of testMW, in wide-lane wavelengths.
+      virtual CSDetectorBank& setMaxNumLambdas(const double& mLambdas);
+
+
+         /// Method to get the limit of testMW, in wide-lane wavelengths.
+      virtual double getMaxNumLambdas() const
+      { return maxNumLambdas; };
+
+
+         /// Method to set the limit of testMWSigma, in MW sigmas.
+      virtual CSDetectorBank& setMWSigmaFactor(const double& factor);
+
+
+         /// Method to get the limit of testMWSigma, in MW sigmas.
+      virtual double getMWSigmaFactor() const
+      { return mwSigmaFactor; };
+
+
+         /// Method to set if unstable satellites will be deleted.
+      virtual CSDetectorBank& setDeleteUnstableSats(const bool delUnstableSats)
+      { deleteUnstableSats = delUnstableSats; return (*this); };
+
+
+         /// Method to known if unstable satellites will be deleted.
+      virtual bool getDeleteUnstableSats() const
+      { return deleteUnstableSats; };
+
+
+         /// Method to set the number of seconds since last arc change that
+         /// a satellite will be considered as unstable.
+      virtual CSDetectorBank& setUnstablePeriod(const double unstableTime);
+
+
+         /// Method to get the number of seconds since last arc change that
+         /// a satellite will be considered as unstable.
+      virtual double getUnstablePeriod() const
+      { return unstablePeriod; };
+
+
+         /** Method to get the results of the tests of the last epoch
+          *  processed for the given source and satellite.
+          *
+          * @param source     Interested SourceID. Use SourceID() for data
+          *                   processed as satTypeValueMap or gnssRinex.
+          * @param sat        Interested SatID.
+          */
+      virtual Diagnostics getDiagnostics( const SourceID& source,
+                                          const SatID& sat ) const;
+
+
+         /** Method to get the arc changed epoch.
+          *
+          * @param source     Interested SourceID.
+          * @param sat        Interested SatID.
+          */
+      virtual CommonTime getArcChangedEpoch( const SourceID& source,
+                                             const SatID& sat ) const;
+
+
+         /// Method to get the number of cycle slips declared by one test.
+      virtual unsigned long getNumSlips(TestType test) const
+      { return numSlips[test]; };
+
+
+         /// Method to get the number of satellites checked so far.
+      virtual unsigned long getNumChecked() const
+      { return numChecked; };
+
+
+         /// Method to reset the slip counters.
+      virtual CSDetectorBank& resetCounters();
+
+
+         /** Returns a satTypeValueMap object, adding the new data generated
+          *  when calling this object.
+          *
+          * @param epoch     Time of observations.
+          * @param gData     Data object holding the data.
+          * @param epochflag Epoch flag.
+          */
+      virtual satTypeValueMap& Process( const CommonTime& epoch,
+                                        satTypeValueMap& gData,
+                                        const short& epochflag = 0 )
+         throw(ProcessingException)
+      { return Process(epoch, SourceID(), gData, epochflag); };
+
+
+         /** Returns a satTypeValueMap object of the given source, adding
+          *  the new data generated when calling this object.
+          *
+          * @param epoch     Time of observations.
+          * @param source    Source of the data.
+          * @param gData     Data object holding the data.
+          * @param epochflag Epoch flag.
+          */
+      virtual satTypeValueMap& Process( const CommonTime& epoch,
+                                        const SourceID& source,
+                                        satTypeValueMap& gData,
+                                        const short& epochflag = 0 )
+         throw(ProcessingException);
+
+
+         /** Returns a gnssSatTypeValue object, adding the new data generated
+          *  when calling this object.
+          *
+          * @param gData    Data object holding the data.
+          */
+      virtual gnssSatTypeValue& Process(gnssSatTypeValue& gData)
+         throw(ProcessingException)
+      { Process(gData.header.epoch, gData.body); return gData; };
+
+
+         /** Returns a gnssRinex object, adding the new data generated when
+          *  calling this object.
+          *
+          * @param gData    Data object holding the data.
+          */
+      virtual gnssRinex& Process(gnssRinex& gData)
+         throw(ProcessingException);
+
+
+         /** Returns a gnssDataMap object, adding the new data generated when
+          *  calling this object.
+          *
+          * @param gData    Data object holding the data.
+          */
+      virtual gnssDataMap& Process(gnssDataMap& gData)
+         throw(ProcessingException);
+
+
+         /// Returns a string identifying this object.
+      virtual std::string getClassName(void) const;
+
+
+         /// Destructor
+      virtual ~CSDetectorBank() {};
+
+
+   private:
+
+
+         /// Whether each test is used
+      bool useTest[numTests];
+
+         /// Maximum interval of time allowed between two successive epochs
+      double deltaTMax;
+
+         /// Whether to use or ignore the LLI indexes as an aid
+      bool useLLI;
+
+         /// testLI: minimum threshold (m) and limit drift (m/s)
+      double minThreshold;
+      double LIDrift;
+
+         /// testLIFit: saturation threshold (m), time constant (s) and
+         /// maximum buffer size
+      double satThreshold;
+      double timeConst;
+      int maxBufferSize;
+
+         /// testLIFit: minimum buffer size. It is always set to 5
+      static const int minBufferSize;
+
+         /// testMW: limit in wide-lane wavelengths
+      double maxNumLambdas;
+
+         /// testMWSigma: limit in MW sigmas
+      double mwSigmaFactor;
+
+         /// Whether unstable satellites will be deleted
+      bool deleteUnstableSats;
+
+         /// Seconds since arc change that a satellite is unstable
+      double unstablePeriod;
+
+
+         /// State of all the tests of one (source, satellite) pair
+      struct SatState
+      {
+         SatState();
+
+            // Epoch of the previous data
+         CommonTime formerEpoch;
+
+            // testLI
+         int liWindow;
+         double formerLI;
+         double formerBias;
+         double formerDeltaT;
+
+            // testLIFit
+         std::deque<CommonTime> fitEpoch;
+         std::deque<double> fitLI;
+
+            // testMW and testMWSigma
+         int mwWindow[2];
+         double meanMW[2];
+         double varMW[2];
+
+            // SatArcMarker
+         double arcNum;
+         CommonTime arcChangeTime;
+         bool arcNew;
+
+            // Results of the last epoch
+         Diagnostics diag;
+      };
+
+
+         /// Per-(source, satellite) states and their keys
+      std::vector<SatState> states;
+      std::vector<unsigned long> stateKeys;
+
+         /// Open addressing hash table: index in 'states' or -1
+      std::vector<int> hashTable;
+
+         /// Index of each source in the keys
+      std::map<SourceID, unsigned long> sourceIndex;
+
+         /// Counters
+      unsigned long numSlips[numTests];
+      unsigned long numChecked;
+
+
+         /// Key of a (source index, satellite) pair
+      static unsigned long makeKey( unsigned long srcIdx,
+                                    const SatID& sat );
+
+         /// Index of the source, inserting it if needed
+      unsigned long getSourceIndex(const SourceID& source);
+
+         /// State of the given key, or 0 if there is none
+      const SatState* findState(unsigned long key) const;
+
+         /// State of the given key, inserting it if needed
+      SatState& getState(unsigned long key);
+
+         /// Double the size of the hash table
+      void rehash();
+
+
+         /// Run testLI. Returns true if a cycle slip is found
+      bool checkLI( SatState& st,
+                    double deltaT,
+                    double li,
+                    bool reset );
+
+         /// Run testLIFit. Returns true if a cycle slip is found
+      bool checkLIFit( SatState& st,
+                       const CommonTime& epoch,
+                       double deltaT,
+                       double li,
+                       bool reset );
+
+         /// Run testMW (i = 0) or testMWSigma (i = 1). Returns true if a
+         /// cycle slip is found
+      bool checkMW( SatState& st,
+                    int i,
+                    double mw,
+                    double lambda,
+                    bool reset );
+
+
+   }; // End of class 'CSDetectorBank'
+
+      //@}
+
+}  // End of namespace gpstk
+
+#endif   // GPSTK_CSDETECTORBANK_HPP
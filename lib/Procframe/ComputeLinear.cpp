@@ -53,53 +53,26 @@ namespace gpstk
 
       try
       {
-         LinearCombList linearList;
 
-            // Loop through all the satellites
+            // Group the satellites by system
+         std::vector<satTypeValueMap::iterator> sats[3];
+
          satTypeValueMap::iterator it;
          for( it = gData.begin(); it != gData.end(); ++it )
          {
-             SatID sat = (*it).first;
-
-            if(sat.system == SatID::systemGPS)
-                linearList = linearListOfGPS;
-            else if(sat.system == SatID::systemGalileo)
-                linearList = linearListOfGAL;
-            else if(sat.system == SatID::systemBDS)
-                linearList = linearListOfBDS;
-
-               // Loop through all the defined linear combinations
-            LinearCombList::const_iterator pos;
-            for( pos = linearList.begin(); pos != linearList.end(); ++pos )
-            {
-
-               double result(0.0);
-
-                  // Read the information of each linear combination
-               typeValueMap::const_iterator iter;
-               for(iter = pos->body.begin(); iter != pos->body.end(); ++iter)
-               {
-                  double temp(0.0);
-
-                  TypeID type(iter->first);
-
-                  if( (*it).second.find(type) != (*it).second.end() )
-                  {
-                     temp = (*it).second[type];
-                  }
-                  else
-                  {
-                     temp = 0.0;
-                  }
-
-                  result = result + (*iter).second * temp;
-               }
-
-                  // Store the result in the proper place
-               (*it).second[pos->header] = result;
-
-            }
+            SatID::SatelliteSystem sys( (*it).first.system );
+
+            if(sys == SatID::systemGPS)
+                sats[0].push_back(it);
+            else if(sys == SatID::systemGalileo)
+                sats[1].push_back(it);
+            else if(sys == SatID::systemBDS)
+                sats[2].push_back(it);
+         }
 
+         for(int i = 0; i < 3; ++i)
+         {
+            evaluate( compiledList[i], sats[i] );
          }
 
          return gData;
@@ -119,6 +92,171 @@ namespace gpstk
 
 
 
+      // Compile the lists of GPS, Galileo and BDS
+   void ComputeLinear::compileAll(void)
+   {
+
+      compile( linearListOfGPS, compiledList[0] );
+      compile( linearListOfGAL, compiledList[1] );
+      compile( linearListOfBDS, compiledList[2] );
+
+   }  // End of method 'ComputeLinear::compileAll()'
+
+
+
+      /* Compile one list of linear combinations.
+       *
+       * @param list      List of linear combination definitions.
+       * @param cl        Compiled list.
+       */
+   void ComputeLinear::compile( const LinearCombList& list,
+                                CompiledList& cl )
+   {
+
+         // Intern every TypeID of the list
+      std::map<TypeID, int> index;
+
+      LinearCombList::const_iterator pos;
+      for( pos = list.begin(); pos != list.end(); ++pos )
+      {
+         index[pos->header] = 0;
+
+         typeValueMap::const_iterator iter;
+         for(iter = pos->body.begin(); iter != pos->body.end(); ++iter)
+         {
+            index[iter->first] = 0;
+         }
+      }
+
+      cl.columns.clear();
+
+      std::map<TypeID, int>::iterator itIdx;
+      for(itIdx = index.begin(); itIdx != index.end(); ++itIdx)
+      {
+         itIdx->second = cl.columns.size();
+         cl.columns.push_back(itIdx->first);
+      }
+
+         // The terms of each combination, in the order of its map, so that
+         // they are added in the same order as before
+      cl.termBegin.assign( 1, 0 );
+      cl.termCol.clear();
+      cl.termCoef.clear();
+      cl.result.clear();
+
+      for( pos = list.begin(); pos != list.end(); ++pos )
+      {
+         cl.result.push_back( index[pos->header] );
+
+         typeValueMap::const_iterator iter;
+         for(iter = pos->body.begin(); iter != pos->body.end(); ++iter)
+         {
+            cl.termCol.push_back( index[iter->first] );
+            cl.termCoef.push_back( iter->second );
+         }
+
+         cl.termBegin.push_back( cl.termCol.size() );
+      }
+
+   }  // End of method 'ComputeLinear::compile()'
+
+
+
+      /* Evaluate a compiled list for a group of satellites.
+       *
+       * @param cl        Compiled list.
+       * @param sats      Satellites to be processed.
+       */
+   void ComputeLinear::evaluate( const CompiledList& cl,
+                                 std::vector<satTypeValueMap::iterator>& sats )
+      const
+   {
+
+      const int numSats( sats.size() );
+      const int numCols( cl.columns.size() );
+      const int numComb( cl.result.size() );
+
+      if( numSats == 0 || numComb == 0 ) return;
+
+         // Gather the values, (satellite x column). Missing ones are zero
+      std::vector<double> values( numSats*numCols, 0.0 );
+      std::vector<char> avail( numSats*numCols, 0 );
+
+      for(int s = 0; s < numSats; ++s)
+      {
+         const typeValueMap& tvMap( sats[s]->second );
+
+         for(int c = 0; c < numCols; ++c)
+         {
+            typeValueMap::const_iterator itType( tvMap.find(cl.columns[c]) );
+            if( itType != tvMap.end() )
+            {
+               values[s*numCols + c] = itType->second;
+               avail[s*numCols + c] = 1;
+            }
+         }
+      }
+
+         // Combinations are applied in order, each result being available
+         // to the following ones
+      std::vector<double> results( numComb*numSats, 0.0 );
+      std::vector<char> written( numComb*numSats, 0 );
+
+      for(int k = 0; k < numComb; ++k)
+      {
+         const int first( cl.termBegin[k] );
+         const int last( cl.termBegin[k+1] );
+         const int out( cl.result[k] );
+
+         for(int s = 0; s < numSats; ++s)
+         {
+            double* x( &values[s*numCols] );
+
+            if( skipIncomplete )
+            {
+               const char* a( &avail[s*numCols] );
+
+               bool complete(true);
+               for(int t = first; t < last; ++t)
+               {
+                  if( !a[cl.termCol[t]] ) complete = false;
+               }
+
+               if( !complete ) continue;
+            }
+
+            double result(0.0);
+            for(int t = first; t < last; ++t)
+            {
+               result += cl.termCoef[t] * x[cl.termCol[t]];
+            }
+
+            x[out] = result;
+            avail[s*numCols + out] = 1;
+
+            results[k*numSats + s] = result;
+            written[k*numSats + s] = 1;
+         }
+      }
+
+         // Store the results in the proper place
+      for(int s = 0; s < numSats; ++s)
+      {
+         typeValueMap& tvMap( sats[s]->second );
+
+         for(int k = 0; k < numComb; ++k)
+         {
+            if( written[k*numSats + s] )
+            {
+               tvMap[ cl.columns[cl.result[k]] ] = results[k*numSats + s];
+            }
+         }
+      }
+
+   }  // End of method 'ComputeLinear::evaluate()'
+
+
+
      /** Returns a gnssDataMap object, adding the new data generated
       *  when calling this object.
       *
@@ -32,6 +32,8 @@
 
 
 
+#include <vector>
+
 #include "ProcessingClass.hpp"
 
 
@@ -118,7 +120,21 @@ namespace gpstk
        * incoming data structure with the results inserted in it. Be warned
        * that if a given satellite does not have the observations or data
        * required by the linear combination definition, such data will be
-       * taken as zero.
+       * taken as zero, unless 'setSkipIncomplete(true)' is used: then the
+       * result of that combination is not stored for that satellite.
+       *
+       * The lists of combinations are compiled, whenever they change, into
+       * a table of the TypeIDs they involve and, for each combination, its
+       * (column, coefficient) terms. Each epoch, the values of those
+       * TypeIDs are gathered once per satellite (with a mask of the missing
+       * ones), the terms of each combination are summed for all the
+       * satellites of a system, and the results are stored back. Only the
+       * terms of a combination are read, so a bad value (inf, NaN) of an
+       * observable it does not use cannot reach its result.
+       *
+       * Process() only reads the members of this class, so one object may
+       * process several data structures at once (e.g. in an EpochPipeline),
+       * as long as the combinations are not changed meanwhile.
        *
        * \warning If the "ComputeLinear" object has more than one linear
        * combination definition, they will be applied in the same order they
@@ -134,6 +150,7 @@ namespace gpstk
 
          /// Default constructor
       ComputeLinear()
+         : skipIncomplete(false)
       { clearAll(); };
 
 
@@ -143,6 +160,7 @@ namespace gpstk
           */
       ComputeLinear( const SatID::SatelliteSystem& sys,
                      const gnssLinearCombination& linearComb )
+         : skipIncomplete(false)
       {
           if(sys == SatID::systemGPS)
               linearListOfGPS.push_back(linearComb);
@@ -150,6 +168,8 @@ namespace gpstk
               linearListOfGAL.push_back(linearComb);
           else if(sys == SatID::systemBDS)
               linearListOfBDS.push_back(linearComb);
+
+          compileAll();
       };
 
 
@@ -159,6 +179,7 @@ namespace gpstk
           */
       ComputeLinear( const SatID::SatelliteSystem& sys,
                      const LinearCombList& list )
+         : skipIncomplete(false)
       {
           if(sys == SatID::systemGPS)
               linearListOfGPS = list;
@@ -166,6 +187,8 @@ namespace gpstk
               linearListOfGAL = list;
           else if(sys == SatID::systemBDS)
               linearListOfBDS = list;
+
+          compileAll();
       };
 
 
@@ -229,6 +252,7 @@ namespace gpstk
           linearListOfGAL.clear();
           linearListOfBDS.clear();
 
+          compileAll();
           return (*this);
       };
 
@@ -258,6 +282,7 @@ namespace gpstk
               linearListOfBDS.push_back(linear);
           }
 
+          compileAll();
           return (*this);
       };
 
@@ -287,6 +312,7 @@ namespace gpstk
               linearListOfBDS = list;
           }
 
+          compileAll();
           return (*this);
       };
 
@@ -305,10 +331,23 @@ namespace gpstk
           else if(sys == SatID::systemBDS)
               linearListOfBDS.push_back(linear);
 
+          compileAll();
           return (*this);
       };
 
 
+         /** Sets whether a combination is skipped (not stored) when any of
+          *  its observables is missing, instead of taking them as zero.
+          */
+      virtual ComputeLinear& setSkipIncomplete(const bool& skip)
+      { skipIncomplete = skip; return (*this); };
+
+
+         /// Returns whether incomplete combinations are skipped.
+      virtual bool getSkipIncomplete(void) const
+      { return skipIncomplete; };
+
+
          /// Returns a string identifying this object.
       virtual std::string getClassName(void) const;
 
@@ -326,6 +365,48 @@ namespace gpstk
       LinearCombList linearListOfBDS;
 
 
+         /// Whether incomplete combinations are skipped
+      bool skipIncomplete;
+
+
+         /// A list of linear combinations compiled to sparse rows
+      struct CompiledList
+      {
+            /// Interned TypeIDs: every input and result of the list
+         std::vector<TypeID> columns;
+
+            /// Terms of combination k are [termBegin[k], termBegin[k+1])
+         std::vector<int> termBegin;
+
+            /// Column of each term
+         std::vector<int> termCol;
+
+            /// Coefficient of each term
+         std::vector<double> termCoef;
+
+            /// Column of the result of each combination
+         std::vector<int> result;
+      };
+
+
+         /// Compile the lists of GPS, Galileo and BDS
+      void compileAll(void);
+
+
+         /// Compile one list of linear combinations
+      static void compile( const LinearCombList& list,
+                           CompiledList& cl );
+
+
+         /// Evaluate a compiled list for a group of satellites
+      void evaluate( const CompiledList& cl,
+                     std::vector<satTypeValueMap::iterator>& sats ) const;
+
+
+         /// Compiled lists of GPS, Galileo and BDS
+      CompiledList compiledList[3];
+
+
    }; // End class ComputeLinear
 
       //@}
@@ -36,6 +36,7 @@
 #include <string>
 #include <sstream>
 #include "ProcessingClass.hpp"
+#include "SatAttitudeStore.hpp"
 #include "Triple.hpp"
 #include "Position.hpp"
 #include "SunPosition.hpp"
@@ -103,7 +104,7 @@ namespace gpstk
 
          /// Default constructor
       ComputeSatPCenter()
-         : pEphStore(NULL), nominalPos(0.0, 0.0, 0.0),
+         : pAttitude(NULL), pEphStore(NULL), nominalPos(0.0, 0.0, 0.0),
            pMSCStore(NULL), pAntexReader(NULL)
       { };
 
@@ -120,7 +121,7 @@ namespace gpstk
           */
       ComputeSatPCenter( XvtStore<SatID>& ephStore,
                          const Position& staPos )
-         : pEphStore(&ephStore), nominalPos(staPos),
+         : pAttitude(NULL), pEphStore(&ephStore), nominalPos(staPos),
            pAntexReader(NULL), pMSCStore(NULL)
       { };
 
@@ -135,7 +136,7 @@ namespace gpstk
           * file named "PRN_GPS" in the current directory.
           */
       ComputeSatPCenter( const Position& stapos )
-         : pEphStore(NULL), nominalPos(stapos),
+         : pAttitude(NULL), pEphStore(NULL), nominalPos(stapos),
            pAntexReader(NULL), pMSCStore(NULL)
       { };
 
@@ -153,7 +154,7 @@ namespace gpstk
       ComputeSatPCenter( XvtStore<SatID>& ephStore,
                          const Position& staPos,
                          AntexReader& antexObj )
-         : pEphStore(&ephStore), nominalPos(staPos),
+         : pAttitude(NULL), pEphStore(&ephStore), nominalPos(staPos),
            pAntexReader(&antexObj), pMSCStore(NULL)
       { };
 
@@ -169,7 +170,7 @@ namespace gpstk
           */
       ComputeSatPCenter( const Position& staPos,
                          AntexReader& antexObj )
-         : pEphStore(NULL), nominalPos(staPos),
+         : pAttitude(NULL), pEphStore(NULL), nominalPos(staPos),
            pAntexReader(&antexObj), pMSCStore(NULL)
       { };
 
@@ -267,6 +268,21 @@ namespace gpstk
       { pAntexReader = &antexObj; return (*this); };
 
 
+         /// Returns a pointer to the SatAttitudeStore object currently in use.
+      virtual SatAttitudeStore *getAttitudeStore(void) const
+      { return pAttitude; };
+
+
+         /** Sets SatAttitudeStore object to be used. The satellite attitude
+          *  and the Sun position are then taken from it, once per epoch,
+          *  instead of being computed for every station.
+          *
+          * @param attitude  SatAttitudeStore object.
+          */
+      virtual ComputeSatPCenter& setAttitudeStore(SatAttitudeStore& attitude)
+      { pAttitude = &attitude; return (*this); };
+
+
          /// Returns a string identifying this object.
       virtual std::string getClassName(void) const;
 
@@ -278,6 +294,9 @@ namespace gpstk
    private:
 
 
+         /// Pointer to SatAttitudeStore object, if available
+      SatAttitudeStore* pAttitude;
+
          /// Pointer to XvtStore<SatID> object
       XvtStore<SatID> *pEphStore;
 
@@ -305,6 +324,25 @@ namespace gpstk
                                             const Triple& sunpos );
 
 
+         /** Compute the value of satellite antenna phase correction, in
+          *  meters, given the unit vectors of the satellite body frame.
+          * @param satid     Satellite ID
+          * @param time      Epoch of interest
+          * @param satpos    Satellite position, as a Triple
+          * @param ri        Body frame X axis, as a Triple
+          * @param rj        Body frame Y axis, as a Triple
+          * @param rk        Body frame Z axis, as a Triple
+          *
+          * @return Satellite antenna phase correction, in meters.
+          */
+      virtual Vector<double> getSatPCenter( const SatID& satid,
+                                            const CommonTime& time,
+                                            const Triple& satpos,
+                                            const Triple& ri,
+                                            const Triple& rj,
+                                            const Triple& rk );
+
+
    }; // End of class 'ComputeSatPCenter'
 
       //@}
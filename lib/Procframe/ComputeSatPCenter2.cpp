@@ -54,9 +54,14 @@ namespace gpstk
         try
         {
 
-            // Compute Sun position at this epoch
-            SunPosition sunPosition;
-            Triple sunPos(sunPosition.getPosition(time));
+            // Compute Sun position at this epoch, unless the satellite
+            // attitude comes from a SatAttitudeStore
+            Triple sunPos(0.0, 0.0, 0.0);
+            if(pAttitude == NULL)
+            {
+                SunPosition sunPosition;
+                sunPos = sunPosition.getPosition(time);
+            }
 
             // Define a Triple that will hold satellite position, in ECEF
             Triple satPos(0.0, 0.0, 0.0);
@@ -94,7 +99,30 @@ namespace gpstk
                 // Let's get the satellite antenna phase correction value in
                 // meters, and insert it in the GNSS data structure.
 
-                Vector<double> satPCenter = getSatPCenter(sat,time,satPos,sunPos);
+                Vector<double> satPCenter;
+
+                if(pAttitude != NULL)
+                {
+                    SatAttitudeStore::Reader reader(*pAttitude);
+
+                    const SatAttitudeData* pAtt;
+                    try
+                    {
+                        pAtt = &pAttitude->getAttitude(reader, time, sat);
+                    }
+                    catch(InvalidRequest& e)
+                    {
+                        satRejectedSet.insert( sat );
+                        continue;
+                    }
+
+                    satPCenter = getSatPCenter( sat, time, satPos,
+                                                pAtt->ri, pAtt->rj, pAtt->rk );
+                }
+                else
+                {
+                    satPCenter = getSatPCenter( sat, time, satPos, sunPos );
+                }
 
 //                cout << sat;
 //                cout << setprecision(3)
@@ -214,6 +242,31 @@ namespace gpstk
         // Let's convert ri to an unitary vector (ECEF)
         ri = ri.unitVector();
 
+        return getSatPCenter(satid, time, satpos, ri, rj, rk);
+
+    }  // End of method 'ComputeSatPCenter2::getSatPCenter()'
+
+
+
+      /* Compute the value of satellite antenna phase correction, in meters,
+       * given the unit vectors of the satellite body frame.
+       * @param satid     Satellite ID
+       * @param time      Epoch of interest
+       * @param satpos    Satellite position, as a Triple
+       * @param ri        Body frame X axis, as a Triple
+       * @param rj        Body frame Y axis, as a Triple
+       * @param rk        Body frame Z axis, as a Triple
+       *
+       * @return Satellite antenna phase correction, in meters.
+       */
+    Vector<double> ComputeSatPCenter2::getSatPCenter( const SatID& satid,
+                                                           const CommonTime& time,
+                                                           const Triple& satpos,
+                                                           const Triple& ri,
+                                                           const Triple& rj,
+                                                           const Triple& rk )
+    {
+
         // Get vector from geocenter to station
         Triple stapos(nominalPos.X(), nominalPos.Y(), nominalPos.Z());
 
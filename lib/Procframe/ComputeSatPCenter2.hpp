@@ -36,6 +36,7 @@
 #include <string>
 #include <sstream>
 #include "ProcessingClass.hpp"
+#include "SatAttitudeStore.hpp"
 #include "SunPosition.hpp"
 #include "AntexReader.hpp"
 #include "MSCStore.hpp"
@@ -80,7 +81,7 @@ namespace gpstk
     public:
 
          /// Default constructor
-        ComputeSatPCenter2() : pAntexReader(NULL)
+        ComputeSatPCenter2() : pAttitude(NULL), pAntexReader(NULL)
         { };
 
 
@@ -90,7 +91,7 @@ namespace gpstk
           *                     antenna data.
           */
         ComputeSatPCenter2( AntexReader& antexReader )
-            : pAntexReader(&antexReader)
+            : pAttitude(NULL), pAntexReader(&antexReader)
         { };
 
 
@@ -161,6 +162,21 @@ namespace gpstk
         { pMSCStore = &mscStore; return (*this); };
 
 
+         /// Returns a pointer to the SatAttitudeStore object currently in use.
+        virtual SatAttitudeStore *getAttitudeStore(void) const
+        { return pAttitude; };
+
+
+         /** Sets SatAttitudeStore object to be used. The satellite attitude
+          *  and the Sun position are then taken from it, once per epoch,
+          *  instead of being computed for every station.
+          *
+          * @param attitude  SatAttitudeStore object.
+          */
+        virtual ComputeSatPCenter2& setAttitudeStore(SatAttitudeStore& attitude)
+        { pAttitude = &attitude; return (*this); };
+
+
          /// Returns a string identifying this object.
         virtual std::string getClassName(void) const;
 
@@ -171,6 +187,9 @@ namespace gpstk
 
     private:
 
+         /// Pointer to SatAttitudeStore object, if available
+        SatAttitudeStore* pAttitude;
+
          /// Pointer to AntexReader object
         AntexReader* pAntexReader;
 
@@ -195,6 +214,25 @@ namespace gpstk
                                               const Triple& sunpos );
 
 
+         /** Compute the value of satellite antenna phase correction, in
+          *  meters, given the unit vectors of the satellite body frame.
+          * @param satid     Satellite ID
+          * @param time      Epoch of interest
+          * @param satpos    Satellite position, as a Triple
+          * @param ri        Body frame X axis, as a Triple
+          * @param rj        Body frame Y axis, as a Triple
+          * @param rk        Body frame Z axis, as a Triple
+          *
+          * @return Satellite antenna phase correction, in meters.
+          */
+        virtual Vector<double> getSatPCenter( const SatID& satid,
+                                              const CommonTime& time,
+                                              const Triple& satpos,
+                                              const Triple& ri,
+                                              const Triple& rj,
+                                              const Triple& rk );
+
+
     }; // End of class 'ComputeSatPCenter2'
 
       //@}
@@ -53,9 +53,17 @@ namespace gpstk
     {
         try
         {
-            // Compute Sun position at this epoch
-            SunPosition sunPosition;
-            Triple sunPos(sunPosition.getPosition(time));
+            // Compute Sun position at this epoch, unless the satellite
+            // attitude comes from a SatAttitudeStore
+            Triple sunPos(0.0, 0.0, 0.0);
+            if(pAttitude == NULL)
+            {
+                SunPosition sunPosition;
+                sunPos = sunPosition.getPosition(time);
+            }
+
+            // Reference frame of the receiver, common to all satellites
+            updateReceiverFrame();
 
             // Define a Triple that will hold satellite position, in ECEF
             Triple svPos(0.0, 0.0, 0.0);
@@ -137,8 +145,31 @@ namespace gpstk
 
                 // Let's get wind-up value in radians, and insert it
                 // into GNSS data structure.
-                (*it).second[TypeID::windUp] =
+                if(pAttitude != NULL)
+                {
+                    SatAttitudeStore::Reader reader(*pAttitude);
+
+                    const SatAttitudeData* pAtt;
+                    try
+                    {
+                        pAtt = &pAttitude->getAttitude( reader, time,
+                                                         (*it).first );
+                    }
+                    catch(InvalidRequest& e)
+                    {
+                        satRejectedSet.insert( (*it).first );
+                        continue;
+                    }
+
+                    (*it).second[TypeID::windUp] =
+                        getWindUp( (*it).first, svPos,
+                                   pAtt->ri, pAtt->rj, pAtt->rk );
+                }
+                else
+                {
+                    (*it).second[TypeID::windUp] =
                                     getWindUp((*it).first, time, svPos, sunPos);
+                }
 
             }  // End of 'for (it = gData.begin(); it != gData.end(); ++it)'
 
@@ -245,6 +276,37 @@ namespace gpstk
 
 
 
+      // Compute the receiver reference frame, which only depends on the
+      // nominal position of the receiver.
+   void ComputeWindUp::updateReceiverFrame()
+   {
+
+         // Get vector from Earth mass center to receiver
+      rxPos = Triple(nominalPos.X(), nominalPos.Y(), nominalPos.Z());
+
+         // Define rk: Unitary vector from Receiver to Earth mass center
+      rxK = (-1.0)*(rxPos.unitVector());
+
+         // Let's define a NORTH unitary vector in the Up, East, North
+         // (UEN) topocentric reference frame
+      Triple delta(0.0, 0.0, 1.0);
+
+         // Rotate delta to XYZ reference frame
+      delta =
+         (delta.R2(nominalPos.geodeticLatitude())).R3(-nominalPos.longitude());
+
+
+         // Computation of reference trame unitary vectors for receiver
+         // rj = rk x delta, and make it unitary
+      rxJ = (rxK.cross(delta)).unitVector();
+
+         // ri = rj x rk, and make it unitary
+      rxI = (rxJ.cross(rxK)).unitVector();
+
+   }  // End of method 'ComputeWindUp::updateReceiverFrame()'
+
+
+
       /* Compute the value of the wind-up, in radians.
        * @param sat       Satellite IDmake
        * @param time      Epoch of interest
@@ -259,11 +321,6 @@ namespace gpstk
                                     const Triple& sunPos )
    {
 
-         // Get satellite rotation angle
-
-         // Get vector from Earth mass center to receiver
-      Triple rxPos(nominalPos.X(), nominalPos.Y(), nominalPos.Z());
-
          // Vector from SV to Sun center of mass
       Triple sat_sun( sunPos-satPos );
 
@@ -278,6 +335,30 @@ namespace gpstk
          // frame, expressed in the ECEF reference frame
       Triple ri( (rj.cross(rk)).unitVector() );
 
+      return getWindUp(satid, satPos, ri, rj, rk);
+
+   }  // End of method 'ComputeWindUp::getWindUp()'
+
+
+
+      /* Compute the value of the wind-up, in radians, given the unit
+       * vectors of the satellite body frame.
+       * @param sat       Satellite ID
+       * @param satpos    Satellite position, as a Triple
+       * @param ri        Body frame X axis, as a Triple
+       * @param rj        Body frame Y axis, as a Triple
+       * @param rk        Body frame Z axis, as a Triple
+       *
+       * @return Wind-up computation, in radians
+       */
+   double ComputeWindUp::getWindUp( const SatID& satid,
+                                    const Triple& satPos,
+                                    const Triple& ri,
+                                    const Triple& rj,
+                                    const Triple& rk )
+   {
+
+         // Get satellite rotation angle
 
          // Compute unitary vector from satellite to receiver
       Triple rrho( (rxPos-satPos).unitVector() );
@@ -297,37 +378,19 @@ namespace gpstk
       double alpha1(std::atan2(yk,xk));
 
 
-         // Get receiver rotation angle
-
-         // Redefine rk: Unitary vector from Receiver to Earth mass center
-      rk = (-1.0)*(rxPos.unitVector());
-
-         // Let's define a NORTH unitary vector in the Up, East, North
-         // (UEN) topocentric reference frame
-      Triple delta(0.0, 0.0, 1.0);
-
-         // Rotate delta to XYZ reference frame
-      delta =
-         (delta.R2(nominalPos.geodeticLatitude())).R3(-nominalPos.longitude());
-
-
-         // Computation of reference trame unitary vectors for receiver
-         // rj = rk x delta, and make it unitary
-      rj = (rk.cross(delta)).unitVector();
-
-         // ri = rj x rk, and make it unitary
-      ri = (rj.cross(rk)).unitVector();
+         // Get receiver rotation angle, with the receiver frame of
+         // 'updateReceiverFrame()'
 
          // Projection of "rk" vector to line of sight vector (rrho)
-      zk = rrho.dot(rk);
+      zk = rrho.dot(rxK);
 
          // Get a vector without components on rk (i.e., belonging
          // to ri, rj plane)
-      dpp = rrho-zk*rk;
+      dpp = rrho-zk*rxK;
 
          // Compute dpp components in ri, rj plane
-      xk = dpp.dot(ri);
-      yk = dpp.dot(rj);
+      xk = dpp.dot(rxI);
+      yk = dpp.dot(rxJ);
 
          // Compute receiver rotation angle, in radians
       double alpha2(std::atan2(yk,xk));
@@ -34,6 +34,7 @@
 
 #include <string>
 #include "ProcessingClass.hpp"
+#include "SatAttitudeStore.hpp"
 #include "SunPosition.hpp"
 #include "XvtStore.hpp"
 #include "MSCStore.hpp"
@@ -103,7 +104,8 @@ namespace gpstk
 
          /// Default constructor
       ComputeWindUp()
-         : pEphStore(NULL), nominalPos(0.0, 0.0, 0.0), pMSCStore(NULL),
+         : pAttitude(NULL), pEphStore(NULL), nominalPos(0.0, 0.0, 0.0),
+           pMSCStore(NULL),
            satData("PRN_GPS"), fileData("PRN_GPS"), pAntexReader(NULL)
       { };
 
@@ -121,7 +123,7 @@ namespace gpstk
       ComputeWindUp( XvtStore<SatID>& ephStore,
                      const Position& staPos,
                      std::string filename="PRN_GPS" )
-         : pEphStore(&ephStore), nominalPos(staPos),
+         : pAttitude(NULL), pEphStore(&ephStore), nominalPos(staPos),
            pMSCStore(NULL), satData(filename),
            fileData(filename), pAntexReader(NULL)
       { };
@@ -141,7 +143,7 @@ namespace gpstk
                      const Position& staPos,
                      MSCStore& mscStore,
                      AntexReader& antexObj )
-         : pEphStore(&ephStore), nominalPos(staPos),
+         : pAttitude(NULL), pEphStore(&ephStore), nominalPos(staPos),
            pMSCStore(&mscStore), pAntexReader(&antexObj)
       { };
 
@@ -157,7 +159,7 @@ namespace gpstk
           */
       ComputeWindUp( const Position& staPos,
                      AntexReader& antexObj )
-         : pEphStore(NULL), nominalPos(staPos),
+         : pAttitude(NULL), pEphStore(NULL), nominalPos(staPos),
            pMSCStore(NULL), pAntexReader(&antexObj)
       { };
 
@@ -265,6 +267,21 @@ namespace gpstk
       { pMSCStore = &msc; return (*this); };
 
 
+         /// Returns a pointer to the SatAttitudeStore object currently in use.
+      virtual SatAttitudeStore *getAttitudeStore(void) const
+      { return pAttitude; };
+
+
+         /** Sets SatAttitudeStore object to be used. The satellite attitude
+          *  and the Sun position are then taken from it, once per epoch,
+          *  instead of being computed for every station.
+          *
+          * @param attitude  SatAttitudeStore object.
+          */
+      virtual ComputeWindUp& setAttitudeStore(SatAttitudeStore& attitude)
+      { pAttitude = &attitude; return (*this); };
+
+
          /// Returns a string identifying this object.
       virtual std::string getClassName(void) const;
 
@@ -276,6 +293,9 @@ namespace gpstk
    private:
 
 
+         /// Pointer to SatAttitudeStore object, if available
+      SatAttitudeStore* pAttitude;
+
          /// Satellite ephemeris to be used
       XvtStore<SatID> *pEphStore;
 
@@ -325,6 +345,14 @@ namespace gpstk
       SatPhaseDataMap m_satPhaseDataMap;
 
 
+         /// Receiver position and reference frame
+      Triple rxPos, rxI, rxJ, rxK;
+
+
+         /// Compute the receiver reference frame
+      void updateReceiverFrame();
+
+
          /** Compute the value of the wind-up, in radians.
           * @param sat       Satellite ID
           * @param time      Epoch of interest
@@ -339,6 +367,23 @@ namespace gpstk
                                 const Triple& sunpos );
 
 
+         /** Compute the value of the wind-up, in radians, given the unit
+          *  vectors of the satellite body frame.
+          * @param sat       Satellite ID
+          * @param satpos    Satellite position, as a Triple
+          * @param ri        Body frame X axis, as a Triple
+          * @param rj        Body frame Y axis, as a Triple
+          * @param rk        Body frame Z axis, as a Triple
+          *
+          * @return Wind-up computation, in radians
+          */
+      virtual double getWindUp( const SatID& sat,
+                                const Triple& satpos,
+                                const Triple& ri,
+                                const Triple& rj,
+                                const Triple& rk );
+
+
    }; // End of class 'ComputeWindUp'
 
       //@}
@@ -3503,7 +3503,42 @@ in matrix and number of types do not match") );
    }  // End of 'operator<<'
 
 
-      // Stream input for gnssRinex
+      // Plan to decode a RINEX 3 stream, and the header it was compiled
+      // from
+    struct CachedDecodePlan
+    {
+        CachedDecodePlan() : compiled(false), headerCount(0) {};
+
+        bool compiled;
+        unsigned long headerCount;
+        Rinex3ObsDecodePlan plan;
+    };
+
+      // Slot of the decode plan in the storage of every stream
+    static const int decodePlanIndex = std::ios_base::xalloc();
+
+      // Delete the decode plan of a stream with the stream. A stream
+      // copying the format of another one gets no plan, and compiles its own.
+    static void decodePlanCallback( std::ios_base::event ev,
+                                    std::ios_base& strm,
+                                    int index )
+    {
+        void*& slot( strm.pword(index) );
+
+        if( ev == std::ios_base::erase_event )
+        {
+            delete static_cast<CachedDecodePlan*>(slot);
+            slot = NULL;
+        }
+        else if( ev == std::ios_base::copyfmt_event )
+        {
+            slot = NULL;
+        }
+    }
+
+
+
+    // Stream input for gnssRinex
     std::istream& operator>>( std::istream& i, gnssRinex& f )
     {
 
@@ -3565,7 +3600,25 @@ in matrix and number of types do not match") );
             f.header.epochFlag = rod.epochFlag;
             f.header.epoch = rod.time;
 
-            f.body = satTypeValueMapFromRinex3ObsData(roh, rod);
+            // Decode with the plan compiled from the header of the stream,
+            // kept in the stream until it reads another header
+            void*& slot( strm.pword(decodePlanIndex) );
+            if( slot == NULL )
+            {
+                slot = new CachedDecodePlan;
+                strm.register_callback(decodePlanCallback, decodePlanIndex);
+            }
+
+            CachedDecodePlan& cached( *static_cast<CachedDecodePlan*>(slot) );
+
+            if( !cached.compiled || cached.headerCount != strm.headerCount )
+            {
+                cached.plan.compile(roh);
+                cached.headerCount = strm.headerCount;
+                cached.compiled = true;
+            }
+
+            f.body = cached.plan.decode(rod);
 
             return i;
         }
@@ -3773,12 +3826,8 @@ in matrix and number of types do not match") );
 
 
 
-      // Convenience function to fill a satTypeValueMap with data
-      // from Rinex3ObsData.
-      // @param roh Rinex3ObsHeader holding the data
-      // @param rod Rinex3ObsData holding the data.
-    satTypeValueMap satTypeValueMapFromRinex3ObsData(
-                         const Rinex3ObsHeader& roh, const Rinex3ObsData& rod )
+      // Compile the plan to decode the observations of a RINEX 3 file
+    void Rinex3ObsDecodePlan::compile(const Rinex3ObsHeader& roh)
     {
         // Valid Rinex Tracking Codes of GPS
         const string G1_validRTCs( ObsID::validRinexTrackingCodes['G']['1'] );
@@ -3808,7 +3857,7 @@ in matrix and number of types do not match") );
         vector<RinexObsID> useObsTypesOfGalileo;
         vector<RinexObsID> useObsTypesOfBDS;
 
-        map< string,vector<RinexObsID> > mapObsTypes(roh.mapObsTypes);
+        const map< string,vector<RinexObsID> >& mapObsTypes(roh.mapObsTypes);
         map< string,vector<RinexObsID> >::const_iterator it_mot;
 
         // Loop of systems
@@ -4088,6 +4137,74 @@ in matrix and number of types do not match") );
 
 
 
+        // Table of the columns to be decoded, for every system
+        const char systems[3] = { 'G', 'E', 'C' };
+        const SatID::SatelliteSystem satSys[3] = { SatID::systemGPS,
+                                                   SatID::systemGalileo,
+                                                   SatID::systemBDS };
+        const vector<RinexObsID>* useObsTypes[3] = { &useObsTypesOfGPS,
+                                                     &useObsTypesOfGalileo,
+                                                     &useObsTypesOfBDS };
+
+        for(int k=0; k<3; k++)
+        {
+            columns[k].clear();
+
+            it_mot = mapObsTypes.find( string(1,systems[k]) );
+            if(it_mot == mapObsTypes.end()) continue;
+
+            const vector<RinexObsID>& roi_obs(it_mot->second);
+            const vector<RinexObsID>& roi_use(*useObsTypes[k]);
+
+            RinexSatID sat(1, satSys[k]);
+
+            for(size_t i=0; i<roi_obs.size(); i++)
+            {
+                if( find(roi_use.begin(),roi_use.end(),roi_obs[i]) == roi_use.end() )
+                    continue;
+
+                TypeID type_3c( ConvertToTypeID(roi_obs[i],sat) );
+
+                Column col;
+                col.index = i;
+                col.type = TypeID( asString(type_3c).substr(0,2) );
+                col.band = GetCarrierBand(roi_obs[i]);
+                col.isPhase = (roi_obs[i].type == ObsID::otL);
+                col.wavelength = getWavelength(sat,col.band);
+                col.haveLLI = true;
+
+                switch(col.band)
+                {
+                    case 1: col.lliType = TypeID::LLI1;
+                            col.ssiType = TypeID::SSI1; break;
+                    case 2: col.lliType = TypeID::LLI2;
+                            col.ssiType = TypeID::SSI2; break;
+                    case 3: col.lliType = TypeID::LLI3;
+                            col.ssiType = TypeID::SSI3; break;
+                    case 5: col.lliType = TypeID::LLI5;
+                            col.ssiType = TypeID::SSI5; break;
+                    case 6: col.lliType = TypeID::LLI6;
+                            col.ssiType = TypeID::SSI6; break;
+                    case 7: col.lliType = TypeID::LLI7;
+                            col.ssiType = TypeID::SSI7; break;
+                    case 8: col.lliType = TypeID::LLI8;
+                            col.ssiType = TypeID::SSI8; break;
+                    case 9: col.lliType = TypeID::LLI9;
+                            col.ssiType = TypeID::SSI9; break;
+                    default: col.haveLLI = false; break;
+                }
+
+                columns[k].push_back(col);
+            }
+        }
+
+    }  // End of method 'Rinex3ObsDecodePlan::compile()'
+
+
+
+      // Decode the observations of an epoch
+    satTypeValueMap Rinex3ObsDecodePlan::decode(const Rinex3ObsData& rod) const
+    {
         // We need to declare a satTypeValueMap
         satTypeValueMap theMap;
 
@@ -4096,93 +4213,64 @@ in matrix and number of types do not match") );
 
         for(it=rod.obs.begin(); it != rod.obs.end(); ++it)
         {
-            RinexSatID sat(it->first);
-
-            typeValueMap tvMap;
-
-            vector<RinexObsID> roi_obs(mapObsTypes[sat.toString().substr(0,1)]);
-
-            vector<RinexObsID> roi_use;
+            const RinexSatID& sat(it->first);
 
+            int k;
             if(sat.system == SatID::systemGPS)
-                roi_use = useObsTypesOfGPS;
+                k = 0;
             else if(sat.system == SatID::systemGalileo)
-                roi_use = useObsTypesOfGalileo;
+                k = 1;
             else if(sat.system == SatID::systemBDS)
-                roi_use = useObsTypesOfBDS;
+                k = 2;
             else
                 continue;
 
-//           cout << sat << ' ';
+            const vector<RinexDatum>& datum(it->second);
 
-            for(size_t i=0; i<roi_obs.size(); i++)
-            {
-                if( find(roi_use.begin(),roi_use.end(),roi_obs[i]) == roi_use.end() )
-                    continue;
+            typeValueMap& tvMap( theMap[sat] );
 
-                TypeID type_3c( ConvertToTypeID(roi_obs[i],sat) );
-                TypeID type_2c( asString(type_3c).substr(0,2) );
+            for(size_t j=0; j<columns[k].size(); j++)
+            {
+                const Column& col(columns[k][j]);
 
-//               cout << type_2c << ' ';
+                if(col.index >= datum.size()) break;
 
-                int n = GetCarrierBand(roi_obs[i]);
-                double data = it->second[i].data;
+                double data = datum[col.index].data;
 
                 if(data == 0.0) continue;
 
-                if(roi_obs[i].type == ObsID::otL)
+                if(col.isPhase)
                 {
-                    tvMap[type_2c] = data * getWavelength(sat,n);
-
-                    double lli = it->second[i].lli;
-                    double ssi = it->second[i].ssi;
+                    tvMap[col.type] = data * col.wavelength;
 
-                    if(n == 1)
-                    {
-                        tvMap[TypeID::LLI1] = lli; tvMap[TypeID::SSI1] = ssi;
-                    }
-                    else if(n == 2)
-                    {
-                        tvMap[TypeID::LLI2] = lli; tvMap[TypeID::SSI2] = ssi;
-                    }
-                    else if(n == 3)
-                    {
-                        tvMap[TypeID::LLI3] = lli; tvMap[TypeID::SSI3] = ssi;
-                    }
-                    else if(n == 5)
-                    {
-                        tvMap[TypeID::LLI5] = lli; tvMap[TypeID::SSI5] = ssi;
-                    }
-                    else if(n == 6)
+                    if(col.haveLLI)
                     {
-                        tvMap[TypeID::LLI6] = lli; tvMap[TypeID::SSI6] = ssi;
-                    }
-                    else if(n == 7)
-                    {
-                        tvMap[TypeID::LLI7] = lli; tvMap[TypeID::SSI7] = ssi;
-                    }
-                    else if(n == 8)
-                    {
-                        tvMap[TypeID::LLI8] = lli; tvMap[TypeID::SSI8] = ssi;
-                    }
-                    else if(n == 9)
-                    {
-                        tvMap[TypeID::LLI9] = lli; tvMap[TypeID::SSI9] = ssi;
+                        tvMap[col.lliType] = datum[col.index].lli;
+                        tvMap[col.ssiType] = datum[col.index].ssi;
                     }
                 }
                 else
                 {
-                    tvMap[type_2c] = data;
+                    tvMap[col.type] = data;
                 }
             }
 
-//           cout << endl;
-
-            theMap[sat] = tvMap;
-
         }   // End loop over all the satellite
 
         return theMap;
+
+    }  // End of method 'Rinex3ObsDecodePlan::decode()'
+
+
+
+      // Convenience function to fill a satTypeValueMap with data
+      // from Rinex3ObsData.
+      // @param roh Rinex3ObsHeader holding the data
+      // @param rod Rinex3ObsData holding the data.
+    satTypeValueMap satTypeValueMapFromRinex3ObsData(
+                         const Rinex3ObsHeader& roh, const Rinex3ObsData& rod )
+    {
+        return Rinex3ObsDecodePlan(roh).decode(rod);
     }
 
 }  // End of namespace gpstk
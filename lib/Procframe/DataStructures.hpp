@@ -47,6 +47,7 @@
 #include "CivilTime.hpp"
 #include "YDSTime.hpp"
 #include "constants.hpp"
+#include "EpochArena.hpp"
 
 
 
@@ -176,8 +177,12 @@ namespace gpstk
    typedef std::set<SourceID> SourceIDSet;
 
 
-      /// Map holding TypeID with corresponding numeric value.
-   struct typeValueMap : std::map<TypeID, double>
+      /// Map holding TypeID with corresponding numeric value. As
+      /// satTypeValueMap, sourceDataMap and gnssDataMap, it takes its
+      /// memory from the current EpochArena of the thread, if any.
+   struct typeValueMap
+      : std::map< TypeID, double, std::less<TypeID>,
+                  EpochAllocator< std::pair<const TypeID, double> > >
    {
 
          /// Returns the number of different types available.
@@ -405,7 +410,9 @@ namespace gpstk
 
 
       /// Map holding SatID with corresponding typeValueMap.
-   struct satTypeValueMap : std::map<SatID, typeValueMap>
+   struct satTypeValueMap
+      : std::map< SatID, typeValueMap, std::less<SatID>,
+                  EpochAllocator< std::pair<const SatID, typeValueMap> > >
    {
 
          /// Returns the number of available satellites.
@@ -1195,7 +1202,9 @@ namespace gpstk
 
       /// GNSS data structure consisting in a map with SourceID as keys, and
       /// satTypeValueMap as elements.
-   struct sourceDataMap : std::map<SourceID, satTypeValueMap>
+   struct sourceDataMap
+      : std::map< SourceID, satTypeValueMap, std::less<SourceID>,
+                  EpochAllocator< std::pair<const SourceID, satTypeValueMap> > >
    {
 
          /// Default constructor
@@ -1241,7 +1250,10 @@ namespace gpstk
 
       /// GNSS data structure consisting in a map with CommonTime as keys, and
       /// sourceDataMap as elements.
-   struct  gnssDataMap : std::multimap<CommonTime, sourceDataMap>
+   struct  gnssDataMap
+      : std::multimap< CommonTime, sourceDataMap, std::less<CommonTime>,
+                       EpochAllocator< std::pair<const CommonTime,
+                                                 sourceDataMap> > >
    {
 
          /// Default constructor
@@ -1660,6 +1672,54 @@ namespace gpstk
    SourceID::SourceType SatIDsystem2SourceIDtype(const SatID& sid);
 
 
+      /** Plan to decode the observations of a RINEX 3 file into
+       *  satTypeValueMap objects, compiled once from its header.
+       *
+       * For GPS, Galileo and BDS, it chooses the tracking codes to be used
+       * from the observation types of the header, and keeps a table with
+       * the columns of the data records to be decoded: their TypeID,
+       * wavelength, and the LLI and SSI types of the phases. Decoding an
+       * epoch is then a walk through the table, with no string handling
+       * nor searches.
+       */
+   class Rinex3ObsDecodePlan
+   {
+   public:
+
+         /// Default constructor, decoding nothing
+      Rinex3ObsDecodePlan() {};
+
+         /// Common constructor, compiling the plan of a header
+      explicit Rinex3ObsDecodePlan(const Rinex3ObsHeader& roh)
+      { compile(roh); };
+
+         /// Compile the plan of a header
+      void compile(const Rinex3ObsHeader& roh);
+
+         /// Decode the observations of an epoch
+      satTypeValueMap decode(const Rinex3ObsData& rod) const;
+
+   private:
+
+         /// Column of the data records to be decoded
+      struct Column
+      {
+         size_t index;        ///< Index in the data record
+         TypeID type;         ///< Two-character TypeID, e.g. C1 or L2
+         int band;            ///< Carrier band
+         bool isPhase;        ///< Whether the column is a phase
+         double wavelength;   ///< Wavelength of a phase
+         TypeID lliType;      ///< LLI TypeID of a phase
+         TypeID ssiType;      ///< SSI TypeID of a phase
+         bool haveLLI;        ///< Whether the band has LLI and SSI types
+      };
+
+         /// Columns of GPS, Galileo and BDS
+      std::vector<Column> columns[3];
+
+   };  // End of class 'Rinex3ObsDecodePlan'
+
+
       /// Convenience function to fill a satTypeValueMap with data
       /// from Rinex3ObsData.
       /// @param roh Rinex3ObsHeader holding the data
@@ -1673,6 +1733,11 @@ namespace gpstk
        * This handy operator allows to fed a gnssRinex data structure
        * directly from an input stream such a RinexObsStream object.
        *
+       * The observations are decoded with a Rinex3ObsDecodePlan compiled
+       * from the header, kept in the stream and deleted with it. It is
+       * compiled again when the stream reads another header, so a header
+       * changed by hand should be read through the stream.
+       *
        * For example:
        *
        * @code
@@ -103,9 +103,14 @@ namespace gpstk
             // threshold = cos(180 - coneAngle/2)
          double threshold( std::cos(PI - coneAngle/2.0*DEG_TO_RAD) );
 
-            // Compute Sun position at this epoch, and store it in a Triple
-         SunPosition sunPosition;
-         Triple sunPos(sunPosition.getPosition(epoch));
+            // Compute Sun position at this epoch, and store it in a Triple,
+            // unless the Sun geometry comes from a SatAttitudeStore
+         Triple sunPos(0.0, 0.0, 0.0);
+         if(pAttitude == NULL)
+         {
+            SunPosition sunPosition;
+            sunPos = sunPosition.getPosition(epoch);
+         }
 
             // Define a Triple that will hold satellite position, in ECEF
          Triple svPos(0.0, 0.0, 0.0);
@@ -114,10 +119,27 @@ namespace gpstk
          satTypeValueMap::iterator it;
          for (it = gData.begin(); it != gData.end(); ++it)
          {
+            double cosAngle(0.0);
+
+            if(pAttitude != NULL)
+            {
+                  // Get the Sun geometry of this satellite
+               try
+               {
+                  SatAttitudeStore::Reader reader(*pAttitude);
+                  cosAngle = pAttitude->getAttitude( reader, epoch,
+                                                     (*it).first ).sunCosAngle;
+               }
+               catch(InvalidRequest& e)
+               {
+                  satRejectedSet.insert( (*it).first );
+                  continue;
+               }
+            }
                // Check if satellite position is not already computed
-            if( ( (*it).second.find(TypeID::satX) == (*it).second.end() ) ||
-                ( (*it).second.find(TypeID::satY) == (*it).second.end() ) ||
-                ( (*it).second.find(TypeID::satZ) == (*it).second.end() ) )
+            else if( ( (*it).second.find(TypeID::satX) == (*it).second.end() ) ||
+                     ( (*it).second.find(TypeID::satY) == (*it).second.end() ) ||
+                     ( (*it).second.find(TypeID::satZ) == (*it).second.end() ) )
             {
 
                   // If satellite position is missing, then schedule this
@@ -131,16 +153,16 @@ namespace gpstk
                svPos[0] = (*it).second[TypeID::satX];
                svPos[1] = (*it).second[TypeID::satY];
                svPos[2] = (*it).second[TypeID::satZ];
-            }
 
-               // Unitary vector from Earth mass center to satellite
-            Triple rk( svPos.unitVector() );
+                  // Unitary vector from Earth mass center to satellite
+               Triple rk( svPos.unitVector() );
 
-               // Unitary vector from Earth mass center to Sun
-            Triple ri( sunPos.unitVector() );
+                  // Unitary vector from Earth mass center to Sun
+               Triple ri( sunPos.unitVector() );
 
-               // Get dot product between unitary vectors = cosine(angle)
-            double cosAngle(ri.dot(rk));
+                  // Get dot product between unitary vectors = cosine(angle)
+               cosAngle = ri.dot(rk);
+            }
 
                // Check if satellite is within shadow
             if(cosAngle <= threshold)
@@ -37,6 +37,7 @@
 #include "SunPosition.hpp"
 #include "Position.hpp"
 #include "ProcessingClass.hpp"
+#include "SatAttitudeStore.hpp"
 #include "constants.hpp"
 
 
@@ -101,7 +102,8 @@ namespace gpstk
       public:
 
          /// Default constructor.
-      EclipsedSatFilter() : coneAngle(30.0), postShadowPeriod(1800.0)
+      EclipsedSatFilter()
+         : pAttitude(NULL), coneAngle(30.0), postShadowPeriod(1800.0)
       { };
 
 
@@ -113,7 +115,7 @@ namespace gpstk
           */
       EclipsedSatFilter( const double angle,
                          const double pShTime )
-         : coneAngle(angle), postShadowPeriod(pShTime)
+         : pAttitude(NULL), coneAngle(angle), postShadowPeriod(pShTime)
       { };
 
 
@@ -184,6 +186,21 @@ namespace gpstk
       virtual EclipsedSatFilter& setPostShadowPeriod(const double pShTime);
 
 
+         /// Returns a pointer to the SatAttitudeStore object currently in use.
+      virtual SatAttitudeStore *getAttitudeStore(void) const
+      { return pAttitude; };
+
+
+         /** Sets SatAttitudeStore object to be used. The satellite attitude
+          *  and the Sun position are then taken from it, once per epoch,
+          *  instead of being computed for every station.
+          *
+          * @param attitude  SatAttitudeStore object.
+          */
+      virtual EclipsedSatFilter& setAttitudeStore(SatAttitudeStore& attitude)
+      { pAttitude = &attitude; return (*this); };
+
+
          /// Returns a string identifying this object.
       virtual std::string getClassName(void) const;
 
@@ -195,6 +212,9 @@ namespace gpstk
    private:
 
 
+         /// Pointer to SatAttitudeStore object, if available
+      SatAttitudeStore* pAttitude;
+
          /// Aperture angle of shadow cone, in degrees.
       double coneAngle;
 
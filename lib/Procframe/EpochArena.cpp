@@ -0,0 +1,262 @@
+#pragma ident "$Id$"
+
+/**
+ * @file EpochArena.cpp
+ * Monotonic memory arena for the GNSS data structures of an epoch, and
+ * the allocator drawing from it.
+ */
+
+//============================================================================
+//
+//  This file is part of GPSTk, the GPS Toolkit.
+//
+//  The GPSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 2.1 of the License, or
+//  any later version.
+//
+//  The GPSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GPSTk; if not, write to the Free Software Foundation,
+//  Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//============================================================================
+
+
+#include "EpochArena.hpp"
+
+using namespace std;
+
+
+namespace gpstk
+{
+
+      // Current arena of every thread
+    static EpochArena* currentArena = NULL;
+#ifdef USE_OPENMP
+#pragma omp threadprivate(currentArena)
+#endif
+
+      // Number of blocks allocated by every thread
+    static unsigned long numAllocated = 0;
+#ifdef USE_OPENMP
+#pragma omp threadprivate(numAllocated)
+#endif
+
+
+      // Common constructor.
+    EpochArena::EpochArena(size_t chunk)
+        : chunkSize(chunk < 1024 ? 1024 : chunk),
+          largeBytes(0), chunkIndex(0), next(NULL), end(NULL),
+          numLive(0), generation(0), retired(false)
+    {
+    }
+
+
+      // Destructor, freeing all the chunks.
+    EpochArena::~EpochArena()
+    {
+        for(size_t i = 0; i < chunks.size(); ++i)
+        {
+            ::operator delete(chunks[i]);
+        }
+
+        for(size_t i = 0; i < largeBlocks.size(); ++i)
+        {
+            ::operator delete(largeBlocks[i]);
+        }
+    }
+
+
+      // Get a block of memory of 'n' bytes, aligned to 16 bytes.
+    void* EpochArena::allocate(size_t n)
+    {
+        n = (n + 15) & ~size_t(15);
+
+        if(n > chunkSize/4)
+        {
+            char* p = static_cast<char*>( ::operator new(n) );
+            largeBlocks.push_back(p);
+            largeBytes += n;
+#ifdef USE_OPENMP
+    #pragma omp atomic
+#endif
+            ++numLive;
+            return p;
+        }
+
+        if(next == NULL || next + n > end)
+        {
+            // Next chunk, reused or new
+            if(next != NULL) ++chunkIndex;
+
+            if(chunkIndex == chunks.size())
+            {
+                chunks.push_back( static_cast<char*>(
+                                                ::operator new(chunkSize) ) );
+            }
+
+            next = chunks[chunkIndex];
+            end = next + chunkSize;
+        }
+
+        char* p = next;
+        next += n;
+#ifdef USE_OPENMP
+    #pragma omp atomic
+#endif
+        ++numLive;
+
+        return p;
+
+    }  // End of method 'EpochArena::allocate()'
+
+
+      // Make all the memory available again, if there are no live blocks.
+    bool EpochArena::reset()
+    {
+        size_t live;
+#ifdef USE_OPENMP
+    #pragma omp atomic read
+#endif
+        live = numLive;
+
+        if(live > 0) return false;
+
+        for(size_t i = 0; i < largeBlocks.size(); ++i)
+        {
+            ::operator delete(largeBlocks[i]);
+        }
+        largeBlocks.clear();
+        largeBytes = 0;
+
+        chunkIndex = 0;
+        next = NULL;
+        end = NULL;
+
+#ifdef USE_OPENMP
+    #pragma omp atomic
+#endif
+        ++generation;
+
+        return true;
+
+    }  // End of method 'EpochArena::reset()'
+
+
+      // Delete the arena now if there are no live blocks, or else when the
+      // last one is given back.
+    void EpochArena::retire()
+    {
+        // Hold a block while the arena is marked, and give it back as any
+        // other one: only the release() taking the count to zero, here or
+        // in another thread, sees 'retired' set and deletes the arena.
+#ifdef USE_OPENMP
+    #pragma omp atomic
+#endif
+        ++numLive;
+
+        retired = true;
+#ifdef USE_OPENMP
+    #pragma omp flush
+#endif
+
+        release();
+    }
+
+
+      // Bytes handed out since the last reset
+    size_t EpochArena::getUsed() const
+    {
+        if(next == NULL) return largeBytes;
+
+        return chunkIndex*chunkSize + (chunkSize - (end - next)) + largeBytes;
+    }
+
+
+      // Bytes of all the chunks
+    size_t EpochArena::getCapacity() const
+    {
+        return chunks.size()*chunkSize + largeBytes;
+    }
+
+
+      // Number of times the arena was reset
+    unsigned long EpochArena::getGeneration() const
+    {
+        unsigned long gen;
+#ifdef USE_OPENMP
+    #pragma omp atomic read
+#endif
+        gen = generation;
+
+        return gen;
+    }
+
+
+      // Get the current arena of this thread, or NULL if there is none.
+    EpochArena* EpochArena::current()
+    {
+        return currentArena;
+    }
+
+
+      // Get a block of 'n' bytes from an arena, or from the heap.
+    void* EpochArena::allocateBlock( EpochArena*& arena,
+                                     unsigned long generation,
+                                     size_t n )
+    {
+        ++numAllocated;
+
+        // An arena reset since it was taken may be used by another thread
+        // now, and the allocator has no blocks of it left
+        if(arena != NULL && arena->getGeneration() != generation)
+        {
+            arena = NULL;
+        }
+
+        if(arena != NULL)
+            return arena->allocate(n);
+        else
+            return ::operator new(n);
+    }
+
+
+      // Give back a block got with 'allocateBlock()' from 'arena'
+    void EpochArena::deallocateBlock(EpochArena* arena, void* p)
+    {
+        if(p == NULL) return;
+
+        if(arena != NULL)
+            arena->release();
+        else
+            ::operator delete(p);
+    }
+
+
+      // Number of blocks got with 'allocateBlock()' by this thread
+    unsigned long EpochArena::getNumAllocated()
+    {
+        return numAllocated;
+    }
+
+
+      // Make 'arena' the current arena of the thread.
+    EpochArena::Scope::Scope(EpochArena* arena)
+        : previous(currentArena)
+    {
+        currentArena = arena;
+    }
+
+
+      // Restore the previous current arena.
+    EpochArena::Scope::~Scope()
+    {
+        currentArena = previous;
+    }
+
+}  // End of namespace gpstk
@@ -0,0 +1,325 @@
+#pragma ident "$Id$"
+
+/**
+ * @file EpochArena.hpp
+ * Monotonic memory arena for the GNSS data structures of an epoch, and
+ * the allocator drawing from it.
+ */
+
+#ifndef GPSTK_EPOCHARENA_HPP
+#define GPSTK_EPOCHARENA_HPP
+
+//============================================================================
+//
+//  This file is part of GPSTk, the GPS Toolkit.
+//
+//  The GPSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 2.1 of the License, or
+//  any later version.
+//
+//  The GPSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GPSTk; if not, write to the Free Software Foundation,
+//  Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//============================================================================
+
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+
+namespace gpstk
+{
+
+    /// @ingroup DataStructures
+    //@{
+
+    /** This class is a monotonic memory arena: memory is handed out from
+     *  big chunks by bumping a pointer, and is given back all at once.
+     *
+     * It is meant for the GNSS data structures of an epoch, whose map
+     * nodes are all created while the epoch is read and processed, and all
+     * destroyed when the next epoch is read. Freeing a block does not give
+     * its memory back, it only decreases the count of live blocks. When
+     * the count is zero, 'reset()' makes the whole arena available again in
+     * O(1), keeping its chunks for the next epoch.
+     *
+     * The arena becomes the current one of the thread within the lifetime
+     * of an 'EpochArena::Scope' object. The default constructed
+     * 'EpochAllocator' objects, and so the GNSS data structures created
+     * there, take their memory from the current arena, or from the heap if
+     * there is none:
+     *
+     * @code
+     *    EpochArena arena;
+     *
+     *    while( ... )
+     *    {
+     *       gData.clear();
+     *       arena.reset();
+     *
+     *       EpochArena::Scope scope(&arena);
+     *       rin >> gRin;
+     *       ...
+     *    }
+     * @endcode
+     *
+     * An arena must outlive the data taken from it; otherwise it should be
+     * created with 'new' and deleted with 'retire()'. Only one thread at a
+     * time may take memory from it, so the data of stations processed in
+     * parallel should be in different arenas, but the blocks may be given
+     * back from any thread, e.g. after the data were handed to the next
+     * stage of an EpochPipeline.
+     */
+    class EpochArena
+    {
+    public:
+
+        /** Common constructor.
+         *
+         * @param chunk     Size of the chunks of memory, in bytes.
+         */
+        explicit EpochArena(size_t chunk = 256*1024);
+
+        /// Destructor, freeing all the chunks. There must be no live blocks.
+        ~EpochArena();
+
+
+        /// Get a block of memory of 'n' bytes, aligned to 16 bytes.
+        void* allocate(size_t n);
+
+        /// Give back a block. The memory is only reused after 'reset()'.
+        void release()
+        {
+            size_t left;
+#ifdef USE_OPENMP
+    #pragma omp atomic capture
+#endif
+            left = --numLive;
+
+            if(left != 0) return;
+
+            // 'retired' is set before retire() gives back its own block
+#ifdef USE_OPENMP
+    #pragma omp flush
+#endif
+            if(retired) delete this;
+        };
+
+        /** Make all the memory available again, if there are no live
+         *  blocks. The allocators still pointing to the arena, e.g. of
+         *  containers left empty, take their memory from the heap from then
+         *  on: the arena may be handed to another thread.
+         *
+         * @return  Whether the arena was reset.
+         */
+        bool reset();
+
+        /** Delete the arena now if there are no live blocks, or else when
+         *  the last one is given back. The arena must have been created
+         *  with 'new', and must not be used anymore.
+         */
+        void retire();
+
+
+        /// Number of blocks not given back yet
+        size_t getNumLive() const
+        { return numLive; };
+
+        /// Bytes handed out since the last reset
+        size_t getUsed() const;
+
+        /// Bytes of all the chunks
+        size_t getCapacity() const;
+
+        /// Number of times the arena was reset
+        unsigned long getGeneration() const;
+
+
+        /// Get the current arena of this thread, or NULL if there is none.
+        static EpochArena* current();
+
+        /** Get a block of 'n' bytes from an arena, or from the heap if
+         *  'arena' is NULL.
+         *
+         * @param arena      Arena, set to NULL if it was reset since
+         *                   'generation'.
+         * @param generation Generation of the arena when it was taken.
+         * @param n          Size of the block, in bytes.
+         */
+        static void* allocateBlock( EpochArena*& arena,
+                                    unsigned long generation,
+                                    size_t n );
+
+        /// Give back a block got with 'allocateBlock()' from 'arena'
+        static void deallocateBlock(EpochArena* arena, void* p);
+
+        /// Number of blocks got with 'allocateBlock()' by this thread,
+        /// from arenas or from the heap
+        static unsigned long getNumAllocated();
+
+
+        /// Object making an arena the current one of the thread during its
+        /// lifetime
+        class Scope
+        {
+        public:
+
+            /// Make 'arena' the current arena. NULL means the heap.
+            explicit Scope(EpochArena* arena);
+
+            /// Restore the previous current arena.
+            ~Scope();
+
+        private:
+
+            EpochArena* previous;
+
+            Scope(const Scope&);
+            Scope& operator=(const Scope&);
+        };
+
+
+    private:
+
+        /// Size of the chunks
+        size_t chunkSize;
+
+        /// Chunks of memory
+        std::vector<char*> chunks;
+
+        /// Blocks bigger than a chunk, freed when reset
+        std::vector<char*> largeBlocks;
+
+        /// Bytes in the large blocks
+        size_t largeBytes;
+
+        /// Chunk being used
+        size_t chunkIndex;
+
+        /// Next free byte, and end of the chunk being used
+        char* next;
+        char* end;
+
+        /// Number of live blocks
+        size_t numLive;
+
+        /// Number of resets
+        unsigned long generation;
+
+        /// Whether the arena deletes itself with the last block
+        bool retired;
+
+        EpochArena(const EpochArena&);
+        EpochArena& operator=(const EpochArena&);
+
+    }; // End of class 'EpochArena'
+
+
+
+    /** Allocator drawing from an 'EpochArena'.
+     *
+     * A default constructed allocator uses the current arena of the thread
+     * (see 'EpochArena::Scope'), or the heap if there is none; copies use
+     * the same arena. Heap blocks are plain '::operator new' ones. A block
+     * is given back to where the allocator takes its memory from, so two
+     * allocators compare equal only if they use the same arena, and
+     * swapping containers swaps their allocators.
+     *
+     * An arena is never reset while a block of it is alive. An allocator
+     * whose arena was reset since it was taken has no blocks left, and
+     * switches to the heap.
+     */
+    template <class T>
+    class EpochAllocator
+    {
+    public:
+
+        typedef size_t      size_type;
+        typedef ptrdiff_t   difference_type;
+        typedef T*          pointer;
+        typedef const T*    const_pointer;
+        typedef T&          reference;
+        typedef const T&    const_reference;
+        typedef T           value_type;
+
+        template <class U>
+        struct rebind { typedef EpochAllocator<U> other; };
+
+        EpochAllocator() throw()
+            : pArena(EpochArena::current()),
+              generation(pArena ? pArena->getGeneration() : 0)
+        {};
+
+        EpochAllocator(const EpochAllocator& right) throw()
+            : pArena(right.pArena), generation(right.generation)
+        {};
+
+        template <class U>
+        EpochAllocator(const EpochAllocator<U>& right) throw()
+            : pArena(right.getArena()), generation(right.getGeneration())
+        {};
+
+        ~EpochAllocator() throw() {};
+
+        pointer address(reference x) const
+        { return &x; };
+
+        const_pointer address(const_reference x) const
+        { return &x; };
+
+        pointer allocate(size_type n, const void* = 0)
+        { return static_cast<pointer>( EpochArena::allocateBlock(
+                                    pArena, generation, n*sizeof(T) ) ); };
+
+        void deallocate(pointer p, size_type)
+        { EpochArena::deallocateBlock(pArena, p); };
+
+        size_type max_size() const throw()
+        { return size_t(-1) / sizeof(T); };
+
+        void construct(pointer p, const T& val)
+        { new(static_cast<void*>(p)) T(val); };
+
+        void destroy(pointer p)
+        { p->~T(); };
+
+        /// Arena the memory is taken from, NULL for the heap
+        EpochArena* getArena() const
+        { return pArena; };
+
+        /// Generation of the arena when it was taken
+        unsigned long getGeneration() const
+        { return generation; };
+
+    private:
+
+        EpochArena* pArena;
+
+        unsigned long generation;
+
+    }; // End of class 'EpochAllocator'
+
+
+    template <class T, class U>
+    inline bool operator==( const EpochAllocator<T>& left,
+                            const EpochAllocator<U>& right )
+    { return (left.getArena() == right.getArena()); }
+
+    template <class T, class U>
+    inline bool operator!=( const EpochAllocator<T>& left,
+                            const EpochAllocator<U>& right )
+    { return (left.getArena() != right.getArena()); }
+
+    //@}
+
+}  // End of namespace gpstk
+
+#endif   // GPSTK_EPOCHARENA_HPP
@@ -0,0 +1,541 @@
+#pragma ident "$Id$"
+
+/**
+ * @file EpochPipeline.cpp
+ * Pipelined processing of the epochs of a gnssDataMap, with every stage
+ * in a thread of its own.
+ */
+
+//============================================================================
+//
+//  This file is part of GPSTk, the GPS Toolkit.
+//
+//  The GPSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 2.1 of the License, or
+//  any later version.
+//
+//  The GPSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GPSTk; if not, write to the Free Software Foundation,
+//  Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//============================================================================
+
+
+#include <iomanip>
+#include <sstream>
+#include "EpochPipeline.hpp"
+#include "Decimate.hpp"
+
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <windows.h>
+#else
+#include <sched.h>
+#include <time.h>
+#include <sys/time.h>
+#endif
+
+using namespace std;
+
+
+namespace gpstk
+{
+
+      // Wall time, in seconds
+    static double wallTime()
+    {
+#if defined(USE_OPENMP)
+        return omp_get_wtime();
+#elif defined(_MSC_VER)
+        return GetTickCount()/1000.0;
+#else
+        struct timeval tv;
+        gettimeofday(&tv, NULL);
+        return tv.tv_sec + tv.tv_usec*1.0e-6;
+#endif
+    }
+
+
+      // Give the processor to other threads
+    static void yieldThread()
+    {
+#if defined(_MSC_VER)
+        Sleep(0);
+#else
+        sched_yield();
+#endif
+    }
+
+
+      // Sleep for some seconds
+    static void sleepFor(double seconds)
+    {
+        if(seconds <= 0.0) return;
+
+#if defined(_MSC_VER)
+        Sleep( static_cast<DWORD>(seconds*1000.0) );
+#else
+        struct timespec ts;
+        ts.tv_sec = static_cast<time_t>(seconds);
+        ts.tv_nsec = static_cast<long>( (seconds - ts.tv_sec)*1.0e9 );
+        nanosleep(&ts, NULL);
+#endif
+    }
+
+
+      // Wait a little while polling a queue: spin first, then yield, and
+      // then sleep, so that an idle thread does not keep a processor busy
+    static void waitBriefly(int& spins)
+    {
+        if(++spins < 64) return;
+
+        if(spins < 128)
+        {
+            yieldThread();
+            return;
+        }
+
+        spins = 128;
+        sleepFor(1.0e-4);
+    }
+
+
+      // Count an exception of a stage
+    static void addError( EpochPipeline::StageStats& st,
+                          const std::string& msg )
+    {
+        if(st.numErrors == 0) st.firstError = msg;
+        ++st.numErrors;
+    }
+
+
+      // Add a time to a total and a maximum
+    static void addTime(double dt, double& total, double& maximum)
+    {
+        total += dt;
+        if(dt > maximum) maximum = dt;
+    }
+
+
+
+      // Read the data of the next epoch.
+    bool NetworkObsSource::readEpochData(gnssDataMap& gData)
+    {
+        if( !pStreams->readEpochData(gData) ) return false;
+
+        if( replayRate <= 0.0 || gData.empty() ) return true;
+
+        CommonTime epoch( gData.begin()->first );
+
+        if(!started)
+        {
+            started = true;
+            firstEpoch = epoch;
+            startTime = wallTime();
+            return true;
+        }
+
+        // Release the epoch at its time, at the replay rate
+        double release( startTime + (epoch - firstEpoch)/replayRate );
+        sleepFor( release - wallTime() );
+
+        return true;
+
+    }  // End of method 'NetworkObsSource::readEpochData()'
+
+
+
+      // Process the data of an epoch.
+    bool ProcessingStage::Process(gnssDataMap& gData)
+        throw(ProcessingException)
+    {
+        try
+        {
+            gData >> (*pProc);
+        }
+        catch(DecimateEpoch& d)
+        {
+            return false;
+        }
+        catch(SVNumException& s)
+        {
+            return false;
+        }
+        catch(Exception& u)
+        {
+            ProcessingException e( getClassName() + ":" + u.what() );
+            GPSTK_THROW(e);
+        }
+
+        return true;
+
+    }  // End of method 'ProcessingStage::Process()'
+
+
+
+      // Process all the epochs of the source.
+    unsigned long EpochPipeline::run()
+        throw(ProcessingException)
+    {
+        stats.assign( stages.size() + 1, StageStats() );
+        stats[0].name = pSource->getClassName();
+        for(size_t i = 0; i < stages.size(); ++i)
+        {
+            stats[i+1].name = stages[i]->getClassName();
+        }
+
+        numOutput = 0;
+        maxLatency = 0.0;
+        totalLatency = 0.0;
+
+        std::vector<Slot> slots(numSlots);
+
+        if( stages.empty() )
+        {
+            runSequential(slots);
+            checkErrors();
+            return numOutput;
+        }
+
+        // Queue 'i' goes into stage 'i', and the last one takes the free
+        // slots back to the source. None of them can be full.
+        std::vector< SPSCQueue<Slot*>* > queues( stages.size() + 1 );
+        for(size_t i = 0; i < queues.size(); ++i)
+        {
+            queues[i] = new SPSCQueue<Slot*>(numSlots);
+        }
+
+        for(size_t i = 0; i < numSlots; ++i)
+        {
+            queues.back()->push( &slots[i] );
+        }
+
+#ifdef USE_OPENMP
+        int numThreads( stages.size() + 1 );
+
+    #pragma omp parallel num_threads(numThreads)
+        {
+            if( omp_get_num_threads() < numThreads )
+            {
+                // Not enough threads: one of them does all the work
+                if( omp_get_thread_num() == 0 )
+                {
+                    runSequential(slots);
+                }
+            }
+            else if( omp_get_thread_num() == 0 )
+            {
+                runSource(queues);
+            }
+            else
+            {
+                runStage( omp_get_thread_num() - 1, queues );
+            }
+        }
+#else
+        runSequential(slots);
+#endif
+
+        for(size_t i = 0; i < queues.size(); ++i)
+        {
+            delete queues[i];
+        }
+
+        checkErrors();
+
+        return numOutput;
+
+    }  // End of method 'EpochPipeline::run()'
+
+
+
+      // Mean latency of the epochs not dropped
+    double EpochPipeline::getMeanLatency() const
+    {
+        return (numOutput > 0) ? totalLatency/numOutput : 0.0;
+
+    }  // End of method 'EpochPipeline::getMeanLatency()'
+
+
+
+      // Print the statistics of the last run
+    void EpochPipeline::dumpStats(std::ostream& s) const
+    {
+        s << setw(24) << left << "stage" << right
+          << setw(10) << "epochs" << setw(10) << "dropped"
+          << setw(12) << "mean(ms)" << setw(12) << "max(ms)"
+          << setw(12) << "wait(ms)" << setw(12) << "maxwait(ms)"
+          << setw(10) << "errors" << endl;
+
+        for(size_t i = 0; i < stats.size(); ++i)
+        {
+            const StageStats& st( stats[i] );
+            double n( (st.numEpochs > 0) ? st.numEpochs : 1.0 );
+
+            s << setw(24) << left << st.name << right
+              << setw(10) << st.numEpochs << setw(10) << st.numDropped
+              << fixed << setprecision(3)
+              << setw(12) << st.totalTime/n*1.0e3
+              << setw(12) << st.maxTime*1.0e3
+              << setw(12) << st.totalWait/n*1.0e3
+              << setw(12) << st.maxWait*1.0e3
+              << setw(10) << st.numErrors << endl;
+        }
+
+        s << "epochs out: " << numOutput
+          << fixed << setprecision(3)
+          << "  latency mean(ms): " << getMeanLatency()*1.0e3
+          << "  max(ms): " << maxLatency*1.0e3 << endl;
+
+    }  // End of method 'EpochPipeline::dumpStats()'
+
+
+
+      // Thread of the source
+    void EpochPipeline::runSource(std::vector< SPSCQueue<Slot*>* >& queues)
+    {
+        SPSCQueue<Slot*>& freeSlots( *queues.back() );
+        SPSCQueue<Slot*>& out( *queues.front() );
+
+        // Data of the epochs dropped in real-time mode
+        Slot overflow;
+
+        while(true)
+        {
+            Slot* slot(NULL);
+
+            double t0( wallTime() );
+
+            if( !freeSlots.pop(slot) )
+            {
+                if(realTime)
+                {
+                    // Keep reading, and drop the epoch
+                    if( !readSlot(overflow) ) break;
+
+                    if( !overflow.dropped ) ++stats[0].numDropped;
+                    continue;
+                }
+
+                int spins(0);
+                while( !freeSlots.pop(slot) ) waitBriefly(spins);
+            }
+
+            addTime( wallTime() - t0, stats[0].totalWait, stats[0].maxWait );
+
+            if( !readSlot(*slot) )
+            {
+                slot->last = true;
+                out.push(slot);
+                return;
+            }
+
+            out.push(slot);
+        }
+
+        // End of the input, in real-time mode with no free slot
+        Slot* slot(NULL);
+        int spins(0);
+        while( !freeSlots.pop(slot) ) waitBriefly(spins);
+
+        slot->last = true;
+        out.push(slot);
+
+    }  // End of method 'EpochPipeline::runSource()'
+
+
+
+      // Thread of a stage
+    void EpochPipeline::runStage( size_t i,
+                                  std::vector< SPSCQueue<Slot*>* >& queues )
+    {
+        SPSCQueue<Slot*>& in( *queues[i] );
+        SPSCQueue<Slot*>& out( *queues[i+1] );
+
+        while(true)
+        {
+            Slot* slot(NULL);
+
+            int spins(0);
+            while( !in.pop(slot) ) waitBriefly(spins);
+
+            if(slot->last)
+            {
+                out.push(slot);
+                return;
+            }
+
+            processSlot(i, *slot);
+
+            if( i + 1 == stages.size() ) finishSlot(*slot);
+
+            out.push(slot);
+        }
+
+    }  // End of method 'EpochPipeline::runStage()'
+
+
+
+      // All the steps of an epoch in turn, with no threads
+    void EpochPipeline::runSequential(std::vector<Slot>& slots)
+    {
+        Slot& slot( slots.front() );
+
+        while( readSlot(slot) )
+        {
+            for(size_t i = 0; i < stages.size(); ++i)
+            {
+                processSlot(i, slot);
+            }
+
+            finishSlot(slot);
+        }
+
+    }  // End of method 'EpochPipeline::runSequential()'
+
+
+
+      // Read an epoch into a slot. An epoch whose reading threw is
+      // dropped; false only at the end of the input.
+    bool EpochPipeline::readSlot(Slot& slot)
+    {
+        slot.last = false;
+        slot.dropped = false;
+
+        double t0( wallTime() );
+
+        bool valid(false);
+        bool failed(true);
+        try
+        {
+            valid = pSource->readEpochData(slot.gData);
+            failed = false;
+        }
+        catch(Exception& e)
+        {
+            addError(stats[0], e.getText());
+        }
+        catch(std::exception& e)
+        {
+            addError(stats[0], e.what());
+        }
+        catch(...)
+        {
+            addError(stats[0], "unknown exception");
+        }
+
+        double t1( wallTime() );
+
+        if( !failed && !valid ) return false;
+
+        addTime( t1 - t0, stats[0].totalTime, stats[0].maxTime );
+        ++stats[0].numEpochs;
+
+        if(failed)
+        {
+            slot.dropped = true;
+            ++stats[0].numDropped;
+        }
+
+        slot.readTime = t1;
+        slot.readyTime = t1;
+
+        return true;
+
+    }  // End of method 'EpochPipeline::readSlot()'
+
+
+
+      // Run a stage on a slot
+    void EpochPipeline::processSlot(size_t i, Slot& slot)
+    {
+        if(slot.dropped) return;
+
+        StageStats& st( stats[i+1] );
+
+        double t0( wallTime() );
+
+        bool valid(false);
+        try
+        {
+            valid = stages[i]->Process(slot.gData);
+        }
+        catch(Exception& e)
+        {
+            addError(st, e.getText());
+        }
+        catch(std::exception& e)
+        {
+            addError(st, e.what());
+        }
+        catch(...)
+        {
+            addError(st, "unknown exception");
+        }
+
+        double t1( wallTime() );
+
+        addTime( t0 - slot.readyTime, st.totalWait, st.maxWait );
+        addTime( t1 - t0, st.totalTime, st.maxTime );
+        ++st.numEpochs;
+
+        if(!valid)
+        {
+            slot.dropped = true;
+            ++st.numDropped;
+        }
+
+        slot.readyTime = t1;
+
+    }  // End of method 'EpochPipeline::processSlot()'
+
+
+
+      // Account for a slot out of the last stage
+    void EpochPipeline::finishSlot(Slot& slot)
+    {
+        if(slot.dropped) return;
+
+        ++numOutput;
+
+        addTime( slot.readyTime - slot.readTime, totalLatency, maxLatency );
+
+    }  // End of method 'EpochPipeline::finishSlot()'
+
+
+
+      // Throw if there was an exception in the last run
+    void EpochPipeline::checkErrors() const
+        throw(ProcessingException)
+    {
+        unsigned long numErrors(0);
+        const StageStats* first(NULL);
+
+        for(size_t i = 0; i < stats.size(); ++i)
+        {
+            numErrors += stats[i].numErrors;
+            if( first == NULL && stats[i].numErrors > 0 ) first = &stats[i];
+        }
+
+        if(first == NULL) return;
+
+        ostringstream ss;
+        ss << "EpochPipeline: " << numErrors << " exception(s); first one of '"
+           << first->name << "': " << first->firstError;
+
+        ProcessingException e( ss.str() );
+        GPSTK_THROW(e);
+
+    }  // End of method 'EpochPipeline::checkErrors()'
+
+
+}  // End of namespace gpstk
@@ -0,0 +1,425 @@
+#pragma ident "$Id$"
+
+/**
+ * @file EpochPipeline.hpp
+ * Pipelined processing of the epochs of a gnssDataMap, with every stage
+ * in a thread of its own.
+ */
+
+#ifndef GPSTK_EPOCHPIPELINE_HPP
+#define GPSTK_EPOCHPIPELINE_HPP
+
+//============================================================================
+//
+//  This file is part of GPSTk, the GPS Toolkit.
+//
+//  The GPSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 2.1 of the License, or
+//  any later version.
+//
+//  The GPSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GPSTk; if not, write to the Free Software Foundation,
+//  Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//============================================================================
+
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include "DataStructures.hpp"
+#include "ProcessingClass.hpp"
+#include "NetworkObsStreams.hpp"
+#include "SPSCQueue.hpp"
+
+
+namespace gpstk
+{
+
+    /// @ingroup DataStructures
+    //@{
+
+    /// Source of the epochs of an EpochPipeline
+    class EpochSource
+    {
+    public:
+
+        /** Read the data of the next epoch.
+         *
+         * @param gData     Object to hold the data. It may hold the data of
+         *                  an older epoch, to be cleared.
+         *
+         * @return  Whether there was data; false at the end of the input.
+         */
+        virtual bool readEpochData(gnssDataMap& gData) = 0;
+
+        /// Returns a string identifying this object.
+        virtual std::string getClassName(void) const = 0;
+
+        /// Destructor
+        virtual ~EpochSource() {};
+
+    }; // End of class 'EpochSource'
+
+
+
+    /// Stage of an EpochPipeline
+    class EpochStage
+    {
+    public:
+
+        /** Process the data of an epoch.
+         *
+         * @param gData     Data of the epoch.
+         *
+         * @return  Whether the epoch goes on to the next stages. When it
+         *          does not, those stages skip it.
+         */
+        virtual bool Process(gnssDataMap& gData) = 0;
+
+        /// Returns a string identifying this object.
+        virtual std::string getClassName(void) const = 0;
+
+        /// Destructor
+        virtual ~EpochStage() {};
+
+    }; // End of class 'EpochStage'
+
+
+
+    /** This class reads the epochs of a NetworkObsStreams object for an
+     *  EpochPipeline.
+     *
+     * The epochs may be released at a given pace with respect to their
+     * time tags, to replay RINEX files as a real-time stream: a rate of 1
+     * releases them in real time, a rate of 10 ten times faster, and a rate
+     * of 0 (the default) as fast as they can be read.
+     */
+    class NetworkObsSource : public EpochSource
+    {
+    public:
+
+        /** Common constructor.
+         *
+         * @param streams   Observation streams of the network.
+         * @param rate      Replay rate, with respect to real time, or 0.
+         */
+        NetworkObsSource(NetworkObsStreams& streams, double rate = 0.0)
+            : pStreams(&streams), replayRate(rate), started(false),
+              startTime(0.0)
+        {};
+
+        /// Set the replay rate, with respect to real time, or 0.
+        NetworkObsSource& setReplayRate(double rate)
+        { replayRate = rate; return (*this); };
+
+        /// Get the replay rate
+        double getReplayRate() const
+        { return replayRate; };
+
+        /// Read the data of the next epoch.
+        virtual bool readEpochData(gnssDataMap& gData);
+
+        /// Returns a string identifying this object.
+        virtual std::string getClassName(void) const
+        { return "NetworkObsSource"; };
+
+        /// Destructor
+        virtual ~NetworkObsSource() {};
+
+    private:
+
+        /// Observation streams
+        NetworkObsStreams* pStreams;
+
+        /// Replay rate
+        double replayRate;
+
+        /// First epoch, and wall time when it was read
+        bool started;
+        CommonTime firstEpoch;
+        double startTime;
+
+    }; // End of class 'NetworkObsSource'
+
+
+
+    /** This class makes a stage out of a processing object, such as a
+     *  ProcessingList. Epochs that are decimated (DecimateEpoch) or have too
+     *  few satellites (SVNumException) are dropped; any other exception is
+     *  passed on to the pipeline.
+     */
+    class ProcessingStage : public EpochStage
+    {
+    public:
+
+        /** Common constructor.
+         *
+         * @param proc      Processing object.
+         * @param name      Name of the stage, or empty for the class name
+         *                  of the processing object.
+         */
+        ProcessingStage(ProcessingClass& proc, const std::string& name = "")
+            : pProc(&proc), stageName(name)
+        {};
+
+        /// Process the data of an epoch.
+        virtual bool Process(gnssDataMap& gData)
+            throw(ProcessingException);
+
+        /// Returns a string identifying this object.
+        virtual std::string getClassName(void) const
+        { return stageName.empty() ? pProc->getClassName() : stageName; };
+
+        /// Destructor
+        virtual ~ProcessingStage() {};
+
+    private:
+
+        ProcessingClass* pProc;
+        std::string stageName;
+
+    }; // End of class 'ProcessingStage'
+
+
+
+    /** This class runs the processing of a network epoch by epoch as a
+     *  pipeline: the source (reading and synchronization) and every stage
+     *  (e.g. preprocessing, filter and output) work at the same time on
+     *  different epochs, each one in a thread of its own.
+     *
+     * The epochs flow through a fixed pool of slots, each one holding a
+     * gnssDataMap, that are handed from a thread to the next one with
+     * lock-free single producer, single consumer queues (SPSCQueue), and
+     * given back to the source after the last stage. The slots are reused,
+     * so the maps and their arenas are not created again for every epoch.
+     * The epochs keep their order through all the stages.
+     *
+     * The number of slots bounds the epochs in flight: when all of them
+     * are taken, the source waits for the last stage (back-pressure). In
+     * real-time mode, it drops the epoch instead, so that reading never
+     * stops; the stages never wait for a later one, since no queue can
+     * be full.
+     *
+     * A typical way to use this class follows:
+     *
+     * @code
+     *   NetworkObsStreams obsStreams;
+     *   ...
+     *   ProcessingList preprocessing;
+     *   preprocessing.push_back(requireObs);
+     *   preprocessing.push_back(basicModel);
+     *   ...
+     *
+     *   NetworkObsSource source(obsStreams, 10.0);   // replay 10x
+     *   ProcessingStage preStage(preprocessing, "preprocessing");
+     *   MyFilterStage filterStage;                   // derived from EpochStage
+     *   MyOutputStage outputStage;
+     *
+     *   EpochPipeline pipeline(source);
+     *   pipeline.addStage(preStage);
+     *   pipeline.addStage(filterStage);
+     *   pipeline.addStage(outputStage);
+     *   pipeline.setRealTime(true);
+     *
+     *   pipeline.run();
+     *   pipeline.dumpStats(std::cerr);
+     * @endcode
+     *
+     * The stages run in parallel only when the library is built with
+     * OpenMP; otherwise every epoch goes through all of them in turn. The
+     * OpenMP loops within a stage run in the thread of the stage unless
+     * nested parallelism is enabled. Every stage should use its own
+     * processing objects.
+     *
+     * An exception thrown by a stage (or by the source) drops the epoch,
+     * and the pipeline goes on with the next ones. They are counted in the
+     * statistics, and run() throws a ProcessingException at the end if
+     * there was any.
+     */
+    class EpochPipeline
+    {
+    public:
+
+        /// Statistics of a stage, or of the source
+        struct StageStats
+        {
+            StageStats()
+                : numEpochs(0), numDropped(0), numErrors(0), totalTime(0.0),
+                  maxTime(0.0), totalWait(0.0), maxWait(0.0)
+            {};
+
+            /// Name of the stage
+            std::string name;
+
+            /// Epochs processed, and dropped there
+            unsigned long numEpochs;
+            unsigned long numDropped;
+
+            /// Exceptions thrown there (their epochs are dropped), and the
+            /// message of the first one
+            unsigned long numErrors;
+            std::string firstError;
+
+            /// Processing time (seconds), total and maximum
+            double totalTime;
+            double maxTime;
+
+            /// Time since the end of the previous stage (seconds), total
+            /// and maximum
+            double totalWait;
+            double maxWait;
+        };
+
+
+        /** Common constructor.
+         *
+         * @param source    Source of the epochs.
+         * @param numSlots  Number of epochs in flight.
+         */
+        EpochPipeline(EpochSource& source, size_t numSlots = 8)
+            : pSource(&source), numSlots(numSlots < 2 ? 2 : numSlots),
+              realTime(false), numOutput(0), maxLatency(0.0),
+              totalLatency(0.0)
+        {};
+
+
+        /// Add a stage at the end of the pipeline.
+        EpochPipeline& addStage(EpochStage& stage)
+        { stages.push_back(&stage); return (*this); };
+
+
+        /// Set whether the source drops epochs instead of waiting for a
+        /// free slot. By default, it is set to false.
+        EpochPipeline& setRealTime(bool rt)
+        { realTime = rt; return (*this); };
+
+        /// Get whether the pipeline runs in real-time mode
+        bool getRealTime() const
+        { return realTime; };
+
+
+        /// Set the number of epochs in flight
+        EpochPipeline& setNumSlots(size_t num)
+        { numSlots = (num < 2) ? 2 : num; return (*this); };
+
+        /// Get the number of epochs in flight
+        size_t getNumSlots() const
+        { return numSlots; };
+
+
+        /** Process all the epochs of the source.
+         *
+         * @return  Number of epochs out of the last stage, not dropped.
+         *
+         * @throw ProcessingException  At the end, if the source or a stage
+         *                             threw an exception. The statistics
+         *                             are still available.
+         */
+        unsigned long run()
+            throw(ProcessingException);
+
+
+        /** Get the statistics of the last run: the source first, and then
+         *  the stages in order.
+         */
+        const std::vector<StageStats>& getStats() const
+        { return stats; };
+
+        /// Mean latency, from the end of reading to the end of the last
+        /// stage, of the epochs not dropped (seconds)
+        double getMeanLatency() const;
+
+        /// Maximum latency (seconds)
+        double getMaxLatency() const
+        { return maxLatency; };
+
+        /// Print the statistics of the last run
+        void dumpStats(std::ostream& s) const;
+
+
+        /// Destructor
+        virtual ~EpochPipeline() {};
+
+
+    private:
+
+        /// Epoch in flight
+        struct Slot
+        {
+            Slot()
+                : last(false), dropped(false), readyTime(0.0), readTime(0.0)
+            {};
+
+            gnssDataMap gData;
+
+            /// Marks the end of the input
+            bool last;
+
+            /// Whether a stage dropped the epoch
+            bool dropped;
+
+            /// Wall time at the end of the last step
+            double readyTime;
+
+            /// Wall time at the end of reading
+            double readTime;
+        };
+
+
+        /// Thread of the source
+        void runSource(std::vector< SPSCQueue<Slot*>* >& queues);
+
+        /// Thread of a stage
+        void runStage( size_t i,
+                       std::vector< SPSCQueue<Slot*>* >& queues );
+
+        /// All the steps of an epoch in turn, with no threads
+        void runSequential(std::vector<Slot>& slots);
+
+        /// Read an epoch into a slot; false at the end of the input. An
+        /// epoch whose reading threw is dropped.
+        bool readSlot(Slot& slot);
+
+        /// Run a stage on a slot
+        void processSlot(size_t i, Slot& slot);
+
+        /// Account for a slot out of the last stage
+        void finishSlot(Slot& slot);
+
+        /// Throw if there was an exception in the last run
+        void checkErrors() const
+            throw(ProcessingException);
+
+
+        /// Source of the epochs
+        EpochSource* pSource;
+
+        /// Stages
+        std::vector<EpochStage*> stages;
+
+        /// Number of slots
+        size_t numSlots;
+
+        /// Whether the source drops epochs instead of waiting
+        bool realTime;
+
+        /// Statistics
+        std::vector<StageStats> stats;
+        unsigned long numOutput;
+        double maxLatency;
+        double totalLatency;
+
+    }; // End of class 'EpochPipeline'
+
+    //@}
+
+}  // End of namespace gpstk
+
+#endif   // GPSTK_EPOCHPIPELINE_HPP
@@ -94,6 +94,9 @@ namespace gpstk
             sourceEqnIter->second.push_back(equation);
         }
 
+        // The equations of the previous epoch must be rebuilt
+        m_EquationIndex.clear();
+
         return (*this);
 
     }  // End of method 'EquationSystemEx::addEquation2Source(...)'
@@ -104,6 +107,8 @@ namespace gpstk
     {
         m_SourceEquationMap.clear();
 
+        m_EquationIndex.clear();
+
         m_IsPrepared = false;
 
         return (*this);
@@ -145,7 +150,14 @@ namespace gpstk
         VariableSet tempOldUnknowns( m_pStateStore->getVariableSet() );
 
         // Prepare set of current unknowns and list of current equations
-        prepareUnknownsAndEquations(gdsMap);
+        if( m_Incremental )
+        {
+            updateUnknownsAndEquations(gdsMap);
+        }
+        else
+        {
+            prepareUnknownsAndEquations(gdsMap);
+        }
 
         // Set up index for Variables now
         setUpEquationIndex( tempOldUnknowns );
@@ -286,6 +298,35 @@ namespace gpstk
     /// Setup Equation Index.
     void EquationSystemEx::setUpEquationIndex( VariableSet& oldVariableSet )
     {
+        // The indexes are looked up by Variable ID. The variables are
+        // interned before the tables are sized.
+        VariableSet::const_iterator preIter;
+
+        for( preIter = oldVariableSet.begin();
+             preIter != oldVariableSet.end();
+             ++preIter )
+        {
+            (*preIter).getID();
+        }
+
+        for( preIter = m_CurrentUnknowns.begin();
+             preIter != m_CurrentUnknowns.end();
+             ++preIter )
+        {
+            (*preIter).getID();
+        }
+
+        const int numIDs( Variable::getNumIDs() );
+        m_PreIndexOfID.assign( numIDs, -1 );
+        m_NowIndexOfID.assign( numIDs, -1 );
+
+        for( preIter = oldVariableSet.begin();
+             preIter != oldVariableSet.end();
+             ++preIter )
+        {
+            m_PreIndexOfID[ (*preIter).getID() ] = (*preIter).getNowIndex();
+        }
+
         /// Setup Variable index in m_CurrentUnknowns
         int now_index  = 0;
 
@@ -296,15 +337,16 @@ namespace gpstk
 
             Variable& nowVar = (Variable&)(*nowIter);
 
+            int id( nowVar.getID() );
+
             // set current index
+            m_NowIndexOfID[id] = now_index;
             nowVar.setNowIndex( now_index++ );
 
-            // set previous index
-            VariableSet::iterator preIter = oldVariableSet.find( *nowIter );
-            if( oldVariableSet.end() != preIter)
-            {
-                nowVar.setPreIndex( (*preIter).getNowIndex() );
-            }
+            // set previous index, -1 if the variable is not in the state
+            // store: in incremental mode, 'nowVar' may keep the index of
+            // an older epoch
+            nowVar.setPreIndex( m_PreIndexOfID[id] );
         }
 
         // Setup Variable index in m_CurrentEquationsList
@@ -320,11 +362,11 @@ namespace gpstk
 
                 Variable& var = (Variable&)(*varIter);
 
-                VariableSet::iterator it = m_CurrentUnknowns.find( varIter->first );
-                if( it != m_CurrentUnknowns.end() )
+                int id( var.getID() );
+                if( id < numIDs && -1 != m_NowIndexOfID[id] )
                 {
-                    var.setPreIndex( (*it).getPreIndex() );
-                    var.setNowIndex( (*it).getNowIndex() );
+                    var.setPreIndex( m_PreIndexOfID[id] );
+                    var.setNowIndex( m_NowIndexOfID[id] );
                 }
             }
         }
@@ -475,6 +517,17 @@ namespace gpstk
         } // End of 'gnssDataMap::const_iterator gdmIter = ...'
 
 
+        addSatClockEquation( satClkVarSet, satClockMap );
+
+    }  // End of method 'EquationSystemEx::prepareUnknownsAndEquations()'
+
+
+
+    // Add the equation of the sum of satellite clocks
+    void EquationSystemEx::addSatClockEquation(
+                                 const VariableSet& satClkVarSet,
+                                 const std::map<SatID, double>& satClockMap )
+    {
         Variable satCS(TypeID::cdtSatSum);
         typeValueMap typeValueData;
 
@@ -484,12 +537,12 @@ namespace gpstk
 
         double sum(0.0);
 
-        for(VariableSet::iterator varIt = satClkVarSet.begin();
+        for(VariableSet::const_iterator varIt = satClkVarSet.begin();
             varIt != satClkVarSet.end();
             ++varIt)
         {
             SatID sat( varIt->getSatellite() );
-            map<SatID,double>::iterator scmIt( satClockMap.find(sat) );
+            map<SatID,double>::const_iterator scmIt( satClockMap.find(sat) );
 
             if( scmIt != satClockMap.end() )
             {
@@ -504,7 +557,213 @@ namespace gpstk
 
         m_CurrentEquationsList.push_back( equation );
 
-}  // End of method 'EquationSystemEx::prepareUnknownsAndEquations()'
+    }  // End of method 'EquationSystemEx::addSatClockEquation()'
+
+
+
+    // Set whether the equations and unknowns of the previous epoch are
+    // updated instead of being rebuilt.
+    EquationSystemEx& EquationSystemEx::setIncremental(bool incremental)
+    {
+        m_Incremental = incremental;
+
+        m_EquationIndex.clear();
+
+        return (*this);
+
+    }  // End of method 'EquationSystemEx::setIncremental()'
+
+
+
+    // Add the variables of an equation to the current unknowns
+    void EquationSystemEx::addUnknowns( const Equation& equation )
+    {
+        for( VarCoeffMap::const_iterator vcmIter = equation.body.begin();
+             vcmIter != equation.body.end();
+             ++vcmIter )
+        {
+            int id( vcmIter->first.getID() );
+
+            if( id >= int(m_UnknownRefs.size()) )
+            {
+                m_UnknownRefs.resize( Variable::getNumIDs(), 0 );
+            }
+
+            if( 0 == m_UnknownRefs[id]++ )
+            {
+                m_CurrentUnknowns.insert( vcmIter->first );
+            }
+        }
+
+    }  // End of method 'EquationSystemEx::addUnknowns()'
+
+
+
+    // Remove the variables of an equation from the current unknowns
+    void EquationSystemEx::removeUnknowns( const Equation& equation )
+    {
+        for( VarCoeffMap::const_iterator vcmIter = equation.body.begin();
+             vcmIter != equation.body.end();
+             ++vcmIter )
+        {
+            int id( vcmIter->first.getID() );
+
+            if( 0 == --m_UnknownRefs[id] )
+            {
+                m_CurrentUnknowns.erase( vcmIter->first );
+            }
+        }
+
+    }  // End of method 'EquationSystemEx::removeUnknowns()'
+
+
+
+    // Update set of current unknowns and list of current equations from
+    // those of the previous epoch
+    void EquationSystemEx::updateUnknownsAndEquations( gnssDataMap& gdsMap )
+    {
+        // Without previous structure, start from scratch
+        if( m_EquationIndex.empty() )
+        {
+            m_CurrentUnknowns.clear();
+            m_CurrentEquationsList.clear();
+            m_UnknownRefs.clear();
+        }
+
+        TypeID satClock(TypeID::cdtSat);
+        map<SatID, double> satClockMap;
+
+        VariableSet satClkVarSet;
+
+        // The equations still present are moved to the new list in the
+        // order of the data, as 'prepareUnknownsAndEquations()' does
+        EquationList newEquationsList;
+        std::map<EquationKey, EquationList::iterator> newEquationIndex;
+
+        int epochIndex(0);
+        for( gnssDataMap::const_iterator it = gdsMap.begin();
+             it != gdsMap.end();
+             ++it, ++epochIndex )
+        {
+            for( sourceDataMap::const_iterator sdmIter = (*it).second.begin();
+                 sdmIter != (*it).second.end();
+                 ++sdmIter )
+            {
+                SourceEquationMap::iterator sourceEqnIter
+                                            = m_SourceEquationMap.find( sdmIter->first );
+
+                if( m_SourceEquationMap.end() == sourceEqnIter ) continue;
+
+                for( satTypeValueMap::const_iterator stvmIter = sdmIter->second.begin();
+                     stvmIter != sdmIter->second.end();
+                     ++stvmIter )
+                {
+                    if(stvmIter->second.find(satClock) != stvmIter->second.end())
+                    {
+                        satClockMap[stvmIter->first] = stvmIter->second.getValue(satClock);
+                    }
+
+                    int eqIndex(0);
+                    for( EquationList::iterator equIter = sourceEqnIter->second.begin();
+                         equIter != sourceEqnIter->second.end();
+                         ++equIter, ++eqIndex )
+                    {
+                        TypeID indType( (*equIter).header.indTerm.getType() );
+
+                        typeValueMap::const_iterator tvmIter
+                                            = stvmIter->second.find( indType );
+
+                        if( stvmIter->second.end() == tvmIter ) continue;
+
+                        EquationKey key( epochIndex, sdmIter->first,
+                                         stvmIter->first, eqIndex );
+
+                        std::map<EquationKey, EquationList::iterator>::iterator
+                            idxIter( m_EquationIndex.find(key) );
+
+                        if( idxIter != m_EquationIndex.end() )
+                        {
+                            // Reuse the equation, only its data change
+                            newEquationsList.splice( newEquationsList.end(),
+                                                     m_CurrentEquationsList,
+                                                     idxIter->second );
+                            m_EquationIndex.erase( idxIter );
+                        }
+                        else
+                        {
+                            // New equation, as in 'prepareUnknownsAndEquations()'
+                            Equation equation( *equIter );
+
+                            equation.header.equationSource = sdmIter->first;
+                            equation.header.equationSat = stvmIter->first;
+                            equation.clear();
+
+                            for( VarCoeffMap::const_iterator vcmIter = (*equIter).body.begin();
+                                 vcmIter != (*equIter).body.end();
+                                 ++vcmIter )
+                            {
+                                Variable var( vcmIter->first );
+                                Coefficient coef( vcmIter->second );
+
+                                if( var.getSourceIndexed() )
+                                {
+                                    var.setSource( sdmIter->first );
+                                }
+
+                                if( var.getSatIndexed() )
+                                {
+                                    var.setSatellite( stvmIter->first );
+                                }
+
+                                equation.addVariable( var, coef );
+                            }
+
+                            addUnknowns( equation );
+
+                            newEquationsList.push_back( equation );
+                        }
+
+                        EquationList::iterator eqIter( --newEquationsList.end() );
+
+                        // set the type value data
+                        (*eqIter).header.typeValueData = stvmIter->second;
+
+                        newEquationIndex.insert( std::make_pair(key, eqIter) );
+
+                        for( VarCoeffMap::const_iterator vcmIter = (*eqIter).body.begin();
+                             vcmIter != (*eqIter).body.end();
+                             ++vcmIter )
+                        {
+                            if( vcmIter->first.getType() == TypeID::dcdtSat )
+                            {
+                                satClkVarSet.insert( vcmIter->first );
+                            }
+                        }
+
+                    } // End of 'EquationList::iterator equIter = ...'
+
+                } // End of 'satTypeValueMap::const_iterator stvmIter = ...'
+
+            } // End of 'SourceDataMap::const_iterator sdmIter = ...'
+
+        } // End of 'gnssDataMap::const_iterator gdmIter = ...'
+
+
+        // The equations left are those of setting satellites
+        for( std::map<EquationKey, EquationList::iterator>::iterator
+                idxIter = m_EquationIndex.begin();
+             idxIter != m_EquationIndex.end();
+             ++idxIter )
+        {
+            removeUnknowns( *(idxIter->second) );
+        }
+
+        m_CurrentEquationsList.swap( newEquationsList );
+        m_EquationIndex.swap( newEquationIndex );
+
+        addSatClockEquation( satClkVarSet, satClockMap );
+
+    }  // End of method 'EquationSystemEx::updateUnknownsAndEquations()'
 
 
 }  // End of namespace gpstk
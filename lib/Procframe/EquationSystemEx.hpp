@@ -172,6 +172,14 @@ namespace gpstk
      * you should balance the importance of machine time (extra overhead)
      * versus researcher time (writing a new solver).
      *
+     * In incremental mode (see 'setIncremental()'), the equations and
+     * unknowns of the previous epoch are kept, and only those of the
+     * (source, satellite, equation) combinations that appear or disappear
+     * are added or removed. Between consecutive epochs most of the
+     * structure is unchanged, so the equations are neither copied nor
+     * rebuilt, and their order, hence the sparsity pattern of the design
+     * matrix, stays the same.
+     *
      * @sa Variable.hpp, Equation.hpp.
      *
      */
@@ -181,7 +189,7 @@ namespace gpstk
 
         /// Default constructor
         EquationSystemEx()
-            : m_IsPrepared(false)
+            : m_IsPrepared(false), m_Incremental(false)
         {};
 
 
@@ -291,6 +299,19 @@ namespace gpstk
         void setUpEquationIndex(VariableSet& oldVariableSet);
 
 
+        /** Set whether the equations and unknowns of the previous epoch
+         *  are updated instead of being rebuilt.
+         *
+         * @param incremental   Whether to use incremental mode.
+         */
+        EquationSystemEx& setIncremental(bool incremental);
+
+
+        /// Get whether incremental mode is used.
+        bool getIncremental() const
+        { return m_Incremental; };
+
+
         /// Set state store reference object.
         EquationSystemEx& setStateStore( StateStore& stateStore )
         { m_pStateStore = &stateStore; return (*this); }
@@ -328,6 +349,52 @@ namespace gpstk
         /// Pointer to object of StateStore
         StateStore* m_pStateStore;
 
+
+        /// Previous index of every Variable ID, -1 if none
+        std::vector<int> m_PreIndexOfID;
+
+        /// Current index of every Variable ID, -1 if none
+        std::vector<int> m_NowIndexOfID;
+
+
+        /// Whether incremental mode is used
+        bool m_Incremental;
+
+
+        /// Identifies an equation: position of the epoch in the
+        /// gnssDataMap, source, satellite and index of its description in
+        /// the list of the source.
+        struct EquationKey
+        {
+            EquationKey( int epoch,
+                         const SourceID& source,
+                         const SatID& sat,
+                         int index )
+                : eqEpoch(epoch), eqSource(source), eqSat(sat), eqIndex(index)
+            {};
+
+            bool operator<(const EquationKey& right) const
+            {
+                if( eqEpoch != right.eqEpoch ) return eqEpoch < right.eqEpoch;
+                if( eqIndex != right.eqIndex ) return eqIndex < right.eqIndex;
+                if( eqSat != right.eqSat ) return eqSat < right.eqSat;
+                return eqSource < right.eqSource;
+            };
+
+            int eqEpoch;
+            SourceID eqSource;
+            SatID eqSat;
+            int eqIndex;
+        };
+
+
+        /// Equations of the previous epoch, in incremental mode
+        std::map<EquationKey, EquationList::iterator> m_EquationIndex;
+
+
+        /// Number of current equations using every Variable ID
+        std::vector<int> m_UnknownRefs;
+
         /// General white noise stochastic model
         static WhiteNoiseModel2 whiteNoiseModel;
 
@@ -337,6 +404,24 @@ namespace gpstk
         /// Prepare set of current unknowns and list of current equations
         void prepareUnknownsAndEquations( gnssDataMap& gdsMap );
 
+
+        /// Update set of current unknowns and list of current equations
+        /// from those of the previous epoch
+        void updateUnknownsAndEquations( gnssDataMap& gdsMap );
+
+
+        /// Add the variables of an equation to the current unknowns
+        void addUnknowns( const Equation& equation );
+
+
+        /// Remove the variables of an equation from the current unknowns
+        void removeUnknowns( const Equation& equation );
+
+
+        /// Add the equation of the sum of satellite clocks
+        void addSatClockEquation( const VariableSet& satClkVarSet,
+                                  const std::map<SatID, double>& satClockMap );
+
     }; // End of class 'EquationSystemEx'
 
     //@}
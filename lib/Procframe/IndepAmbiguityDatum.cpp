@@ -100,8 +100,8 @@ namespace gpstk
          // Store the independent ambiguity unknowns of the previous epoch
       oldIndepEdges = currentIndepEdges;
 
-         // Prepare set of current unknowns and list of current constraints
-      currentEdges = prepareCurrentEdges(gdsMap);
+         // Give the edges of this epoch to the spanning forest
+      prepareCurrentEdges(gdsMap);
 
          // Prepare set of current unknowns and list of current constraints
       currentIndepEdges = prepareCurrentIndepEdges();
@@ -115,15 +115,12 @@ namespace gpstk
 
 
 
-      // Prepare set of current unknowns and list of current constraints
-   EdgeSet IndepAmbiguityDatum::prepareCurrentEdges( gnssDataMap& gdsMap )
+      // Give the edges of this epoch to the spanning forest
+   void IndepAmbiguityDatum::prepareCurrentEdges( gnssDataMap& gdsMap )
    {
 
-         // Let's create current edge set
-      EdgeSet currentEdgeSet;
-
-         // The ambiguity fixing method
-      ARRound ambRes;
+         // Start a new epoch of the spanning forest
+      forest.beginEpoch();
 
          // Iterate through all items in the gnssDataMap
       for( gnssDataMap::const_iterator it = gdsMap.begin();
@@ -163,8 +160,8 @@ namespace gpstk
                   // Create a new edge
                Edge edge( (*sdmIter).first, (*stvmIter).first, satArc, weight, elev );
 
-                  // New constraint is complete: Add it to 'currentEdgeSet'
-               currentEdgeSet.insert( edge );
+                  // Only the arcs that started or ended change the forest
+               forest.addEdge( edge );
 
             }  // End of 'for( satTypeValueMap::const_iterator stvmIter = ...'
 
@@ -172,8 +169,8 @@ namespace gpstk
 
       }  // End of 'for( gnssDataMap::const_iterator it = ...'
 
-         // Return set of current edges
-      return currentEdgeSet;
+         // Remove the arcs that ended and update the forest
+      forest.endEpoch();
 
    }  // End of method 'IndepAmbiguityDatum::prepareCurrentEdges()'
 
@@ -185,41 +182,10 @@ namespace gpstk
          // Current independent edge set
       EdgeSet currentIndepEdgeSet;
 
-         // Continuous independent edges
-      EdgeSet continuousIndepEdges;
-
-         // Find the edge of the oldIndepEdges in currentEdges
-///   for( EdgeSet::const_iterator it1 = oldIndepEdges.begin();
-///        it1 != oldIndepEdges.end();
-///        ++it1 )
-///   {
-///         // Arc information of the previous edge
-///      Arc oldArc( (*it1) );
-
-///         // Current edge information
-///      for( EdgeSet::const_iterator it2 = currentEdges.begin();
-///           it2 != currentEdges.end();
-///           ++it2)
-///      {
-///            // Arc information of current edge
-///         Arc newArc( (*it2) );
-
-///            // Add the old independent edge into the 'continuousIndepEdges'
-///         if( newArc == oldArc)
-///         {
-///            continuousIndepEdges.insert( (*it2) );
-///         }
-///      }
-///   }
-
-         // Class of the Kruskal algorithm, which will generate independent edges
-      Kruskal kruskal(currentEdges);
-
-         // Set initial independent edges
-      kruskal.setInitialEdges(continuousIndepEdges);
-
-         // Create the Minimum Spanning Tree from the 'currentEdges'
-      currentIndepEdgeSet = kruskal.createMST();
+         // The forest keeps the independent edges of the previous epoch
+         // that are still observed, and only chooses new ones where arcs
+         // started or ended.
+      currentIndepEdgeSet = forest.getTreeEdges();
 
          /**
           * Now, Let's fix the independent ambiguities into integers
@@ -49,6 +49,7 @@
 #include "Arc.hpp"
 #include "Edge.hpp"
 #include "Kruskal.hpp"
+#include "SpanningForest.hpp"
 #include "ARRound.hpp"
 
 namespace gpstk
@@ -255,6 +256,21 @@ namespace gpstk
          ambVarMap = apriCovMap;
       };
 
+         /** Set the order in which new or replacement independent
+          *  ambiguities are chosen.
+          *
+          * @param type    Order of the candidate edges.
+          */
+      virtual IndepAmbiguityDatum& setWeightType(
+                                       SpanningForest::WeightType type )
+      { forest.setWeightType(type); return (*this); };
+
+
+         /// Forget the independent ambiguities of the previous epochs
+      virtual void resetDatum()
+      { forest.reset(); currentIndepEdges.clear(); };
+
+
          /** Get the ambiguity datum which are fixed directly.
           */
       virtual VariableDataMap getIndepAmbMap( void )
@@ -292,8 +308,8 @@ namespace gpstk
       EdgeSet currentIndepEdges;
 
 
-         /// Global set of unknowns
-      EdgeSet currentEdges;
+         /// Spanning forest of the edges, kept from epoch to epoch
+      SpanningForest forest;
 
 
          /// Whether or not this IndepAmbiguityDatumNet is ready to be used
@@ -321,7 +337,7 @@ namespace gpstk
 
 
          /// Prepare set of current edges for all sources and satellites
-      EdgeSet prepareCurrentEdges( gnssDataMap& gdsMap );
+      void prepareCurrentEdges( gnssDataMap& gdsMap );
 
 
          /// Prepare set of current independent edges for all sources and satellites
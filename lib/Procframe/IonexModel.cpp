@@ -39,6 +39,7 @@
 
 #include "IonexModel.hpp"
 #include "constants.hpp"
+#include "WGS84Ellipsoid.hpp"
 
 using namespace std;
 
@@ -58,6 +59,7 @@ namespace gpstk
    {
 
       pDefaultMaps = NULL;
+      pMSCStore = NULL;
       defaultObservable = TypeID::C1;
       useDCB = true;
       setIonoMapType("NONE");
@@ -86,6 +88,7 @@ namespace gpstk
          throw(Exception)
       {
 
+         pMSCStore = NULL;
          setInitialRxPosition(RxCoordinates);
          setDefaultMaps(istore);
          defaultObservable = dObservable;
@@ -107,193 +110,315 @@ namespace gpstk
       throw(Exception)
    {
 
-      SatIDSet satRejectedSet;
+      try
+      {
+
+         std::vector<satTypeValueMap*> staData(1, &gData);
+         std::vector<Position> staPos(1, rxPos);
+
+         processStations(time, staData, staPos);
+
+         return gData;
+
+      }   // End of try...
+      catch(Exception& e)
+      {
+
+         GPSTK_RETHROW(e);
+
+      }
+
+   }  // End of method 'IonexModel::Process()'
+
+
+
+      /** Returns a gnssDataMap object, adding the new data generated when
+       *  calling a modeling object.
+       *
+       * @param gData    Data object holding the data.
+       */
+   gnssDataMap& IonexModel::Process(gnssDataMap& gData)
+      throw(Exception)
+   {
 
       try
       {
 
-            // Loop through all the satellites
-         satTypeValueMap::iterator stv;
-         for(stv = gData.begin(); stv != gData.end(); ++stv)
+            // Without station coordinates, the data are left untouched
+         if(pMSCStore == NULL) return gData;
+
+         SourceIDSet sourceRejectedSet;
+
+            // All the stations of an epoch at once, even if they are in
+            // different entries of the gnssDataMap
+         gnssDataMap::iterator gdmIt( gData.begin() );
+         while( gdmIt != gData.end() )
          {
 
-               // First check if ionex maps were set
-            if(pDefaultMaps==NULL)
+            CommonTime time( gdmIt->first );
+            gnssDataMap::iterator gdmEnd( gData.upper_bound(time) );
+
+            CommonTime epoch( time );
+            epoch.setTimeSystem( TimeSystem::Unknown );
+
+            std::vector<satTypeValueMap*> staData;
+            std::vector<Position> staPos;
+
+            for( ; gdmIt != gdmEnd; ++gdmIt )
             {
 
-                  // If ionex maps are missing, then remove all satellites
-               satRejectedSet.insert( stv->first );
+               for( sourceDataMap::iterator sdmIt = gdmIt->second.begin();
+                    sdmIt != gdmIt->second.end();
+                    ++sdmIt )
+               {
 
-               continue;
+                  MSCData mscData;
 
-            }
+                  try
+                  {
+                     mscData = pMSCStore->findMSC( sdmIt->first.sourceName,
+                                                   epoch );
+                  }
+                  catch(...)
+                  {
+                     sourceRejectedSet.insert( sdmIt->first );
+                     continue;
+                  }
 
-               // If elevation or azimuth is missing, then remove satellite
-            if( stv->second.find(TypeID::elevation) == stv->second.end() ||
-                stv->second.find(TypeID::azimuth)   == stv->second.end() )
-            {
+                  staData.push_back( &sdmIt->second );
+                  staPos.push_back( mscData.coordinates );
 
-               satRejectedSet.insert( stv->first );
+               }  // End of 'for( sourceDataMap::iterator sdmIt = ...'
 
-               continue;
+            }  // End of 'for( ; gdmIt != gdmEnd; ++gdmIt )'
 
-            }
-            else
+            processStations(time, staData, staPos);
+
+         }  // End of 'while( gdmIt != gData.end() )'
+
+         gData.removeSourceID( sourceRejectedSet );
+
+         return gData;
+
+      }   // End of try...
+      catch(Exception& e)
+      {
+
+         GPSTK_RETHROW(e);
+
+      }
+
+   }  // End of method 'IonexModel::Process()'
+
+
+
+      /* Compute the IONEX model of a set of stations at an epoch.
+       *
+       * The pierce points of all the station-satellite rays are computed
+       * first, as Position::getIonosphericPiercePoint() does, and then the
+       * TEC values, mapping functions and slant delays of all of them are
+       * computed in tight loops over plain arrays.
+       *
+       * @param time      Epoch.
+       * @param staData   Data of the stations.
+       * @param staPos    Positions of the stations.
+       */
+   void IonexModel::processStations( const CommonTime& time,
+                                     const std::vector<satTypeValueMap*>& staData,
+                                     const std::vector<Position>& staPos )
+      throw(Exception)
+   {
+
+      const size_t numSta( staData.size() );
+
+      std::vector<SatIDSet> satRejectedSet(numSta);
+
+         // Pierce points of the station-satellite rays
+      std::vector<satTypeValueMap::iterator> rayIt;
+      std::vector<size_t> raySta;
+      std::vector<double> elev, lat, lon;
+
+         // Earth radius, as in Position::getIonosphericPiercePoint()
+      WGS84Ellipsoid WGS84;
+      const double ratio( WGS84.a() / (WGS84.a() + ionoHeight) );
+
+      for(size_t s = 0; s < numSta; ++s)
+      {
+
+         satTypeValueMap& data( *staData[s] );
+
+         if(pDefaultMaps == NULL)
+         {
+               // If ionex maps are missing, then remove all satellites
+            for( satTypeValueMap::iterator stv = data.begin();
+                 stv != data.end();
+                 ++stv )
             {
+               satRejectedSet[s].insert( stv->first );
+            }
 
-                  // Scalars to hold satellite elevation, azimuth, ionospheric
-                  // map and ionospheric slant delays
-               double elevation( stv->second(TypeID::elevation) );
-               double azimuth(   stv->second(TypeID::azimuth)   );
-               double ionoMap(0.0);
-               double ionexL1(0.0), ionexL2(0.0), ionexL5(0.0);   // GPS
-               double ionexL6(0.0), ionexL7(0.0), ionexL8(0.0);   // Galileo
+            continue;
+         }
 
-                  // calculate the position of the ionospheric pierce-point
-                  // corresponding to the receiver-satellite ray
-               Position IPP = rxPos.getIonosphericPiercePoint( elevation,
-                                                               azimuth,
-                                                               ionoHeight);
+         double rxLat( staPos[s].getGeocentricLatitude() * DEG_TO_RAD );
+         double rxLon( staPos[s].getLongitude() );
+         double sinLat( std::sin(rxLat) ), cosLat( std::cos(rxLat) );
 
-                  // TODO
-                  // Checking the collinearity of rxPos, IPP and SV
+         for( satTypeValueMap::iterator stv = data.begin();
+              stv != data.end();
+              ++stv )
+         {
 
+            typeValueMap::const_iterator itEl(
+                                       stv->second.find(TypeID::elevation) );
+            typeValueMap::const_iterator itAz(
+                                       stv->second.find(TypeID::azimuth) );
 
-                  // Let's get TEC, RMS and ionosphere height for IPP
-                  // at current epoch
-               Position pos(IPP);
-               pos.transformTo(Position::Geocentric);
-               Triple val = pDefaultMaps->getIonexValue( time, pos );
+               // If elevation or azimuth is missing, then remove satellite
+            if( itEl == stv->second.end() || itAz == stv->second.end() )
+            {
+               satRejectedSet[s].insert( stv->first );
+               continue;
+            }
 
-                  // just to make it handy for useage
-               double tecval = val[0];
+            double el( itEl->second * DEG_TO_RAD );
+            double az( itAz->second * DEG_TO_RAD );
 
-               try
-               {
+               // angle subtended at Earth center by receiver and IPP
+            double p( PI/2.0 - el - std::asin( ratio*std::cos(el) ) );
 
-                  ionoMap = pDefaultMaps->iono_mapping_function( elevation,
-                                                                 ionoMapType);
+            double ippLat( std::asin( sinLat*std::cos(p) +
+                                      cosLat*std::sin(p)*std::cos(az) ) );
+            double ippLon( rxLon + RAD_TO_DEG *
+                     std::asin( std::sin(p)*std::sin(az)/std::cos(ippLat) ) );
 
-                     // Compute ionospheric slant correction
-                  ionexL1 = pDefaultMaps->getIonoL1( elevation,
-                                                     tecval,
-                                                     ionoMapType);
+            if( ippLon < 0.0 ) ippLon += 360.0;
+            else if( ippLon >= 360.0 ) ippLon -= 360.0;
 
-                  ionexL2 = pDefaultMaps->getIonoL2( elevation,
-                                                     tecval,
-                                                     ionoMapType);
+            rayIt.push_back( stv );
+            raySta.push_back( s );
+            elev.push_back( itEl->second );
+            lat.push_back( ippLat * RAD_TO_DEG );
+            lon.push_back( ippLon );
 
-                  ionexL5 = pDefaultMaps->getIonoL5( elevation,
-                                                     tecval,
-                                                     ionoMapType);
+         }  // End of 'for( satTypeValueMap::iterator stv = ...'
 
-                  ionexL6 = pDefaultMaps->getIonoL6( elevation,
-                                                     tecval,
-                                                     ionoMapType);
+      }  // End of 'for(size_t s = 0; s < numSta; ++s)'
 
-                  ionexL7 = pDefaultMaps->getIonoL7( elevation,
-                                                     tecval,
-                                                     ionoMapType);
 
-                  ionexL8 = pDefaultMaps->getIonoL8( elevation,
-                                                     tecval,
-                                                     ionoMapType);
+      const size_t n( rayIt.size() );
 
-               }
-               catch(InvalidRequest)
-               {
+      if( n > 0 )
+      {
 
-                     // If some problem appears, then schedule this
-                     // satellite for removal
-                  satRejectedSet.insert( stv->first );
+            // Maps of the epoch, prepared only once
+         if( !grid.isValid() || grid.getEpoch() != time )
+         {
+            pDefaultMaps->prepareGrid(time, grid, 3, ionoHeight);
+         }
 
-                  continue;    // Skip this SV if problems arise
+            // TEC values, mapping functions and slant delays
+         static const double freq[6] = { L1_FREQ_GPS, L2_FREQ_GPS,
+                                         L5_FREQ_GPS, L6_FREQ_GAL,
+                                         L7_FREQ_GAL, L8_FREQ_GAL };
 
-               }
+         std::vector<double> tec(n), imap(n);
+         std::vector<double> iono[6];
 
-                  // DCB corrections for P1 measurements and satellite clock
-                  // values should be considered because precise ephemerides
-                  // and satellite clock information for SP3 orbit file always
-                  // refers to the ionosphere-free linear combination (LC)
-                  // see Appendix B, pg.14 of the Ionex manual
-                  // Useful link:
+         grid.interpolate( n, &lat[0], &lon[0], &tec[0] );
 
-                  // http://www.ngs.noaa.gov/IGSWorkshop2008/docs/...
-                  // Schaer_DCB_IGSWS2008.ppt
+         pDefaultMaps->iono_mapping_function( n, &elev[0],
+                                              ionoMapType, &imap[0] );
 
-                  // Computing Differential Code Biases (DCB - nanoseconds)
-               double tempDCB( getDCBCorrections( time,
-                                                 (*pDefaultMaps),
-                                                  stv->first) );
+         for(int f = 0; f < 6; ++f)
+         {
+            iono[f].resize(n);
+            pDefaultMaps->getIono( n, &elev[0], &tec[0], &imap[0],
+                                   freq[f], &iono[f][0] );
+         }
 
-                  // add to the GDS the  corresponding correction,
-                  // if appropriate
-               if(useDCB)
-               {
+            // DCB of the satellites, looked up once per satellite
+         std::map<SatID, double> satDCB;
 
-                     // Convert from nano second to meters
-                  double dcb(tempDCB * C_MPS * 1e-9);  // meters
+         for(size_t k = 0; k < n; ++k)
+         {
 
-                     // the second LC factor (see gpstk::LinearCombinations.cpp)
-                     // see pg.14, Ionex manual
-                  double kappa1(-1.0/0.646944444);
-                  double kappa2(-1.646944444/0.646944444);
+            satTypeValueMap::iterator stv( rayIt[k] );
 
-                     /**
-                      * instP1 <=> ( kappa1 * dcb);
-                      * instP2 <=> ( kappa2 * dcb);
-                      */
+               // Undefined or negative TEC: remove satellite
+            if( !(tec[k] >= 0.0) )
+            {
+               satRejectedSet[ raySta[k] ].insert( stv->first );
+               continue;
+            }
 
-                     // If found 'instC1', it means the c12p1 bias has been
-                     // inserted, i.e. the c1 is used instead of P1.
-                  if( stv->second.find(TypeID::instC1) == stv->second.end() )
-                  {
-                     stv->second[TypeID::instC1] = (kappa1 * dcb);
-                  }
-                  else
-                  {
-                     stv->second[TypeID::instC1] += (kappa1 * dcb);
-                  }
+               // DCB corrections for P1 measurements and satellite clock
+               // values should be considered because precise ephemerides
+               // and satellite clock information for SP3 orbit file always
+               // refers to the ionosphere-free linear combination (LC)
+               // see Appendix B, pg.14 of the Ionex manual
+               // Useful link:
 
-               }  // End of 'if(useDCB)...'
+               // http://www.ngs.noaa.gov/IGSWorkshop2008/docs/...
+               // Schaer_DCB_IGSWS2008.ppt
 
-                  // get the instrumental delays
-               double instC1 = stv->second[TypeID::instC1];
+               // add to the GDS the  corresponding correction,
+               // if appropriate
+            if(useDCB)
+            {
 
-               cout << "sat:" <<  stv->first
-                    << "instC1:" << instC1 << endl;
+                  // Computing Differential Code Biases (DCB - nanoseconds)
+               std::map<SatID, double>::iterator itDCB(
+                                                   satDCB.find(stv->first) );
+               if( itDCB == satDCB.end() )
+               {
+                  itDCB = satDCB.insert( std::make_pair( stv->first,
+                              getDCBCorrections( time,
+                                                 (*pDefaultMaps),
+                                                 stv->first ) ) ).first;
+               }
 
-                  // Now we have to add the new values (i.e., ionosphere delays)
-                  // to the data structure
-               (*stv).second[TypeID::ionoTEC] = tecval;
-               (*stv).second[TypeID::ionoMap] = ionoMap;
-               (*stv).second[TypeID::ionoL1]  = ionexL1;
-               (*stv).second[TypeID::ionoL2]  = ionexL2;
-               (*stv).second[TypeID::ionoL5]  = ionexL5;
-               (*stv).second[TypeID::ionoL6]  = ionexL6;
-               (*stv).second[TypeID::ionoL7]  = ionexL7;
-               (*stv).second[TypeID::ionoL8]  = ionexL8;
+                  // Convert from nano second to meters
+               double dcb(itDCB->second * C_MPS * 1e-9);  // meters
 
+                  // the second LC factor (see gpstk::LinearCombinations.cpp)
+                  // see pg.14, Ionex manual
+               double kappa1(-1.0/0.646944444);
 
-            }  // End of 'if( stv->second.find(TypeID::elevation) == ... '
+                  /**
+                   * instP1 <=> ( kappa1 * dcb);
+                   * instP2 <=> ( kappa2 * dcb);
+                   */
 
-         }  // End of loop 'for(stv = gData.begin()...'
+                  // If found 'instC1', it means the c12p1 bias has been
+                  // inserted, i.e. the c1 is used instead of P1.
+               stv->second[TypeID::instC1] += (kappa1 * dcb);
 
+            }  // End of 'if(useDCB)...'
 
-            // Remove satellites with missing data
-         gData.removeSatID(satRejectedSet);
+               // Now we have to add the new values (i.e., ionosphere delays)
+               // to the data structure
+            stv->second[TypeID::ionoTEC] = tec[k];
+            stv->second[TypeID::ionoMap] = imap[k];
+            stv->second[TypeID::ionoL1]  = iono[0][k];
+            stv->second[TypeID::ionoL2]  = iono[1][k];
+            stv->second[TypeID::ionoL5]  = iono[2][k];
+            stv->second[TypeID::ionoL6]  = iono[3][k];
+            stv->second[TypeID::ionoL7]  = iono[4][k];
+            stv->second[TypeID::ionoL8]  = iono[5][k];
 
-         return gData;
+         }  // End of 'for(size_t k = 0; k < n; ++k)'
 
-      }   // End of try...
-      catch(Exception& e)
-      {
+      }  // End of 'if( n > 0 )'
 
-         GPSTK_RETHROW(e);
 
+         // Remove satellites with missing data
+      for(size_t s = 0; s < numSta; ++s)
+      {
+         staData[s]->removeSatID( satRejectedSet[s] );
       }
 
-   }  // End of method 'IonexModel::Process()'
+   }  // End of method 'IonexModel::processStations()'
 
 
 
@@ -366,6 +491,9 @@ namespace gpstk
          // and here the ionosphere height, in meters
       ionoHeight = (ionoMap == "MSLM") ? 506700.0 : 450000.0;
 
+         // the maps of 3D IONEX files depend on the height
+      grid = IonexGrid();
+
       return (*this);
 
    }
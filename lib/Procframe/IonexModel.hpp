@@ -34,7 +34,9 @@
 //============================================================================
 
 
+#include <vector>
 #include "IonexStore.hpp"
+#include "MSCStore.hpp"
 #include "Position.hpp"
 #include "ProcessingClass.hpp"
 #include "TypeID.hpp"
@@ -98,7 +100,14 @@ namespace gpstk
        * needed (elevation and azimuth ARE REQUIRED), it will be summarily
        * deleted from the data structure. This also implies that if you try
        * to use a "IonexModel" object without first defining the IONEX model,
-       * then ALL satellites will be deleted.
+       * then ALL satellites will be deleted. Satellites whose pierce point
+       * falls on undefined or negative TEC values are deleted, too.
+       *
+       * The maps of the epoch are prepared once (see IonexGrid), and the
+       * pierce points of all the satellites are interpolated at once. With
+       * a "gnssDataMap", this is done for all the stations of an epoch,
+       * whose coordinates are taken from the MSCStore object given with
+       * setMSCStore().
        *
        * @sa IonexStore.hpp
        *
@@ -109,7 +118,7 @@ namespace gpstk
 
 
          /// Default constructor.
-      IonexModel() : pDefaultMaps(NULL), useDCB(false)
+      IonexModel() : pDefaultMaps(NULL), pMSCStore(NULL), useDCB(false)
       { };
 
 
@@ -175,8 +184,7 @@ namespace gpstk
           * @param gData    Data object holding the data.
           */
       virtual gnssDataMap& Process(gnssDataMap& gData)
-         throw(Exception)
-      { return gData; };
+         throw(Exception);
 
 
          /// Method to get the default observable for computations.
@@ -204,7 +212,21 @@ namespace gpstk
           * @param istore   IonexStore object to be used by default
           */
       virtual IonexModel& setDefaultMaps(IonexStore& istore)
-      { pDefaultMaps = &istore; return (*this); };
+      { pDefaultMaps = &istore; grid = IonexGrid(); return (*this); };
+
+
+         /// Method to get a pointer to the MSCStore object currently in use.
+      virtual MSCStore* getMSCStore(void) const
+      { return pMSCStore; };
+
+
+         /** Method to set the MSCStore object giving the coordinates of the
+          *  stations of a gnssDataMap.
+          *
+          * @param msc   MSCStore object.
+          */
+      virtual IonexModel& setMSCStore(MSCStore& msc)
+      { pMSCStore = &msc; return (*this); };
 
 
          /// Method to get if DCB is being used
@@ -276,6 +298,18 @@ namespace gpstk
    protected:
 
 
+         /** Compute the IONEX model of a set of stations at an epoch.
+          *
+          * @param time      Epoch.
+          * @param staData   Data of the stations.
+          * @param staPos    Positions of the stations.
+          */
+      virtual void processStations( const CommonTime& time,
+                                    const std::vector<satTypeValueMap*>& staData,
+                                    const std::vector<Position>& staPos )
+         throw(Exception);
+
+
          /// Default observable to be used when fed with GNSS data structures.
       TypeID defaultObservable;
 
@@ -285,6 +319,14 @@ namespace gpstk
       IonexStore* pDefaultMaps;
 
 
+         /// Pointer to the station coordinates of a gnssDataMap
+      MSCStore* pMSCStore;
+
+
+         /// Maps of the last epoch
+      IonexGrid grid;
+
+
          /// Either estimated or "a priori" position of receiver
       Position rxPos;
 
@@ -0,0 +1,1051 @@
+#pragma ident "$Id$"
+
+/**
+ * @file MeasUpdateSRIF.cpp
+ * Kalman filter (time and measurement updates) in square root information
+ * form.
+ */
+
+//============================================================================
+//
+//  This file is part of GPSTk, the GPS Toolkit.
+//
+//  The GPSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 2.1 of the License, or
+//  any later version.
+//
+//  The GPSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GPSTk; if not, write to the Free Software Foundation,
+//  Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//============================================================================
+
+
+#include <cmath>
+#include <algorithm>
+#include <map>
+
+#include "MeasUpdateSRIF.hpp"
+
+using namespace std;
+
+namespace gpstk
+{
+
+    // Return a string identifying this object.
+    std::string MeasUpdateSRIF::getClassName() const
+    { return "MeasUpdateSRIF"; }
+
+
+    // Invert the upper triangular matrix 'U', n x n with row stride
+    // 'stride', into 'Ui', n x n row-major. Zero elements of 'U' are
+    // skipped, so sparse rows are cheap.
+    static void invertUpper( int n,
+                             const double* U,
+                             int stride,
+                             std::vector<double>& Ui )
+    {
+        Ui.assign( n*n, 0.0 );
+
+        for(int i=n-1; i>=0; --i)
+        {
+            const double* Urow( &U[i*stride] );
+            double* row( &Ui[i*n] );
+
+            // row i of Ui = ( e_i - sum_k U(i,k) * row k of Ui ) / U(i,i)
+            for(int k=i+1; k<n; ++k)
+            {
+                double u( Urow[k] );
+                if(u == 0.0) continue;
+
+                const double* rowk( &Ui[k*n] );
+                for(int j=k; j<n; ++j) row[j] -= u*rowk[j];
+            }
+
+            double inv( 1.0/Urow[i] );
+            row[i] = 1.0;
+            for(int j=i; j<n; ++j) row[j] *= inv;
+        }
+
+    }  // End of function 'invertUpper()'
+
+
+    // Move column 'p' of R and z, n x (n+1) row-major, to the front, and
+    // make R upper triangular again with Givens rotations of rows (i-1,i),
+    // from the bottom. It costs O(p*n).
+    static void moveToFront( int n,
+                             std::vector<double>& Rz,
+                             std::vector<Variable>& vars,
+                             int p )
+    {
+        if(p <= 0) return;
+
+        const int nc( n+1 );
+
+        // Only rows 0..p have elements in columns 0..p
+        for(int i=0; i<=p; ++i)
+        {
+            double* row( &Rz[i*nc] );
+
+            double v( row[p] );
+            for(int j=p; j>0; --j) row[j] = row[j-1];
+            row[0] = v;
+        }
+
+        // Row i has elements in column 0 and from column i+1 on, and row
+        // i-1 from column i on. Zeroing the first one puts the diagonal
+        // element of row i in place.
+        for(int i=p; i>0; --i)
+        {
+            double* a( &Rz[(i-1)*nc] );
+            double* b( &Rz[i*nc] );
+
+            if(b[0] == 0.0) continue;
+
+            double r( std::sqrt( a[0]*a[0] + b[0]*b[0] ) );
+            double c( a[0]/r );
+            double s( b[0]/r );
+
+            a[0] = r;
+            b[0] = 0.0;
+
+            for(int j=i; j<nc; ++j)
+            {
+                double x( a[j] );
+                double y( b[j] );
+                a[j] = c*x + s*y;
+                b[j] = c*y - s*x;
+            }
+        }
+
+        // keep the diagonal positive
+        for(int i=0; i<=p; ++i)
+        {
+            double* row( &Rz[i*nc] );
+            if(row[i] < 0.0)
+            {
+                for(int j=i; j<nc; ++j) row[j] = -row[j];
+            }
+        }
+
+        Variable var( vars[p] );
+        for(int j=p; j>0; --j) vars[j] = vars[j-1];
+        vars[0] = var;
+
+    }  // End of function 'moveToFront()'
+
+
+    // Triangularize the first 'ncols' columns of B, m x w row-major, by
+    // Householder transformations, keeping the diagonal positive.
+    static void householderQR( std::vector<double>& B,
+                               int m,
+                               int w,
+                               int ncols )
+    {
+        for(int j=0; j<ncols && j<m; ++j)
+        {
+            double* Bj( &B[j*w] );
+
+            double s(0.0);
+            for(int i=j+1; i<m; ++i) s += B[i*w+j]*B[i*w+j];
+
+            if(s > 0.0)
+            {
+                double r( Bj[j] );
+                double alpha( std::sqrt(r*r + s) );
+                if(r > 0.0) alpha = -alpha;
+
+                double u0( r - alpha );
+                double f( 2.0/(u0*u0 + s) );
+
+                for(int k=j+1; k<w; ++k)
+                {
+                    double d( u0*Bj[k] );
+                    for(int i=j+1; i<m; ++i) d += B[i*w+j]*B[i*w+k];
+                    d *= f;
+
+                    Bj[k] -= d*u0;
+                    for(int i=j+1; i<m; ++i) B[i*w+k] -= d*B[i*w+j];
+                }
+
+                Bj[j] = alpha;
+                for(int i=j+1; i<m; ++i) B[i*w+j] = 0.0;
+            }
+
+            if(Bj[j] < 0.0)
+            {
+                for(int k=j; k<w; ++k) Bj[k] = -Bj[k];
+            }
+        }
+
+    }  // End of function 'householderQR()'
+
+
+    // Get S, lower triangular, with S'*S = inverse(Q). Returns false if Q
+    // is not positive definite.
+    static bool noiseSqrtInfo( const Matrix<double>& Q, Matrix<double>& S )
+    {
+        const int r( Q.rows() );
+
+        // Q = L*L'
+        Matrix<double> L( r, r, 0.0 );
+        for(int j=0; j<r; ++j)
+        {
+            double d( Q(j,j) );
+            for(int k=0; k<j; ++k) d -= L(j,k)*L(j,k);
+
+            if(!(d > 0.0)) return false;
+
+            L(j,j) = std::sqrt(d);
+
+            for(int i=j+1; i<r; ++i)
+            {
+                double v( Q(i,j) );
+                for(int k=0; k<j; ++k) v -= L(i,k)*L(j,k);
+                L(i,j) = v/L(j,j);
+            }
+        }
+
+        // S = inverse(L)
+        S.resize( r, r, 0.0 );
+        for(int j=0; j<r; ++j)
+        {
+            S(j,j) = 1.0/L(j,j);
+
+            for(int i=j+1; i<r; ++i)
+            {
+                double v(0.0);
+                for(int k=j; k<i; ++k) v -= L(i,k)*S(k,j);
+                S(i,j) = v/L(i,i);
+            }
+        }
+
+        return true;
+
+    }  // End of function 'noiseSqrtInfo()'
+
+
+    namespace
+    {
+        // Variables related by a stochastic model, with their Phi and Q
+        struct ModelBlock
+        {
+            std::vector<Variable> vars;
+            Matrix<double> phi;
+            Matrix<double> q;
+        };
+
+        // Position of a variable in the columns of R
+        int columnOf( const std::vector<Variable>& vars, const Variable& var )
+        {
+            for(size_t i=0; i<vars.size(); ++i)
+            {
+                if( vars[i] == var ) return i;
+            }
+
+            return -1;
+        }
+    }
+
+
+    // Get the information square root of a covariance matrix.
+    void MeasUpdateSRIF::covToInfo( const Matrix<double>& cov,
+                                    const Vector<double>& x,
+                                    std::vector<double>& Rz )
+        throw(InvalidSolver)
+    {
+        const int n( x.size() );
+
+        // cov = U*U', U upper triangular, computed from the last column.
+        // last[i] is the last column where row i of U is not zero.
+        std::vector<double> U(n*n, 0.0);
+        std::vector<int> last(n, -1);
+
+        for(int j=n-1; j>=0; --j)
+        {
+            double* Uj( &U[j*n] );
+
+            double d( cov(j,j) );
+            for(int k=j+1; k<=last[j]; ++k) d -= Uj[k]*Uj[k];
+
+            if(!(d > 0.0))
+            {
+                InvalidSolver e("Covariance matrix is not positive definite.");
+                GPSTK_THROW(e);
+            }
+
+            Uj[j] = std::sqrt(d);
+            if(last[j] < j) last[j] = j;
+
+            for(int i=0; i<j; ++i)
+            {
+                double* Ui( &U[i*n] );
+
+                double s( cov(i,j) );
+                int end( std::min(last[i], last[j]) );
+                for(int k=j+1; k<=end; ++k) s -= Ui[k]*Uj[k];
+
+                if(s == 0.0) continue;
+
+                Ui[j] = s/Uj[j];
+                if(last[i] < j) last[i] = j;
+            }
+        }
+
+        // R = inverse(U), z = R*x
+        std::vector<double> R;
+        invertUpper(n, &U[0], n, R);
+
+        Rz.assign( n*(n+1), 0.0 );
+        for(int i=0; i<n; ++i)
+        {
+            double* row( &Rz[i*(n+1)] );
+            const double* Ri( &R[i*n] );
+
+            double z(0.0);
+            for(int j=i; j<n; ++j)
+            {
+                row[j] = Ri[j];
+                z += Ri[j]*x(j);
+            }
+            row[n] = z;
+        }
+
+    }  // End of method 'MeasUpdateSRIF::covToInfo()'
+
+
+    // Update R and z with a block of weighted equations.
+    void MeasUpdateSRIF::householderUpdate( int n,
+                                            std::vector<double>& Rz,
+                                            std::vector<double>& A,
+                                            int m,
+                                            int minCol )
+    {
+        const int nc( n+1 );
+
+        std::vector<int> rows;
+        std::vector<double> d(nc, 0.0);
+
+        for(int j=minCol; j<n; ++j)
+        {
+            // rows of the block not zero in this column
+            rows.clear();
+            double s(0.0);
+            for(int i=0; i<m; ++i)
+            {
+                double a( A[i*nc+j] );
+                if(a != 0.0)
+                {
+                    rows.push_back(i);
+                    s += a*a;
+                }
+            }
+
+            if(rows.empty()) continue;
+
+            double* Rj( &Rz[j*nc] );
+
+            double r( Rj[j] );
+            double alpha( std::sqrt(r*r + s) );
+            if(r > 0.0) alpha = -alpha;
+
+            double u0( r - alpha );
+            double vtv( u0*u0 + s );
+
+            // d = v' * [R(j,j+1:n); A(:,j+1:n)]
+            for(int k=j+1; k<nc; ++k) d[k] = u0*Rj[k];
+
+            for(size_t l=0; l<rows.size(); ++l)
+            {
+                const double* Ai( &A[rows[l]*nc] );
+                double a( Ai[j] );
+                for(int k=j+1; k<nc; ++k) d[k] += a*Ai[k];
+            }
+
+            for(int k=j+1; k<nc; ++k) d[k] *= 2.0/vtv;
+
+            for(int k=j+1; k<nc; ++k) Rj[k] -= d[k]*u0;
+
+            for(size_t l=0; l<rows.size(); ++l)
+            {
+                double* Ai( &A[rows[l]*nc] );
+                double a( Ai[j] );
+                for(int k=j+1; k<nc; ++k) Ai[k] -= d[k]*a;
+                Ai[j] = 0.0;
+            }
+
+            Rj[j] = alpha;
+
+            // keep the diagonal positive
+            if(alpha < 0.0)
+            {
+                for(int k=j; k<nc; ++k) Rj[k] = -Rj[k];
+            }
+
+        }  // End of 'for(int j=minCol; ...)'
+
+    }  // End of method 'MeasUpdateSRIF::householderUpdate()'
+
+
+    // Get the state and covariance from R and z.
+    void MeasUpdateSRIF::infoToCov( int n,
+                                    const std::vector<double>& Rz,
+                                    Vector<double>& x,
+                                    Matrix<double>& cov )
+        throw(InvalidSolver)
+    {
+        const int nc( n+1 );
+
+        for(int i=0; i<n; ++i)
+        {
+            if(Rz[i*nc+i] == 0.0)
+            {
+                InvalidSolver e("Information matrix is singular.");
+                GPSTK_THROW(e);
+            }
+        }
+
+        // R*x = z
+        x.resize(n, 0.0);
+        for(int i=n-1; i>=0; --i)
+        {
+            const double* row( &Rz[i*nc] );
+
+            double s( row[n] );
+            for(int j=i+1; j<n; ++j) s -= row[j]*x(j);
+            x(i) = s/row[i];
+        }
+
+        // cov = inverse(R) * inverse(R)'
+        std::vector<double> Ri;
+        invertUpper(n, &Rz[0], nc, Ri);
+
+        std::vector<int> last(n);
+        for(int i=0; i<n; ++i)
+        {
+            last[i] = i;
+            for(int k=n-1; k>i; --k)
+            {
+                if(Ri[i*n+k] != 0.0) { last[i] = k; break; }
+            }
+        }
+
+        cov.resize(n, n, 0.0);
+        for(int i=0; i<n; ++i)
+        {
+            const double* rowi( &Ri[i*n] );
+
+            for(int j=i; j<n; ++j)
+            {
+                const double* rowj( &Ri[j*n] );
+
+                double s(0.0);
+                int end( std::min(last[i], last[j]) );
+                for(int k=j; k<=end; ++k) s += rowi[k]*rowj[k];
+
+                cov(i,j) = cov(j,i) = s;
+            }
+        }
+
+    }  // End of method 'MeasUpdateSRIF::infoToCov()'
+
+
+    // Take R and z from the state and covariance of the 'StateStore'
+    void MeasUpdateSRIF::loadStateStore()
+        throw(InvalidSolver)
+    {
+        const VariableSet& vars( m_pStateStore->getVariableSet() );
+
+        srifVars.assign( vars.begin(), vars.end() );
+
+        if( srifVars.empty() )
+        {
+            srifRz.clear();
+        }
+        else
+        {
+            covToInfo( m_pStateStore->getCovarMatrix(),
+                       m_pStateStore->getStateVector(),
+                       srifRz );
+        }
+
+        haveSRIF = true;
+
+    }  // End of method 'MeasUpdateSRIF::loadStateStore()'
+
+
+
+    // Whether the 'StateStore' holds what this object stored last
+    bool MeasUpdateSRIF::stateStoreUnchanged()
+    {
+        if( !( m_pStateStore->getVariableSet() == storedVars ) ) return false;
+
+        Vector<double> state( m_pStateStore->getStateVector() );
+        if( state.size() != storedState.size() ) return false;
+
+        for(size_t i=0; i<state.size(); ++i)
+        {
+            if( state(i) != storedState(i) ) return false;
+        }
+
+        return true;
+
+    }  // End of method 'MeasUpdateSRIF::stateStoreUnchanged()'
+
+
+
+    /* Time update of R and z, to the variables of the current epoch.
+     *
+     * @param gdsMap          Data of the epoch, for the stochastic models.
+     * @param currentUnknowns Variables of the epoch.
+     */
+    void MeasUpdateSRIF::timeUpdate( gnssDataMap& gdsMap,
+                                     const VariableSet& currentUnknowns )
+        throw(InvalidSolver)
+    {
+        int n( srifVars.size() );
+
+        // Firstly, the variables no longer processed are moved to the
+        // front, and cut off with their rows
+        int numDrop(0);
+        for(int i=0; i<n; ++i)
+        {
+            if( currentUnknowns.find( srifVars[i] ) == currentUnknowns.end() )
+            {
+                moveToFront( n, srifRz, srifVars, i );
+                ++numDrop;
+            }
+        }
+
+        // Secondly, the new variables are put in front, not correlated
+        std::vector<Variable> newVars;
+        {
+            VariableSet known( srifVars.begin(), srifVars.end() );
+
+            for( VariableSet::const_iterator it = currentUnknowns.begin();
+                 it != currentUnknowns.end();
+                 ++it )
+            {
+                if( known.find(*it) == known.end() ) newVars.push_back(*it);
+            }
+        }
+
+        const int numNew( newVars.size() );
+
+        if( numDrop > 0 || numNew > 0 )
+        {
+            const int m( n - numDrop + numNew );
+            const int nc( n+1 );
+
+            std::vector<double> Rz( m*(m+1), 0.0 );
+
+            for(int i=0; i<numNew; ++i)
+            {
+                double variance( newVars[i].getInitialVariance() );
+                if(!(variance > 0.0))
+                {
+                    InvalidSolver e("Initial variance must be positive.");
+                    GPSTK_THROW(e);
+                }
+
+                Rz[i*(m+1)+i] = 1.0/std::sqrt(variance);
+            }
+
+            for(int i=numDrop; i<n; ++i)
+            {
+                const double* src( &srifRz[i*nc] );
+                double* dst( &Rz[(i-numDrop+numNew)*(m+1)] );
+
+                for(int j=i; j<n; ++j) dst[j-numDrop+numNew] = src[j];
+                dst[m] = src[n];
+            }
+
+            srifRz.swap(Rz);
+
+            newVars.insert( newVars.end(),
+                            srifVars.begin()+numDrop, srifVars.end() );
+            srifVars.swap(newVars);
+
+            n = m;
+        }
+
+        const int nc( n+1 );
+
+        // Thirdly, Phi and Q of the related variables, as in 'TimeUpdate'
+        std::vector<ModelBlock> blocks;
+
+        VariableSet tempUnknowns( currentUnknowns );
+        VariableSet::iterator varIter( tempUnknowns.begin() );
+
+        while( varIter != tempUnknowns.end() )
+        {
+            Variable var( *varIter );
+
+            std::vector<TypeID> relTypeIDVec( var.getModel()->getRelTypeIDVec() );
+            std::vector<Variable> relVarVec;
+
+            for( VariableSet::iterator it = tempUnknowns.begin();
+                 it != tempUnknowns.end();
+                 ++it )
+            {
+                if( var.getSatIndexed() &&
+                    var.getSatellite() != (*it).getSatellite() ) continue;
+
+                if( var.getSourceIndexed() &&
+                    var.getSource() != (*it).getSource() ) continue;
+
+                if( relTypeIDVec.end() != std::find( relTypeIDVec.begin(),
+                                                     relTypeIDVec.end(),
+                                                     (*it).getType() ) )
+                {
+                    relVarVec.push_back( *it );
+                }
+
+                if( relVarVec.size() == relTypeIDVec.size() ) break;
+            }
+
+            var.getModel()->Prepare( relVarVec, gdsMap );
+
+            Matrix<double> phiMatrix( var.getModel()->getPhi() );
+            Matrix<double> qMatrix( var.getModel()->getQ() );
+
+            // The variables in the order of Phi and Q
+            std::vector<int> index;
+            ModelBlock block;
+            for(size_t i=0; i<relTypeIDVec.size(); ++i)
+            {
+                for(size_t j=0; j<relVarVec.size(); ++j)
+                {
+                    if( relVarVec[j].getType() == relTypeIDVec[i] )
+                    {
+                        index.push_back(i);
+                        block.vars.push_back( relVarVec[j] );
+                        break;
+                    }
+                }
+            }
+
+            const int r( index.size() );
+            block.phi.resize( r, r, 0.0 );
+            block.q.resize( r, r, 0.0 );
+            for(int i=0; i<r; ++i)
+            {
+                for(int j=0; j<r; ++j)
+                {
+                    block.phi(i,j) = phiMatrix( index[i], index[j] );
+                    block.q(i,j) = qMatrix( index[i], index[j] );
+                }
+            }
+
+            if(r > 0) blocks.push_back(block);
+
+            for(size_t i=0; i<relVarVec.size(); ++i)
+            {
+                tempUnknowns.erase( relVarVec[i] );
+            }
+
+            // A model must at least take the variable itself
+            tempUnknowns.erase( var );
+
+            varIter = tempUnknowns.begin();
+        }
+
+        // Blocks of Phi and Q are split into single variables when they
+        // are diagonal. Noise blocks need Q positive definite; without
+        // noise, Phi must be the identity, or a scale factor for a single
+        // variable.
+        std::vector<ModelBlock> noise;
+        std::vector<Variable> scaleVars;
+        std::vector<double> scales;
+        bool srifForm(true);
+
+        for(size_t b=0; b<blocks.size() && srifForm; ++b)
+        {
+            const ModelBlock& block( blocks[b] );
+            const int r( block.vars.size() );
+
+            bool diagonal(true);
+            bool identity(true);
+            bool noNoise(true);
+            for(int i=0; i<r; ++i)
+            {
+                for(int j=0; j<r; ++j)
+                {
+                    if( block.q(i,j) != 0.0 ) noNoise = false;
+                    if( block.phi(i,j) != ( (i == j) ? 1.0 : 0.0 ) )
+                    {
+                        identity = false;
+                    }
+                    if( i != j && ( block.phi(i,j) != 0.0 ||
+                                    block.q(i,j) != 0.0 ) )
+                    {
+                        diagonal = false;
+                    }
+                }
+            }
+
+            if( noNoise && identity ) continue;
+
+            if( diagonal )
+            {
+                for(int i=0; i<r; ++i)
+                {
+                    double phi( block.phi(i,i) );
+                    double q( block.q(i,i) );
+
+                    if( q > 0.0 )
+                    {
+                        ModelBlock single;
+                        single.vars.push_back( block.vars[i] );
+                        single.phi.resize( 1, 1, phi );
+                        single.q.resize( 1, 1, q );
+                        noise.push_back(single);
+                    }
+                    else if( q == 0.0 && phi != 0.0 )
+                    {
+                        if( phi != 1.0 )
+                        {
+                            scaleVars.push_back( block.vars[i] );
+                            scales.push_back( phi );
+                        }
+                    }
+                    else
+                    {
+                        srifForm = false;
+                    }
+                }
+            }
+            else
+            {
+                Matrix<double> S;
+                if( noNoise || !noiseSqrtInfo( block.q, S ) )
+                {
+                    srifForm = false;
+                }
+                else
+                {
+                    noise.push_back(block);
+                }
+            }
+        }
+
+        if( !srifForm )
+        {
+            // Time update in covariance form: P = Phi*P*Phi' + Q
+            Vector<double> x;
+            Matrix<double> P;
+            infoToCov( n, srifRz, x, P );
+
+            for(size_t b=0; b<blocks.size(); ++b)
+            {
+                const ModelBlock& block( blocks[b] );
+                const int r( block.vars.size() );
+
+                std::vector<int> idx(r);
+                for(int i=0; i<r; ++i)
+                {
+                    idx[i] = columnOf( srifVars, block.vars[i] );
+                }
+
+                std::vector<double> v(r);
+
+                for(int i=0; i<r; ++i)
+                {
+                    v[i] = 0.0;
+                    for(int j=0; j<r; ++j) v[i] += block.phi(i,j)*x(idx[j]);
+                }
+                for(int i=0; i<r; ++i) x(idx[i]) = v[i];
+
+                for(int c=0; c<n; ++c)
+                {
+                    for(int i=0; i<r; ++i)
+                    {
+                        v[i] = 0.0;
+                        for(int j=0; j<r; ++j) v[i] += block.phi(i,j)*P(idx[j],c);
+                    }
+                    for(int i=0; i<r; ++i) P(idx[i],c) = v[i];
+                }
+
+                for(int c=0; c<n; ++c)
+                {
+                    for(int i=0; i<r; ++i)
+                    {
+                        v[i] = 0.0;
+                        for(int j=0; j<r; ++j) v[i] += P(c,idx[j])*block.phi(i,j);
+                    }
+                    for(int i=0; i<r; ++i) P(c,idx[i]) = v[i];
+                }
+
+                for(int i=0; i<r; ++i)
+                {
+                    for(int j=0; j<r; ++j) P(idx[i],idx[j]) += block.q(i,j);
+                }
+            }
+
+            covToInfo( P, x, srifRz );
+
+            return;
+        }
+
+        // Deterministic scale: x' = phi*x, so column j of R is divided by phi
+        for(size_t k=0; k<scaleVars.size(); ++k)
+        {
+            const int j( columnOf( srifVars, scaleVars[k] ) );
+
+            for(int i=0; i<=j; ++i) srifRz[i*nc+j] /= scales[k];
+
+            if( srifRz[j*nc+j] < 0.0 )
+            {
+                for(int l=j; l<nc; ++l) srifRz[j*nc+l] = -srifRz[j*nc+l];
+            }
+        }
+
+        // Noise: with the variables of the block in front,
+        //
+        //   | R_gg   0    R_gc  z_g |            | *   *      *     * |
+        //   | -S*Phi S    0     0   |   ---->    | 0   R'_gg  R'_gc z'_g|
+        //
+        // for the old values x_g and the new ones x'_g, with S'*S = inv(Q).
+        // The first rows, holding x_g, are dropped.
+        for(size_t b=0; b<noise.size(); ++b)
+        {
+            const ModelBlock& block( noise[b] );
+            const int r( block.vars.size() );
+
+            for(int i=r-1; i>=0; --i)
+            {
+                moveToFront( n, srifRz, srifVars,
+                             columnOf( srifVars, block.vars[i] ) );
+            }
+
+            Matrix<double> S;
+            noiseSqrtInfo( block.q, S );
+
+            const int w( r + nc );
+            std::vector<double> B( 2*r*w, 0.0 );
+
+            for(int k=0; k<r; ++k)
+            {
+                const double* row( &srifRz[k*nc] );
+                double* Bk( &B[k*w] );
+
+                for(int j=0; j<r; ++j) Bk[j] = row[j];
+                for(int j=r; j<nc; ++j) Bk[r+j] = row[j];
+
+                double* Nk( &B[(r+k)*w] );
+                for(int j=0; j<r; ++j)
+                {
+                    double sphi(0.0);
+                    for(int l=0; l<r; ++l) sphi += S(k,l)*block.phi(l,j);
+
+                    Nk[j] = -sphi;
+                    Nk[r+j] = S(k,j);
+                }
+            }
+
+            householderQR( B, 2*r, w, 2*r );
+
+            for(int k=0; k<r; ++k)
+            {
+                const double* src( &B[(r+k)*w] );
+                double* row( &srifRz[k*nc] );
+
+                for(int j=0; j<nc; ++j) row[j] = src[r+j];
+            }
+        }
+
+    }  // End of method 'MeasUpdateSRIF::timeUpdate()'
+
+
+
+    /** Return a reference to a gnssDataMap object after solving
+     *  the previously defined equation system.
+     *
+     * @param gdsMap    Data object holding the data.
+     */
+    gnssDataMap& MeasUpdateSRIF::Process( gnssDataMap& gdsMap )
+        throw(ProcessingException)
+    {
+
+        try
+        {
+            // Start again from the StateStore if it was changed by others
+            if( !haveSRIF || !stateStoreUnchanged() ) loadStateStore();
+
+            // Prepare the equation system with current data
+            equSystem.Prepare( gdsMap );
+
+            const int numUnknowns( equSystem.getCurrentNumVariables() );
+
+            // Get the set with unknowns to be processed
+            VariableSet currentUnknowns( equSystem.getCurrentUnknowns() );
+
+            // Get the list with equations to be processed
+            EquationList equList( equSystem.getCurrentEquationsList() );
+
+            const int numEquations( equList.size() );
+            const int nc( numUnknowns+1 );
+
+            // Predicted R and z
+            timeUpdate( gdsMap, currentUnknowns );
+
+            std::vector<double>& Rz( srifRz );
+
+            // Column of R of every variable, by its index in the unknowns
+            std::vector<int> column( numUnknowns, -1 );
+            {
+                std::map<Variable, int> columnOfVar;
+                for(int i=0; i<numUnknowns; ++i) columnOfVar[ srifVars[i] ] = i;
+
+                int i(0);
+                for( VariableSet::const_iterator it = currentUnknowns.begin();
+                     it != currentUnknowns.end();
+                     ++it, ++i )
+                {
+                    column[i] = columnOfVar[*it];
+                }
+            }
+
+            Vector<double> prefitResiduals( numEquations, 0.0 );
+
+            // Sparse geometry matrix, for the postfit residuals
+            std::vector<int> rowStart(1, 0);
+            std::vector<int> colIndex;
+            std::vector<double> hValue;
+
+            // Block of weighted equations
+            std::vector<double> A( blockSize*nc, 0.0 );
+            int numRows(0);
+            int minCol(numUnknowns);
+
+            int row(0);
+            for( EquationList::const_iterator itEqu = equList.begin();
+                 itEqu != equList.end();
+                 ++itEqu, ++row )
+            {
+                const typeValueMap& tData( (*itEqu).header.typeValueData );
+
+                // Get the independent type of this equation
+                TypeID indepType( (*itEqu).header.indTerm.getType() );
+
+                double tempPrefit( tData.getValue(indepType) );
+
+                // Weight, as in 'MeasUpdate'
+                double weight( (*itEqu).header.constWeight );
+
+                if( indepType == TypeID::prefitC )
+                {
+                    typeValueMap::const_iterator it( tData.find(TypeID::weightC) );
+                    if( it != tData.end() ) weight *= it->second;
+                }
+                else if( indepType == TypeID::prefitL )
+                {
+                    typeValueMap::const_iterator it( tData.find(TypeID::weightL) );
+                    if( it != tData.end() ) weight *= it->second;
+                }
+
+                double sw( (weight > 0.0) ? std::sqrt(weight) : 0.0 );
+
+                double* Arow( &A[numRows*nc] );
+
+                for( VarCoeffMap::const_iterator vcmIter = (*itEqu).body.begin();
+                     vcmIter != (*itEqu).body.end();
+                     ++vcmIter )
+                {
+                    const Variable& var( (*vcmIter).first );
+                    const Coefficient& coef( (*vcmIter).second );
+
+                    double tempCoef( coef.defaultCoefficient );
+
+                    if( !coef.forceDefault )
+                    {
+                        typeValueMap::const_iterator it( tData.find(var.getType()) );
+                        if( it != tData.end() ) tempCoef = it->second;
+                    }
+
+                    colIndex.push_back( var.getNowIndex() );
+                    hValue.push_back( tempCoef );
+
+                    int col( column[ var.getNowIndex() ] );
+
+                    Arow[col] = sw*tempCoef;
+                    if( col < minCol ) minCol = col;
+                }
+
+                Arow[numUnknowns] = sw*tempPrefit;
+
+                rowStart.push_back( colIndex.size() );
+                prefitResiduals(row) = tempPrefit;
+
+                ++numRows;
+
+                if( numRows == blockSize || row == numEquations-1 )
+                {
+                    householderUpdate( numUnknowns, Rz, A, numRows, minCol );
+
+                    std::fill( A.begin(), A.begin() + numRows*nc, 0.0 );
+                    numRows = 0;
+                    minCol = numUnknowns;
+                }
+
+            }  // End of 'for( EquationList::const_iterator itEqu = ...'
+
+            // State and covariance, in the order of the unknowns
+            Vector<double> x;
+            Matrix<double> cov;
+            infoToCov( numUnknowns, Rz, x, cov );
+
+            xhat.resize( numUnknowns, 0.0 );
+            P.resize( numUnknowns, numUnknowns, 0.0 );
+            for(int i=0; i<numUnknowns; ++i)
+            {
+                xhat(i) = x( column[i] );
+                for(int j=0; j<numUnknowns; ++j)
+                {
+                    P(i,j) = cov( column[i], column[j] );
+                }
+            }
+
+            // Compute the postfit residuals Vector
+            postfitResiduals.resize( numEquations, 0.0 );
+            for(int i=0; i<numEquations; ++i)
+            {
+                double v( prefitResiduals(i) );
+                for(int k=rowStart[i]; k<rowStart[i+1]; ++k)
+                {
+                    v -= hValue[k]*xhat( colIndex[k] );
+                }
+                postfitResiduals(i) = v;
+            }
+
+            m_pStateStore->setStateVector( xhat );
+            m_pStateStore->setCovarMatrix( P );
+            m_pStateStore->setVariableSet( currentUnknowns );
+
+            storedVars = currentUnknowns;
+            storedState = xhat;
+
+        }
+        catch(Exception& u)
+        {
+            // R and z may be half updated
+            haveSRIF = false;
+
+            // Throw an exception if something unexpected happens
+            ProcessingException e( getClassName() + ":" + u.what() );
+
+            GPSTK_THROW(e);
+        }
+
+        return gdsMap;
+
+    }  // End of method 'MeasUpdateSRIF::Process()'
+
+
+}  // End of namespace gpstk
@@ -0,0 +1,247 @@
+#pragma ident "$Id$"
+
+/**
+ * @file MeasUpdateSRIF.hpp
+ * Kalman filter (time and measurement updates) in square root information
+ * form.
+ */
+
+#ifndef GPSTK_MEASUPDATESRIF_HPP
+#define GPSTK_MEASUPDATESRIF_HPP
+
+//============================================================================
+//
+//  This file is part of GPSTk, the GPS Toolkit.
+//
+//  The GPSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 2.1 of the License, or
+//  any later version.
+//
+//  The GPSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GPSTk; if not, write to the Free Software Foundation,
+//  Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//============================================================================
+
+
+#include <vector>
+
+#include "MeasUpdate.hpp"
+
+
+namespace gpstk
+{
+
+    /** @addtogroup GPSsolutions */
+    /// @ingroup math
+
+    //@{
+
+    /** This class is a Kalman filter in square root information (SRIF)
+     *  form, doing both the time update of 'TimeUpdate' and the
+     *  measurement update of 'MeasUpdate'.
+     *
+     * It is programmed with the same 'EquationSystemEx' and stochastic
+     * models, and stores the updated state and covariance into the same
+     * 'StateStore', so it replaces the pair 'TimeUpdate' + 'MeasUpdate'.
+     * Do not run a 'TimeUpdate' before it.
+     *
+     * The information square root R and z = R*x are kept from epoch to
+     * epoch, with the variables in an order of their own:
+     *
+     *    \li Variables no longer processed are moved to the front of R by
+     *        Givens rotations and cut off, which leaves the information
+     *        of the others.
+     *    \li New variables are put in front, with a single element
+     *        1/sigma in their rows.
+     *    \li Variables with process noise (white noise, random walk,
+     *        ambiguities after a cycle slip...) are moved to the front,
+     *        and their time update is the QR factorization of their rows
+     *        and those of the noise. It costs O(n*k^2) for k such
+     *        variables, instead of O(n^3).
+     *
+     * Then R and z are updated with blocks of weighted equations by
+     * Householder transformations:
+     *
+     * @code
+     *   | R   z  |            | R'  z' |
+     *   | A   b  |   ---->    | 0   e  |
+     * @endcode
+     *
+     * Only the columns where the equations of the block, including the
+     * fill-in, are not zero are transformed, and each transformation
+     * touches only the rows of the block which are not zero in that
+     * column.
+     *
+     * The covariance P = inverse(R)*inverse(R)' given to the 'StateStore'
+     * is always symmetric and positive definite, even with very large
+     * initial variances and thousands of variables. Computing it is the
+     * only O(n^3) step of an epoch. Stochastic models whose Phi and Q
+     * matrices are not diagonal and whose Q is singular cannot be updated
+     * in SRIF form; at the epochs they appear, R is rebuilt from the
+     * covariance after a time update in covariance form.
+     *
+     * If another object changes the variables or the state in the
+     * 'StateStore' between two epochs (e.g. fixing ambiguities), R is
+     * rebuilt from the 'StateStore' at the next epoch.
+     *
+     * @code
+     *   MeasUpdateSRIF srifUpdate;
+     *   srifUpdate.addEquation2Source( equPC, source );
+     *   srifUpdate.setStateStore( stateStore );
+     *
+     *   srifUpdate.Process( gdsMap );
+     * @endcode
+     *
+     * @sa TimeUpdate.hpp, MeasUpdate.hpp, SRIFilter.hpp.
+     */
+    class MeasUpdateSRIF : public MeasUpdate
+    {
+    public:
+
+        /// Default constructor.
+        MeasUpdateSRIF()
+            : blockSize(64), haveSRIF(false)
+        {};
+
+
+        /** Explicit constructor.
+         *
+         * @param equationSys         Object describing an equation system to
+         *                            be solved.
+         */
+        MeasUpdateSRIF( const EquationSystemEx& equationSys )
+            : MeasUpdate(equationSys), blockSize(64), haveSRIF(false)
+        {};
+
+
+        /// Set the number of equations processed in every block
+        virtual MeasUpdateSRIF& setBlockSize(int size)
+        { blockSize = (size > 0) ? size : 1; return (*this); };
+
+
+        /// Get the number of equations processed in every block
+        virtual int getBlockSize() const
+        { return blockSize; };
+
+
+        /// Forget R and z, and start again from the 'StateStore' at the
+        /// next epoch.
+        virtual MeasUpdateSRIF& reset()
+        { haveSRIF = false; return (*this); };
+
+
+        /** Return a reference to a gnssDataMap object after the time and
+         *  measurement updates of the previously defined equation system.
+         *
+         * @param gdsMap    Data object holding the data.
+         */
+        virtual gnssDataMap& Process( gnssDataMap& gdsMap )
+            throw(ProcessingException);
+
+
+        /// Return a string identifying this object.
+        virtual std::string getClassName(void) const;
+
+
+        /// Destructor.
+        virtual ~MeasUpdateSRIF() {};
+
+
+    protected:
+
+        /// Number of equations processed in every block
+        int blockSize;
+
+
+    private:
+
+        /// Take R and z from the state and covariance of the 'StateStore'
+        void loadStateStore()
+            throw(InvalidSolver);
+
+
+        /// Whether the 'StateStore' holds what this object stored last
+        bool stateStoreUnchanged();
+
+
+        /** Time update of R and z, to the variables of the current epoch.
+         *
+         * @param gdsMap          Data of the epoch, for the stochastic
+         *                        models.
+         * @param currentUnknowns Variables of the epoch.
+         */
+        void timeUpdate( gnssDataMap& gdsMap,
+                         const VariableSet& currentUnknowns )
+            throw(InvalidSolver);
+
+
+        /** Get the information square root of a covariance matrix.
+         *
+         * @param cov     Covariance matrix, n x n.
+         * @param x       State vector, n.
+         * @param Rz      Returns R and z, n x (n+1), row-major.
+         */
+        static void covToInfo( const Matrix<double>& cov,
+                               const Vector<double>& x,
+                               std::vector<double>& Rz )
+            throw(InvalidSolver);
+
+
+        /** Update R and z with a block of weighted equations.
+         *
+         * @param n       Number of variables.
+         * @param Rz      R and z, n x (n+1), row-major.
+         * @param A       Equations and prefits, m x (n+1), row-major. It is
+         *                destroyed.
+         * @param m       Number of equations.
+         * @param minCol  First column not zero in the block.
+         */
+        static void householderUpdate( int n,
+                                       std::vector<double>& Rz,
+                                       std::vector<double>& A,
+                                       int m,
+                                       int minCol );
+
+
+        /** Get the state and covariance from R and z.
+         *
+         * @param n       Number of variables.
+         * @param Rz      R and z, n x (n+1), row-major.
+         * @param x       Returns the state vector.
+         * @param cov     Returns the covariance matrix.
+         */
+        static void infoToCov( int n,
+                               const std::vector<double>& Rz,
+                               Vector<double>& x,
+                               Matrix<double>& cov )
+            throw(InvalidSolver);
+
+
+        /// Whether R and z hold the filter of the last epoch
+        bool haveSRIF;
+
+        /// Variables of the columns of R
+        std::vector<Variable> srifVars;
+
+        /// R and z, n x (n+1), row-major
+        std::vector<double> srifRz;
+
+        /// Variables and state given to the 'StateStore' at the last epoch
+        VariableSet storedVars;
+        Vector<double> storedState;
+
+
+    }; // End of class 'MeasUpdateSRIF'
+
+    //@}
+
+}  // End of namespace gpstk
+
+#endif   // GPSTK_MEASUPDATESRIF_HPP
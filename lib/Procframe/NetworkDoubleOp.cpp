@@ -0,0 +1,400 @@
+#pragma ident "$Id$"
+
+/**
+ * @file NetworkDoubleOp.cpp
+ * This is a class to compute the double differences of all the baselines
+ * of a network in one pass over the GNSS data structures.
+ */
+
+//============================================================================
+//
+//  This file is part of GPSTk, the GPS Toolkit.
+//
+//  The GPSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 2.1 of the License, or
+//  any later version.
+//
+//  The GPSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GPSTk; if not, write to the Free Software Foundation,
+//  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+//
+//============================================================================
+
+
+#include <algorithm>
+
+#include "NetworkDoubleOp.hpp"
+
+
+namespace gpstk
+{
+
+      // Returns a string identifying this object.
+   std::string NetworkDoubleOp::getClassName() const
+   { return "NetworkDoubleOp"; }
+
+
+
+      // Default constructor.
+   NetworkDoubleOp::NetworkDoubleOp()
+      : refSatStrategy(Continuity), refSatMinElev(35.0)
+   {
+
+         // Insert default types to be differenced
+      diffTypes.insert(TypeID::prefitC);
+      diffTypes.insert(TypeID::dStaX);
+      diffTypes.insert(TypeID::dStaY);
+      diffTypes.insert(TypeID::dStaZ);
+
+   }  // End of constructor 'NetworkDoubleOp::NetworkDoubleOp()'
+
+
+
+      // Method to get the reference satellites of the given rover.
+   std::map<SatID::SatelliteSystem, SatID>
+   NetworkDoubleOp::getRefSats(const SourceID& rover) const
+   {
+
+      std::map<SourceID, std::map<SatID::SatelliteSystem, SatID> >::const_iterator
+         it = refSats.find(rover);
+
+      if( it == refSats.end() )
+      {
+         return std::map<SatID::SatelliteSystem, SatID>();
+      }
+
+      return it->second;
+
+   }  // End of method 'NetworkDoubleOp::getRefSats()'
+
+
+
+      // Choose the reference satellite of each system for a baseline.
+   void NetworkDoubleOp::selectRefSats( const SourceID& rover,
+                                        const StationBlock& roverBlock,
+                                        const std::vector<char>& common )
+   {
+
+      const int numSats( epochSats.size() );
+
+         // Highest common satellite of each system
+      std::map<SatID::SatelliteSystem, int> highest;
+      for(int s = 0; s < numSats; ++s)
+      {
+         if( !common[s] ) continue;
+
+         SatID::SatelliteSystem sys( epochSats[s].system );
+         std::map<SatID::SatelliteSystem, int>::iterator it = highest.find(sys);
+         if( it == highest.end() ||
+             roverBlock.elev[s] > roverBlock.elev[it->second] )
+         {
+            highest[sys] = s;
+         }
+      }
+
+      std::map<SatID::SatelliteSystem, SatID>& refs = refSats[rover];
+      std::map<SatID::SatelliteSystem, SatID> newRefs;
+
+      std::map<SatID::SatelliteSystem, int>::const_iterator it;
+      for(it = highest.begin(); it != highest.end(); ++it)
+      {
+         newRefs[it->first] = epochSats[it->second];
+
+         if( refSatStrategy != Continuity ) continue;
+
+            // Keep the previous reference satellite if it is still usable
+         std::map<SatID::SatelliteSystem, SatID>::const_iterator itPrev =
+            refs.find(it->first);
+         if( itPrev == refs.end() ) continue;
+
+         std::vector<SatID>::const_iterator pos =
+            std::lower_bound(epochSats.begin(), epochSats.end(), itPrev->second);
+         if( pos == epochSats.end() || *pos != itPrev->second ) continue;
+
+         int s( pos - epochSats.begin() );
+         if( common[s] && roverBlock.elev[s] >= refSatMinElev )
+         {
+            newRefs[it->first] = itPrev->second;
+         }
+      }
+
+      refs = newRefs;
+
+   }  // End of method 'NetworkDoubleOp::selectRefSats()'
+
+
+
+      /* Returns a reference to a sourceDataMap object after computing
+       * the double differences of all the baselines.
+       *
+       * @param epoch      Epoch of the data.
+       * @param gData      Data object holding the data.
+       */
+   sourceDataMap& NetworkDoubleOp::Process( const CommonTime& epoch,
+                                            sourceDataMap& gData )
+      throw(ProcessingException)
+   {
+
+      ddData.clear();
+
+      return processEpoch(epoch, gData);
+
+   }  // End of method 'NetworkDoubleOp::Process()'
+
+
+
+      /* Computes the double differences of all the baselines of one
+       * epoch, adding them to 'ddData'.
+       *
+       * @param epoch      Epoch of the data.
+       * @param gData      Data object holding the data.
+       */
+   sourceDataMap& NetworkDoubleOp::processEpoch( const CommonTime& epoch,
+                                                 sourceDataMap& gData )
+      throw(ProcessingException)
+   {
+
+      try
+      {
+
+         SatIDSet satSet( gData.getSatIDSet() );
+         epochSats.assign( satSet.begin(), satSet.end() );
+
+         std::vector<TypeID> types( diffTypes.begin(), diffTypes.end() );
+
+         const int numSats( epochSats.size() );
+         const int numTypes( types.size() );
+
+         if( numSats == 0 || numTypes == 0 ) return gData;
+
+
+            // Copy the data of every station into its dense block. Both
+            // 'epochSats' and the satTypeValueMap are sorted by SatID, so
+            // the row of each satellite is found by walking them together.
+         std::map<SourceID, StationBlock> blocks;
+
+         for( sourceDataMap::const_iterator sdmIt = gData.begin();
+              sdmIt != gData.end();
+              ++sdmIt )
+         {
+            StationBlock& block = blocks[sdmIt->first];
+            block.obs.assign(numSats*numTypes, 0.0);
+            block.has.assign(numSats, 0);
+            block.elev.assign(numSats, -90.0);
+
+            int s(0);
+            for( satTypeValueMap::const_iterator stvIt = sdmIt->second.begin();
+                 stvIt != sdmIt->second.end();
+                 ++stvIt )
+            {
+               while( epochSats[s] < stvIt->first ) ++s;
+
+               const typeValueMap& tvMap = stvIt->second;
+
+               typeValueMap::const_iterator itElev = tvMap.find(TypeID::elevation);
+               if( itElev != tvMap.end() ) block.elev[s] = itElev->second;
+
+               bool hasAll(true);
+               for(int k = 0; k < numTypes; ++k)
+               {
+                  typeValueMap::const_iterator itType = tvMap.find(types[k]);
+                  if( itType == tvMap.end() )
+                  {
+                     hasAll = false;
+                     break;
+                  }
+                  block.obs[s*numTypes + k] = itType->second;
+               }
+
+               block.has[s] = hasAll;
+            }
+         }
+
+
+            // Baselines of this epoch: the given ones, or a star network
+         std::map<SourceID, SourceID> epochBaselines(baselines);
+         if( epochBaselines.empty() )
+         {
+            SourceID hub( refSourceID );
+            if( gData.find(hub) == gData.end() ) hub = gData.begin()->first;
+
+            for( sourceDataMap::const_iterator sdmIt = gData.begin();
+                 sdmIt != gData.end();
+                 ++sdmIt )
+            {
+               if( sdmIt->first != hub ) epochBaselines[sdmIt->first] = hub;
+            }
+         }
+
+
+         DDTypeValueMap& ddMap = ddData[epoch];
+
+         std::vector<char> common(numSats);
+         std::vector<double> sd(numSats*numTypes);
+         std::vector<double> dd(numSats*numTypes);
+
+            // Rovers whose reference station has no data at this epoch
+         SourceIDSet sourceRejectedSet;
+
+         std::map<SourceID, SourceID>::const_iterator blIt;
+         for(blIt = epochBaselines.begin(); blIt != epochBaselines.end(); ++blIt)
+         {
+            const SourceID& rover = blIt->first;
+            const SourceID& reference = blIt->second;
+
+            std::map<SourceID, StationBlock>::const_iterator itRover =
+               blocks.find(rover);
+            if( itRover == blocks.end() ) continue;
+
+            std::map<SourceID, StationBlock>::const_iterator itRef =
+               blocks.find(reference);
+            if( itRef == blocks.end() )
+            {
+               sourceRejectedSet.insert(rover);
+               continue;
+            }
+
+            const StationBlock& roverBlock = itRover->second;
+            const StationBlock& refBlock = itRef->second;
+
+               // Single differences between stations
+            for(int s = 0; s < numSats; ++s)
+            {
+               common[s] = roverBlock.has[s] && refBlock.has[s];
+            }
+
+            for(int i = 0; i < numSats*numTypes; ++i)
+            {
+               sd[i] = roverBlock.obs[i] - refBlock.obs[i];
+            }
+
+            selectRefSats(rover, roverBlock, common);
+            const std::map<SatID::SatelliteSystem, SatID>& refs = refSats[rover];
+
+               // Row of the reference satellite of each satellite, or -1
+            std::map<SatID::SatelliteSystem, int> refRows;
+            std::map<SatID::SatelliteSystem, SatID>::const_iterator itRefSat;
+            for(itRefSat = refs.begin(); itRefSat != refs.end(); ++itRefSat)
+            {
+               refRows[itRefSat->first] =
+                  std::lower_bound( epochSats.begin(), epochSats.end(),
+                                    itRefSat->second ) - epochSats.begin();
+            }
+
+            std::vector<int> refRow(numSats, -1);
+            for(int s = 0; s < numSats; ++s)
+            {
+               std::map<SatID::SatelliteSystem, int>::const_iterator it =
+                  refRows.find(epochSats[s].system);
+               if( common[s] && it != refRows.end() && it->second != s )
+               {
+                  refRow[s] = it->second;
+               }
+            }
+
+               // Double differences between satellites
+            for(int s = 0; s < numSats; ++s)
+            {
+               if( refRow[s] < 0 ) continue;
+
+               const double* sdSat = &sd[s*numTypes];
+               const double* sdRef = &sd[refRow[s]*numTypes];
+               double* ddSat = &dd[s*numTypes];
+               for(int k = 0; k < numTypes; ++k)
+               {
+                  ddSat[k] = sdSat[k] - sdRef[k];
+               }
+            }
+
+
+               // Write the double differences into the rover data
+            satTypeValueMap& roverData = gData[rover];
+            SatIDSet satRejectedSet;
+
+            int s(0);
+            for( satTypeValueMap::iterator stvIt = roverData.begin();
+                 stvIt != roverData.end();
+                 ++stvIt )
+            {
+               while( epochSats[s] < stvIt->first ) ++s;
+
+               if( refRow[s] < 0 )
+               {
+                  satRejectedSet.insert(stvIt->first);
+                  continue;
+               }
+
+               typeValueMap ddValues;
+               for(int k = 0; k < numTypes; ++k)
+               {
+                  stvIt->second[types[k]] = dd[s*numTypes + k];
+                  ddValues[types[k]] = dd[s*numTypes + k];
+               }
+
+               const SatID& refSat = epochSats[refRow[s]];
+               DDid ddid( reference.sourceName, rover.sourceName,
+                          GSatID(refSat.id, refSat.system),
+                          GSatID(stvIt->first.id, stvIt->first.system) );
+
+               ddMap[ddid] = ddValues;
+            }
+
+            roverData.removeSatID(satRejectedSet);
+
+         }  // End of 'for(blIt = epochBaselines.begin(); ...'
+
+            // Their undifferenced data must not be mixed with the DD data
+         for( SourceIDSet::const_iterator itSource = sourceRejectedSet.begin();
+              itSource != sourceRejectedSet.end();
+              ++itSource )
+         {
+            gData.erase(*itSource);
+         }
+
+         return gData;
+
+      }
+      catch(Exception& u)
+      {
+            // Throw an exception if something unexpected happens
+         ProcessingException e( getClassName() + ":"
+                                + u.what() );
+
+         GPSTK_THROW(e);
+
+      }
+
+   }  // End of method 'NetworkDoubleOp::Process()'
+
+
+
+      /* Returns a reference to a gnssDataMap object after computing
+       * the double differences of all the baselines.
+       *
+       * @param gData      Data object holding the data.
+       */
+   gnssDataMap& NetworkDoubleOp::Process(gnssDataMap& gData)
+      throw(ProcessingException)
+   {
+
+      ddData.clear();
+
+      for( gnssDataMap::iterator gdmIt = gData.begin();
+           gdmIt != gData.end();
+           ++gdmIt )
+      {
+         processEpoch( gdmIt->first, gdmIt->second );
+      }
+
+      return gData;
+
+   }  // End of method 'NetworkDoubleOp::Process()'
+
+
+}  // End of namespace gpstk
@@ -0,0 +1,321 @@
+#pragma ident "$Id$"
+
+/**
+ * @file NetworkDoubleOp.hpp
+ * This is a class to compute the double differences of all the baselines
+ * of a network in one pass over the GNSS data structures.
+ */
+
+#ifndef GPSTK_NETWORKDOUBLEOP_HPP
+#define GPSTK_NETWORKDOUBLEOP_HPP
+
+//============================================================================
+//
+//  This file is part of GPSTk, the GPS Toolkit.
+//
+//  The GPSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 2.1 of the License, or
+//  any later version.
+//
+//  The GPSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GPSTk; if not, write to the Free Software Foundation,
+//  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+//
+//============================================================================
+
+
+#include <vector>
+#include <map>
+
+#include "ProcessingClass.hpp"
+#include "DDid.hpp"
+
+
+namespace gpstk
+{
+
+      /** @addtogroup GPSsolutions */
+      //@{
+
+      /// Double-differenced values of one epoch, indexed by DDid.
+   typedef std::map<DDid, typeValueMap> DDTypeValueMap;
+
+      /// Double-differenced values indexed by epoch.
+   typedef std::map<CommonTime, DDTypeValueMap> epochDDTypeValueMap;
+
+
+      /** This class computes the double differences (between stations and
+       *  between satellites) of all the baselines of a network, working on
+       *  a gnssDataMap. It does the job of DeltaOp + NablaOp (DoubleOp) for
+       *  every baseline at once.
+       *
+       * At each epoch, the types to be differenced of every station are
+       * copied once into a dense (satellite x type) matrix, with a mask of
+       * the satellites having all of them. Single and double differences are
+       * then plain loops over those matrices, instead of a map lookup per
+       * (satellite, type) pair and baseline.
+       *
+       * A typical way to use this class follows:
+       *
+       * @code
+       *   NetworkDoubleOp ddOp;
+       *   ddOp.setDiffTypeSet(types);
+       *   ddOp.setRefSource(hubStation);      // star network around 'hub'
+       *   ddOp.setRefSatStrategy(NetworkDoubleOp::Continuity);
+       *
+       *   while( obsStreams.readEpochData(gData) )
+       *   {
+       *      gData >> basic >> ... >> ddOp >> solver;
+       *   }
+       * @endcode
+       *
+       * The baselines are given with 'addBaseline()'. When none is given, a
+       * star network is formed around 'refSource' (or the first source of
+       * the epoch if none is set).
+       *
+       * For each baseline, a reference satellite is chosen per satellite
+       * system among the satellites common to both stations, and the data of
+       * the rover station are REPLACED with the double differences
+       *
+       *    (rover - refStation)(sat) - (rover - refStation)(refSat)
+       *
+       * for all the types in 'diffTypes'; the reference satellites and the
+       * satellites missing any of those types at any of the two stations
+       * are REMOVED from the rover data, as DoubleOp does. A rover whose
+       * reference station has no data at the epoch is REMOVED altogether,
+       * so that no undifferenced data is left next to the DD data. The
+       * data of the reference stations are left untouched, and differences
+       * are always computed from the data as they were before this
+       * processor.
+       *
+       * The double differences are also kept in a DDTypeValueMap, available
+       * with 'getDDData()'. Values are stored as computed above, i.e. with
+       * DDid(refStation, rover, refSat, sat); use DDid::ssite*DDid::ssat for
+       * the sign with respect to DDid's own ordering.
+       *
+       * Reference satellite strategies:
+       *
+       *    \li HighestElevation: the common satellite with highest elevation
+       *        at the rover, each epoch.
+       *    \li Continuity: the previous reference satellite of the baseline
+       *        is kept while it is common and above 'refSatMinElev' degrees,
+       *        so that the DD ambiguities are not re-parameterized; otherwise
+       *        the highest one is taken. This is the default.
+       *
+       * @sa DoubleOp.hpp, DeltaOp.hpp and NablaOp.hpp.
+       */
+   class NetworkDoubleOp : public ProcessingClass
+   {
+   public:
+
+         /// Strategies to choose the reference satellites
+      enum RefSatStrategy
+      {
+         HighestElevation = 0,
+         Continuity
+      };
+
+
+         /** Default constructor.
+          *
+          * By default it will difference prefitC, dx, dy, and dz data, and
+          * keep the reference satellites while they are above 35 degrees.
+          */
+      NetworkDoubleOp();
+
+
+         /// Method to set data type values to be differenced.
+      virtual NetworkDoubleOp& setDiffType(const TypeID& difftype)
+      { diffTypes.clear(); diffTypes.insert(difftype); return (*this); };
+
+
+         /// Method to add a data value type to be differenced.
+      virtual NetworkDoubleOp& addDiffType(const TypeID& difftype)
+      { diffTypes.insert(difftype); return (*this); };
+
+
+         /// Method to establish a set of data values to be differenced.
+      virtual NetworkDoubleOp& setDiffTypeSet(const TypeIDSet& diffSet)
+      { diffTypes = diffSet; return (*this); };
+
+
+         /// Method to get the set of data value types to be differenced.
+      virtual TypeIDSet getDiffTypeSet(void) const
+      { return diffTypes; };
+
+
+         /// Method to set the hub of the default star network.
+      virtual NetworkDoubleOp& setRefSource(const SourceID& refSource)
+      { refSourceID = refSource; return (*this); };
+
+
+         /// Method to get the hub of the default star network.
+      virtual SourceID getRefSource(void) const
+      { return refSourceID; };
+
+
+         /** Method to add a baseline. A rover can only have one reference
+          *  station; adding it again replaces its reference station.
+          *
+          * @param rover       station whose data will be replaced by DD
+          * @param reference   reference station of the baseline
+          */
+      virtual NetworkDoubleOp& addBaseline( const SourceID& rover,
+                                            const SourceID& reference )
+      { baselines[rover] = reference; return (*this); };
+
+
+         /// Method to remove all the baselines (go back to a star network).
+      virtual NetworkDoubleOp& clearBaselines(void)
+      { baselines.clear(); return (*this); };
+
+
+         /// Method to set the reference satellite strategy.
+      virtual NetworkDoubleOp& setRefSatStrategy(RefSatStrategy strategy)
+      { refSatStrategy = strategy; return (*this); };
+
+
+         /// Method to get the reference satellite strategy.
+      virtual RefSatStrategy getRefSatStrategy(void) const
+      { return refSatStrategy; };
+
+
+         /// Method to set the minimum elevation (degrees) to keep a
+         /// reference satellite with the 'Continuity' strategy.
+      virtual NetworkDoubleOp& setRefSatMinElevation(const double& minElev)
+      { refSatMinElev = minElev; return (*this); };
+
+
+         /// Method to get the minimum elevation of the reference satellites.
+      virtual double getRefSatMinElevation(void) const
+      { return refSatMinElev; };
+
+
+         /// Method to get the reference satellite of each system for the
+         /// given rover at the last epoch processed.
+      virtual std::map<SatID::SatelliteSystem, SatID>
+      getRefSats(const SourceID& rover) const;
+
+
+         /// Method to get the double differences of the last call to
+         /// Process(), indexed by epoch. Each call clears them first.
+      virtual const epochDDTypeValueMap& getDDData(void) const
+      { return ddData; };
+
+
+         /** Returns a reference to a gnssSatTypeValue object. A single
+          *  station has no baseline: data are returned untouched.
+          *
+          * @param gData      Data object holding the data.
+          */
+      virtual gnssSatTypeValue& Process(gnssSatTypeValue& gData)
+         throw(ProcessingException)
+      { return gData; };
+
+
+         /** Returns a reference to a gnssRinex object. A single station has
+          *  no baseline: data are returned untouched.
+          *
+          * @param gData      Data object holding the data.
+          */
+      virtual gnssRinex& Process(gnssRinex& gData)
+         throw(ProcessingException)
+      { return gData; };
+
+
+         /** Returns a reference to a sourceDataMap object after computing
+          *  the double differences of all the baselines.
+          *
+          * @param epoch      Epoch of the data.
+          * @param gData      Data object holding the data.
+          */
+      virtual sourceDataMap& Process( const CommonTime& epoch,
+                                      sourceDataMap& gData )
+         throw(ProcessingException);
+
+
+         /** Returns a reference to a gnssDataMap object after computing
+          *  the double differences of all the baselines.
+          *
+          * @param gData      Data object holding the data.
+          */
+      virtual gnssDataMap& Process(gnssDataMap& gData)
+         throw(ProcessingException);
+
+
+         /// Returns a string identifying this object.
+      virtual std::string getClassName(void) const;
+
+
+         /// Destructor.
+      virtual ~NetworkDoubleOp() {};
+
+
+   private:
+
+
+         /// Dense data of one station at the current epoch
+      struct StationBlock
+      {
+            /// Values, row-major (satellite x type)
+         std::vector<double> obs;
+
+            /// 1 if the satellite has all the types to be differenced
+         std::vector<char> has;
+
+            /// Elevation of each satellite (degrees)
+         std::vector<double> elev;
+      };
+
+
+         /// Compute the double differences of one epoch, adding them to
+         /// 'ddData'
+      sourceDataMap& processEpoch( const CommonTime& epoch,
+                                   sourceDataMap& gData )
+         throw(ProcessingException);
+
+
+         /// Choose the reference satellite of each system for a baseline
+      void selectRefSats( const SourceID& rover,
+                          const StationBlock& roverBlock,
+                          const std::vector<char>& common );
+
+
+         /// Set (TypeIDSet) containing the types of data to be differenced.
+      TypeIDSet diffTypes;
+
+         /// Hub of the default star network
+      SourceID refSourceID;
+
+         /// Baselines, rover -> reference station
+      std::map<SourceID, SourceID> baselines;
+
+         /// Strategy to choose reference satellites
+      RefSatStrategy refSatStrategy;
+
+         /// Minimum elevation to keep a reference satellite (degrees)
+      double refSatMinElev;
+
+         /// Satellites of the current epoch and their row in the blocks
+      std::vector<SatID> epochSats;
+
+         /// Reference satellite per rover and system
+      std::map<SourceID, std::map<SatID::SatelliteSystem, SatID> > refSats;
+
+         /// Double differences of the last call to Process()
+      epochDDTypeValueMap ddData;
+
+
+   }; // End of class 'NetworkDoubleOp'
+
+      //@}
+
+}  // End of namespace gpstk
+
+#endif   // GPSTK_NETWORKDOUBLEOP_HPP
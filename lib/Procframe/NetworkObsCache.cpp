@@ -0,0 +1,322 @@
+#pragma ident "$Id$"
+
+/**
+ * @file NetworkObsCache.cpp
+ * Read the observation epochs of a network from binary caches of the
+ * RINEX files.
+ */
+
+//============================================================================
+//
+//  This file is part of GPSTk, the GPS Toolkit.
+//
+//  The GPSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 2.1 of the License, or
+//  any later version.
+//
+//  The GPSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GPSTk; if not, write to the Free Software Foundation,
+//  Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//============================================================================
+
+
+#include <sstream>
+#include "NetworkObsCache.hpp"
+#include "Rinex3ObsStream.hpp"
+
+using namespace std;
+
+
+namespace gpstk
+{
+
+      // Add a RINEX observation file to the network
+    bool NetworkObsCache::addRinexObsFile(const std::string& obsFile)
+    {
+        string cacheFile( cacheFileOf(obsFile) );
+
+        try
+        {
+            if( !BinaryObsCache::isUpToDate(obsFile, cacheFile) )
+            {
+                BinaryObsCache::convert(obsFile, cacheFile);
+            }
+        }
+        catch(...)
+        {
+            // Problem reading the file, or writing the cache
+            return false;
+        }
+
+        return addCacheFile(cacheFile);
+
+    }  // End of method 'NetworkObsCache::addRinexObsFile()'
+
+
+
+      // Add the cache of a RINEX observation file to the network.
+    bool NetworkObsCache::addCacheFile(const std::string& cacheFile)
+    {
+        BinaryObsCache* pCache( new BinaryObsCache );
+
+        try
+        {
+            pCache->open(cacheFile);
+        }
+        catch(...)
+        {
+            delete pCache;
+            return false;
+        }
+
+        SourceID source( pCache->getSource() );
+
+        if( mapSourceCache.find(source) != mapSourceCache.end() )
+        {
+            // The station is already in the network
+            delete pCache;
+            return false;
+        }
+
+        caches.push_back(pCache);
+        mapSourceCache[source] = pCache;
+
+        referenceSource = source;
+
+        return true;
+
+    }  // End of method 'NetworkObsCache::addCacheFile()'
+
+
+
+      // Get the cache of a RINEX observation file
+    std::string NetworkObsCache::cacheFileOf(const std::string& obsFile) const
+    {
+        if( cacheDirectory.empty() ) return obsFile + ".obc";
+
+        string::size_type pos( obsFile.find_last_of("/\\") );
+        string name( (pos == string::npos) ? obsFile
+                                           : obsFile.substr(pos + 1) );
+
+        return cacheDirectory + "/" + name + ".obc";
+
+    }  // End of method 'NetworkObsCache::cacheFileOf()'
+
+
+
+      // Read only the epochs of the reference station within a time span.
+    NetworkObsCache& NetworkObsCache::setEpochRange( const CommonTime& start,
+                                                     const CommonTime& end )
+    {
+        haveStart = true;
+        haveEnd = true;
+        startEpoch = start;
+        endEpoch = end;
+
+        started = false;
+
+        return (*this);
+
+    }  // End of method 'NetworkObsCache::setEpochRange()'
+
+
+
+      // Get epoch data of the network
+    bool NetworkObsCache::readEpochData(gnssDataMap& gdsMap)
+        throw(SynchronizeException)
+    {
+        // First, We clear the data map
+        gdsMap.clear();
+
+        BinaryObsCache* pRef( getObsCache(referenceSource) );
+        if(pRef == NULL) return false;
+
+        if(!started)
+        {
+            pRef->seekEpoch(0);
+            if(haveStart) pRef->seek(startEpoch);
+
+            started = true;
+        }
+
+        if( pRef->tell() >= pRef->getNumEpochs() ) return false;
+
+        if( haveEnd && pRef->getEpoch( pRef->tell() ) > endEpoch )
+        {
+            return false;
+        }
+
+        // The data of every station go to an arena of their own
+        EpochArena::Scope refScope( useEpochArena ? getFreeArena() : NULL );
+
+        gnssRinex gRef;
+
+        try
+        {
+            pRef->readEpoch(gRef);
+        }
+        catch(...)
+        {
+            // The cache is corrupted
+            return false;
+        }
+
+        gdsMap.addGnssRinex(gRef);
+
+        for(size_t i = 0; i < caches.size(); ++i)
+        {
+            if( caches[i] == pRef ) continue;
+
+            EpochArena::Scope scope( useEpochArena ? getFreeArena() : NULL );
+
+            bool found(false);
+            gnssRinex gRin;
+
+            try
+            {
+                long index( caches[i]->findEpoch( gRef.header.epoch,
+                                                  tolerance ) );
+                if(index >= 0)
+                {
+                    caches[i]->readEpoch(index, gRin);
+                    found = true;
+                }
+            }
+            catch(...)
+            {
+                found = false;
+            }
+
+            if(found)
+            {
+                gdsMap.addGnssRinex(gRin);
+            }
+            else if(synchronizeException)
+            {
+                std::stringstream ss;
+                ss << "Exception when try to synchronize at epoch: "
+                   << gRef.header.epoch << std::endl;
+
+                SynchronizeException e(ss.str());
+
+                GPSTK_THROW(e);
+            }
+        }
+
+        return true;
+
+    }  // End of method 'NetworkObsCache::readEpochData()'
+
+
+
+      // Get the SourceID of a RINEX observation file, or of its cache
+    SourceID NetworkObsCache::sourceIDOfRinexObsFile(const std::string& obsFile)
+    {
+        // The cache of the file, or the file itself, may be read at once
+        const string files[2] = { cacheFileOf(obsFile), obsFile };
+
+        for(int i = 0; i < 2; ++i)
+        {
+            try
+            {
+                if( i == 0 && !BinaryObsCache::isUpToDate(obsFile, files[0]) )
+                {
+                    continue;
+                }
+
+                BinaryObsCache cache(files[i]);
+                return cache.getSource();
+            }
+            catch(...)
+            {
+            }
+        }
+
+        try
+        {
+            Rinex3ObsStream rin;
+            rin.exceptions(std::ios::failbit);
+            rin.open(obsFile.c_str(), std::ios::in);
+
+            gnssRinex gRin;
+            rin >> gRin;
+
+            rin.close();
+
+            return gRin.header.source;
+        }
+        catch(...)
+        {
+            Exception e("Problem opening the file "
+                        + obsFile
+                        + ". Maybe it doesn't exist or you don't have proper"
+                        + " read permissions");
+
+            GPSTK_THROW(e);
+        }
+
+    }  // End of method 'NetworkObsCache::sourceIDOfRinexObsFile()'
+
+
+
+      // Get the cache of a source
+    BinaryObsCache* NetworkObsCache::getObsCache(const SourceID& source)
+    {
+        std::map<SourceID, BinaryObsCache*>::iterator it(
+                                                mapSourceCache.find(source) );
+
+        return (it != mapSourceCache.end()) ? it->second : NULL;
+
+    }  // End of method 'NetworkObsCache::getObsCache()'
+
+
+
+      // Get an arena with no live data, reset
+    EpochArena* NetworkObsCache::getFreeArena()
+    {
+        for(size_t i = 0; i < arenaPool.size(); ++i)
+        {
+            if( arenaPool[i]->reset() )
+            {
+                return arenaPool[i];
+            }
+        }
+
+        arenaPool.push_back( new EpochArena() );
+
+        return arenaPool.back();
+
+    }  // End of method 'NetworkObsCache::getFreeArena()'
+
+
+
+      // Do some clean operation
+    void NetworkObsCache::cleanUp()
+    {
+        for(size_t i = 0; i < caches.size(); ++i)
+        {
+            delete caches[i];
+        }
+
+        caches.clear();
+        mapSourceCache.clear();
+
+        // Arenas still holding data are deleted with their last block
+        for(size_t i = 0; i < arenaPool.size(); ++i)
+        {
+            arenaPool[i]->retire();
+        }
+
+        arenaPool.clear();
+
+    }  // End of method 'NetworkObsCache::cleanUp()'
+
+
+}  // End of namespace gpstk
@@ -0,0 +1,226 @@
+#pragma ident "$Id$"
+
+/**
+ * @file NetworkObsCache.hpp
+ * Read the observation epochs of a network from binary caches of the
+ * RINEX files.
+ */
+
+#ifndef GPSTK_NETWORKOBSCACHE_HPP
+#define GPSTK_NETWORKOBSCACHE_HPP
+
+//============================================================================
+//
+//  This file is part of GPSTk, the GPS Toolkit.
+//
+//  The GPSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 2.1 of the License, or
+//  any later version.
+//
+//  The GPSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GPSTk; if not, write to the Free Software Foundation,
+//  Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//============================================================================
+
+
+#include <map>
+#include <string>
+#include <vector>
+#include "DataStructures.hpp"
+#include "Synchronize.hpp"
+#include "EpochArena.hpp"
+#include "EpochPipeline.hpp"
+#include "BinaryObsCache.hpp"
+
+
+namespace gpstk
+{
+
+    /// @ingroup DataStructures
+    //@{
+
+    /** This class reads the observation epochs of a network from binary
+     *  caches of the RINEX files (see BinaryObsCache), with the same
+     *  interface as NetworkObsStreams.
+     *
+     * The cache of every RINEX file is written the first time the file is
+     * added, or when the file is newer than its cache, and is read in the
+     * next runs instead of the file:
+     *
+     * @code
+     *   NetworkObsCache network;
+     *   network.setCacheDirectory("cache");
+     *
+     *   network.addRinexObsFile("obs/onsa0010.15o");
+     *   network.addRinexObsFile("obs/wtzr0010.15o");
+     *
+     *   network.setEpochRange( CivilTime(2015,1,1,6,0,0.0),
+     *                          CivilTime(2015,1,1,12,0,0.0) );
+     *
+     *   gnssDataMap gdsMap;
+     *   while( network.readEpochData(gdsMap) )
+     *   {
+     *      // processing code here
+     *   }
+     * @endcode
+     *
+     * The epochs of the reference station are given in order; those of the
+     * rest of the stations are looked for in the index of their caches,
+     * within the synchronization tolerance, so any span of the files may be
+     * read without reading the epochs before it. As in NetworkObsStreams,
+     * the stations not synchronized are skipped, or a SynchronizeException
+     * is thrown if 'setSynchronizeException(true)' was used, and the data
+     * of every station are allocated from an EpochArena of their own.
+     *
+     * It may be the source of an EpochPipeline.
+     */
+    class NetworkObsCache : public EpochSource
+    {
+    public:
+
+        /// Default constructor
+        NetworkObsCache()
+            : synchronizeException(false), useEpochArena(true),
+              tolerance(1.0), haveStart(false), haveEnd(false),
+              started(false)
+        {};
+
+        /// Destructor
+        virtual ~NetworkObsCache()
+        { cleanUp(); };
+
+
+        /** Add a RINEX observation file to the network, writing its cache
+         *  if it does not exist or is older than the file.
+         *
+         * @param obsFile   RINEX observation file.
+         *
+         * @return  Whether the file was added.
+         */
+        bool addRinexObsFile(const std::string& obsFile);
+
+        /** Add the cache of a RINEX observation file to the network.
+         *
+         * @param cacheFile Cache written with BinaryObsCache::convert().
+         *
+         * @return  Whether the cache was added.
+         */
+        bool addCacheFile(const std::string& cacheFile);
+
+
+        /// Set the directory of the caches; by default, they are written
+        /// next to the RINEX files.
+        NetworkObsCache& setCacheDirectory(const std::string& dir)
+        { cacheDirectory = dir; return (*this); };
+
+        /// Get the cache of a RINEX observation file
+        std::string cacheFileOf(const std::string& obsFile) const;
+
+
+        /** Sets the source of reference data.
+         *
+         * @param refSource      Reference SourceID of the network.
+         */
+        void setReferenceSource(const SourceID& refSource)
+        { referenceSource = refSource; };
+
+        void setSynchronizeException(const bool& synException = true)
+        { synchronizeException = synException; };
+
+        /// Set the synchronization tolerance, in seconds. By default, 1 s.
+        NetworkObsCache& setTolerance(double tol)
+        { tolerance = tol; return (*this); };
+
+        /// Set whether the epoch data are allocated from arenas. By
+        /// default, it is set to true.
+        void setUseEpochArena(bool useArena)
+        { useEpochArena = useArena; };
+
+        /// Get whether the epoch data are allocated from arenas
+        bool getUseEpochArena() const
+        { return useEpochArena; };
+
+
+        /// Read only the epochs of the reference station within a time
+        /// span.
+        NetworkObsCache& setEpochRange( const CommonTime& start,
+                                        const CommonTime& end );
+
+
+        /// Get epoch data of the network
+        /// @gdsMap  Object hold epoch observation data of the network
+        /// @return  Is there more epoch data for the network
+        virtual bool readEpochData(gnssDataMap& gdsMap)
+            throw(SynchronizeException);
+
+
+        /// Get the SourceID of a RINEX observation file, or of its cache
+        SourceID sourceIDOfRinexObsFile(const std::string& obsFile);
+
+        /// Get the cache of a source
+        BinaryObsCache* getObsCache(const SourceID& source);
+
+
+        /// Returns a string identifying this object.
+        virtual std::string getClassName(void) const
+        { return "NetworkObsCache"; };
+
+
+    private:
+
+        /// Caches of the network, in order of addition
+        std::vector<BinaryObsCache*> caches;
+
+        /// Map to easy access the caches by 'SourceID'
+        std::map<SourceID, BinaryObsCache*> mapSourceCache;
+
+        /// Directory of the caches
+        std::string cacheDirectory;
+
+        /// Reference source
+        SourceID referenceSource;
+
+        /// Flag indicate will throw 'SynchronizeException'
+        bool synchronizeException;
+
+        /// Whether the epoch data are allocated from arenas
+        bool useEpochArena;
+
+        /// Synchronization tolerance
+        double tolerance;
+
+        /// Span of the epochs
+        bool haveStart;
+        bool haveEnd;
+        CommonTime startEpoch;
+        CommonTime endEpoch;
+
+        /// Whether the first epoch was read
+        bool started;
+
+        /// Arenas of the epoch data
+        std::vector<EpochArena*> arenaPool;
+
+        /// Get an arena with no live data, reset
+        EpochArena* getFreeArena();
+
+        /// Do some clean operation
+        void cleanUp();
+
+        NetworkObsCache(const NetworkObsCache&);
+        NetworkObsCache& operator=(const NetworkObsCache&);
+
+    }; // End of class 'NetworkObsCache'
+
+    //@}
+
+}  // End of namespace gpstk
+
+#endif   // GPSTK_NETWORKOBSCACHE_HPP
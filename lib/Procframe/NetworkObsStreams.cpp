@@ -78,6 +78,7 @@ namespace gpstk
 
          oData.obsSource.type = SatIDsystem2SourceIDtype(obsHeader.fileSysSat);
          oData.obsSource.sourceName = obsHeader.markerName;
+         oData.obsSource.sourceNumber = obsHeader.markerNumber;
 
          oData.pSynchro->setReferenceSource(*oData.pObsStream);
 
@@ -119,6 +120,9 @@ namespace gpstk
 
       gnssRinex gRef;
 
+         // The data of every station go to an arena of their own
+      EpochArena::Scope refScope( useEpochArena ? getFreeArena() : NULL );
+
       if( (*pRefObsStream) >> gRef )
       {
          gdsMap.addGnssRinex(gRef);
@@ -130,6 +134,8 @@ namespace gpstk
          {
             if( it->first == referenceSource) continue;
 
+            EpochArena::Scope scope( useEpochArena ? getFreeArena() : NULL );
+
             Synchronize* synchro = mapSourceSynchro[it->first];
             synchro->setRoverData(gRef);
 
@@ -191,8 +197,34 @@ namespace gpstk
 
       allStreamData.clear();
 
+         // Arenas still holding data are deleted with their last block
+      for(size_t i = 0; i < arenaPool.size(); ++i)
+      {
+         arenaPool[i]->retire();
+      }
+
+      arenaPool.clear();
+
    }  // End of method 'NetworkObsStreams::cleanUp()'
 
+
+      // Get an arena with no live data, reset
+   EpochArena* NetworkObsStreams::getFreeArena()
+   {
+      for(size_t i = 0; i < arenaPool.size(); ++i)
+      {
+         if( arenaPool[i]->reset() )
+         {
+            return arenaPool[i];
+         }
+      }
+
+      arenaPool.push_back( new EpochArena() );
+
+      return arenaPool.back();
+
+   }  // End of method 'NetworkObsStreams::getFreeArena()'
+
       // Get the SourceID of the rinex observation file
    SourceID NetworkObsStreams::sourceIDOfRinexObsFile(std::string obsFile)
    {
@@ -47,9 +47,11 @@
 #include <string>
 #include <list>
 #include <map>
+#include <vector>
 #include "Rinex3ObsStream.hpp"
 #include "DataStructures.hpp"
 #include "Synchronize.hpp"
+#include "EpochArena.hpp"
 
 namespace gpstk
 {
@@ -95,12 +97,22 @@ namespace gpstk
        * to be synchronized. When 'NetworkObsStreams::setSynchronizeException(true)'
        * is used, it'll throw a 'SynchronizeException' when faied to synchronize data.
        * Then, you must handle it appropriately.
+       *
+       * The data of every station are read into an EpochArena of their
+       * own, so all the map nodes of the returned gnssDataMap, including
+       * those added later by the processing classes, come from arenas
+       * instead of the heap. The arenas are reset in O(1) when the data are
+       * cleared at the next call to 'readEpochData()', and the stations
+       * may be processed in parallel threads without sharing an arena.
+       * Copies of the data keep their arena alive, so they may outlive the
+       * epoch, but an arena is not reused while they exist.
        */
    class NetworkObsStreams
    {
    public:
          /// Default constructor
-      NetworkObsStreams() : synchronizeException(false)
+      NetworkObsStreams()
+         : synchronizeException(false), useEpochArena(true)
       {}
 
          /// Default destructor
@@ -122,6 +134,15 @@ namespace gpstk
       void setSynchronizeException(const bool& synException = true)
       { synchronizeException = synException; }
 
+         /// Set whether the epoch data are allocated from arenas. By
+         /// default, it is set to true.
+      void setUseEpochArena(bool useArena)
+      { useEpochArena = useArena; }
+
+         /// Get whether the epoch data are allocated from arenas
+      bool getUseEpochArena() const
+      { return useEpochArena; }
+
          /// Get epoch data of the network
          /// @gdsMap  Object hold epoch observation data of the network
          /// @return  Is there more epoch data for the network
@@ -162,6 +183,15 @@ namespace gpstk
          /// Flag indicate will throw 'SynchronizeException'
       bool synchronizeException;
 
+         /// Whether the epoch data are allocated from arenas
+      bool useEpochArena;
+
+         /// Arenas of the epoch data
+      std::vector<EpochArena*> arenaPool;
+
+         /// Get an arena with no live data, reset
+      EpochArena* getFreeArena();
+
    private:
          // Do some clean operation
       virtual void cleanUp();
@@ -0,0 +1,320 @@
+#pragma ident "$Id$"
+
+/**
+ * @file ObsStreamReplayer.cpp
+ * Replay RINEX 3 observation files over loopback sockets, at the pace of
+ * their time tags.
+ */
+
+//============================================================================
+//
+//  This file is part of GPSTk, the GPS Toolkit.
+//
+//  The GPSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 2.1 of the License, or
+//  any later version.
+//
+//  The GPSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GPSTk; if not, write to the Free Software Foundation,
+//  Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//============================================================================
+
+
+#include <cstring>
+#include <fstream>
+#include "ObsStreamReplayer.hpp"
+#include "CivilTime.hpp"
+#include "StringUtils.hpp"
+
+#if !defined(_MSC_VER)
+#include <time.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+using namespace std;
+
+
+namespace gpstk
+{
+
+      // Wall clock, in seconds since 1970
+    static double unixTime()
+    {
+#if !defined(_MSC_VER)
+        struct timeval tv;
+        gettimeofday(&tv, NULL);
+        return tv.tv_sec + tv.tv_usec*1.0e-6;
+#else
+        return 0.0;
+#endif
+    }
+
+
+      // Sleep for some seconds
+    static void sleepFor(double seconds)
+    {
+#if !defined(_MSC_VER)
+        if(seconds <= 0.0) return;
+
+        struct timespec ts;
+        ts.tv_sec = static_cast<time_t>(seconds);
+        ts.tv_nsec = static_cast<long>( (seconds - ts.tv_sec)*1.0e9 );
+        nanosleep(&ts, NULL);
+#endif
+    }
+
+
+
+      // Add a file to replay, and listen for its client.
+    int ObsStreamReplayer::addFile(const std::string& file, int port)
+        throw(Exception)
+    {
+        File f;
+        f.name = file;
+
+        readFile(f);
+
+#if !defined(_MSC_VER)
+        f.listenFd = socket(AF_INET, SOCK_STREAM, 0);
+        if(f.listenFd < 0)
+        {
+            Exception e("Can not create a socket for " + file);
+            GPSTK_THROW(e);
+        }
+
+        int on(1);
+        setsockopt(f.listenFd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        if( bind( f.listenFd, (struct sockaddr*)&addr, sizeof(addr) ) != 0 ||
+            listen(f.listenFd, 1) != 0 )
+        {
+            close(f.listenFd);
+            Exception e( "Can not listen on port "
+                         + StringUtils::asString(port) + " for " + file );
+            GPSTK_THROW(e);
+        }
+
+        socklen_t len( sizeof(addr) );
+        getsockname( f.listenFd, (struct sockaddr*)&addr, &len );
+        port = ntohs(addr.sin_port);
+
+        files.push_back(f);
+
+        return port;
+#else
+        Exception e("Sockets are not supported on this platform.");
+        GPSTK_THROW(e);
+#endif
+
+    }  // End of method 'ObsStreamReplayer::addFile()'
+
+
+
+      // Wait for the clients, and send them the files.
+    unsigned long ObsStreamReplayer::run()
+        throw(Exception)
+    {
+#if !defined(_MSC_VER)
+        for(size_t i = 0; i < files.size(); ++i)
+        {
+            files[i].fd = accept(files[i].listenFd, NULL, NULL);
+
+            close(files[i].listenFd);
+            files[i].listenFd = -1;
+
+            if(files[i].fd < 0)
+            {
+                Exception e("No client for " + files[i].name);
+                GPSTK_THROW(e);
+            }
+
+            sendText(files[i], files[i].header);
+        }
+
+        // Next block of every file
+        std::vector<size_t> next( files.size(), 0 );
+
+        unsigned long numEpochs(0);
+        bool started(false);
+
+        while(true)
+        {
+            // The file with the earliest next epoch
+            int first(-1);
+            for(size_t i = 0; i < files.size(); ++i)
+            {
+                if( next[i] >= files[i].blocks.size() ) continue;
+
+                if( first < 0 ||
+                    files[i].blocks[next[i]].epoch
+                                        < files[first].blocks[next[first]].epoch )
+                {
+                    first = i;
+                }
+            }
+
+            if(first < 0) break;
+
+            const Block& block( files[first].blocks[next[first]] );
+            ++next[first];
+
+            if(!started)
+            {
+                started = true;
+                startEpoch = block.epoch;
+                startTime = unixTime();
+            }
+            else if(replayRate > 0.0)
+            {
+                sleepFor( startTime + (block.epoch - startEpoch)/replayRate
+                          - unixTime() );
+            }
+
+            sendText(files[first], block.text);
+            ++numEpochs;
+        }
+
+        for(size_t i = 0; i < files.size(); ++i)
+        {
+            if(files[i].fd >= 0) close(files[i].fd);
+            files[i].fd = -1;
+        }
+
+        return numEpochs;
+#else
+        Exception e("Sockets are not supported on this platform.");
+        GPSTK_THROW(e);
+#endif
+
+    }  // End of method 'ObsStreamReplayer::run()'
+
+
+
+      // Destructor
+    ObsStreamReplayer::~ObsStreamReplayer()
+    {
+#if !defined(_MSC_VER)
+        for(size_t i = 0; i < files.size(); ++i)
+        {
+            if(files[i].listenFd >= 0) close(files[i].listenFd);
+            if(files[i].fd >= 0) close(files[i].fd);
+        }
+#endif
+
+    }  // End of destructor 'ObsStreamReplayer::~ObsStreamReplayer()'
+
+
+
+      // Read a file into the header and the epoch blocks
+    void ObsStreamReplayer::readFile(File& file)
+        throw(Exception)
+    {
+        ifstream in( file.name.c_str() );
+        if( !in )
+        {
+            Exception e("Can not open " + file.name);
+            GPSTK_THROW(e);
+        }
+
+        bool inHeader(true);
+        string line;
+
+        while( getline(in, line) )
+        {
+            line += '\n';
+
+            if(inHeader)
+            {
+                file.header += line;
+                if( line.find("END OF HEADER") != string::npos )
+                {
+                    inHeader = false;
+                }
+                continue;
+            }
+
+            if( line[0] == '>' )
+            {
+                if( line.size() < 30 )
+                {
+                    Exception e("Bad epoch line in " + file.name);
+                    GPSTK_THROW(e);
+                }
+
+                // The time tags are only compared among themselves
+                Block block;
+                block.epoch = CivilTime( StringUtils::asInt( line.substr(2, 4) ),
+                                         StringUtils::asInt( line.substr(7, 2) ),
+                                         StringUtils::asInt( line.substr(10, 2) ),
+                                         StringUtils::asInt( line.substr(13, 2) ),
+                                         StringUtils::asInt( line.substr(16, 2) ),
+                                     StringUtils::asDouble( line.substr(18, 11) ),
+                                         TimeSystem::Any );
+
+                file.blocks.push_back(block);
+            }
+
+            if( file.blocks.empty() ) continue;
+
+            file.blocks.back().text += line;
+        }
+
+        if(inHeader)
+        {
+            Exception e("No header in " + file.name);
+            GPSTK_THROW(e);
+        }
+
+    }  // End of method 'ObsStreamReplayer::readFile()'
+
+
+
+      // Send some text to a client
+    void ObsStreamReplayer::sendText(File& file, const std::string& text)
+    {
+#if !defined(_MSC_VER)
+        size_t sent(0);
+
+        while( file.fd >= 0 && sent < text.size() )
+        {
+            ssize_t n( send( file.fd, text.data() + sent, text.size() - sent,
+                             MSG_NOSIGNAL ) );
+
+            if(n <= 0)
+            {
+                // The client is gone: stop sending this file
+                close(file.fd);
+                file.fd = -1;
+                break;
+            }
+
+            sent += n;
+        }
+#endif
+
+    }  // End of method 'ObsStreamReplayer::sendText()'
+
+
+}  // End of namespace gpstk
@@ -0,0 +1,179 @@
+#pragma ident "$Id$"
+
+/**
+ * @file ObsStreamReplayer.hpp
+ * Replay RINEX 3 observation files over loopback sockets, at the pace of
+ * their time tags.
+ */
+
+#ifndef GPSTK_OBSSTREAMREPLAYER_HPP
+#define GPSTK_OBSSTREAMREPLAYER_HPP
+
+//============================================================================
+//
+//  This file is part of GPSTk, the GPS Toolkit.
+//
+//  The GPSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 2.1 of the License, or
+//  any later version.
+//
+//  The GPSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GPSTk; if not, write to the Free Software Foundation,
+//  Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//============================================================================
+
+
+#include <string>
+#include <vector>
+#include "CommonTime.hpp"
+#include "Exception.hpp"
+
+
+namespace gpstk
+{
+
+    /// @ingroup DataStructures
+    //@{
+
+    /** This class replays RINEX 3 observation files as TCP streams on the
+     *  loopback interface, one per file, sending every epoch at the time
+     *  given by its time tag, so that a real-time system can be tested
+     *  with recorded data (see StreamObsSource).
+     *
+     * Each file is served on a port of 127.0.0.1. 'run()' waits for a
+     * client on every port, sends the headers, and then the epochs of all
+     * the files in time order, until the end of the files. It blocks, so
+     * it runs in a thread or process of its own:
+     *
+     * @code
+     *   ObsStreamReplayer replayer(1.0);
+     *   int port1( replayer.addFile("onsa0010.15o") );
+     *   int port2( replayer.addFile("wtzr0010.15o") );
+     *
+     *   StreamObsSource source;
+     *
+     *   #pragma omp parallel sections num_threads(2)
+     *   {
+     *      #pragma omp section
+     *      replayer.run();
+     *
+     *      #pragma omp section
+     *      {
+     *         source.connectStream("127.0.0.1", port1);
+     *         source.connectStream("127.0.0.1", port2);
+     *         ...
+     *      }
+     *   }
+     * @endcode
+     *
+     * Sockets are supported on POSIX systems.
+     */
+    class ObsStreamReplayer
+    {
+    public:
+
+        /** Common constructor
+         *
+         * @param rate      Rate of the time tags with respect to the wall
+         *                  clock: 1 replays in real time, 10 ten times
+         *                  faster, and 0 or less as fast as possible.
+         */
+        ObsStreamReplayer(double rate = 1.0)
+            : replayRate(rate), startTime(0.0)
+        {};
+
+
+        /** Add a file to replay, and listen for its client.
+         *
+         * @param file      RINEX 3 observation file.
+         * @param port      Port of 127.0.0.1; 0 takes a free one.
+         *
+         * @return  Port the file is served on.
+         */
+        int addFile(const std::string& file, int port = 0)
+            throw(Exception);
+
+
+        /** Wait for the clients, and send them the files.
+         *
+         * @return  Number of epochs sent.
+         */
+        unsigned long run()
+            throw(Exception);
+
+
+        /// Rate of the time tags with respect to the wall clock
+        double getRate() const
+        { return replayRate; };
+
+        /// Time tag of the first epoch sent
+        const CommonTime& getStartEpoch() const
+        { return startEpoch; };
+
+        /// Wall clock (seconds since 1970) when the first epoch was sent
+        double getStartTime() const
+        { return startTime; };
+
+
+        /// Destructor
+        virtual ~ObsStreamReplayer();
+
+
+    private:
+
+        /// Epoch of a file
+        struct Block
+        {
+            CommonTime epoch;
+            std::string text;
+        };
+
+        /// File being replayed
+        struct File
+        {
+            File() : listenFd(-1), fd(-1) {};
+
+            std::string name;
+            int listenFd;
+            int fd;
+
+            std::string header;
+            std::vector<Block> blocks;
+        };
+
+
+        /// Read a file into the header and the epoch blocks
+        void readFile(File& file)
+            throw(Exception);
+
+        /// Send some text to a client
+        void sendText(File& file, const std::string& text);
+
+
+        /// Files to replay
+        std::vector<File> files;
+
+        /// Replay rate
+        double replayRate;
+
+        /// Start of the replay
+        CommonTime startEpoch;
+        double startTime;
+
+        ObsStreamReplayer(const ObsStreamReplayer&);
+        ObsStreamReplayer& operator=(const ObsStreamReplayer&);
+
+    }; // End of class 'ObsStreamReplayer'
+
+    //@}
+
+}  // End of namespace gpstk
+
+#endif   // GPSTK_OBSSTREAMREPLAYER_HPP
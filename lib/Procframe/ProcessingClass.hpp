@@ -34,6 +34,7 @@
 
 #include "StringUtils.hpp"
 #include "DataStructures.hpp"
+#include "ProcessingProfiler.hpp"
 
 
 namespace gpstk
@@ -120,19 +121,34 @@ namespace gpstk
       /// Input operator from gnssSatTypeValue to ProcessingClass.
    inline gnssSatTypeValue& operator>>( gnssSatTypeValue& gData,
                                         ProcessingClass& procClass )
-   { procClass.Process(gData); return gData; }
+   {
+      if( ProcessingProfiler::isEnabled() )
+         return ProcessingProfiler::Process(procClass, gData);
+
+      procClass.Process(gData); return gData;
+   }
 
 
       /// Input operator from gnssRinex to ProcessingClass.
    inline gnssRinex& operator>>( gnssRinex& gData,
                                  ProcessingClass& procClass )
-   { procClass.Process(gData); return gData; }
+   {
+      if( ProcessingProfiler::isEnabled() )
+         return ProcessingProfiler::Process(procClass, gData);
+
+      procClass.Process(gData); return gData;
+   }
 
 
       /// Input operator from gnssDataMap to ProcessingClass.
    inline gnssDataMap& operator>>( gnssDataMap& gData,
                                    ProcessingClass& procClass )
-   { procClass.Process(gData); return gData; }
+   {
+      if( ProcessingProfiler::isEnabled() )
+         return ProcessingProfiler::Process(procClass, gData);
+
+      procClass.Process(gData); return gData;
+   }
 
 
    //@}
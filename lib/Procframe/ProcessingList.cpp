@@ -53,7 +53,7 @@ namespace gpstk
          std::list<ProcessingClass*>::const_iterator pos;
          for (pos = proclist.begin(); pos != proclist.end(); ++pos)
          {
-            (*pos)->Process(gData);
+            gData >> (**pos);
          }
 
          return gData;
@@ -85,7 +85,7 @@ namespace gpstk
          std::list<ProcessingClass*>::const_iterator pos;
          for (pos = proclist.begin(); pos != proclist.end(); ++pos)
          {
-            (*pos)->Process(gData);
+            gData >> (**pos);
          }
 
          return gData;
@@ -117,7 +117,7 @@ namespace gpstk
          std::list<ProcessingClass*>::const_iterator pos;
          for (pos = proclist.begin(); pos != proclist.end(); ++pos)
          {
-            (*pos)->Process(gData);
+            gData >> (**pos);
          }
 
          return gData;
@@ -0,0 +1,379 @@
+#pragma ident "$Id$"
+
+/**
+ * @file ProcessingProfiler.cpp
+ * Instrumentation of the ProcessingClass objects chained with 'operator>>':
+ * time, data and allocations of every processor, epoch by epoch.
+ */
+
+//============================================================================
+//
+//  This file is part of GPSTk, the GPS Toolkit.
+//
+//  The GPSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 2.1 of the License, or
+//  any later version.
+//
+//  The GPSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GPSTk; if not, write to the Free Software Foundation,
+//  Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//============================================================================
+
+
+#include <cmath>
+#include <map>
+#include <iomanip>
+#include "ProcessingProfiler.hpp"
+#include "ProcessingClass.hpp"
+#include "EpochArena.hpp"
+
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+using namespace std;
+
+
+namespace gpstk
+{
+
+      // Wall time, in seconds
+    static double wallTime()
+    {
+#if defined(USE_OPENMP)
+        return omp_get_wtime();
+#elif defined(_MSC_VER)
+        LARGE_INTEGER count, freq;
+        QueryPerformanceCounter(&count);
+        QueryPerformanceFrequency(&freq);
+        return double(count.QuadPart)/double(freq.QuadPart);
+#else
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec + ts.tv_nsec*1.0e-9;
+#endif
+    }
+
+
+      // Statistics of the processors, in order of first call
+    static std::vector<ProcessingProfiler::Stats> statsList;
+
+      // Index of every processor in 'statsList'
+    static std::map<std::string, size_t> statsIndex;
+
+
+      // Lower limit of the histograms, and bins per decade
+    static const double minTime = 1.0e-7;
+    static const double binsPerDecade = 10.0;
+
+
+      // Name of a processor as a JSON string
+    static std::string jsonString(const std::string& str)
+    {
+        std::string out("\"");
+
+        for(size_t i = 0; i < str.size(); ++i)
+        {
+            if(str[i] == '"' || str[i] == '\\') out += '\\';
+            out += str[i];
+        }
+
+        return out + "\"";
+    }
+
+
+
+    bool ProcessingProfiler::enabled = false;
+
+    const size_t ProcessingProfiler::numBins;
+
+
+      // Constructor of the statistics of a processor
+    ProcessingProfiler::Stats::Stats()
+        : numCalls(0), numThrown(0), totalTime(0.0), maxTime(0.0),
+          numSats(0), numSources(0), numAllocs(0), maxAllocs(0),
+          histogram(numBins, 0)
+    {
+    }
+
+
+
+      // Time below which a fraction of the calls took.
+    double ProcessingProfiler::Stats::getPercentile(double fraction) const
+    {
+        if(numCalls == 0) return 0.0;
+
+        double target( fraction*numCalls );
+
+        unsigned long count(0);
+        for(size_t i = 0; i < histogram.size(); ++i)
+        {
+            count += histogram[i];
+
+            if( count >= target && count > 0 )
+            {
+                double t( binTime(i) );
+                return (t < maxTime) ? t : maxTime;
+            }
+        }
+
+        return maxTime;
+
+    }  // End of method 'ProcessingProfiler::Stats::getPercentile()'
+
+
+
+      // Forget all the statistics gathered so far.
+    void ProcessingProfiler::reset()
+    {
+#ifdef USE_OPENMP
+    #pragma omp critical(ProcessingProfiler)
+#endif
+        {
+            statsList.clear();
+            statsIndex.clear();
+        }
+
+    }  // End of method 'ProcessingProfiler::reset()'
+
+
+
+      // Get the statistics of every processor, in order of first call.
+    std::vector<ProcessingProfiler::Stats> ProcessingProfiler::getStats()
+    {
+        std::vector<Stats> stats;
+
+#ifdef USE_OPENMP
+    #pragma omp critical(ProcessingProfiler)
+#endif
+        stats = statsList;
+
+        return stats;
+
+    }  // End of method 'ProcessingProfiler::getStats()'
+
+
+
+      // Print the statistics as CSV, one line per processor.
+    void ProcessingProfiler::dumpCSV(std::ostream& s)
+    {
+        std::vector<Stats> stats( getStats() );
+
+        s << "name,calls,thrown,total_s,mean_us,p50_us,p99_us,max_us,"
+          << "sats_per_call,sources_per_call,allocs_per_call,max_allocs"
+          << endl;
+
+        for(size_t i = 0; i < stats.size(); ++i)
+        {
+            const Stats& st( stats[i] );
+            double n( (st.numCalls > 0) ? st.numCalls : 1.0 );
+
+            s << st.name << ','
+              << st.numCalls << ','
+              << st.numThrown << ','
+              << fixed << setprecision(6) << st.totalTime << ','
+              << setprecision(3)
+              << st.getMeanTime()*1.0e6 << ','
+              << st.getPercentile(0.50)*1.0e6 << ','
+              << st.getPercentile(0.99)*1.0e6 << ','
+              << st.maxTime*1.0e6 << ','
+              << setprecision(2)
+              << st.numSats/n << ','
+              << st.numSources/n << ','
+              << st.numAllocs/n << ','
+              << st.maxAllocs << endl;
+        }
+
+    }  // End of method 'ProcessingProfiler::dumpCSV()'
+
+
+
+      // Print the statistics as a JSON array, one object per processor.
+    void ProcessingProfiler::dumpJSON(std::ostream& s)
+    {
+        std::vector<Stats> stats( getStats() );
+
+        s << "[" << endl;
+
+        for(size_t i = 0; i < stats.size(); ++i)
+        {
+            const Stats& st( stats[i] );
+            double n( (st.numCalls > 0) ? st.numCalls : 1.0 );
+
+            s << "  {\"name\": " << jsonString(st.name)
+              << ", \"calls\": " << st.numCalls
+              << ", \"thrown\": " << st.numThrown
+              << fixed << setprecision(6)
+              << ", \"total_s\": " << st.totalTime
+              << setprecision(3)
+              << ", \"mean_us\": " << st.getMeanTime()*1.0e6
+              << ", \"p50_us\": " << st.getPercentile(0.50)*1.0e6
+              << ", \"p99_us\": " << st.getPercentile(0.99)*1.0e6
+              << ", \"max_us\": " << st.maxTime*1.0e6
+              << setprecision(2)
+              << ", \"sats_per_call\": " << st.numSats/n
+              << ", \"sources_per_call\": " << st.numSources/n
+              << ", \"allocs_per_call\": " << st.numAllocs/n
+              << ", \"max_allocs\": " << st.maxAllocs
+              << "}" << ( (i + 1 < stats.size()) ? "," : "" ) << endl;
+        }
+
+        s << "]" << endl;
+
+    }  // End of method 'ProcessingProfiler::dumpJSON()'
+
+
+
+      // Time a call of a processor on a gnssSatTypeValue object.
+    gnssSatTypeValue& ProcessingProfiler::Process( ProcessingClass& procClass,
+                                                   gnssSatTypeValue& gData )
+    {
+        return profile(procClass, gData, gData.numSats(), 1);
+
+    }  // End of method 'ProcessingProfiler::Process()'
+
+
+
+      // Time a call of a processor on a gnssRinex object.
+    gnssRinex& ProcessingProfiler::Process( ProcessingClass& procClass,
+                                            gnssRinex& gData )
+    {
+        return profile(procClass, gData, gData.numSats(), 1);
+
+    }  // End of method 'ProcessingProfiler::Process()'
+
+
+
+      // Time a call of a processor on a gnssDataMap object.
+    gnssDataMap& ProcessingProfiler::Process( ProcessingClass& procClass,
+                                              gnssDataMap& gData )
+    {
+        size_t numSats(0);
+        size_t numSources(0);
+
+        for( gnssDataMap::const_iterator it = gData.begin();
+             it != gData.end();
+             ++it )
+        {
+            numSources += it->second.size();
+
+            for( sourceDataMap::const_iterator its = it->second.begin();
+                 its != it->second.end();
+                 ++its )
+            {
+                numSats += its->second.size();
+            }
+        }
+
+        return profile(procClass, gData, numSats, numSources);
+
+    }  // End of method 'ProcessingProfiler::Process()'
+
+
+
+      // Upper limit of a bin of the histograms
+    double ProcessingProfiler::binTime(size_t bin)
+    {
+        if(bin + 1 >= numBins) return 1.0e300;
+
+        return minTime*std::pow(10.0, bin/binsPerDecade);
+
+    }  // End of method 'ProcessingProfiler::binTime()'
+
+
+
+      // Time a call of a processor on any GNSS data structure
+    template<class GDS>
+    GDS& ProcessingProfiler::profile( ProcessingClass& procClass,
+                                      GDS& gData,
+                                      size_t numSats,
+                                      size_t numSources )
+    {
+        unsigned long allocs( EpochArena::getNumAllocated() );
+        double t0( wallTime() );
+
+        try
+        {
+            procClass.Process(gData);
+        }
+        catch(...)
+        {
+            record( procClass, wallTime() - t0, true, numSats, numSources,
+                    EpochArena::getNumAllocated() - allocs );
+            throw;
+        }
+
+        record( procClass, wallTime() - t0, false, numSats, numSources,
+                EpochArena::getNumAllocated() - allocs );
+
+        return gData;
+
+    }  // End of method 'ProcessingProfiler::profile()'
+
+
+
+      // Add a call to the statistics of a processor
+    void ProcessingProfiler::record( const ProcessingClass& procClass,
+                                     double time,
+                                     bool thrown,
+                                     size_t numSats,
+                                     size_t numSources,
+                                     unsigned long numAllocs )
+    {
+        std::string name( procClass.getClassName() );
+
+        size_t bin(0);
+        if(time >= minTime)
+        {
+            bin = 1 + static_cast<size_t>(
+                            std::floor( binsPerDecade*std::log10(time/minTime) ) );
+            if(bin >= numBins) bin = numBins - 1;
+        }
+
+#ifdef USE_OPENMP
+    #pragma omp critical(ProcessingProfiler)
+#endif
+        {
+            std::map<std::string, size_t>::iterator it( statsIndex.find(name) );
+            if( it == statsIndex.end() )
+            {
+                it = statsIndex.insert(
+                                make_pair(name, statsList.size()) ).first;
+                statsList.push_back( Stats() );
+                statsList.back().name = name;
+            }
+
+            Stats& st( statsList[it->second] );
+
+            ++st.numCalls;
+            if(thrown) ++st.numThrown;
+
+            st.totalTime += time;
+            if(time > st.maxTime) st.maxTime = time;
+
+            st.numSats += numSats;
+            st.numSources += numSources;
+
+            st.numAllocs += numAllocs;
+            if(numAllocs > st.maxAllocs) st.maxAllocs = numAllocs;
+
+            ++st.histogram[bin];
+        }
+
+    }  // End of method 'ProcessingProfiler::record()'
+
+
+}  // End of namespace gpstk
@@ -0,0 +1,198 @@
+#pragma ident "$Id$"
+
+/**
+ * @file ProcessingProfiler.hpp
+ * Instrumentation of the ProcessingClass objects chained with 'operator>>':
+ * time, data and allocations of every processor, epoch by epoch.
+ */
+
+#ifndef GPSTK_PROCESSINGPROFILER_HPP
+#define GPSTK_PROCESSINGPROFILER_HPP
+
+//============================================================================
+//
+//  This file is part of GPSTk, the GPS Toolkit.
+//
+//  The GPSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 2.1 of the License, or
+//  any later version.
+//
+//  The GPSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GPSTk; if not, write to the Free Software Foundation,
+//  Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//============================================================================
+
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include "DataStructures.hpp"
+
+
+namespace gpstk
+{
+
+    class ProcessingClass;
+
+
+    /** @addtogroup GPSsolutions */
+    //@{
+
+    /** This class measures where the time of a processing chain goes.
+     *
+     * When it is enabled, every call of a ProcessingClass object through
+     * 'operator>>' (and so through ProcessingList, ProcessingVector and
+     * the stages of an EpochPipeline) is timed, and its statistics are
+     * gathered under the name given by 'getClassName()':
+     *
+     * - Number of calls, and of calls ending with an exception.
+     * - Wall time: total, maximum, and a histogram giving the median
+     *   (p50) and the 99th percentile (p99) of a call.
+     * - Satellites and sources handed to the processor.
+     * - Blocks of GNSS data structures allocated during the call (see
+     *   EpochArena), in the thread of the call.
+     *
+     * The statistics are printed as CSV or JSON at the end of the run:
+     *
+     * @code
+     *   ProcessingProfiler::enable();
+     *
+     *   while( obsStreams.readEpochData(gData) )
+     *   {
+     *      gData >> requireObs >> linearPC >> basicModel >> ...;
+     *   }
+     *
+     *   std::ofstream report("profile.csv");
+     *   ProcessingProfiler::dumpCSV(report);
+     * @endcode
+     *
+     * When it is disabled, as it is by default, 'operator>>' only tests a
+     * flag before calling 'Process()'. The statistics of calls in several
+     * threads are gathered together.
+     */
+    class ProcessingProfiler
+    {
+    public:
+
+        /// Statistics of a processor
+        struct Stats
+        {
+            Stats();
+
+            /// Name of the processor, from 'getClassName()'
+            std::string name;
+
+            /// Number of calls, and of calls ending with an exception
+            unsigned long numCalls;
+            unsigned long numThrown;
+
+            /// Wall time of the calls (seconds)
+            double totalTime;
+            double maxTime;
+
+            /// Satellites and sources handed to the processor
+            unsigned long numSats;
+            unsigned long numSources;
+
+            /// Blocks allocated during the calls, and maximum in a call
+            unsigned long numAllocs;
+            unsigned long maxAllocs;
+
+            /// Number of calls in every bin of time (see 'binTime()')
+            std::vector<unsigned long> histogram;
+
+            /// Mean time of a call (seconds)
+            double getMeanTime() const
+            { return (numCalls > 0) ? totalTime/numCalls : 0.0; };
+
+            /** Time (seconds) below which a fraction of the calls took,
+             *  from the histogram, e.g. 0.5 for the median.
+             */
+            double getPercentile(double fraction) const;
+        };
+
+
+        /// Start gathering statistics.
+        static void enable()
+        { enabled = true; };
+
+        /// Stop gathering statistics. Those gathered so far are kept.
+        static void disable()
+        { enabled = false; };
+
+        /// Whether the statistics are being gathered
+        static bool isEnabled()
+        { return enabled; };
+
+
+        /// Forget all the statistics gathered so far.
+        static void reset();
+
+        /// Get the statistics of every processor, in order of first call.
+        static std::vector<Stats> getStats();
+
+
+        /// Print the statistics as CSV, one line per processor.
+        static void dumpCSV(std::ostream& s);
+
+        /// Print the statistics as a JSON array, one object per processor.
+        static void dumpJSON(std::ostream& s);
+
+
+        /// Time a call of a processor on a gnssSatTypeValue object.
+        static gnssSatTypeValue& Process( ProcessingClass& procClass,
+                                          gnssSatTypeValue& gData );
+
+        /// Time a call of a processor on a gnssRinex object.
+        static gnssRinex& Process( ProcessingClass& procClass,
+                                   gnssRinex& gData );
+
+        /// Time a call of a processor on a gnssDataMap object.
+        static gnssDataMap& Process( ProcessingClass& procClass,
+                                     gnssDataMap& gData );
+
+
+        /** Upper limit (seconds) of a bin of the histograms. The bins are
+         *  logarithmic, ten per decade from 0.1 us to 1000 s; the first
+         *  and the last ones take all the shorter and longer calls.
+         */
+        static double binTime(size_t bin);
+
+        /// Number of bins of the histograms
+        static const size_t numBins = 102;
+
+
+    private:
+
+        /// Time a call of a processor on any GNSS data structure
+        template<class GDS>
+        static GDS& profile( ProcessingClass& procClass,
+                             GDS& gData,
+                             size_t numSats,
+                             size_t numSources );
+
+        /// Add a call to the statistics of a processor
+        static void record( const ProcessingClass& procClass,
+                            double time,
+                            bool thrown,
+                            size_t numSats,
+                            size_t numSources,
+                            unsigned long numAllocs );
+
+        /// Whether the statistics are being gathered
+        static bool enabled;
+
+    }; // End of class 'ProcessingProfiler'
+
+    //@}
+
+}  // End of namespace gpstk
+
+#endif   // GPSTK_PROCESSINGPROFILER_HPP
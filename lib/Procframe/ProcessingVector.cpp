@@ -53,7 +53,7 @@ namespace gpstk
          std::vector<ProcessingClass*>::const_iterator pos;
          for (pos = procvector.begin(); pos != procvector.end(); ++pos)
          {
-            (*pos)->Process(gData);
+            gData >> (**pos);
          }
 
          return gData;
@@ -85,7 +85,7 @@ namespace gpstk
          std::vector<ProcessingClass*>::const_iterator pos;
          for (pos = procvector.begin(); pos != procvector.end(); ++pos)
          {
-            (*pos)->Process(gData);
+            gData >> (**pos);
          }
 
          return gData;
@@ -118,7 +118,7 @@ namespace gpstk
          std::vector<ProcessingClass*>::const_iterator pos;
          for (pos = procvector.begin(); pos != procvector.end(); ++pos)
          {
-            (*pos)->Process(gData);
+            gData >> (**pos);
          }
 
          return gData;
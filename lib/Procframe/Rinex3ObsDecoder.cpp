@@ -0,0 +1,194 @@
+#pragma ident "$Id$"
+
+/**
+ * @file Rinex3ObsDecoder.cpp
+ * Decode RINEX 3 observation epochs from a byte stream into gnssRinex
+ * objects.
+ */
+
+//============================================================================
+//
+//  This file is part of GPSTk, the GPS Toolkit.
+//
+//  The GPSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 2.1 of the License, or
+//  any later version.
+//
+//  The GPSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GPSTk; if not, write to the Free Software Foundation,
+//  Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//============================================================================
+
+
+#include <cstdlib>
+#include "Rinex3ObsDecoder.hpp"
+
+using namespace std;
+
+
+namespace gpstk
+{
+
+      // Default constructor
+    Rinex3ObsDecoder::Rinex3ObsDecoder()
+        : start(0)
+    {
+        // The stream reads from the in-memory buffer instead of a file
+        strm.std::basic_ios<char>::rdbuf(&buffer);
+        strm.clear();
+
+    }  // End of constructor 'Rinex3ObsDecoder::Rinex3ObsDecoder()'
+
+
+
+      // Add the bytes arrived from the stream.
+    void Rinex3ObsDecoder::addData(const char* data, size_t size)
+    {
+        // Drop the bytes already decoded, once they are most of the buffer
+        if( start > 0 && start >= pending.size()/2 )
+        {
+            pending.erase(0, start);
+            start = 0;
+        }
+
+        pending.append(data, size);
+
+    }  // End of method 'Rinex3ObsDecoder::addData()'
+
+
+
+      // Take the next complete epoch, if any.
+    bool Rinex3ObsDecoder::getEpoch(gnssRinex& gRin)
+        throw(FFStreamError)
+    {
+        if( !strm.headerRead && !readHeader() ) return false;
+
+        // Skip anything before the next epoch line, e.g. blank lines
+        while( start < pending.size() && pending[start] != '>' )
+        {
+            size_t next( skipLines(start, 1) );
+            if(next == string::npos) return false;
+
+            start = next;
+        }
+
+        size_t end( skipLines(start, 1) );
+        if(end == string::npos) return false;
+
+        // Number of satellites, or of special records for event flags
+        // 2 to 5, following the epoch line
+        if( end - start < 36 )
+        {
+            FFStreamError e( "Bad epoch line: >"
+                             + pending.substr(start, end - start) + "<" );
+            start = end;
+            GPSTK_THROW(e);
+        }
+
+        size_t num( std::atoi( pending.substr(start + 32, 3).c_str() ) );
+
+        end = skipLines(end, num);
+        if(end == string::npos) return false;
+
+        setText(start, end);
+        start = end;
+
+        gRin = gnssRinex();
+        strm >> gRin;
+
+        if( !strm )
+        {
+            FFStreamError e("Invalid RINEX 3 observation epoch.");
+            strm.clear();
+            GPSTK_THROW(e);
+        }
+
+        return true;
+
+    }  // End of method 'Rinex3ObsDecoder::getEpoch()'
+
+
+
+      // Forget the header and all the data, to start a new stream.
+    void Rinex3ObsDecoder::reset()
+    {
+        pending.clear();
+        start = 0;
+
+        strm.header = Rinex3ObsHeader();
+        strm.headerRead = false;
+        strm.clear();
+
+    }  // End of method 'Rinex3ObsDecoder::reset()'
+
+
+
+      // Find the end of the next 'n' lines from 'pos'.
+    size_t Rinex3ObsDecoder::skipLines(size_t pos, size_t n) const
+    {
+        for(size_t i = 0; i < n; ++i)
+        {
+            pos = pending.find('\n', pos);
+            if(pos == string::npos) return string::npos;
+
+            ++pos;
+        }
+
+        return pos;
+
+    }  // End of method 'Rinex3ObsDecoder::skipLines()'
+
+
+
+      // Read the header, if complete
+    bool Rinex3ObsDecoder::readHeader()
+        throw(FFStreamError)
+    {
+        size_t label( pending.find("END OF HEADER", start) );
+        if(label == string::npos) return false;
+
+        size_t end( skipLines(label, 1) );
+        if(end == string::npos) return false;
+
+        setText(start, end);
+        start = end;
+
+        strm >> strm.header;
+
+        if( !strm || !strm.headerRead )
+        {
+            FFStreamError e("Invalid RINEX observation header.");
+            strm.clear();
+            GPSTK_THROW(e);
+        }
+
+        if( strm.header.version < 3.0 )
+        {
+            FFStreamError e("Only RINEX 3 observation streams are supported.");
+            GPSTK_THROW(e);
+        }
+
+        return true;
+
+    }  // End of method 'Rinex3ObsDecoder::readHeader()'
+
+
+
+      // Make the bytes from 'first' to 'last' the contents of the buffer
+      // of the stream.
+    void Rinex3ObsDecoder::setText(size_t first, size_t last)
+    {
+        buffer.str( pending.substr(first, last - first) );
+        strm.clear();
+
+    }  // End of method 'Rinex3ObsDecoder::setText()'
+
+
+}  // End of namespace gpstk
@@ -0,0 +1,153 @@
+#pragma ident "$Id$"
+
+/**
+ * @file Rinex3ObsDecoder.hpp
+ * Decode RINEX 3 observation epochs from a byte stream into gnssRinex
+ * objects.
+ */
+
+#ifndef GPSTK_RINEX3OBSDECODER_HPP
+#define GPSTK_RINEX3OBSDECODER_HPP
+
+//============================================================================
+//
+//  This file is part of GPSTk, the GPS Toolkit.
+//
+//  The GPSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 2.1 of the License, or
+//  any later version.
+//
+//  The GPSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GPSTk; if not, write to the Free Software Foundation,
+//  Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//============================================================================
+
+
+#include <sstream>
+#include <string>
+#include "Rinex3ObsStream.hpp"
+#include "DataStructures.hpp"
+
+
+namespace gpstk
+{
+
+    /// @ingroup DataStructures
+    //@{
+
+    /** This class decodes the RINEX 3 observation data arriving in pieces
+     *  from a byte stream, such as a socket or a pipe, into gnssRinex
+     *  objects, with no temporary files.
+     *
+     * The bytes are given with 'addData()' as they arrive, and the epochs
+     * complete so far are taken with 'getEpoch()'. An epoch is complete
+     * when its epoch line and the number of records given there have
+     * arrived. The header and every complete epoch are then read with the
+     * same code as a Rinex3ObsStream file, from an in-memory buffer, so
+     * the result is the same as reading the file:
+     *
+     * @code
+     *   Rinex3ObsDecoder decoder;
+     *   gnssRinex gRin;
+     *
+     *   while( (n = read(fd, buffer, sizeof(buffer))) > 0 )
+     *   {
+     *      decoder.addData(buffer, n);
+     *
+     *      while( decoder.getEpoch(gRin) )
+     *      {
+     *         // processing code here
+     *      }
+     *   }
+     * @endcode
+     *
+     * Only RINEX version 3 streams are supported, since version 2 epochs
+     * can not be told complete from their first line.
+     */
+    class Rinex3ObsDecoder
+    {
+    public:
+
+        /// Default constructor
+        Rinex3ObsDecoder();
+
+
+        /// Add the bytes arrived from the stream.
+        void addData(const char* data, size_t size);
+
+
+        /** Take the next complete epoch, if any.
+         *
+         * @param gRin      Data of the epoch.
+         *
+         * @return  Whether there was a complete epoch.
+         */
+        bool getEpoch(gnssRinex& gRin)
+            throw(FFStreamError);
+
+
+        /// Whether the header has been read
+        bool isHeaderRead() const
+        { return strm.headerRead; };
+
+        /// Get the header of the stream
+        const Rinex3ObsHeader& getHeader() const
+        { return strm.header; };
+
+
+        /// Number of bytes not decoded yet
+        size_t getPendingSize() const
+        { return pending.size() - start; };
+
+
+        /// Forget the header and all the data, to start a new stream.
+        void reset();
+
+
+        /// Destructor
+        virtual ~Rinex3ObsDecoder() {};
+
+
+    private:
+
+        /** Find the end of the next 'n' lines from 'pos'.
+         *
+         * @return  Position after them, or std::string::npos if they have
+         *          not arrived yet.
+         */
+        size_t skipLines(size_t pos, size_t n) const;
+
+        /// Read the header, if complete
+        bool readHeader()
+            throw(FFStreamError);
+
+        /// Make the bytes from 'first' to 'last' the contents of the
+        /// buffer of the stream.
+        void setText(size_t first, size_t last);
+
+
+        /// Bytes arrived, and start of the ones not decoded yet
+        std::string pending;
+        size_t start;
+
+        /// Buffer of the stream, and stream reading from it
+        std::stringbuf buffer;
+        Rinex3ObsStream strm;
+
+        Rinex3ObsDecoder(const Rinex3ObsDecoder&);
+        Rinex3ObsDecoder& operator=(const Rinex3ObsDecoder&);
+
+    }; // End of class 'Rinex3ObsDecoder'
+
+    //@}
+
+}  // End of namespace gpstk
+
+#endif   // GPSTK_RINEX3OBSDECODER_HPP
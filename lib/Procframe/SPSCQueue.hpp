@@ -0,0 +1,153 @@
+#pragma ident "$Id$"
+
+/**
+ * @file SPSCQueue.hpp
+ * Bounded lock-free queue with a single producer and a single consumer.
+ */
+
+#ifndef GPSTK_SPSCQUEUE_HPP
+#define GPSTK_SPSCQUEUE_HPP
+
+//============================================================================
+//
+//  This file is part of GPSTk, the GPS Toolkit.
+//
+//  The GPSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 2.1 of the License, or
+//  any later version.
+//
+//  The GPSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GPSTk; if not, write to the Free Software Foundation,
+//  Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//============================================================================
+
+
+#include <cstddef>
+#include <vector>
+
+
+namespace gpstk
+{
+
+    /// @ingroup DataStructures
+    //@{
+
+    /** This class is a bounded FIFO queue for exactly one producer thread
+     *  and one consumer thread, without locks.
+     *
+     * It is a ring buffer with one more slot than its capacity. Only the
+     * producer writes the tail index, and only the consumer writes the
+     * head index; each one publishes its index after a memory flush, so
+     * the other thread sees the element before the index moves past it.
+     * The two indexes are kept in different cache lines.
+     *
+     * Neither 'push()' nor 'pop()' ever waits: they return false when the
+     * queue is full or empty, and the caller decides whether to retry,
+     * wait or drop.
+     */
+    template <class T>
+    class SPSCQueue
+    {
+    public:
+
+        /** Common constructor.
+         *
+         * @param capacity  Maximum number of elements in the queue.
+         */
+        explicit SPSCQueue(size_t capacity)
+            : buffer(capacity + 1), head(0), tail(0)
+        {};
+
+
+        /// Add an element at the end. Producer only.
+        bool push(const T& value)
+        {
+            size_t t( tail );
+            size_t next( (t + 1 == buffer.size()) ? 0 : t + 1 );
+
+#ifdef USE_OPENMP
+    #pragma omp flush
+#endif
+            if( next == head ) return false;
+
+            buffer[t] = value;
+
+#ifdef USE_OPENMP
+    #pragma omp flush
+#endif
+            tail = next;
+
+            return true;
+        };
+
+
+        /// Take the element at the front. Consumer only.
+        bool pop(T& value)
+        {
+            size_t h( head );
+
+#ifdef USE_OPENMP
+    #pragma omp flush
+#endif
+            if( h == tail ) return false;
+
+            value = buffer[h];
+
+#ifdef USE_OPENMP
+    #pragma omp flush
+#endif
+            head = (h + 1 == buffer.size()) ? 0 : h + 1;
+
+            return true;
+        };
+
+
+        /// Number of elements, as seen from the calling thread
+        size_t size() const
+        {
+            size_t h( head ), t( tail );
+            return (t >= h) ? (t - h) : (t + buffer.size() - h);
+        };
+
+
+        /// Whether the queue is empty, as seen from the calling thread
+        bool empty() const
+        { return (head == tail); };
+
+
+        /// Maximum number of elements
+        size_t capacity() const
+        { return buffer.size() - 1; };
+
+
+    private:
+
+        /// Ring buffer
+        std::vector<T> buffer;
+
+        /// Index of the front element, written by the consumer
+        volatile size_t head;
+
+        /// Keep the indexes in different cache lines
+        char pad[64];
+
+        /// Index after the last element, written by the producer
+        volatile size_t tail;
+
+        SPSCQueue(const SPSCQueue&);
+        SPSCQueue& operator=(const SPSCQueue&);
+
+    }; // End of class 'SPSCQueue'
+
+    //@}
+
+}  // End of namespace gpstk
+
+#endif   // GPSTK_SPSCQUEUE_HPP
@@ -0,0 +1,503 @@
+#pragma ident "$Id$"
+
+/**
+ * @file SatAttitudeStore.cpp
+ * Per-epoch attitude and Sun geometry of the satellites, shared by the
+ * processing classes of all the stations.
+ */
+
+//============================================================================
+//
+//  This file is part of GPSTk, the GPS Toolkit.
+//
+//  The GPSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 2.1 of the License, or
+//  any later version.
+//
+//  The GPSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GPSTk; if not, write to the Free Software Foundation,
+//  Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//============================================================================
+
+
+#include <cmath>
+#include "SatAttitudeStore.hpp"
+
+using namespace std;
+
+
+namespace gpstk
+{
+
+    const int SatAttitudeStore::MaxNumEpochs;
+    const int SatAttitudeStore::MaxSatNumber;
+    const int SatAttitudeStore::NumIndex;
+
+
+    // Get the maximum yaw rate of a satellite, in degrees/s
+    double SatAttitudeStore::getMaxYawRate(const SatID& sat) const
+    {
+        map<SatID, double>::const_iterator it( satYawRate.find(sat) );
+
+        if( it != satYawRate.end() ) return it->second * RAD_TO_DEG;
+
+        return defaultYawRate * RAD_TO_DEG;
+
+    }  // End of method 'SatAttitudeStore::getMaxYawRate()'
+
+
+
+    // Data of an epoch, without any satellite
+    SatAttitudeStore::EpochData::EpochData(const CommonTime& t)
+        : time(t), haveSun(false)
+    {
+        entries = new SatEntry* volatile[NumIndex];
+        for(int i = 0; i < NumIndex; ++i) entries[i] = NULL;
+
+    }  // End of constructor 'SatAttitudeStore::EpochData::EpochData()'
+
+
+
+    SatAttitudeStore::EpochData::~EpochData()
+    {
+        for(int i = 0; i < NumIndex; ++i) delete entries[i];
+        delete [] entries;
+
+    }  // End of destructor 'SatAttitudeStore::EpochData::~EpochData()'
+
+
+
+    // Destructor. No other thread may use the object.
+    SatAttitudeStore::~SatAttitudeStore()
+    {
+        for(int i = 0; i < MaxNumEpochs; ++i) delete ring[i];
+        delete [] ring;
+
+    }  // End of destructor 'SatAttitudeStore::~SatAttitudeStore()'
+
+
+
+    // Get the attitude and Sun geometry of a satellite.
+    bool SatAttitudeStore::getAttitude( const CommonTime& time,
+                                        const SatID& sat,
+                                        SatAttitudeData& att )
+    {
+        const int idx( indexOf(sat) );
+
+        bool valid(false);
+
+        if( idx >= 0 )
+        {
+            try
+            {
+                Reader reader(*this);
+
+                const SatEntry* entry( getEntry(time, sat, idx) );
+
+                if( entry != NULL && entry->valid )
+                {
+                    att = entry->data;
+                    valid = true;
+                }
+            }
+            catch(...)
+            {
+                valid = false;
+            }
+
+            return valid;
+        }
+
+        // Satellites out of the tables are not kept
+#ifdef USE_OPENMP
+    #pragma omp critical(SatAttitudeStore)
+#endif
+        {
+            try
+            {
+                EpochData& ed( getEpochData(time) );
+
+                valid = ed.haveSun &&
+                        computeAttitude(time, sat, ed.sunPos, att);
+            }
+            catch(...)
+            {
+                valid = false;
+            }
+        }
+
+        return valid;
+
+    }  // End of method 'SatAttitudeStore::getAttitude()'
+
+
+
+    // Get the attitude and Sun geometry of a satellite, without any copy.
+    const SatAttitudeData& SatAttitudeStore::getAttitude(
+                                                    const Reader& reader,
+                                                    const CommonTime& time,
+                                                    const SatID& sat )
+        throw(InvalidRequest)
+    {
+        const int idx( indexOf(sat) );
+
+        const SatEntry* entry( (idx >= 0) ? getEntry(time, sat, idx) : NULL );
+
+        if( entry == NULL || !entry->valid )
+        {
+            InvalidRequest e("Attitude not available.");
+            GPSTK_THROW(e);
+        }
+
+        return entry->data;
+
+    }  // End of method 'SatAttitudeStore::getAttitude()'
+
+
+
+    // Entry of a satellite at an epoch, computing it if needed
+    const SatAttitudeStore::SatEntry*
+    SatAttitudeStore::getEntry( const CommonTime& time,
+                                const SatID& sat,
+                                int idx )
+    {
+        // Data already computed, without any lock
+        const EpochData* found( findEpoch(time) );
+        const SatEntry* entry( (found != NULL) ? found->entries[idx] : NULL );
+
+        if( entry != NULL ) return entry;
+
+        // Otherwise compute it, one thread at a time
+#ifdef USE_OPENMP
+    #pragma omp critical(SatAttitudeStore)
+#endif
+        {
+            try
+            {
+                EpochData& ed( getEpochData(time) );
+
+                SatEntry* newEntry( ed.entries[idx] );
+
+                if( newEntry == NULL )
+                {
+                    newEntry = new SatEntry;
+                    newEntry->valid = ed.haveSun &&
+                        computeAttitude(time, sat, ed.sunPos, newEntry->data);
+
+                    // the entry must be complete before readers see it
+#ifdef USE_OPENMP
+    #pragma omp flush
+#endif
+                    ed.entries[idx] = newEntry;
+                }
+
+                entry = newEntry;
+            }
+            catch(...)
+            {
+                entry = NULL;
+            }
+        }
+
+        return entry;
+
+    }  // End of method 'SatAttitudeStore::getEntry()'
+
+
+
+    // Get the Sun position (ECEF) at an epoch, in m
+    Triple SatAttitudeStore::getSunPosition(const CommonTime& time)
+        throw(InvalidRequest)
+    {
+        bool found(false);
+        bool haveSun(false);
+        Triple sunPos;
+
+        try
+        {
+            Reader reader(*this);
+
+            const EpochData* ed( findEpoch(time) );
+            if( ed != NULL )
+            {
+                found = true;
+                haveSun = ed->haveSun;
+                sunPos = ed->sunPos;
+            }
+        }
+        catch(...)
+        {
+            found = false;
+        }
+
+        if( !found )
+        {
+#ifdef USE_OPENMP
+    #pragma omp critical(SatAttitudeStore)
+#endif
+            {
+                try
+                {
+                    EpochData& ed( getEpochData(time) );
+
+                    haveSun = ed.haveSun;
+                    sunPos = ed.sunPos;
+                }
+                catch(...)
+                {
+                    haveSun = false;
+                }
+            }
+        }
+
+        if(!haveSun)
+        {
+            InvalidRequest e("Sun position not available.");
+            GPSTK_THROW(e);
+        }
+
+        return sunPos;
+
+    }  // End of method 'SatAttitudeStore::getSunPosition()'
+
+
+
+    // Drop all the data computed so far
+    void SatAttitudeStore::clear()
+    {
+#ifdef USE_OPENMP
+    #pragma omp critical(SatAttitudeStore)
+#endif
+        {
+            for(int i = 0; i < MaxNumEpochs; ++i)
+            {
+                EpochData* old( ring[i] );
+                ring[i] = NULL;
+                reclaimer.retire(old, &deleteEpochData);
+            }
+
+            nextSlot = 0;
+
+            reclaimer.collect();
+        }
+
+    }  // End of method 'SatAttitudeStore::clear()'
+
+
+
+    // Position of the satellite in the entries, or -1 if out of range
+    int SatAttitudeStore::indexOf(const SatID& sat)
+    {
+        if( sat.system < 1 || sat.system > SatID::systemUnknown ||
+            sat.id < 0 || sat.id >= MaxSatNumber ) return -1;
+
+        return (sat.system - 1)*MaxSatNumber + sat.id;
+
+    }  // End of method 'SatAttitudeStore::indexOf()'
+
+
+
+    // Allocate the (empty) ring of epochs
+    void SatAttitudeStore::initRing()
+    {
+        ring = new EpochData* volatile[MaxNumEpochs];
+        for(int i = 0; i < MaxNumEpochs; ++i) ring[i] = NULL;
+
+        nextSlot = 0;
+
+    }  // End of method 'SatAttitudeStore::initRing()'
+
+
+
+    // Published data of an epoch, or NULL
+    const SatAttitudeStore::EpochData*
+    SatAttitudeStore::findEpoch(const CommonTime& time) const
+    {
+        for(int i = 0; i < MaxNumEpochs; ++i)
+        {
+            const EpochData* ed( ring[i] );
+            if( ed != NULL && ed->time == time ) return ed;
+        }
+
+        return NULL;
+
+    }  // End of method 'SatAttitudeStore::findEpoch()'
+
+
+
+    // Get the data of an epoch, creating it if needed
+    SatAttitudeStore::EpochData&
+    SatAttitudeStore::getEpochData(const CommonTime& time)
+    {
+        const EpochData* found( findEpoch(time) );
+        if( found != NULL ) return const_cast<EpochData&>(*found);
+
+        EpochData* ed( new EpochData(time) );
+
+        try
+        {
+            SunPosition sunPosition;
+            ed->sunPos = sunPosition.getPosition(time);
+            ed->haveSun = true;
+        }
+        catch(...)
+        {
+            ed->haveSun = false;
+        }
+
+        // Replace the oldest epoch; it is deleted once no reader uses it
+        if( nextSlot >= numEpochs ) nextSlot = 0;
+
+        EpochData* old( ring[nextSlot] );
+
+#ifdef USE_OPENMP
+    #pragma omp flush
+#endif
+        ring[nextSlot] = ed;
+
+        nextSlot = (nextSlot + 1) % numEpochs;
+
+        reclaimer.retire(old, &deleteEpochData);
+        reclaimer.collect();
+
+        return *ed;
+
+    }  // End of method 'SatAttitudeStore::getEpochData()'
+
+
+
+    // Compute the attitude data of a satellite
+    bool SatAttitudeStore::computeAttitude( const CommonTime& time,
+                                            const SatID& sat,
+                                            const Triple& sunPos,
+                                            SatAttitudeData& att ) const
+    {
+        if(pEphStore == NULL) return false;
+
+        Xvt xvt;
+        try
+        {
+            xvt = pEphStore->getXvt(sat, time);
+        }
+        catch(...)
+        {
+            return false;
+        }
+
+        att.satPos = xvt.x;
+        att.satVel = xvt.v;
+        att.sunPos = sunPos;
+
+        computeFrame(sat, att);
+
+        return true;
+
+    }  // End of method 'SatAttitudeStore::computeAttitude()'
+
+
+
+    // Compute the body frame and orbit geometry of a satellite
+    void SatAttitudeStore::computeFrame( const SatID& sat,
+                                         SatAttitudeData& att ) const
+    {
+        const Triple& r(att.satPos);
+        const Triple& sunPos(att.sunPos);
+
+        // Nominal body frame: rk to the geocenter, rj = rk x (sat->sun),
+        // ri = rj x rk
+        att.rk = (-1.0)*(r.unitVector());
+        att.rj = ( att.rk.cross(sunPos - r) ).unitVector();
+        att.ri = ( att.rj.cross(att.rk) ).unitVector();
+
+        // Orbital frame, with the inertial velocity
+        Triple vi( att.satVel[0] - OMEGA_EARTH*r[1],
+                   att.satVel[1] + OMEGA_EARTH*r[0],
+                   att.satVel[2] );
+
+        Triple h( r.cross(vi) );
+        double radius( r.mag() );
+
+        Triple er( r.unitVector() );
+        Triple en( h.unitVector() );
+        Triple et( en.cross(er) );
+
+        // Mean motion, in rad/s
+        double muDot( h.mag()/(radius*radius) );
+
+        Triple es( sunPos.unitVector() );
+
+        att.beta = std::asin( es.dot(en) );
+
+        // Orbit angle, from the midnight direction
+        Triple midnight( ( (-1.0)*(es - es.dot(en)*en) ).unitVector() );
+        att.mu = std::atan2( midnight.cross(er).dot(en), midnight.dot(er) );
+
+        att.nominalYaw = std::atan2( att.ri.dot(en), att.ri.dot(et) );
+        att.yaw = att.nominalYaw;
+        att.inTurn = false;
+
+        // Noon and midnight turns at the maximum yaw rate. The nominal yaw
+        // is atan2(tan(beta), sin(mu)), and its rate is largest, mu'/tan(beta),
+        // at mu = 0 and mu = PI.
+        double rate( defaultYawRate );
+        map<SatID, double>::const_iterator itRate( satYawRate.find(sat) );
+        if( itRate != satYawRate.end() ) rate = itRate->second;
+
+        double tb( std::tan(att.beta) );
+        if( std::abs(tb) < 1.0e-9 ) tb = (tb < 0.0) ? -1.0e-9 : 1.0e-9;
+
+        if( rate > 0.0 && std::abs(tb) < muDot/rate )
+        {
+            // Half width of the turn, in orbit angle
+            double xs( std::sqrt( muDot*std::abs(tb)/rate - tb*tb ) );
+
+            for(int k = 0; k < 2; ++k)
+            {
+                double center( k*PI );
+
+                double dm( att.mu - center );
+                while(dm > PI) dm -= TWO_PI;
+                while(dm <= -PI) dm += TWO_PI;
+
+                if( dm < -xs || dm >= PI/2.0 ) continue;
+
+                // Direction of the turn
+                double dir( (-tb*std::cos(center) > 0.0) ? 1.0 : -1.0 );
+
+                double yawStart( std::atan2( tb, std::sin(center-xs) ) );
+                double yawTurn( yawStart + dir*rate*(dm + xs)/muDot );
+                double yawNominal( std::atan2( tb, std::sin(att.mu) ) );
+
+                // Still behind the nominal yaw
+                if( dir*(yawTurn - yawNominal) < 0.0 )
+                {
+                    att.yaw = att.nominalYaw + (yawTurn - yawNominal);
+                    att.inTurn = true;
+
+                    att.ri = std::cos(att.yaw)*et + std::sin(att.yaw)*en;
+                    att.ri = ( att.ri - att.ri.dot(att.rk)*att.rk ).unitVector();
+                    att.rj = att.rk.cross(att.ri);
+                }
+
+                break;
+            }
+        }
+
+        // Eclipse
+        att.sunCosAngle = er.dot(es);
+
+        double along( r.dot(es) );
+        att.inShadow = ( along < 0.0 ) &&
+                       ( (r - along*es).mag() < RE_EARTH );
+
+    }  // End of method 'SatAttitudeStore::computeFrame()'
+
+
+}  // End of namespace gpstk
@@ -0,0 +1,381 @@
+#pragma ident "$Id$"
+
+/**
+ * @file SatAttitudeStore.hpp
+ * Per-epoch attitude and Sun geometry of the satellites, shared by the
+ * processing classes of all the stations.
+ */
+
+#ifndef GPSTK_SATATTITUDESTORE_HPP
+#define GPSTK_SATATTITUDESTORE_HPP
+
+//============================================================================
+//
+//  This file is part of GPSTk, the GPS Toolkit.
+//
+//  The GPSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 2.1 of the License, or
+//  any later version.
+//
+//  The GPSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GPSTk; if not, write to the Free Software Foundation,
+//  Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//============================================================================
+
+
+#include <map>
+#include "CommonTime.hpp"
+#include "EpochReclaimer.hpp"
+#include "SatID.hpp"
+#include "Triple.hpp"
+#include "XvtStore.hpp"
+#include "SunPosition.hpp"
+#include "constants.hpp"
+
+
+namespace gpstk
+{
+
+    /// @ingroup DataStructures
+    //@{
+
+    /// Attitude and Sun geometry of a satellite at an epoch
+    struct SatAttitudeData
+    {
+        /// Satellite position and velocity (ECEF), in m and m/s
+        Triple satPos;
+        Triple satVel;
+
+        /// Sun position (ECEF), in m
+        Triple sunPos;
+
+        /** Unit vectors of the satellite body frame (ECEF): 'rk' points to
+         *  the geocenter, 'ri' is in the plane of 'rk' and the Sun,
+         *  towards the Sun, and 'rj = rk x ri' is the rotation axis of the
+         *  solar panels.
+         */
+        Triple ri;
+        Triple rj;
+        Triple rk;
+
+        /// Elevation of the Sun above the orbital plane, in radians
+        double beta;
+
+        /// Orbit angle of the satellite from midnight, in radians
+        double mu;
+
+        /// Nominal yaw angle, and yaw angle actually used, in radians.
+        /// Both are measured from the along-track direction towards the
+        /// orbit normal.
+        double nominalYaw;
+        double yaw;
+
+        /// Whether the satellite is in a noon or midnight turn
+        bool inTurn;
+
+        /// Cosine of the angle between the Earth-Sun and Earth-satellite
+        /// directions
+        double sunCosAngle;
+
+        /// Whether the satellite is in the (cylindrical) Earth shadow
+        bool inShadow;
+
+    }; // End of struct 'SatAttitudeData'
+
+
+
+    /** This class computes, once per satellite and epoch, the attitude of
+     *  the satellites and the Sun geometry needed by the processing classes
+     *  ComputeWindUp, ComputeSatPCenter, ComputeSatPCenter2 and
+     *  EclipsedSatFilter.
+     *
+     * The attitude of a satellite at an epoch is the same for all the
+     * stations, so the same object should be given to the processing
+     * classes of all of them; they then only compute the station dependent
+     * part, i.e., the projections on the line of sight.
+     *
+     * The body frame follows the nominal yaw-steering attitude, but the yaw
+     * angle can not change faster than the maximum yaw rate of the
+     * satellite. When the Sun is close to the orbital plane, the nominal
+     * yaw rate at orbit noon and midnight exceeds it, and the satellite is
+     * turned at the maximum yaw rate from the start of the turn until it
+     * meets the nominal yaw again (Kouba, 2009). The special behaviour of
+     * some blocks within the Earth shadow is not modeled; such satellites
+     * are flagged with 'inShadow', and EclipsedSatFilter may be used to
+     * take them out.
+     *
+     * A typical way to use this class follows:
+     *
+     * @code
+     *   SP3EphemerisStore sp3Eph;
+     *   ...
+     *   SatAttitudeStore attitude(sp3Eph);
+     *
+     *   ComputeWindUp windup;
+     *   windup.setAttitudeStore(attitude);
+     *
+     *   ComputeSatPCenter svPcenter;
+     *   svPcenter.setAttitudeStore(attitude);
+     *
+     *   gnssDataMap gData;
+     *   while( ... )
+     *   {
+     *      gData >> ... >> windup >> svPcenter >> ...;
+     *   }
+     * @endcode
+     *
+     * The data is computed the first time that it is asked for, and the
+     * last epochs are kept. It is safe to use the same object from several
+     * OpenMP threads: data already computed is read without any lock, and
+     * only the computation of new data is serialized. The setters must not
+     * be called while other threads use the object.
+     *
+     * The processing classes read the cached data by reference, holding
+     * a SatAttitudeStore::Reader while they use it. The body frame is the
+     * one at the position of the ephemeris at the epoch, not at the
+     * transmission time seen by each station. The satellite moves by less
+     * than 300 m in between, which turns 'rk' by less than 2.0e-5 rad and
+     * 'ri' and 'rj' by less than 2.0e-4 rad, even close to orbit noon and
+     * midnight: less than 0.1 mm of antenna offset and 0.01 mm of phase
+     * wind-up.
+     */
+    class SatAttitudeStore
+    {
+    public:
+
+        /// Keeps the data read by reference alive while it exists
+        class Reader
+        {
+        public:
+
+            /// Common constructor
+            explicit Reader(const SatAttitudeStore& store)
+                : reclaimer(store.reclaimer), slot(store.reclaimer.enter())
+            {};
+
+            /// Destructor
+            ~Reader()
+            { reclaimer.leave(slot); };
+
+        private:
+
+            const EpochReclaimer& reclaimer;
+            int slot;
+
+            Reader(const Reader&);
+            Reader& operator=(const Reader&);
+
+        }; // End of class 'SatAttitudeStore::Reader'
+
+
+        /// Default constructor
+        SatAttitudeStore()
+            : pEphStore(NULL), defaultYawRate(0.2*DEG_TO_RAD), numEpochs(2)
+        { initRing(); };
+
+
+        /** Common constructor.
+         *
+         * @param ephStore  Satellite ephemeris store, giving positions and
+         *                  velocities.
+         */
+        SatAttitudeStore(XvtStore<SatID>& ephStore)
+            : pEphStore(&ephStore), defaultYawRate(0.2*DEG_TO_RAD),
+              numEpochs(2)
+        { initRing(); };
+
+
+        /// Set the satellite ephemeris store
+        SatAttitudeStore& setEphStore(XvtStore<SatID>& ephStore)
+        { pEphStore = &ephStore; clear(); return (*this); };
+
+        /// Get a pointer to the satellite ephemeris store
+        XvtStore<SatID>* getEphStore() const
+        { return pEphStore; };
+
+
+        /// Set the maximum yaw rate of the satellites, in degrees/s
+        SatAttitudeStore& setMaxYawRate(double rate)
+        { defaultYawRate = rate*DEG_TO_RAD; clear(); return (*this); };
+
+        /// Set the maximum yaw rate of a satellite, in degrees/s
+        SatAttitudeStore& setMaxYawRate(const SatID& sat, double rate)
+        { satYawRate[sat] = rate*DEG_TO_RAD; clear(); return (*this); };
+
+        /// Get the maximum yaw rate of a satellite, in degrees/s
+        double getMaxYawRate(const SatID& sat) const;
+
+
+        /// Set the number of epochs kept, at most MaxNumEpochs
+        SatAttitudeStore& setNumEpochs(int num)
+        {
+            numEpochs = (num < 1) ? 1 : (num > MaxNumEpochs) ? MaxNumEpochs
+                                                             : num;
+            clear();
+            return (*this);
+        };
+
+        /// Get the number of epochs kept
+        int getNumEpochs() const
+        { return numEpochs; };
+
+
+        /** Get the attitude and Sun geometry of a satellite, with the body
+         *  frame at the position of the ephemeris at 'time'.
+         *
+         * @param time      Epoch of interest.
+         * @param sat       Satellite.
+         * @param att       Attitude data of the satellite.
+         *
+         * @return  Whether the data is available. It is not when there is
+         *          no ephemeris for the satellite at that epoch.
+         */
+        bool getAttitude( const CommonTime& time,
+                          const SatID& sat,
+                          SatAttitudeData& att );
+
+
+        /** Get the attitude and Sun geometry of a satellite, without any
+         *  copy.
+         *
+         * @param reader    Reader, to be kept while the data is used.
+         * @param time      Epoch of interest.
+         * @param sat       Satellite.
+         *
+         * @return  Attitude data of the satellite, valid while 'reader'
+         *          exists.
+         *
+         * @throw InvalidRequest if the data is not available.
+         */
+        const SatAttitudeData& getAttitude( const Reader& reader,
+                                            const CommonTime& time,
+                                            const SatID& sat )
+            throw(InvalidRequest);
+
+
+        /// Get the Sun position (ECEF) at an epoch, in m
+        Triple getSunPosition(const CommonTime& time)
+            throw(InvalidRequest);
+
+
+        /// Drop all the data computed so far
+        void clear();
+
+
+        /// Destructor
+        virtual ~SatAttitudeStore();
+
+
+        /// Largest number of epochs kept
+        static const int MaxNumEpochs = 16;
+
+
+    private:
+
+        /// Attitude data of a satellite, and whether it is valid
+        struct SatEntry
+        {
+            bool valid;
+            SatAttitudeData data;
+        };
+
+        /// Largest satellite number, plus one
+        static const int MaxSatNumber = 256;
+
+        /// Number of satellite entries of an epoch, one per system and
+        /// satellite number
+        static const int NumIndex = SatID::systemUnknown * MaxSatNumber;
+
+        /// Data of an epoch. Once published, only null entries change.
+        struct EpochData
+        {
+            EpochData(const CommonTime& t);
+            ~EpochData();
+
+            CommonTime time;
+
+            bool haveSun;
+            Triple sunPos;
+
+            /// Entries of the satellites, NULL until computed
+            SatEntry* volatile* entries;
+
+        private:
+            EpochData(const EpochData&);
+            EpochData& operator=(const EpochData&);
+        };
+
+
+        /// Position of the satellite in the entries, or -1 if out of range
+        static int indexOf(const SatID& sat);
+
+        /// Allocate the (empty) ring of epochs
+        void initRing();
+
+        /// Published data of an epoch, or NULL. Readers must be between
+        /// reclaimer.enter() and reclaimer.leave(), or in the critical
+        /// section.
+        const EpochData* findEpoch(const CommonTime& time) const;
+
+        /// Get the data of an epoch, creating it if needed. Only in the
+        /// critical section.
+        EpochData& getEpochData(const CommonTime& time);
+
+        /// Compute the attitude data of a satellite
+        bool computeAttitude( const CommonTime& time,
+                              const SatID& sat,
+                              const Triple& sunPos,
+                              SatAttitudeData& att ) const;
+
+        /// Compute the body frame and orbit geometry of 'att' from its
+        /// satellite position and velocity and Sun position
+        void computeFrame( const SatID& sat,
+                           SatAttitudeData& att ) const;
+
+        /// Entry of a satellite at an epoch, computing it if needed, or
+        /// NULL. The caller must hold a Reader.
+        const SatEntry* getEntry( const CommonTime& time,
+                                  const SatID& sat,
+                                  int idx );
+
+        static void deleteEpochData(void* p)
+        { delete static_cast<EpochData*>(p); }
+
+
+        /// Satellite ephemeris store
+        XvtStore<SatID>* pEphStore;
+
+        /// Maximum yaw rate, in radians/s
+        double defaultYawRate;
+        std::map<SatID, double> satYawRate;
+
+        /// Number of epochs kept
+        int numEpochs;
+
+        /// Data of the last epochs, MaxNumEpochs slots used in turn
+        EpochData* volatile* ring;
+
+        /// Next slot of 'ring' to be replaced
+        int nextSlot;
+
+        /// Deletes the replaced epochs once no reader uses them
+        mutable EpochReclaimer reclaimer;
+
+
+        SatAttitudeStore(const SatAttitudeStore&);
+        SatAttitudeStore& operator=(const SatAttitudeStore&);
+
+    }; // End of class 'SatAttitudeStore'
+
+    //@}
+
+}  // End of namespace gpstk
+
+#endif   // GPSTK_SATATTITUDESTORE_HPP
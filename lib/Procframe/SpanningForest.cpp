@@ -0,0 +1,471 @@
+#pragma ident "$Id$"
+
+/**
+ * @file SpanningForest.cpp
+ * Class to maintain the spanning forest of the 'observed' network from
+ * epoch to epoch, updating it only where arcs start or end.
+ */
+
+//============================================================================
+//
+//  This file is part of GPSTk, the GPS Toolkit.
+//
+//  The GPSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 2.1 of the License, or
+//  any later version.
+//
+//  The GPSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GPSTk; if not, write to the Free Software Foundation,
+//  Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//============================================================================
+
+
+#include <algorithm>
+
+#include "SpanningForest.hpp"
+
+namespace gpstk
+{
+
+   using namespace std;
+
+
+      // Start the edges of a new epoch
+   void SpanningForest::beginEpoch()
+   {
+      ++epochNumber;
+
+      addedEdges.clear();
+      splitRoots.clear();
+
+      numAdded = numRemoved = 0;
+      numTreeAdded = numTreeRemoved = 0;
+
+      inEpoch = true;
+
+   }  // End of method 'SpanningForest::beginEpoch()'
+
+
+
+      /* Give an edge of the current epoch.
+       *
+       * @param edge      Observed edge.
+       */
+   void SpanningForest::addEdge(const Edge& edge)
+   {
+      if( !inEpoch ) beginEpoch();
+
+      int s( sourceIndex( edge.getSource() ) );
+      int t( satIndex( edge.getSatellite() ) );
+
+      vector<int>& row( edgeOf[s] );
+      if( t >= (int)row.size() ) row.resize(t+1, -1);
+
+      int e( row[t] );
+
+      if( e >= 0 )
+      {
+         EdgeData& data( edgeIndex[e] );
+
+            // Same arc: only refresh its weight
+         if( data.edge.getArcNumber() == edge.getArcNumber() )
+         {
+            if( data.lastSeen != epochNumber )
+            {
+               data.lastSeen = epochNumber;
+               data.age++;
+            }
+            data.edge.setApriWeight( edge.getApriWeight() );
+            data.edge.setElevation( edge.getElevation() );
+            return;
+         }
+
+            // A new arc of the same receiver and satellite ends the old one
+         removeEdge(e);
+      }
+
+         // Take a free index, or a new one
+      if( freeIndex.empty() )
+      {
+         e = edgeIndex.size();
+         edgeIndex.push_back( EdgeData() );
+      }
+      else
+      {
+         e = freeIndex.back();
+         freeIndex.pop_back();
+      }
+
+      EdgeData& data( edgeIndex[e] );
+      data.edge = edge;
+      data.source = s;
+      data.sat = t;
+      data.u = sourceVertex[s];
+      data.v = satVertex[t];
+      data.age = 1;
+      data.lastSeen = epochNumber;
+      data.active = true;
+      data.inTree = false;
+
+      row[t] = e;
+      incident[data.u].push_back(e);
+      incident[data.v].push_back(e);
+
+      addedEdges.push_back(e);
+      numAdded++;
+
+   }  // End of method 'SpanningForest::addEdge()'
+
+
+
+      // Remove the edges not given since beginEpoch(), and update the forest
+   void SpanningForest::endEpoch()
+   {
+      if( !inEpoch ) beginEpoch();
+
+         // Firstly, the arcs that ended
+      for(int e = 0; e < (int)edgeIndex.size(); ++e)
+      {
+         if( edgeIndex[e].active && edgeIndex[e].lastSeen != epochNumber )
+         {
+            removeEdge(e);
+         }
+      }
+
+         // Candidate edges to join the trees
+      vector<int> candidates;
+      vector<char> isCandidate( edgeIndex.size(), 0 );
+
+         // Secondly, the trees that were split. The union-find still holds
+         // the trees of the previous epoch, so the vertices of a split tree
+         // are those with one of the recorded roots. Any edge that could
+         // join its pieces again is incident to one of them, and once the
+         // union-find holds the pieces, its ends are in different ones.
+      if( !splitRoots.empty() )
+      {
+         const int nv( parent.size() );
+
+         vector<char> isSplitRoot( nv, 0 );
+         for(size_t i = 0; i < splitRoots.size(); ++i)
+         {
+            isSplitRoot[ splitRoots[i] ] = 1;
+         }
+
+         vector<int> splitVertex;
+         for(int x = 0; x < nv; ++x)
+         {
+            if( isSplitRoot[ findRoot(x) ] ) splitVertex.push_back(x);
+         }
+
+         rebuildTrees();
+
+         for(size_t i = 0; i < splitVertex.size(); ++i)
+         {
+            const vector<int>& inc( incident[ splitVertex[i] ] );
+            for(size_t j = 0; j < inc.size(); ++j)
+            {
+               int e( inc[j] );
+               if( edgeIndex[e].inTree || isCandidate[e] ) continue;
+
+               if( findRoot( edgeIndex[e].u ) != findRoot( edgeIndex[e].v ) )
+               {
+                  isCandidate[e] = 1;
+                  candidates.push_back(e);
+               }
+            }
+         }
+      }
+
+         // Thirdly, the new edges
+      for(size_t i = 0; i < addedEdges.size(); ++i)
+      {
+         int e( addedEdges[i] );
+         if( edgeIndex[e].active && !isCandidate[e] )
+         {
+            isCandidate[e] = 1;
+            candidates.push_back(e);
+         }
+      }
+
+         // Kruskal over the candidates only
+      sort( candidates.begin(), candidates.end(),
+            WeightOrder(edgeIndex, weightType) );
+
+      for(size_t i = 0; i < candidates.size(); ++i)
+      {
+         EdgeData& data( edgeIndex[ candidates[i] ] );
+         if( unite(data.u, data.v) )
+         {
+            data.inTree = true;
+            numTreeAdded++;
+         }
+      }
+
+      addedEdges.clear();
+      splitRoots.clear();
+
+      inEpoch = false;
+
+   }  // End of method 'SpanningForest::endEpoch()'
+
+
+
+      // Forget all the edges and vertices
+   void SpanningForest::reset()
+   {
+      sourceMap.clear();
+      satMap.clear();
+      sourceVertex.clear();
+      satVertex.clear();
+      edgeOf.clear();
+      edgeIndex.clear();
+      freeIndex.clear();
+      incident.clear();
+      parent.clear();
+      rank.clear();
+      addedEdges.clear();
+      splitRoots.clear();
+
+      inEpoch = false;
+      numAdded = numRemoved = 0;
+      numTreeAdded = numTreeRemoved = 0;
+
+   }  // End of method 'SpanningForest::reset()'
+
+
+
+      // The edges of the forest
+   EdgeSet SpanningForest::getTreeEdges() const
+   {
+      EdgeSet treeEdges;
+
+      for(size_t e = 0; e < edgeIndex.size(); ++e)
+      {
+         if( edgeIndex[e].active && edgeIndex[e].inTree )
+         {
+            treeEdges.insert( edgeIndex[e].edge );
+         }
+      }
+
+      return treeEdges;
+
+   }  // End of method 'SpanningForest::getTreeEdges()'
+
+
+
+      // Whether the given arc is an edge of the forest
+   bool SpanningForest::isTreeEdge(const Arc& arc) const
+   {
+      map<SourceID, int>::const_iterator its( sourceMap.find(arc.getSource()) );
+      if( its == sourceMap.end() ) return false;
+
+      map<SatID, int>::const_iterator itt( satMap.find(arc.getSatellite()) );
+      if( itt == satMap.end() ) return false;
+
+      const vector<int>& row( edgeOf[its->second] );
+      if( itt->second >= (int)row.size() || row[itt->second] < 0 ) return false;
+
+      const EdgeData& data( edgeIndex[ row[itt->second] ] );
+
+      return ( data.inTree &&
+               data.edge.getArcNumber() == arc.getArcNumber() );
+
+   }  // End of method 'SpanningForest::isTreeEdge()'
+
+
+
+      // Number of edges in the forest
+   int SpanningForest::getNumTreeEdges() const
+   {
+      int n(0);
+      for(size_t e = 0; e < edgeIndex.size(); ++e)
+      {
+         if( edgeIndex[e].active && edgeIndex[e].inTree ) n++;
+      }
+
+      return n;
+
+   }  // End of method 'SpanningForest::getNumTreeEdges()'
+
+
+
+      // Sort candidate edges by weight
+   bool SpanningForest::WeightOrder::operator()(int a, int b) const
+   {
+      const EdgeData& da( edges[a] );
+      const EdgeData& db( edges[b] );
+
+      if( type == ElevationWeight )
+      {
+         if( da.edge.getElevVariance() != db.edge.getElevVariance() )
+         {
+            return ( da.edge.getElevVariance() < db.edge.getElevVariance() );
+         }
+         if( da.edge.getApriVariance() != db.edge.getApriVariance() )
+         {
+            return ( da.edge.getApriVariance() < db.edge.getApriVariance() );
+         }
+      }
+      else if( type == ArcLengthWeight )
+      {
+         if( da.age != db.age )
+         {
+            return ( da.age > db.age );
+         }
+      }
+
+      return ( da.edge < db.edge );
+
+   }  // End of method 'SpanningForest::WeightOrder::operator()'
+
+
+
+      // Index of the receiver, creating its vertex if needed
+   int SpanningForest::sourceIndex(const SourceID& source)
+   {
+      map<SourceID, int>::iterator it( sourceMap.find(source) );
+      if( it != sourceMap.end() ) return it->second;
+
+      int s( sourceVertex.size() );
+      sourceMap[source] = s;
+      sourceVertex.push_back( newVertex() );
+      edgeOf.push_back( vector<int>( satVertex.size(), -1 ) );
+
+      return s;
+
+   }  // End of method 'SpanningForest::sourceIndex()'
+
+
+
+      // Index of the satellite, creating its vertex if needed
+   int SpanningForest::satIndex(const SatID& sat)
+   {
+      map<SatID, int>::iterator it( satMap.find(sat) );
+      if( it != satMap.end() ) return it->second;
+
+      int t( satVertex.size() );
+      satMap[sat] = t;
+      satVertex.push_back( newVertex() );
+
+      return t;
+
+   }  // End of method 'SpanningForest::satIndex()'
+
+
+
+      // New vertex, alone in its tree
+   int SpanningForest::newVertex()
+   {
+      int x( parent.size() );
+
+      parent.push_back(x);
+      rank.push_back(0);
+      incident.push_back( vector<int>() );
+
+      return x;
+
+   }  // End of method 'SpanningForest::newVertex()'
+
+
+
+      // Remove edge 'e' from the graph
+   void SpanningForest::removeEdge(int e)
+   {
+      EdgeData& data( edgeIndex[e] );
+
+         // Its tree will be split: remember it, as known before this epoch
+      if( data.inTree )
+      {
+         splitRoots.push_back( findRoot(data.u) );
+         numTreeRemoved++;
+      }
+
+      int ends[2] = { data.u, data.v };
+      for(int k = 0; k < 2; ++k)
+      {
+         vector<int>& inc( incident[ ends[k] ] );
+         vector<int>::iterator it( find(inc.begin(), inc.end(), e) );
+         if( it != inc.end() )
+         {
+            *it = inc.back();
+            inc.pop_back();
+         }
+      }
+
+      edgeOf[data.source][data.sat] = -1;
+
+      data.active = false;
+      data.inTree = false;
+      freeIndex.push_back(e);
+
+      numRemoved++;
+
+   }  // End of method 'SpanningForest::removeEdge()'
+
+
+
+      // Root of the tree of vertex 'x', compressing the path
+   int SpanningForest::findRoot(int x)
+   {
+      int root(x);
+      while( parent[root] != root ) root = parent[root];
+
+      while( parent[x] != root )
+      {
+         int next( parent[x] );
+         parent[x] = root;
+         x = next;
+      }
+
+      return root;
+
+   }  // End of method 'SpanningForest::findRoot()'
+
+
+
+      // Join the trees of 'x' and 'y'; false if they were the same
+   bool SpanningForest::unite(int x, int y)
+   {
+      int rx( findRoot(x) );
+      int ry( findRoot(y) );
+
+      if( rx == ry ) return false;
+
+      if( rank[rx] < rank[ry] ) std::swap(rx, ry);
+      parent[ry] = rx;
+      if( rank[rx] == rank[ry] ) rank[rx]++;
+
+      return true;
+
+   }  // End of method 'SpanningForest::unite()'
+
+
+
+      // Rebuild the union-find from the edges of the forest
+   void SpanningForest::rebuildTrees()
+   {
+      for(size_t x = 0; x < parent.size(); ++x)
+      {
+         parent[x] = x;
+         rank[x] = 0;
+      }
+
+      for(size_t e = 0; e < edgeIndex.size(); ++e)
+      {
+         if( edgeIndex[e].active && edgeIndex[e].inTree )
+         {
+            unite( edgeIndex[e].u, edgeIndex[e].v );
+         }
+      }
+
+   }  // End of method 'SpanningForest::rebuildTrees()'
+
+
+}  // End of namespace gpstk
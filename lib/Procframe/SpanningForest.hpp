@@ -0,0 +1,300 @@
+#pragma ident "$Id$"
+
+/**
+ * @file SpanningForest.hpp
+ * Class to maintain the spanning forest of the 'observed' network from
+ * epoch to epoch, updating it only where arcs start or end.
+ */
+
+#ifndef GPSTK_SPANNINGFOREST_HPP
+#define GPSTK_SPANNINGFOREST_HPP
+
+//============================================================================
+//
+//  This file is part of GPSTk, the GPS Toolkit.
+//
+//  The GPSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 2.1 of the License, or
+//  any later version.
+//
+//  The GPSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GPSTk; if not, write to the Free Software Foundation,
+//  Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//============================================================================
+
+
+#include <map>
+#include <vector>
+
+#include "Edge.hpp"
+
+
+namespace gpstk
+{
+
+      /** @addtogroup Graph */
+
+      //@{
+
+
+      /** This class maintains a spanning forest of the observation graph
+       *  (receivers and satellites as vertices, ambiguity arcs as edges)
+       *  across epochs, to select the independent ambiguities.
+       *
+       * Kruskal builds a new minimum spanning tree from all the edges at
+       * every epoch. Here, the forest of the previous epoch is kept, and
+       * only the edges of the arcs that started or ended are processed:
+       *
+       *    \li An edge that is not given again is removed. If it was in the
+       *        forest, its tree is split, and the lightest edges that join
+       *        the pieces again are added. The union-find is then rebuilt
+       *        from the forest edges, and only the edges between two
+       *        pieces of the split trees are candidates.
+       *    \li A new edge (new receiver-satellite pair, or new arc number)
+       *        is added to the forest if it joins two different trees.
+       *
+       * So the independent ambiguities (the datum) only change where the
+       * topology changed, and an epoch costs a scan of the edges plus work
+       * proportional to the changes; an epoch splitting a tree also
+       * rebuilds the union-find, in O(V+E), and visits the edges incident
+       * to the split trees. Vertices get dense integer IDs the
+       * first time they are seen, and the trees are tracked with a
+       * union-find over these IDs.
+       *
+       * The weight of an edge only matters when choosing among candidates;
+       * an edge in the forest is never replaced by a lighter one.
+       *
+       * A typical way to use this class follows:
+       *
+       * @code
+       *
+       *    SpanningForest forest(SpanningForest::ElevationWeight);
+       *
+       *       // For every epoch
+       *    forest.beginEpoch();
+       *    for( ... )
+       *       forest.addEdge( Edge(source, sat, satArc, weight, elev) );
+       *    forest.endEpoch();
+       *
+       *    EdgeSet indepEdges( forest.getTreeEdges() );
+       *
+       * @endcode
+       *
+       * @sa Kruskal.hpp, IndepAmbiguityDatum.hpp
+       */
+   class SpanningForest
+   {
+   public:
+
+         /// Order in which candidate edges are taken
+      enum WeightType
+      {
+            /// Smallest a priori variance first, then highest elevation;
+            /// the order of Edge (and of Kruskal)
+         VarianceWeight,
+            /// Highest elevation first, then smallest a priori variance
+         ElevationWeight,
+            /// Longest arc (most epochs seen) first, then as VarianceWeight
+         ArcLengthWeight
+      };
+
+
+         /** Common constructor.
+          *
+          * @param type      Order of the candidate edges.
+          */
+      SpanningForest(WeightType type = VarianceWeight)
+         : weightType(type), inEpoch(false), epochNumber(0),
+           numAdded(0), numRemoved(0),
+           numTreeAdded(0), numTreeRemoved(0)
+      {};
+
+
+         /// Set the order of the candidate edges
+      SpanningForest& setWeightType(WeightType type)
+      { weightType = type; return (*this); };
+
+
+         /// Get the order of the candidate edges
+      WeightType getWeightType() const
+      { return weightType; };
+
+
+         /// Start the edges of a new epoch
+      void beginEpoch();
+
+
+         /** Give an edge of the current epoch. An edge of the previous
+          *  epoch with the same receiver, satellite and arc number is kept,
+          *  with the weight and elevation of this one.
+          *
+          * @param edge      Observed edge.
+          */
+      void addEdge(const Edge& edge);
+
+
+         /// Remove the edges that were not given since beginEpoch(), and
+         /// update the forest.
+      void endEpoch();
+
+
+         /// Forget all the edges and vertices
+      void reset();
+
+
+         /// The edges of the forest, i.e. the independent ambiguities
+      EdgeSet getTreeEdges() const;
+
+
+         /// Whether the given arc is an edge of the forest
+      bool isTreeEdge(const Arc& arc) const;
+
+
+         /// Number of edges of the current epoch
+      int getNumEdges() const
+      { return (int)edgeIndex.size() - (int)freeIndex.size(); };
+
+
+         /// Number of edges in the forest
+      int getNumTreeEdges() const;
+
+
+         /// Number of edges added at the last epoch
+      int getNumAdded() const
+      { return numAdded; };
+
+
+         /// Number of edges removed at the last epoch
+      int getNumRemoved() const
+      { return numRemoved; };
+
+
+         /// Number of edges that entered the forest at the last epoch
+      int getNumTreeAdded() const
+      { return numTreeAdded; };
+
+
+         /// Number of edges that left the forest at the last epoch
+      int getNumTreeRemoved() const
+      { return numTreeRemoved; };
+
+
+         /// Destructor
+      virtual ~SpanningForest() {};
+
+
+   private:
+
+
+         /// An edge with its vertices and state
+      struct EdgeData
+      {
+         Edge edge;
+         int source;       ///< Receiver index
+         int sat;          ///< Satellite index
+         int u;            ///< Vertex ID of the receiver
+         int v;            ///< Vertex ID of the satellite
+         int age;          ///< Number of epochs the edge was given
+         int lastSeen;     ///< Last epoch the edge was given
+         bool active;      ///< False once removed (index is free)
+         bool inTree;      ///< Edge of the forest
+      };
+
+
+         /// Sort candidate edges by weight
+      struct WeightOrder
+      {
+         WeightOrder(const std::vector<EdgeData>& e, WeightType t)
+            : edges(e), type(t)
+         {};
+
+         bool operator()(int a, int b) const;
+
+         const std::vector<EdgeData>& edges;
+         WeightType type;
+      };
+
+
+         /// Index of the receiver, creating its vertex if needed
+      int sourceIndex(const SourceID& source);
+
+
+         /// Index of the satellite, creating its vertex if needed
+      int satIndex(const SatID& sat);
+
+
+         /// New vertex, alone in its tree
+      int newVertex();
+
+
+         /// Remove edge 'e' from the graph
+      void removeEdge(int e);
+
+
+         /// Root of the tree of vertex 'x', compressing the path
+      int findRoot(int x);
+
+
+         /// Join the trees of 'x' and 'y'; false if they were the same
+      bool unite(int x, int y);
+
+
+         /// Rebuild the union-find from the edges of the forest
+      void rebuildTrees();
+
+
+      WeightType weightType;
+
+         /// Whether beginEpoch() was called without endEpoch()
+      bool inEpoch;
+
+         /// Number of the current epoch
+      int epochNumber;
+
+         /// Vertex IDs of receivers and satellites
+      std::map<SourceID, int> sourceMap;
+      std::map<SatID, int> satMap;
+      std::vector<int> sourceVertex;
+      std::vector<int> satVertex;
+
+         /// Edge of each [receiver][satellite] pair, or -1
+      std::vector< std::vector<int> > edgeOf;
+
+         /// All the edges; removed ones are reused
+      std::vector<EdgeData> edgeIndex;
+      std::vector<int> freeIndex;
+
+         /// Edges incident to each vertex
+      std::vector< std::vector<int> > incident;
+
+         /// Union-find over the vertex IDs, joined by the forest edges
+      std::vector<int> parent;
+      std::vector<int> rank;
+
+         /// Edges added since beginEpoch()
+      std::vector<int> addedEdges;
+
+         /// Roots (before the epoch) of the trees that lost an edge
+      std::vector<int> splitRoots;
+
+         /// Statistics of the last epoch
+      int numAdded;
+      int numRemoved;
+      int numTreeAdded;
+      int numTreeRemoved;
+
+
+   }; // End of class 'SpanningForest'
+
+      //@}
+
+}  // End of namespace gpstk
+
+#endif   // GPSTK_SPANNINGFOREST_HPP
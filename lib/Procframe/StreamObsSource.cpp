@@ -0,0 +1,408 @@
+#pragma ident "$Id$"
+
+/**
+ * @file StreamObsSource.cpp
+ * Read the observation epochs of a network from byte streams, such as
+ * sockets or pipes.
+ */
+
+//============================================================================
+//
+//  This file is part of GPSTk, the GPS Toolkit.
+//
+//  The GPSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 2.1 of the License, or
+//  any later version.
+//
+//  The GPSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GPSTk; if not, write to the Free Software Foundation,
+//  Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//============================================================================
+
+
+#include <cerrno>
+#include <cstring>
+#include "StreamObsSource.hpp"
+#include "CivilTime.hpp"
+#include "StringUtils.hpp"
+
+#if !defined(_MSC_VER)
+#include <poll.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#endif
+
+using namespace std;
+
+
+namespace gpstk
+{
+
+      // Wall clock, in seconds since 1970
+    static double unixTime()
+    {
+#if !defined(_MSC_VER)
+        struct timeval tv;
+        gettimeofday(&tv, NULL);
+        return tv.tv_sec + tv.tv_usec*1.0e-6;
+#else
+        return 0.0;
+#endif
+    }
+
+
+
+      // Add a stream.
+    StreamObsSource& StreamObsSource::addStream( int fd,
+                                                 const std::string& name )
+    {
+        Stream stream;
+        stream.fd = fd;
+        stream.name = name.empty() ? ( "fd " + StringUtils::asString(fd) )
+                                   : name;
+        stream.pDecoder = new Rinex3ObsDecoder;
+
+        streams.push_back(stream);
+
+        return (*this);
+
+    }  // End of method 'StreamObsSource::addStream()'
+
+
+
+      // Connect to a TCP server and add the stream.
+    StreamObsSource& StreamObsSource::connectStream( const std::string& host,
+                                                     int port )
+        throw(Exception)
+    {
+        string name( host + ":" + StringUtils::asString(port) );
+
+#if !defined(_MSC_VER)
+        struct addrinfo hints;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+
+        struct addrinfo* res(NULL);
+        if( getaddrinfo( host.c_str(), StringUtils::asString(port).c_str(),
+                         &hints, &res ) != 0 )
+        {
+            Exception e("Unknown host " + host);
+            GPSTK_THROW(e);
+        }
+
+        int fd(-1);
+        for(struct addrinfo* p = res; p != NULL; p = p->ai_next)
+        {
+            fd = socket(p->ai_family, p->ai_socktype, p->ai_protocol);
+            if(fd < 0) continue;
+
+            if( connect(fd, p->ai_addr, p->ai_addrlen) == 0 ) break;
+
+            close(fd);
+            fd = -1;
+        }
+
+        freeaddrinfo(res);
+
+        if(fd < 0)
+        {
+            Exception e("Can not connect to " + name);
+            GPSTK_THROW(e);
+        }
+
+        return addStream(fd, name);
+#else
+        Exception e("Sockets are not supported on this platform.");
+        GPSTK_THROW(e);
+#endif
+
+    }  // End of method 'StreamObsSource::connectStream()'
+
+
+
+      // Map the time tags of the epochs to the wall clock.
+    StreamObsSource& StreamObsSource::setTimeReference( const CommonTime& epoch,
+                                                        double wall,
+                                                        double rate )
+    {
+        haveReference = true;
+        referenceEpoch = epoch;
+        referenceWall = wall;
+        referenceRate = (rate > 0.0) ? rate : 1.0;
+
+        return (*this);
+
+    }  // End of method 'StreamObsSource::setTimeReference()'
+
+
+
+      // Read the data of the next epoch.
+    bool StreamObsSource::readEpochData(gnssDataMap& gData)
+    {
+        gData.clear();
+
+        while(true)
+        {
+            double now( unixTime() );
+
+            if( isReady(now) )
+            {
+                std::map<CommonTime, PendingEpoch>::iterator it(
+                                                            pending.begin() );
+
+                gData.swap(it->second.gData);
+
+                lastValid = true;
+                lastEpoch = it->first;
+
+                double latency( unixTime() - wallTimeOf(it->first) );
+
+                ++numEpochs;
+                totalLatency += latency;
+                if(latency > maxLatency) maxLatency = latency;
+
+                if(latencies.size() < latencyHistory)
+                {
+                    latencies.push_back(latency);
+                }
+                else if(latencyHistory > 0)
+                {
+                    latencies[latencyNext] = latency;
+                    latencyNext = (latencyNext + 1) % latencyHistory;
+                }
+
+                pending.erase(it);
+
+                return true;
+            }
+
+            bool open(false);
+            for(size_t i = 0; i < streams.size(); ++i)
+            {
+                if(streams[i].fd >= 0) open = true;
+            }
+
+            if(!open) return false;
+
+            // Wait for data, or for the first pending epoch to expire
+            double timeout(-1.0);
+            if( !pending.empty() )
+            {
+                timeout = pending.begin()->second.arrival + maxWait - now;
+                if(timeout < 0.0) timeout = 0.0;
+            }
+
+            pollStreams(timeout);
+        }
+
+    }  // End of method 'StreamObsSource::readEpochData()'
+
+
+
+      // Latency of the last epochs given, oldest first
+    std::vector<double> StreamObsSource::getLatencies() const
+    {
+        std::vector<double> recent;
+        recent.reserve( latencies.size() );
+
+        recent.insert( recent.end(),
+                       latencies.begin() + latencyNext, latencies.end() );
+        recent.insert( recent.end(),
+                       latencies.begin(), latencies.begin() + latencyNext );
+
+        return recent;
+
+    }  // End of method 'StreamObsSource::getLatencies()'
+
+
+
+      // Destructor, closing the streams
+    StreamObsSource::~StreamObsSource()
+    {
+        for(size_t i = 0; i < streams.size(); ++i)
+        {
+#if !defined(_MSC_VER)
+            if(streams[i].fd >= 0) close(streams[i].fd);
+#endif
+            delete streams[i].pDecoder;
+        }
+
+    }  // End of destructor 'StreamObsSource::~StreamObsSource()'
+
+
+
+      // Read the data available in the streams
+    void StreamObsSource::pollStreams(double timeout)
+    {
+#if !defined(_MSC_VER)
+        std::vector<struct pollfd> fds;
+        std::vector<size_t> index;
+
+        for(size_t i = 0; i < streams.size(); ++i)
+        {
+            if(streams[i].fd < 0) continue;
+
+            struct pollfd p;
+            p.fd = streams[i].fd;
+            p.events = POLLIN;
+            p.revents = 0;
+
+            fds.push_back(p);
+            index.push_back(i);
+        }
+
+        if( fds.empty() ) return;
+
+        int ms( (timeout < 0.0) ? -1 : static_cast<int>(timeout*1000.0 + 1.0) );
+
+        int n( poll(&fds[0], fds.size(), ms) );
+        if(n <= 0) return;
+
+        for(size_t i = 0; i < fds.size(); ++i)
+        {
+            if( fds[i].revents & (POLLIN | POLLHUP | POLLERR | POLLNVAL) )
+            {
+                readStream( streams[ index[i] ] );
+            }
+        }
+#endif
+
+    }  // End of method 'StreamObsSource::pollStreams()'
+
+
+
+      // Read the data available in a stream
+    void StreamObsSource::readStream(Stream& stream)
+    {
+#if !defined(_MSC_VER)
+        char buffer[65536];
+
+        ssize_t n( read(stream.fd, buffer, sizeof(buffer)) );
+
+        if(n <= 0)
+        {
+            if( n < 0 && (errno == EINTR || errno == EAGAIN) ) return;
+
+            // End of the stream, or error
+            close(stream.fd);
+            stream.fd = -1;
+        }
+        else
+        {
+            stream.pDecoder->addData(buffer, n);
+        }
+
+        while(true)
+        {
+            gnssRinex gRin;
+
+            try
+            {
+                if( !stream.pDecoder->getEpoch(gRin) ) break;
+            }
+            catch(...)
+            {
+                // Skip the invalid epoch
+                continue;
+            }
+
+            CommonTime epoch( gRin.header.epoch );
+
+            stream.haveEpoch = true;
+            stream.lastEpoch = epoch;
+
+            // Too late: the epoch was already given
+            if( lastValid && epoch <= lastEpoch )
+            {
+                ++numLate;
+                continue;
+            }
+
+            PendingEpoch& pe( pending[epoch] );
+            if( pe.gData.empty() ) pe.arrival = unixTime();
+
+            pe.gData.addGnssRinex(gRin);
+        }
+#endif
+
+    }  // End of method 'StreamObsSource::readStream()'
+
+
+
+      // Whether the first pending epoch may be given
+    bool StreamObsSource::isReady(double now) const
+    {
+        if( pending.empty() ) return false;
+
+        const CommonTime& epoch( pending.begin()->first );
+
+        if( now - pending.begin()->second.arrival >= maxWait ) return true;
+
+        // Every open stream has sent this epoch, or a later one
+        for(size_t i = 0; i < streams.size(); ++i)
+        {
+            if(streams[i].fd < 0) continue;
+
+            if( !streams[i].haveEpoch || streams[i].lastEpoch < epoch )
+            {
+                return false;
+            }
+        }
+
+        return true;
+
+    }  // End of method 'StreamObsSource::isReady()'
+
+
+
+      // Wall clock of the time tag of an epoch
+    double StreamObsSource::wallTimeOf(const CommonTime& epoch) const
+    {
+        if(haveReference)
+        {
+            return referenceWall + (epoch - referenceEpoch)/referenceRate;
+        }
+
+        CommonTime t(epoch);
+
+        // Offset of the time system of the time tag from UTC
+        double corr(0.0);
+        try
+        {
+            TimeSystem ts( t.getTimeSystem() );
+            if( ts == TimeSystem::Unknown || ts == TimeSystem::Any )
+            {
+                ts = TimeSystem::GPS;
+            }
+
+            CivilTime civ(t);
+            corr = TimeSystem::Correction( ts, TimeSystem::UTC,
+                                           civ.year, civ.month, civ.day );
+        }
+        catch(...)
+        {
+            corr = 0.0;
+        }
+
+        t.setTimeSystem(TimeSystem::Unknown);
+
+        CommonTime unixEpoch( CivilTime( 1970, 1, 1, 0, 0, 0.0,
+                                         TimeSystem::Unknown ) );
+
+        return (t - unixEpoch) + corr;
+
+    }  // End of method 'StreamObsSource::wallTimeOf()'
+
+
+}  // End of namespace gpstk
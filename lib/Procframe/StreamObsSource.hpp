@@ -0,0 +1,261 @@
+#pragma ident "$Id$"
+
+/**
+ * @file StreamObsSource.hpp
+ * Read the observation epochs of a network from byte streams, such as
+ * sockets or pipes.
+ */
+
+#ifndef GPSTK_STREAMOBSSOURCE_HPP
+#define GPSTK_STREAMOBSSOURCE_HPP
+
+//============================================================================
+//
+//  This file is part of GPSTk, the GPS Toolkit.
+//
+//  The GPSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 2.1 of the License, or
+//  any later version.
+//
+//  The GPSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GPSTk; if not, write to the Free Software Foundation,
+//  Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//============================================================================
+
+
+#include <map>
+#include <string>
+#include <vector>
+#include "DataStructures.hpp"
+#include "EpochPipeline.hpp"
+#include "Rinex3ObsDecoder.hpp"
+
+
+namespace gpstk
+{
+
+    /// @ingroup DataStructures
+    //@{
+
+    /** This class reads the observation epochs of a network from byte
+     *  streams, one per station, and gives them as gnssDataMap objects,
+     *  epoch by epoch. It may be the source of an EpochPipeline.
+     *
+     * The streams are file descriptors of connected sockets or pipes
+     * carrying RINEX 3 observation data (see Rinex3ObsDecoder); all of them
+     * are polled together, and decoded as the data arrive. An epoch is
+     * given as soon as every open stream has sent it, or a later one, or
+     * when the maximum waiting time since the first station arrived is
+     * over; stations arriving later are dropped. The epochs are always
+     * given in order.
+     *
+     * The latency of every epoch, from its time tag to the moment it is
+     * given, is measured against the system clock. When the streams are
+     * replayed (see ObsStreamReplayer), the time tags are mapped to the
+     * wall clock with 'setTimeReference()'. The mean and maximum cover all
+     * the epochs, while only the latencies of the last epochs are kept
+     * (see 'setLatencyHistory()'), so a long run takes constant memory.
+     *
+     * @code
+     *   StreamObsSource source;
+     *   source.connectStream("caster.example.org", 2101);
+     *   ...
+     *
+     *   gnssDataMap gData;
+     *   while( source.readEpochData(gData) )
+     *   {
+     *      // processing code here
+     *   }
+     *
+     *   std::cout << source.getMeanLatency() << std::endl;
+     * @endcode
+     *
+     * Sockets are supported on POSIX systems.
+     */
+    class StreamObsSource : public EpochSource
+    {
+    public:
+
+        /// Default constructor
+        StreamObsSource()
+            : maxWait(0.5), haveReference(false), referenceWall(0.0),
+              referenceRate(1.0), lastValid(false), numEpochs(0),
+              numLate(0), totalLatency(0.0), maxLatency(0.0),
+              latencyHistory(3600), latencyNext(0)
+        {};
+
+
+        /** Add a stream.
+         *
+         * @param fd        File descriptor of a connected socket or a pipe.
+         *                  It is closed by this object.
+         * @param name      Name of the stream, for error messages.
+         */
+        StreamObsSource& addStream(int fd, const std::string& name = "");
+
+
+        /** Connect to a TCP server and add the stream.
+         *
+         * @param host      Name or address of the server.
+         * @param port      Port of the server.
+         */
+        StreamObsSource& connectStream(const std::string& host, int port)
+            throw(Exception);
+
+
+        /// Set the maximum time (seconds) to wait for the stations missing
+        /// in an epoch, since the first one arrived. By default, 0.5 s.
+        StreamObsSource& setMaxWait(double wait)
+        { maxWait = wait; return (*this); };
+
+        /// Get the maximum waiting time
+        double getMaxWait() const
+        { return maxWait; };
+
+
+        /** Map the time tags of the epochs to the wall clock, e.g. for
+         *  replayed streams.
+         *
+         * @param epoch     Time tag of reference.
+         * @param wall      Wall clock (seconds since 1970) at 'epoch'.
+         * @param rate      Rate of the time tags with respect to the wall
+         *                  clock.
+         */
+        StreamObsSource& setTimeReference( const CommonTime& epoch,
+                                           double wall,
+                                           double rate = 1.0 );
+
+
+        /// Read the data of the next epoch.
+        virtual bool readEpochData(gnssDataMap& gData);
+
+
+        /// Number of epochs given
+        unsigned long getNumEpochs() const
+        { return numEpochs; };
+
+        /// Number of station epochs dropped, since they arrived late
+        unsigned long getNumLate() const
+        { return numLate; };
+
+        /// Mean latency of the epochs (seconds)
+        double getMeanLatency() const
+        { return (numEpochs > 0) ? totalLatency/numEpochs : 0.0; };
+
+        /// Maximum latency of the epochs (seconds)
+        double getMaxLatency() const
+        { return maxLatency; };
+
+        /// Set the number of epochs whose latency is kept. By default,
+        /// 3600. The latencies kept are cleared.
+        StreamObsSource& setLatencyHistory(size_t n)
+        { latencyHistory = n; latencies.clear(); latencyNext = 0;
+          return (*this); };
+
+        /// Get the number of epochs whose latency is kept
+        size_t getLatencyHistory() const
+        { return latencyHistory; };
+
+        /// Latency of the last epochs given, oldest first (seconds)
+        std::vector<double> getLatencies() const;
+
+
+        /// Returns a string identifying this object.
+        virtual std::string getClassName(void) const
+        { return "StreamObsSource"; };
+
+
+        /// Destructor, closing the streams
+        virtual ~StreamObsSource();
+
+
+    private:
+
+        /// Data of a stream
+        struct Stream
+        {
+            Stream() : fd(-1), haveEpoch(false), pDecoder(NULL) {};
+
+            int fd;
+            std::string name;
+
+            /// Last epoch decoded
+            bool haveEpoch;
+            CommonTime lastEpoch;
+
+            Rinex3ObsDecoder* pDecoder;
+        };
+
+        /// Epoch waiting for the rest of the stations
+        struct PendingEpoch
+        {
+            PendingEpoch() : arrival(0.0) {};
+
+            gnssDataMap gData;
+
+            /// Wall clock when the first station arrived
+            double arrival;
+        };
+
+
+        /// Read the data available in the streams, waiting up to
+        /// 'timeout' seconds (forever if negative)
+        void pollStreams(double timeout);
+
+        /// Read the data available in a stream
+        void readStream(Stream& stream);
+
+        /// Whether the first pending epoch may be given
+        bool isReady(double now) const;
+
+        /// Wall clock of the time tag of an epoch
+        double wallTimeOf(const CommonTime& epoch) const;
+
+
+        /// Streams
+        std::vector<Stream> streams;
+
+        /// Epochs waiting for the rest of the stations
+        std::map<CommonTime, PendingEpoch> pending;
+
+        /// Maximum time to wait for the stations of an epoch
+        double maxWait;
+
+        /// Reference of the time tags
+        bool haveReference;
+        CommonTime referenceEpoch;
+        double referenceWall;
+        double referenceRate;
+
+        /// Last epoch given
+        bool lastValid;
+        CommonTime lastEpoch;
+
+        /// Statistics
+        unsigned long numEpochs;
+        unsigned long numLate;
+        double totalLatency;
+        double maxLatency;
+
+        /// Latencies of the last epochs, a ring once full
+        size_t latencyHistory;
+        std::vector<double> latencies;
+        size_t latencyNext;
+
+        StreamObsSource(const StreamObsSource&);
+        StreamObsSource& operator=(const StreamObsSource&);
+
+    }; // End of class 'StreamObsSource'
+
+    //@}
+
+}  // End of namespace gpstk
+
+#endif   // GPSTK_STREAMOBSSOURCE_HPP
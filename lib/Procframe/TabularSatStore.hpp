@@ -584,6 +584,15 @@ namespace gpstk
       virtual bool isPresent(const SatID& sat) const throw()
          { return (tables.find(sat) != tables.end()); }
 
+      /// Return true if the store has a record of the given SatID at exactly
+      /// the given time
+      bool hasRecord(const SatID& sat, const CommonTime& ttag) const
+      {
+         typename SatTable::const_iterator satit(tables.find(sat));
+         return (satit != tables.end() &&
+                 satit->second.find(ttag) != satit->second.end());
+      }
+
       /// determine if the input TimeSystem conflicts with the stored TimeSystem
       /// @param ts TimeSystem to compare with stored TimeSystem
       /// @throw if time systems are inconsistent
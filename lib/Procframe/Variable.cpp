@@ -30,6 +30,12 @@
 
 #include "Variable.hpp"
 
+#include <vector>
+
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
+
 
 namespace gpstk
 {
@@ -131,6 +137,35 @@ namespace gpstk
 
 
 
+    // Copy constructor
+    Variable::Variable(const Variable& right)
+        : varType(right.varType),
+          varSource(right.varSource),
+          varSat(right.varSat),
+          pVarModel(right.pVarModel),
+          isSourceIndexed(right.isSourceIndexed),
+          isSatIndexed(right.isSatIndexed),
+          isTypeIndexed(right.isTypeIndexed),
+          initialVariance(right.initialVariance),
+          defaultCoefficient(right.defaultCoefficient),
+          forceDefault(right.forceDefault),
+          m_pre_index(right.m_pre_index),
+          m_now_index(right.m_now_index),
+          m_id(right.m_id),
+          m_refs(right.m_refs)
+    {
+        if(m_refs != NULL)
+        {
+#ifdef USE_OPENMP
+    #pragma omp atomic
+#endif
+            ++(*m_refs);
+        }
+
+    }  // End of 'Variable::Variable()'
+
+
+
     /** Initializing function
      *
      * @param type        TypeID of variable.
@@ -181,6 +216,10 @@ namespace gpstk
 
         m_pre_index = pre_index;
 
+        m_id = -1;
+
+        m_refs = NULL;
+
         return;
 
     }  // End of method 'Variable::Init()'
@@ -190,16 +229,10 @@ namespace gpstk
     // Equality operator
     bool Variable::operator==(const Variable& right) const
     {
-        return ( ( varType == right.getType() )                           &&
-                 ( pVarModel == right.getModel() )                        &&
-                 ( isSourceIndexed == right.getSourceIndexed() )          &&
-                 ( isSatIndexed == right.getSatIndexed() )                &&
-                 ( initialVariance == right.getInitialVariance() )        &&
-                 ( defaultCoefficient == right.getDefaultCoefficient() )  &&
-                 ( forceDefault == right.isDefaultForced() )              &&
-                 ( varSource == right.getSource() )                       &&
-                 ( varSat == right.getSatellite() )                       &&
-                 ( isTypeIndexed == right.getTypeIndexed() ) );
+        // Interned variables are equal if their IDs are
+        if( m_id >= 0 && right.m_id >= 0 ) return ( m_id == right.m_id );
+
+        return ( !lessFields(right) && !right.lessFields(*this) );
 
     }  // End of 'Variable::operator=='
 
@@ -207,8 +240,21 @@ namespace gpstk
 
     // This ordering is somewhat arbitrary, but is required to be able
     // to use a Variable as an index to a std::map, or as part of a
-    // std::set.
+    // std::set. The IDs depend on the order of interning, so the fields
+    // are compared.
     bool Variable::operator<(const Variable& right) const
+    {
+        // Same ID, same fields
+        if( m_id >= 0 && m_id == right.m_id ) return false;
+
+        return lessFields(right);
+
+    }  // End of 'Variable::operator<'
+
+
+
+    // Compare all the fields defining a variable, except the indexes
+    bool Variable::lessFields(const Variable& right) const
     {
         // Compare each field in turn
         if( varType == right.getType() )
@@ -291,7 +337,141 @@ namespace gpstk
             return ( varType < right.getType() );
         }
 
-    }  // End of 'Variable::operator<'
+    }  // End of 'Variable::lessFields()'
+
+
+
+    // Registry of the variables alive. The key variables hold no ID.
+    struct Variable::Registry
+    {
+        /// ID and number of references of a variable
+        struct Entry
+        {
+            int id;
+            int refs;
+        };
+
+        typedef std::map<Variable, Entry, FieldLess> VarMap;
+
+        /// Entries of the variables alive
+        VarMap varMap;
+
+        /// Entry of each ID, or varMap.end() if the ID is free
+        std::vector<VarMap::iterator> byID;
+
+        /// IDs to give again
+        std::vector<int> freeIDs;
+    };
+
+
+    // Get the registry of the variables alive
+    Variable::Registry& Variable::registry()
+    {
+        static Registry varRegistry;
+        return varRegistry;
+
+    }  // End of method 'Variable::registry()'
+
+
+    // Take the ID of the current fields, registering them if needed
+    void Variable::setID() const
+    {
+        releaseID();
+
+#ifdef USE_OPENMP
+    #pragma omp critical(VariableRegistry)
+#endif
+        {
+            Registry& reg( registry() );
+
+            // Neither this variable nor its copies hold an ID now
+            Registry::VarMap::iterator it( reg.varMap.find(*this) );
+            if( it == reg.varMap.end() )
+            {
+                Registry::Entry entry;
+                entry.refs = 0;
+
+                if( reg.freeIDs.empty() )
+                {
+                    entry.id = reg.byID.size();
+                    reg.byID.push_back( reg.varMap.end() );
+                }
+                else
+                {
+                    entry.id = reg.freeIDs.back();
+                    reg.freeIDs.pop_back();
+                }
+
+                it = reg.varMap.insert( std::make_pair(*this, entry) ).first;
+                reg.byID[entry.id] = it;
+            }
+
+            m_id = it->second.id;
+            m_refs = &(it->second.refs);
+
+            // Copies change the count outside of the critical section
+#ifdef USE_OPENMP
+    #pragma omp atomic
+#endif
+            ++(*m_refs);
+        }
+
+    }  // End of method 'Variable::setID()'
+
+
+    // Drop the reference to the ID, freeing it if it was the last one
+    void Variable::releaseID() const
+    {
+        if(m_refs == NULL) return;
+
+        int left;
+
+#ifdef USE_OPENMP
+    #pragma omp atomic capture
+#endif
+        left = --(*m_refs);
+
+        if(left == 0)
+        {
+#ifdef USE_OPENMP
+    #pragma omp critical(VariableRegistry)
+#endif
+            {
+                Registry& reg( registry() );
+
+                // setID() may have taken the entry again meanwhile, and
+                // another thread may have freed it. Entries without
+                // references are only found here, and can be erased.
+                Registry::VarMap::iterator it( reg.byID[m_id] );
+                if( it != reg.varMap.end() && it->second.refs == 0 )
+                {
+                    reg.varMap.erase(it);
+                    reg.byID[m_id] = reg.varMap.end();
+                    reg.freeIDs.push_back(m_id);
+                }
+            }
+        }
+
+        m_id = -1;
+        m_refs = NULL;
+
+    }  // End of method 'Variable::releaseID()'
+
+
+
+    // Get the size of the ID tables
+    int Variable::getNumIDs()
+    {
+        int num(0);
+
+#ifdef USE_OPENMP
+    #pragma omp critical(VariableRegistry)
+#endif
+        num = registry().byID.size();
+
+        return num;
+
+    }  // End of method 'Variable::getNumIDs()'
 
 
 
@@ -302,30 +482,45 @@ namespace gpstk
         // First check if these Variables are the same
         if ( this == &right ) return (*this);
 
-        // If Variables are different, then set values of all fields
-        setType( right.getType() );
+        // If Variables are different, then set values of all fields. The
+        // setters are not used: the ID of 'right' is shared below.
+        varType = right.varType;
 
-        setModel( right.getModel() );
+        pVarModel = right.pVarModel;
 
-        setSourceIndexed( right.getSourceIndexed() );
+        isSourceIndexed = right.isSourceIndexed;
 
-        setSatIndexed( right.getSatIndexed() );
+        isSatIndexed = right.isSatIndexed;
 
-        setInitialVariance( right.getInitialVariance() );
+        initialVariance = right.initialVariance;
 
-        setDefaultCoefficient( right.getDefaultCoefficient() );
+        defaultCoefficient = right.defaultCoefficient;
 
-        setDefaultForced( right.isDefaultForced() );
+        forceDefault = right.forceDefault;
 
-        setSource( right.getSource() );
+        varSource = right.varSource;
 
-        setSatellite( right.getSatellite() );
+        varSat = right.varSat;
 
-        setTypeIndexed(right.getTypeIndexed());
+        isTypeIndexed = right.isTypeIndexed;
+
+        m_now_index = right.m_now_index;
+
+        m_pre_index = right.m_pre_index;
+
+        // Take the ID of 'right' before dropping ours, which may be the same
+        if(right.m_refs != NULL)
+        {
+#ifdef USE_OPENMP
+    #pragma omp atomic
+#endif
+            ++(*right.m_refs);
+        }
 
-        setNowIndex(right.getNowIndex());
+        releaseID();
 
-        setPreIndex(right.getPreIndex());
+        m_id = right.m_id;
+        m_refs = right.m_refs;
 
         return *this;
 
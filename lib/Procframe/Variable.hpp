@@ -32,6 +32,8 @@
 //============================================================================
 
 
+#include <map>
+
 #include "DataStructures.hpp"
 #include "StochasticModel2.hpp"
 
@@ -88,7 +90,7 @@ namespace gpstk
          * @param type        New TypeID of variable.
          */
         Variable& setType(const TypeID& type)
-        { varType = type; return (*this); };
+        { varType = type; releaseID(); return (*this); };
 
 
         /// Get variable model pointer
@@ -103,7 +105,7 @@ namespace gpstk
          *                    noise model.
          */
         Variable& setModel(StochasticModel2* pModel)
-        { pVarModel = pModel; return (*this); };
+        { pVarModel = pModel; releaseID(); return (*this); };
 
 
         /// Get if this variable is SourceID-indexed
@@ -117,7 +119,7 @@ namespace gpstk
          *                         or not. By default, it IS SourceID-indexed.
          */
         Variable& setSourceIndexed(bool sourceIndexed)
-        { isSourceIndexed = sourceIndexed; return (*this); };
+        { isSourceIndexed = sourceIndexed; releaseID(); return (*this); };
 
 
         /// Get if this variable is SatID-indexed.
@@ -131,7 +133,7 @@ namespace gpstk
          *                         or not. By default, it is NOT SatID-indexed.
          */
         Variable& setSatIndexed(bool satIndexed)
-        { isSatIndexed = satIndexed; return (*this); };
+        { isSatIndexed = satIndexed; releaseID(); return (*this); };
 
 
         /// Get if this variable is Type-indexed.
@@ -145,7 +147,7 @@ namespace gpstk
          *                         or not. By default, it IS Type-indexed.
          */
         Variable& setTypeIndexed(bool typeIndexed)
-        { isTypeIndexed = typeIndexed; return (*this); };
+        { isTypeIndexed = typeIndexed; releaseID(); return (*this); };
 
 
         /// Get value of initial variance assigned to this variable.
@@ -158,7 +160,7 @@ namespace gpstk
          * @param variance      Initial variance assigned to this variable.
          */
         Variable& setInitialVariance(double variance)
-        { initialVariance = variance; return (*this); };
+        { initialVariance = variance; releaseID(); return (*this); };
 
 
         /// Get value of default coefficient assigned to this variable.
@@ -171,7 +173,7 @@ namespace gpstk
          * @param coef    Default coefficient assigned to this variable.
          */
         Variable& setDefaultCoefficient(double coef)
-        { defaultCoefficient = coef; return (*this); };
+        { defaultCoefficient = coef; releaseID(); return (*this); };
 
 
         /// Ask if default coefficient will always be used.
@@ -184,7 +186,7 @@ namespace gpstk
          * @param forceCoef     Always use default coefficient.
          */
         Variable& setDefaultForced(bool forceCoef)
-        { forceDefault = forceCoef; return (*this); };
+        { forceDefault = forceCoef; releaseID(); return (*this); };
 
 
         /// Get internal source this variable is assigned to (if any).
@@ -197,7 +199,7 @@ namespace gpstk
          * @param source     Internal, specific SourceID of variable.
          */
         Variable& setSource(const SourceID& source)
-        { varSource = source; return (*this); };
+        { varSource = source; releaseID(); return (*this); };
 
 
         /// Get internal satellite this variable is assigned to (if any).
@@ -210,7 +212,30 @@ namespace gpstk
          * @param satellite  Internal, specific SatID of variable.
          */
         Variable& setSatellite(const SatID& satellite)
-        { varSat = satellite; return (*this); };
+        { varSat = satellite; releaseID(); return (*this); };
+
+
+        /** Get the ID of this variable.
+         *
+         * Every distinct variable is interned in a global registry the
+         * first time its ID is asked for, and gets a dense integer ID,
+         * kept by copies. The setters above drop the ID, so a variable
+         * built field by field is interned once, when it is complete.
+         *
+         * The registry only holds the variables alive: copies count the
+         * references to an ID, and when the last one is destroyed, the
+         * ID is given to the next new variable. IDs depend on the order
+         * of interning, so they index tables but do not order variables.
+         *
+         * \warning The first call on a given object is not thread-safe.
+         */
+        int getID() const
+        { if(m_id < 0) setID(); return m_id; };
+
+
+        /// Get the size of the ID tables, i.e., the largest number of
+        /// distinct variables alive so far. IDs are in [0, getNumIDs()).
+        static int getNumIDs();
 
 
         /// Get index of current epoch
@@ -239,7 +264,7 @@ namespace gpstk
 
         /// This ordering is somewhat arbitrary, but is required to be able
         /// to use a Variable as an index to a std::map, or as part of a
-        /// std::set.
+        /// std::set. Variables are ordered by their fields.
         virtual bool operator<(const Variable& right) const;
 
 
@@ -248,6 +273,10 @@ namespace gpstk
         { return !(operator==(right)); }
 
 
+        /// Copy constructor
+        Variable(const Variable& right);
+
+
         /// Assignment operator
         virtual Variable& operator=(const Variable& right);
 
@@ -297,7 +326,8 @@ namespace gpstk
 
 
         /// Destructor
-        virtual ~Variable() {};
+        virtual ~Variable()
+        { releaseID(); };
 
 
     private:
@@ -370,6 +400,38 @@ namespace gpstk
         int m_now_index;
 
 
+        /// ID of this Variable in the registry, -1 if not interned.
+        mutable int m_id;
+
+        /// References to the ID, shared by all the copies.
+        mutable int* m_refs;
+
+
+        /// Compare all the fields defining a variable, except the indexes
+        bool lessFields(const Variable& right) const;
+
+
+        /// Functor comparing the fields of two variables
+        struct FieldLess
+        {
+            bool operator()(const Variable& a, const Variable& b) const
+            { return a.lessFields(b); };
+        };
+
+
+        /// Registry of the variables alive, defined in Variable.cpp
+        struct Registry;
+
+        /// Get the registry
+        static Registry& registry();
+
+        /// Take the ID of the current fields, registering them if needed
+        void setID() const;
+
+        /// Drop the reference to the ID, freeing it if it was the last one
+        void releaseID() const;
+
+
         /** Initializing function
          *
          * @param type        TypeID of variable.
@@ -0,0 +1,861 @@
+#pragma ident "$Id$"
+
+/**
+ * @file benchmark.cpp
+ * Times the key kernels of the processing pipelines on the data bundled
+ * with ROCKET, and prints the results as JSON or CSV.
+ *
+ * Usage: benchmark [rootDir] [json|csv] [repeats]
+ *
+ * 'rootDir' is the top directory of ROCKET, holding 'tables' and
+ * 'workplace' (by default, the current directory). Every kernel is run
+ * once to warm up, and then 'repeats' times (by default, 5); the best and
+ * the median times are reported, so the results of different commits can
+ * be compared. The kernels whose warm up run takes longer than 10 s, such
+ * as the measurement update of 2000 states, are timed in that run alone.
+ *
+ * The observations in 'workplace/obs' are synthetic: one hour of GPS
+ * observations of three IGS stations, computed from the orbits of
+ * 'workplace/sp3/igs18254.sp3'.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Counter.hpp"
+
+#include "CivilTime.hpp"
+#include "YDSTime.hpp"
+
+#include "EOPDataStore2.hpp"
+#include "LeapSecStore.hpp"
+#include "ReferenceSystem.hpp"
+#include "SolarSystem.hpp"
+
+#include "MSCStore.hpp"
+#include "AntexReader.hpp"
+
+#include "Rinex3ObsStream.hpp"
+#include "SP3EphemerisStore.hpp"
+
+#include "DataStructures.hpp"
+#include "BasicModel.hpp"
+
+#include "StochasticModel2.hpp"
+#include "StateStore.hpp"
+#include "TimeUpdate.hpp"
+#include "MeasUpdate.hpp"
+
+#include "EGM08Model.hpp"
+#include "ThirdBody.hpp"
+#include "ECOM1Model.hpp"
+#include "Relativity.hpp"
+#include "GNSSOrbit.hpp"
+#include "RKF78Integrator.hpp"
+
+
+using namespace std;
+using namespace gpstk;
+
+
+    /// A kernel to be timed
+class Kernel
+{
+public:
+
+        /// Name of the kernel
+    virtual string getName() const = 0;
+
+        /// Size of the problem, if the kernel is run with several sizes
+    virtual int getSize() const
+    { return 0; };
+
+        /// Work done before every run, not timed
+    virtual void prepare()
+    {};
+
+        /// Run the kernel once, returning the number of operations done
+    virtual long run() = 0;
+
+    virtual ~Kernel() {};
+
+}; // End of class 'Kernel'
+
+
+    /// Timing of a kernel
+struct Result
+{
+    string name;
+    int size;
+    long numOps;
+    int repeats;
+    double best;
+    double median;
+};
+
+
+    /// Time a kernel: one run to warm up, then 'repeats' runs.
+Result timeKernel(Kernel& kernel, int repeats)
+{
+    const double maxWarmUp(10.0);
+
+    Result result;
+    result.name = kernel.getName();
+    result.size = kernel.getSize();
+
+    kernel.prepare();
+
+    double t0( Counter::now() );
+    result.numOps = kernel.run();
+    double warmUp( Counter::now() - t0 );
+
+    vector<double> times;
+
+    // The kernels taking longer than 'maxWarmUp' are timed in the warm up
+    // run alone
+    if(warmUp > maxWarmUp)
+    {
+        times.push_back(warmUp);
+        repeats = 0;
+    }
+
+    for(int i = 0; i < repeats; ++i)
+    {
+        kernel.prepare();
+
+        double t0( Counter::now() );
+        kernel.run();
+        times.push_back( Counter::now() - t0 );
+    }
+
+    sort(times.begin(), times.end());
+
+    result.repeats = times.size();
+    result.best = times.front();
+    result.median = times[times.size()/2];
+
+    return result;
+
+}  // End of function 'timeKernel()'
+
+
+
+    /// Read the RINEX 3 observation files, epoch by epoch.
+class RinexDecodeKernel : public Kernel
+{
+public:
+
+    RinexDecodeKernel(const vector<string>& files)
+        : obsFiles(files)
+    {};
+
+    virtual string getName() const
+    { return "rinex_decode"; };
+
+    virtual long run()
+    {
+        long numEpochs(0);
+
+        for(size_t i = 0; i < obsFiles.size(); ++i)
+        {
+            Rinex3ObsStream rin( obsFiles[i].c_str() );
+            rin >> rin.header;
+
+            gnssRinex gRin;
+            while( rin >> gRin ) ++numEpochs;
+        }
+
+        return numEpochs;
+    };
+
+private:
+
+    vector<string> obsFiles;
+
+}; // End of class 'RinexDecodeKernel'
+
+
+    /// Interpolate the SP3 orbits and clocks of all the satellites along
+    /// a day.
+class SP3InterpolationKernel : public Kernel
+{
+public:
+
+    SP3InterpolationKernel(SP3EphemerisStore& eph, const CommonTime& t)
+        : pEph(&eph), time0(t)
+    {};
+
+    virtual string getName() const
+    { return "sp3_interpolation"; };
+
+    virtual long run()
+    {
+        long numOps(0);
+
+        for(int i = 0; i < 288; ++i)
+        {
+            CommonTime time( time0 + i*300.0 );
+
+            for(int prn = 1; prn <= MAX_PRN_GPS; ++prn)
+            {
+                try
+                {
+                    pEph->getXvt( SatID(prn, SatID::systemGPS), time );
+                    ++numOps;
+                }
+                catch(...)
+                {
+                }
+            }
+        }
+
+        return numOps;
+    };
+
+private:
+
+    SP3EphemerisStore* pEph;
+    CommonTime time0;
+
+}; // End of class 'SP3InterpolationKernel'
+
+
+    /// Compute the geometry of all the stations with BasicModel.
+class BasicModelKernel : public Kernel
+{
+public:
+
+    BasicModelKernel( SP3EphemerisStore& eph,
+                      MSCStore& msc,
+                      const vector<gnssDataMap>& data )
+        : epochData(data)
+    {
+        model.setEphStore(eph);
+        model.setMSCStore(msc);
+        model.setMinElev(5.0);
+    };
+
+    virtual string getName() const
+    { return "basic_model"; };
+
+    virtual long run()
+    {
+        long numOps(0);
+
+        for(size_t i = 0; i < epochData.size(); ++i)
+        {
+            gnssDataMap gData( epochData[i] );
+            model.Process(gData);
+
+            for( gnssDataMap::iterator it = gData.begin();
+                 it != gData.end();
+                 ++it )
+            {
+                for( sourceDataMap::iterator its = it->second.begin();
+                     its != it->second.end();
+                     ++its )
+                {
+                    numOps += its->second.size();
+                }
+            }
+        }
+
+        return numOps;
+    };
+
+private:
+
+    BasicModel model;
+    vector<gnssDataMap> epochData;
+
+}; // End of class 'BasicModelKernel'
+
+
+    /// Kalman filter measurement update of a network of stations, with
+    /// coordinates, clocks and ambiguities.
+class MeasUpdateKernel : public Kernel
+{
+public:
+
+    MeasUpdateKernel(int size)
+        : numSources( std::max(1, (size - numSats)/(4 + numSats)) ),
+          numStates( numSources*(4 + numSats) + numSats )
+    {
+        xModel.addTypeID(TypeID::dStaX);
+        yModel.addTypeID(TypeID::dStaY);
+        zModel.addTypeID(TypeID::dStaZ);
+        staClockModel.addTypeID(TypeID::dcdtSta);
+        satClockModel.addTypeID(TypeID::dcdtSat);
+        ambModel.addTypeID(TypeID::BLC);
+
+        xModel.setSigma(100.0);
+        yModel.setSigma(100.0);
+        zModel.setSigma(100.0);
+        staClockModel.setSigma(10.0);
+        satClockModel.setSigma(10.0);
+
+        Variable dx(TypeID::dStaX, &xModel);
+        Variable dy(TypeID::dStaY, &yModel);
+        Variable dz(TypeID::dStaZ, &zModel);
+        Variable cdt(TypeID::dcdtSta, &staClockModel);
+        Variable cdtSat(TypeID::dcdtSat, &satClockModel, false, true);
+        Variable amb(TypeID::BLC, &ambModel, true, true, 100.0);
+
+        Equation equC( Variable(TypeID::prefitC) );
+        equC.addVariable(dx);
+        equC.addVariable(dy);
+        equC.addVariable(dz);
+        equC.addVariable(cdt, true, 1.0);
+        equC.addVariable(cdtSat, true, -1.0);
+
+        Equation equL( Variable(TypeID::prefitL) );
+        equL.addVariable(dx);
+        equL.addVariable(dy);
+        equL.addVariable(dz);
+        equL.addVariable(cdt, true, 1.0);
+        equL.addVariable(cdtSat, true, -1.0);
+        equL.addVariable(amb, true, 1.0);
+        equL.header.constWeight = 1.0e4;
+
+        srand(1);
+
+        for(int i = 0; i < numSources; ++i)
+        {
+            SourceID source( SourceID::GPS, "S" + StringUtils::asString(i) );
+
+            timeUpdate.addEquation2Source(equC, source);
+            timeUpdate.addEquation2Source(equL, source);
+            measUpdate.addEquation2Source(equC, source);
+            measUpdate.addEquation2Source(equL, source);
+
+            gnssRinex gRin;
+            gRin.header.source = source;
+
+            for(int prn = 1; prn <= numSats; ++prn)
+            {
+                typeValueMap& tvm( gRin.body[SatID(prn, SatID::systemGPS)] );
+
+                tvm[TypeID::prefitC] = rand()%1000/100.0;
+                tvm[TypeID::prefitL] = rand()%1000/1000.0;
+                tvm[TypeID::dStaX] = rand()%1000/1000.0 - 0.5;
+                tvm[TypeID::dStaY] = rand()%1000/1000.0 - 0.5;
+                tvm[TypeID::dStaZ] = rand()%1000/1000.0;
+                tvm[TypeID::weightC] = 1.0;
+                tvm[TypeID::weightL] = 1.0;
+            }
+
+            epochData.addGnssRinex(gRin);
+        }
+
+        timeUpdate.setStateStore(stateStore);
+        measUpdate.setStateStore(stateStore);
+    };
+
+    virtual string getName() const
+    { return "meas_update"; };
+
+    virtual int getSize() const
+    { return numStates; };
+
+    virtual void prepare()
+    {
+        gData = epochData;
+        timeUpdate.Process(gData);
+    };
+
+    virtual long run()
+    {
+        measUpdate.Process(gData);
+        return 1;
+    };
+
+private:
+
+    static const int numSats = 10;
+
+    int numSources;
+    int numStates;
+
+    WhiteNoiseModel2 xModel;
+    WhiteNoiseModel2 yModel;
+    WhiteNoiseModel2 zModel;
+    WhiteNoiseModel2 staClockModel;
+    WhiteNoiseModel2 satClockModel;
+    PhaseAmbiguityModel2 ambModel;
+
+    StateStore stateStore;
+    TimeUpdate timeUpdate;
+    MeasUpdate measUpdate;
+
+    gnssDataMap epochData;
+    gnssDataMap gData;
+
+}; // End of class 'MeasUpdateKernel'
+
+
+    /// Earth gravitation acting on all the satellites.
+class EGMKernel : public Kernel
+{
+public:
+
+    EGMKernel( const string& file,
+               int degree,
+               ReferenceSystem& refSys,
+               const CommonTime& t,
+               const satVectorMap& orbits )
+        : egm(degree, degree), tt(t), satOrbits(orbits), egmDegree(degree)
+    {
+        egm.loadFile(file);
+        egm.setReferenceSystem(refSys);
+    };
+
+    virtual string getName() const
+    { return "egm"; };
+
+    virtual int getSize() const
+    { return egmDegree; };
+
+    virtual long run()
+    {
+        for(int i = 0; i < 10; ++i)
+        {
+            egm.Compute(tt, satOrbits);
+        }
+
+        return 10*satOrbits.size();
+    };
+
+private:
+
+    EGM08Model egm;
+    CommonTime tt;
+    satVectorMap satOrbits;
+    int egmDegree;
+
+}; // End of class 'EGMKernel'
+
+
+    /// Integrate the orbits and partials of all the satellites along two
+    /// hours.
+class RKF78ArcKernel : public Kernel
+{
+public:
+
+    RKF78ArcKernel( GNSSOrbit& gnss,
+                    const CommonTime& t,
+                    const satVectorMap& orbits )
+        : tt0(t), satOrbits(orbits)
+    {
+        rkf78.setStepSize(300.0);
+        rkf78.setEquationOfMotion(gnss);
+    };
+
+    virtual string getName() const
+    { return "rkf78_arc"; };
+
+    virtual long run()
+    {
+        rkf78.setCurrentTime(tt0);
+        rkf78.setCurrentState(satOrbits);
+
+        for(int i = 1; i <= 24; ++i)
+        {
+            CommonTime tt( tt0 + i*300.0 );
+
+            satVectorMap orbits( rkf78.integrateTo(tt) );
+
+            rkf78.setCurrentTime(tt);
+            rkf78.setCurrentState(orbits);
+        }
+
+        return 24*satOrbits.size();
+    };
+
+private:
+
+    RKF78Integrator rkf78;
+    CommonTime tt0;
+    satVectorMap satOrbits;
+
+}; // End of class 'RKF78ArcKernel'
+
+
+    /// Look for the antennas of the satellites and the stations, and get
+    /// their phase center corrections.
+class AntexLookupKernel : public Kernel
+{
+public:
+
+    AntexLookupKernel( const string& file,
+                       const vector<string>& models,
+                       const CommonTime& t )
+        : antModels(models), time(t)
+    {
+        antex.open( file.c_str() );
+    };
+
+    virtual string getName() const
+    { return "antex_lookup"; };
+
+    virtual long run()
+    {
+        long numOps(0);
+
+        for(int prn = 1; prn <= MAX_PRN_GPS; ++prn)
+        {
+            try
+            {
+                std::ostringstream sat;
+                sat << "G" << setw(2) << setfill('0') << prn;
+
+                Antenna antenna( antex.getAntenna(sat.str(), time) );
+
+                antenna.getAntennaEccentricity(Antenna::G01);
+
+                // Nadir angles up to 14 degrees
+                for(int nadir = 0; nadir <= 14; nadir += 2)
+                {
+                    antenna.getAntennaPCVariation( Antenna::G01,
+                                                   90.0 - nadir );
+                }
+                ++numOps;
+            }
+            catch(...)
+            {
+            }
+        }
+
+        for(size_t i = 0; i < antModels.size(); ++i)
+        {
+            try
+            {
+                Antenna antenna;
+
+                try
+                {
+                    antenna = antex.getAntenna(antModels[i]);
+                }
+                catch(ObjectNotFound& notFound)
+                {
+                    string model( antModels[i] );
+                    model.replace(16, 4, "NONE");
+                    antenna = antex.getAntenna(model);
+                }
+
+                for(int elev = 5; elev <= 90; elev += 5)
+                {
+                    antenna.getAntennaPCVariation( Antenna::G01,
+                                                   elev, 10.0*elev );
+                }
+                ++numOps;
+            }
+            catch(...)
+            {
+            }
+        }
+
+        return numOps;
+    };
+
+private:
+
+    AntexReader antex;
+    vector<string> antModels;
+    CommonTime time;
+
+}; // End of class 'AntexLookupKernel'
+
+
+
+    /// Print the results as JSON
+void printJSON(const vector<Result>& results)
+{
+    cout << "[" << endl;
+
+    for(size_t i = 0; i < results.size(); ++i)
+    {
+        const Result& r( results[i] );
+        double n( (r.numOps > 0) ? r.numOps : 1.0 );
+
+        cout << "  {\"kernel\": \"" << r.name << "\""
+             << ", \"size\": " << r.size
+             << ", \"ops\": " << r.numOps
+             << ", \"repeats\": " << r.repeats
+             << fixed << setprecision(6)
+             << ", \"best_s\": " << r.best
+             << ", \"median_s\": " << r.median
+             << setprecision(3)
+             << ", \"best_us_per_op\": " << r.best/n*1.0e6
+             << "}" << ( (i + 1 < results.size()) ? "," : "" ) << endl;
+    }
+
+    cout << "]" << endl;
+
+}  // End of function 'printJSON()'
+
+
+    /// Print the results as CSV
+void printCSV(const vector<Result>& results)
+{
+    cout << "kernel,size,ops,repeats,best_s,median_s,best_us_per_op" << endl;
+
+    for(size_t i = 0; i < results.size(); ++i)
+    {
+        const Result& r( results[i] );
+        double n( (r.numOps > 0) ? r.numOps : 1.0 );
+
+        cout << r.name << ','
+             << r.size << ','
+             << r.numOps << ','
+             << r.repeats << ','
+             << fixed << setprecision(6)
+             << r.best << ','
+             << r.median << ','
+             << setprecision(3)
+             << r.best/n*1.0e6 << endl;
+    }
+
+}  // End of function 'printCSV()'
+
+
+
+int main(int argc, char* argv[])
+{
+
+    string rootDir( (argc > 1) ? argv[1] : "." );
+    string format( (argc > 2) ? argv[2] : "json" );
+    int repeats( (argc > 3) ? atoi(argv[3]) : 5 );
+
+    if(repeats < 1) repeats = 1;
+
+    string tableDir( rootDir + "/tables/" );
+    string dataDir( rootDir + "/workplace/" );
+
+
+    // observation fixtures, 2015-01-01 00:00 to 01:00
+    const char* stations[] = { "onsa", "wtzr", "algo" };
+    const int numStations(3);
+
+    vector<string> obsFiles;
+    for(int i = 0; i < numStations; ++i)
+    {
+        obsFiles.push_back( dataDir + "obs/" + stations[i] + "0010.15o" );
+    }
+
+    CommonTime gps0( CivilTime(2015,1,1,0,0,0.0, TimeSystem::GPS) );
+
+
+    // reference system
+    EOPDataStore2 eopStore;
+    LeapSecStore lsStore;
+    SolarSystem solSys;
+
+    try
+    {
+        eopStore.loadIERSFile(tableDir + "finals2000A.data");
+        lsStore.loadFile(tableDir + "Leap_Second.dat");
+        solSys.initializeWithBinaryFile(tableDir + "1980_2040.DE405");
+    }
+    catch(...)
+    {
+        cerr << "table files load error, in '" << tableDir << "'." << endl;
+        exit(-1);
+    }
+
+    ReferenceSystem refSys;
+    refSys.setEOPDataStore(eopStore);
+    refSys.setLeapSecStore(lsStore);
+
+    CommonTime tt0( refSys.GPS2TT(gps0) );
+
+
+    // precise orbits, from 2014-12-31 to 2015-01-02
+    SP3EphemerisStore sp3Store;
+    sp3Store.rejectBadPositions(true);
+    sp3Store.rejectBadClocks(true);
+
+    try
+    {
+        sp3Store.loadFile(dataDir + "sp3/igs18253.sp3");
+        sp3Store.loadFile(dataDir + "sp3/igs18254.sp3");
+        sp3Store.loadFile(dataDir + "sp3/igs18255.sp3");
+    }
+    catch(...)
+    {
+        cerr << "sp3 files load error, in '" << dataDir << "sp3'." << endl;
+        exit(-1);
+    }
+
+
+    // stations and epochs of the observation fixtures
+    MSCStore mscStore;
+    vector<string> antModels;
+    vector<gnssDataMap> epochData;
+
+    try
+    {
+        map<CommonTime, size_t> epochIndex;
+
+        for(size_t i = 0; i < obsFiles.size(); ++i)
+        {
+            Rinex3ObsStream rin( obsFiles[i].c_str() );
+            rin.exceptions(ios::failbit);
+            rin >> rin.header;
+
+            MSCData mscData;
+            mscData.mnemonic = rin.header.markerName;
+            mscData.station = i;
+            mscData.effepoch = YDSTime(2000, 1, 0.0);
+            mscData.refepoch = mscData.effepoch;
+            mscData.time = mscData.effepoch;
+            mscData.coordinates = rin.header.antennaPosition;
+            mscData.velocities = Triple(0.0, 0.0, 0.0);
+            mscStore.addMSC(mscData);
+
+            antModels.push_back(rin.header.antType);
+
+            rin.exceptions(ios::goodbit);
+
+            gnssRinex gRin;
+            while( rin >> gRin )
+            {
+                if( epochIndex.find(gRin.header.epoch) == epochIndex.end() )
+                {
+                    epochIndex[gRin.header.epoch] = epochData.size();
+                    epochData.push_back( gnssDataMap() );
+                }
+
+                epochData[ epochIndex[gRin.header.epoch] ].addGnssRinex(gRin);
+            }
+        }
+    }
+    catch(...)
+    {
+        cerr << "obs files read error, in '" << dataDir << "obs'." << endl;
+        exit(-1);
+    }
+
+
+    // initial orbits in ICRS, with the partials of the state and of five
+    // ECOM parameters
+    const int numSRP(5);
+
+    satVectorMap satOrbits;
+    satVectorMap satSRPCoeff;
+
+    Matrix<double> t2cRaw( refSys.T2CMatrix( refSys.GPS2UTC(gps0) ) );
+    Matrix<double> t2cDot( refSys.dT2CMatrix( refSys.GPS2UTC(gps0) ) );
+
+    for(int prn = 1; prn <= MAX_PRN_GPS; ++prn)
+    {
+        SatID sat(prn, SatID::systemGPS);
+
+        Xvt xvt;
+        try
+        {
+            xvt = sp3Store.getXvt(sat, gps0);
+        }
+        catch(...)
+        {
+            continue;
+        }
+
+        Vector<double> r( t2cRaw * xvt.x.toVector() );
+        Vector<double> v( t2cRaw * xvt.v.toVector()
+                          + t2cDot * xvt.x.toVector() );
+
+        Vector<double> orbit(42 + 6*numSRP, 0.0);
+        orbit(0) = r(0); orbit(1) = r(1); orbit(2) = r(2);
+        orbit(3) = v(0); orbit(4) = v(1); orbit(5) = v(2);
+        orbit( 6) = 1.0; orbit(10) = 1.0; orbit(14) = 1.0;
+        orbit(33) = 1.0; orbit(37) = 1.0; orbit(41) = 1.0;
+
+        satOrbits[sat] = orbit;
+        satSRPCoeff[sat] = Vector<double>(numSRP, 0.0);
+    }
+
+
+    // force models of the orbit arc
+    EGM08Model egm(12, 12);
+    ThirdBody thd;
+    ECOM1Model srp;
+    Relativity rel;
+    GNSSOrbit gnss;
+
+    try
+    {
+        egm.loadFile(tableDir + "EGM2008.SMALL");
+    }
+    catch(...)
+    {
+        cerr << "EGM file load error, in '" << tableDir << "'." << endl;
+        exit(-1);
+    }
+
+    egm.setReferenceSystem(refSys);
+
+    thd.setSolarSystem(solSys);
+    thd.setReferenceSystem(refSys);
+    thd.enableAllPlanets();
+
+    srp.setReferenceSystem(refSys);
+    srp.setSolarSystem(solSys);
+    srp.setSRPCoeff(satSRPCoeff);
+
+    gnss.setEGMModel(egm);
+    gnss.setThirdBody(thd);
+    gnss.setSRPModel(srp);
+    gnss.setRelativity(rel);
+
+
+    // kernels
+    vector<Kernel*> kernels;
+
+    kernels.push_back( new RinexDecodeKernel(obsFiles) );
+    kernels.push_back( new SP3InterpolationKernel(sp3Store, gps0) );
+    kernels.push_back( new BasicModelKernel(sp3Store, mscStore, epochData) );
+    kernels.push_back( new MeasUpdateKernel(100) );
+    kernels.push_back( new MeasUpdateKernel(500) );
+    kernels.push_back( new MeasUpdateKernel(2000) );
+    kernels.push_back( new EGMKernel( tableDir + "EGM2008.SMALL", 12,
+                                      refSys, tt0, satOrbits ) );
+    kernels.push_back( new EGMKernel( tableDir + "EGM2008.SMALL", 70,
+                                      refSys, tt0, satOrbits ) );
+    kernels.push_back( new RKF78ArcKernel(gnss, tt0, satOrbits) );
+    kernels.push_back( new AntexLookupKernel( tableDir + "igs14_1958.atx",
+                                              antModels, gps0 ) );
+
+    vector<Result> results;
+
+    for(size_t i = 0; i < kernels.size(); ++i)
+    {
+        cerr << "timing " << kernels[i]->getName();
+        if( kernels[i]->getSize() > 0 ) cerr << " " << kernels[i]->getSize();
+        cerr << endl;
+
+        try
+        {
+            results.push_back( timeKernel(*kernels[i], repeats) );
+        }
+        catch(Exception& e)
+        {
+            cerr << kernels[i]->getName() << " error: " << e << endl;
+        }
+
+        delete kernels[i];
+    }
+
+    if(format == "csv")
+        printCSV(results);
+    else
+        printJSON(results);
+
+    return 0;
+
+}
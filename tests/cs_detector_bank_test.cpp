@@ -0,0 +1,279 @@
+#pragma ident "$Id$"
+
+/**
+ * @file cs_detector_bank_test.cpp
+ * tests CSDetectorBank against the chain of the individual detectors it
+ * replaces,
+ *
+ *    LICSDetector >> [LICSDetector2] >> MWCSDetector >> [MWCSDetector2]
+ *       >> SatArcMarker
+ *
+ * on synthetic data of two receivers with cycle slips, LLI flags, data
+ * gaps and missing observables. The CSL flags, 'satArc' and the
+ * satellites kept must be the same at every epoch.
+ *
+ * The bank processes both receivers at once, and each receiver has its
+ * own chain: MWCSDetector keeps a single state per satellite for all the
+ * sources of a gnssDataMap.
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "DataStructures.hpp"
+#include "CivilTime.hpp"
+#include "LICSDetector.hpp"
+#include "LICSDetector2.hpp"
+#include "MWCSDetector.hpp"
+#include "MWCSDetector2.hpp"
+#include "SatArcMarker.hpp"
+#include "CSDetectorBank.hpp"
+
+using namespace std;
+using namespace gpstk;
+
+   /// Number of epochs, 30 s apart
+static const int NumEpochs = 240;
+
+   /// Number of GPS satellites of each receiver
+static const int NumGPS = 10;
+
+
+   /// Uniform random number in [-1, 1)
+static double noise()
+{
+   return ( 2.0*(rand()/(RAND_MAX + 1.0)) - 1.0 );
+}
+
+
+   /** Synthetic LI and MW of every satellite of one epoch.
+    *
+    * @param epoch      Epoch number.
+    * @param src        Receiver number.
+    * @param mixed      Add a Galileo and a BDS satellite.
+    */
+static gnssRinex makeEpoch(int epoch, int src, bool mixed)
+{
+   gnssRinex gRin;
+   gRin.header.source = SourceID( SourceID::GPS,
+                                  (src == 0) ? "AAAA" : "BBBB" );
+   gRin.header.epoch = CivilTime(2015, 1, 1, 0, 0, 0.0).convertToCommonTime();
+   gRin.header.epoch += 30.0*epoch;
+   gRin.header.epochFlag = 0;
+
+   vector<SatID> sats;
+   for(int prn = 1; prn <= NumGPS; ++prn)
+   {
+      sats.push_back( SatID(prn, SatID::systemGPS) );
+   }
+   if(mixed)
+   {
+      sats.push_back( SatID(11, SatID::systemGalileo) );
+      sats.push_back( SatID(6, SatID::systemBDS) );
+   }
+
+   for(size_t i = 0; i < sats.size(); ++i)
+   {
+      const SatID& sat( sats[i] );
+      const int k( i + 3*src );
+
+         // Gaps longer than 'deltaTMax', and a satellite that sets
+      if( k == 2 && epoch >= 50 && epoch < 53 ) continue;
+      if( k == 7 && epoch >= 120 && epoch < 122 ) continue;
+      if( k == 5 && epoch >= 200 ) continue;
+
+      typeValueMap& tvm( gRin.body[sat] );
+
+         // Slowly varying ionosphere, and jumps at the slips
+      double li( 0.3 + 0.1*k + 2.0e-5*epoch*(k+1) + 0.003*noise() );
+      double mw( 5.0*k + 0.15*noise() );
+
+      if( epoch >= 30 + 7*k ) li += 0.25;
+      if( epoch >= 90 + 5*k ) mw += 15.0*WL_WAVELENGTH_GPS;
+      if( epoch >= 160 + 3*k ) { li += 0.05; mw += 1.0; }
+
+         // Satellites without one of the observables are deleted
+      if( !( k == 4 && epoch == 70 ) ) tvm[TypeID::LI] = li;
+      if( !( k == 9 && epoch == 140 ) ) tvm[TypeID::MW] = mw;
+
+         // Loss of lock, and a flag which is not a slip
+      tvm[TypeID::LLI1] = ( epoch == 110 + k ) ? 1.0 : 0.0;
+      tvm[TypeID::LLI2] = ( epoch == 180 + k ) ? 2.0 : 0.0;
+      if( sat.system == SatID::systemGalileo ) tvm[TypeID::LLI5] = 0.0;
+      if( sat.system == SatID::systemBDS ) tvm[TypeID::LLI7] = 0.0;
+   }
+
+   return gRin;
+}
+
+
+   /// Chain of individual detectors of one receiver
+struct DetectorChain
+{
+   LICSDetector markCSLI;
+   LICSDetector2 markCSLI2;
+   MWCSDetector markCSMW;
+   MWCSDetector2 markCSMW2;
+   SatArcMarker markArc;
+   bool withFit;
+
+   void Process(gnssRinex& gRin)
+   {
+      markCSLI.Process(gRin);
+      if(withFit) markCSLI2.Process(gRin);
+      markCSMW.Process(gRin);
+      if(withFit) markCSMW2.Process(gRin);
+      markArc.Process(gRin);
+   }
+};
+
+
+   /** Compare the bank with the chain over all the epochs.
+    *
+    * @param withFit    Also run the LI fit and MW sigma tests.
+    * @param deleteSats Delete the unstable satellites.
+    * @param mixed      Add Galileo and BDS satellites.
+    *
+    * @return Number of differences.
+    */
+static int compare(bool withFit, bool deleteSats, bool mixed)
+{
+   DetectorChain chain[2];
+   for(int src = 0; src < 2; ++src)
+   {
+      chain[src].withFit = withFit;
+      chain[src].markArc.setDeleteUnstableSats(deleteSats);
+   }
+
+   CSDetectorBank bank;
+   bank.setTest(CSDetectorBank::testLIFit, withFit);
+   bank.setTest(CSDetectorBank::testMWSigma, withFit);
+   bank.setDeleteUnstableSats(deleteSats);
+
+   srand(7);
+
+   int diffs(0);
+   int numSlips(0);
+
+   for(int epoch = 0; epoch < NumEpochs; ++epoch)
+   {
+      gnssDataMap chainData;
+      gnssDataMap bankData;
+      for(int src = 0; src < 2; ++src)
+      {
+         gnssRinex gRin( makeEpoch(epoch, src, mixed) );
+         bankData.addGnssRinex(gRin);
+
+         chain[src].Process(gRin);
+         chainData.addGnssRinex(gRin);
+      }
+
+      bank.Process(bankData);
+
+      const sourceDataMap& chainSdm( chainData.begin()->second );
+      const sourceDataMap& bankSdm( bankData.begin()->second );
+
+      for( sourceDataMap::const_iterator sdmIt = chainSdm.begin();
+           sdmIt != chainSdm.end();
+           ++sdmIt )
+      {
+         const satTypeValueMap& chainStv( sdmIt->second );
+         const satTypeValueMap& bankStv( bankSdm.find(sdmIt->first)->second );
+
+         if( chainStv.numSats() != bankStv.numSats() )
+         {
+            cout << "Epoch " << epoch << ", " << sdmIt->first << ": "
+                 << chainStv.numSats() << " satellites kept by the chain, "
+                 << bankStv.numSats() << " by the bank." << endl;
+            diffs++;
+            continue;
+         }
+
+         for( satTypeValueMap::const_iterator it = chainStv.begin();
+              it != chainStv.end();
+              ++it )
+         {
+            satTypeValueMap::const_iterator bit( bankStv.find(it->first) );
+            if( bit == bankStv.end() )
+            {
+               cout << "Epoch " << epoch << ", " << it->first
+                    << " deleted by the bank only." << endl;
+               diffs++;
+               continue;
+            }
+
+            TypeID types[] = { TypeID::CSL1, TypeID::CSL2, TypeID::CSL5,
+                               TypeID::CSL7, TypeID::satArc };
+
+            for(int t = 0; t < 5; ++t)
+            {
+               typeValueMap::const_iterator c( it->second.find(types[t]) );
+               typeValueMap::const_iterator b( bit->second.find(types[t]) );
+
+               bool inChain( c != it->second.end() );
+               bool inBank( b != bit->second.end() );
+
+               if( inChain != inBank ||
+                   ( inChain && c->second != b->second ) )
+               {
+                  cout << "Epoch " << epoch << ", " << it->first << ", "
+                       << types[t] << ": chain "
+                       << ( inChain ? c->second : -1.0 ) << ", bank "
+                       << ( inBank ? b->second : -1.0 ) << endl;
+                  diffs++;
+               }
+            }
+
+               // Galileo satellites are flagged in CSL1, BDS ones in CSL2
+            typeValueMap::const_iterator flag( bit->second.find(
+                     (it->first.system == SatID::systemBDS) ? TypeID::CSL2
+                                                            : TypeID::CSL1 ) );
+            if( flag != bit->second.end() && flag->second > 0.0 ) numSlips++;
+         }
+      }
+   }
+
+   cout << "LI fit and MW sigma tests " << ( withFit ? "on" : "off" )
+        << ", unstable satellites " << ( deleteSats ? "deleted" : "kept" )
+        << ( mixed ? ", GPS+GAL+BDS" : ", GPS" ) << ": "
+        << numSlips << " slips flagged, " << diffs << " differences."
+        << endl;
+
+      // The data must have slips to compare
+   if(numSlips == 0) diffs++;
+
+   return diffs;
+}
+
+
+   /// Returns 0 when successful.
+int main(int argc, char *argv[])
+{
+   try
+   {
+      int fails(0);
+
+         // LICSDetector2 flags CSL1/CSL2 for all systems, while the bank
+         // uses the types of LICSDetector, so it is compared with GPS only
+      fails += compare(false, false, true);
+      fails += compare(false, true, true);
+      fails += compare(true, false, false);
+      fails += compare(true, true, false);
+
+      cout << fails << " failures.  Done." << endl;
+
+      return (fails ? 1 : 0);
+   }
+   catch(Exception& e)
+   {
+      cout << e;
+      return 1;
+   }
+   catch (...)
+   {
+      cout << "unknown error.  Done." << endl;
+      return 1;
+   }
+
+} // main()
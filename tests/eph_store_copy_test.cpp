@@ -0,0 +1,96 @@
+#pragma ident "$Id$"
+
+/**
+ * @file eph_store_copy_test.cpp
+ * tests the copies of OrbitEphStore (copy constructor, assignment and
+ * destructor), which own clones of the ephemerides of the original.
+ *
+ * Run it under a leak checker, e.g.
+ *
+ *    valgrind --leak-check=full --errors-for-leak-kinds=definite \
+ *       --error-exitcode=1 eph_store_copy_test brdm0010.15p
+ *
+ * or build with -fsanitize=address, so that a store that does not delete
+ * its ephemerides makes the test fail.
+ */
+
+#include <iostream>
+
+#include "Rinex3EphemerisStore2.hpp"
+#include "GPSEphemerisStore.hpp"
+
+using namespace std;
+using namespace gpstk;
+
+/// Number of copies made and destroyed
+static const int NumCopies = 50;
+
+/// Returns 0 when successful.
+int main(int argc, char *argv[])
+{
+   if (argc<2)
+   {
+      cout << "Gimme a rinex nav to chew on!  Exiting." << endl;
+      return -1;
+   }
+
+   try
+   {
+      Rinex3EphemerisStore2 bce;
+      bce.loadFile(argv[1]);
+
+      const GPSEphemerisStore& gps = bce.getGPSEphemerisStore();
+      if (gps.size() == 0)
+      {
+         cout << "No GPS ephemerides in " << argv[1] << "." << endl;
+         return 1;
+      }
+
+         // A satellite and a time where the original computes an Xvt
+      SatID sat(1, SatID::systemGPS);
+      while (gps.size(sat) == 0 && sat.id < 32) sat.id++;
+      CommonTime t( gps.getInitialTime(sat) );
+      t += 3600.0;
+      Xvt xvt( gps.getXvt(sat, t) );
+
+      int fails(0);
+
+      for (int i = 0; i < NumCopies; i++)
+      {
+         GPSEphemerisStore copy(gps);
+
+         GPSEphemerisStore assigned;
+         assigned = copy;
+         assigned = gps;
+
+            // The copies are deep: emptying one leaves the others intact
+         copy.clear();
+
+         Xvt xc( assigned.getXvt(sat, t) );
+         if (!(xc.x == xvt.x) || xc.clkbias != xvt.clkbias) fails++;
+
+         copy = gps;
+         copy.edit(t);
+
+         Rinex3EphemerisStore2 bce2(bce);
+      }
+
+      if (gps.size() == 0 || !(gps.getXvt(sat, t).x == xvt.x)) fails++;
+
+      cout << "Copied the store " << NumCopies << " times, "
+           << fails << " failures.  Done." << endl;
+
+      return (fails ? 1 : 0);
+   }
+   catch(Exception& e)
+   {
+      cout << e;
+      return 1;
+   }
+   catch (...)
+   {
+      cout << "unknown error.  Done." << endl;
+      return 1;
+   }
+
+} // main()
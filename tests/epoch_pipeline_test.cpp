@@ -0,0 +1,149 @@
+#pragma ident "$Id$"
+
+/**
+ * @file epoch_pipeline_test.cpp
+ * tests that EpochPipeline drops an epoch whose source threw, and goes on
+ * with the next ones until the end of the input, both with a single
+ * stage and with stages running in parallel.
+ */
+
+#include <iostream>
+
+#include "EpochPipeline.hpp"
+#include "CivilTime.hpp"
+
+using namespace std;
+using namespace gpstk;
+
+   /// Number of epochs of the source
+static const int NumEpochs = 50;
+
+   /// Epoch whose reading throws
+static const int BadEpoch = 20;
+
+
+   /// Source of empty epochs, throwing once
+class ThrowingSource : public EpochSource
+{
+public:
+
+   ThrowingSource() : count(0) {};
+
+   virtual bool readEpochData(gnssDataMap& gData)
+   {
+      if(count == NumEpochs) return false;
+
+      int epoch( count++ );
+      if(epoch == BadEpoch)
+      {
+         Exception e("Bad epoch");
+         GPSTK_THROW(e);
+      }
+
+      gnssRinex gRin;
+      gRin.header.source = SourceID(SourceID::GPS, "AAAA");
+      gRin.header.epoch = CivilTime(2015, 1, 1, 0, 0, 0.0).convertToCommonTime();
+      gRin.header.epoch += 30.0*epoch;
+
+      gData.clear();
+      gData.addGnssRinex(gRin);
+
+      return true;
+   };
+
+   virtual std::string getClassName(void) const
+   { return "ThrowingSource"; };
+
+   int count;
+};
+
+
+   /// Stage counting the epochs it gets
+class CountingStage : public EpochStage
+{
+public:
+
+   CountingStage() : count(0) {};
+
+   virtual bool Process(gnssDataMap& gData)
+   { ++count; return true; };
+
+   virtual std::string getClassName(void) const
+   { return "CountingStage"; };
+
+   int count;
+};
+
+
+   /** Run a pipeline over the source.
+    *
+    * @param numStages  Number of stages.
+    *
+    * @return Number of failures.
+    */
+static int check(int numStages)
+{
+   ThrowingSource source;
+   vector<CountingStage> stages(numStages);
+
+   EpochPipeline pipeline(source, 4);
+   for(int i = 0; i < numStages; ++i) pipeline.addStage(stages[i]);
+
+   bool thrown(false);
+   try
+   {
+      pipeline.run();
+   }
+   catch(ProcessingException& e)
+   {
+      thrown = true;
+   }
+
+   const vector<EpochPipeline::StageStats>& stats( pipeline.getStats() );
+
+   int fails(0);
+   if( !thrown ) fails++;
+   if( source.count != NumEpochs ) fails++;
+   if( stats[0].numEpochs != NumEpochs ) fails++;
+   if( stats[0].numDropped != 1 || stats[0].numErrors != 1 ) fails++;
+   for(int i = 0; i < numStages; ++i)
+   {
+      if( stages[i].count != NumEpochs - 1 ) fails++;
+      if( stats[i+1].numEpochs != NumEpochs - 1 ) fails++;
+   }
+
+   cout << numStages << " stage(s): " << source.count << " epochs read, "
+        << stats[0].numDropped << " dropped, "
+        << stages.back().count << " processed, "
+        << fails << " failures." << endl;
+
+   return fails;
+}
+
+
+   /// Returns 0 when successful.
+int main(int argc, char *argv[])
+{
+   try
+   {
+      int fails(0);
+
+      fails += check(1);
+      fails += check(3);
+
+      cout << fails << " failures.  Done." << endl;
+
+      return (fails ? 1 : 0);
+   }
+   catch(Exception& e)
+   {
+      cout << e;
+      return 1;
+   }
+   catch (...)
+   {
+      cout << "unknown error.  Done." << endl;
+      return 1;
+   }
+
+} // main()
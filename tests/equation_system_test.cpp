@@ -0,0 +1,357 @@
+#pragma ident "$Id$"
+
+/**
+ * @file equation_system_test.cpp
+ * tests the incremental mode of EquationSystemEx against the full rebuild
+ * of the equations every epoch, on synthetic clock data of two receivers
+ * whose satellites set and rise.
+ *
+ * First, both systems are prepared against a state store which misses a
+ * variable every other epoch, as when a solver drops it: the current and
+ * previous indices of the unknowns and of the equations must be the same.
+ * Then both drive a TimeUpdate/MeasUpdate filter, and the solutions must
+ * be the same.
+ */
+
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "CivilTime.hpp"
+#include "EquationSystemEx.hpp"
+#include "StochasticModel2.hpp"
+#include "TimeUpdate.hpp"
+#include "MeasUpdate.hpp"
+
+using namespace std;
+using namespace gpstk;
+
+   /// Number of epochs, 30 s apart
+static const int NumEpochs = 60;
+
+   /// Number of GPS satellites
+static const int NumGPS = 8;
+
+
+   /** Synthetic data of one receiver at one epoch.
+    *
+    * @param epoch      Epoch number.
+    * @param src        Receiver number.
+    */
+static gnssRinex makeEpoch(int epoch, int src)
+{
+   gnssRinex gRin;
+   gRin.header.source = SourceID( SourceID::GPS,
+                                  (src == 0) ? "AAAA" : "BBBB" );
+   gRin.header.epoch = CivilTime(2015, 1, 1, 0, 0, 0.0).convertToCommonTime();
+   gRin.header.epoch += 30.0*epoch;
+   gRin.header.epochFlag = 0;
+
+   for(int prn = 1; prn <= NumGPS; ++prn)
+   {
+         // A satellite that sets and rises, one that rises, one that sets
+      if( prn == 3 && epoch >= 12 && epoch < 25 ) continue;
+      if( prn == 6 && epoch < 8 + 4*src ) continue;
+      if( prn == 8 && epoch >= 40 - 5*src ) continue;
+
+      SatID sat(prn, SatID::systemGPS);
+      typeValueMap& tvm( gRin.body[sat] );
+
+      double satClk( 100.0*prn + 0.5*epoch*std::sin(prn + 0.1*epoch) );
+      double staClk( 50.0*(src+1) + 2.0*epoch );
+      double wetMap( 1.0 + 0.2*prn + 0.01*epoch );
+      double tropo( 0.1 + 0.02*src );
+
+      tvm[TypeID::cdtSat] = satClk;
+      tvm[TypeID::wetMap] = wetMap;
+      tvm[TypeID::prefitC] = staClk - satClk + wetMap*tropo
+                             + 0.3*std::cos( 7.0*prn + 3.0*src + epoch );
+   }
+
+   return gRin;
+}
+
+
+   /// Both GNSS data of one epoch
+static gnssDataMap makeData(int epoch)
+{
+   gnssDataMap gData;
+   for(int src = 0; src < 2; ++src)
+   {
+      gData.addGnssRinex( makeEpoch(epoch, src) );
+   }
+
+   return gData;
+}
+
+
+   /** Compare the indices of the unknowns and equations of two systems.
+    *
+    * @return Number of differences.
+    */
+static int compareIndices( int epoch,
+                           const EquationSystemEx& full,
+                           const EquationSystemEx& inc )
+{
+   int diffs(0);
+
+   VariableSet fullVars( full.getCurrentUnknowns() );
+   VariableSet incVars( inc.getCurrentUnknowns() );
+
+   if( fullVars.size() != incVars.size() )
+   {
+      cout << "Epoch " << epoch << ": " << fullVars.size()
+           << " unknowns rebuilt, " << incVars.size() << " updated." << endl;
+      return 1;
+   }
+
+   for( VariableSet::const_iterator fIt = fullVars.begin(),
+                                    iIt = incVars.begin();
+        fIt != fullVars.end();
+        ++fIt, ++iIt )
+   {
+      if( !( *fIt == *iIt ) ||
+          fIt->getNowIndex() != iIt->getNowIndex() ||
+          fIt->getPreIndex() != iIt->getPreIndex() )
+      {
+         cout << "Epoch " << epoch << ", "
+              << StringUtils::asString(*fIt) << ": indices "
+              << fIt->getPreIndex() << "/" << fIt->getNowIndex()
+              << " rebuilt, " << iIt->getPreIndex() << "/"
+              << iIt->getNowIndex() << " updated." << endl;
+         diffs++;
+      }
+   }
+
+   EquationList fullEqs( full.getCurrentEquationsList() );
+   EquationList incEqs( inc.getCurrentEquationsList() );
+
+   if( fullEqs.size() != incEqs.size() )
+   {
+      cout << "Epoch " << epoch << ": " << fullEqs.size()
+           << " equations rebuilt, " << incEqs.size() << " updated." << endl;
+      return diffs + 1;
+   }
+
+   for( EquationList::const_iterator fIt = fullEqs.begin(),
+                                     iIt = incEqs.begin();
+        fIt != fullEqs.end();
+        ++fIt, ++iIt )
+   {
+      VarCoeffMap::const_iterator fvIt( fIt->body.begin() );
+      VarCoeffMap::const_iterator ivIt( iIt->body.begin() );
+      for( ; fvIt != fIt->body.end() && ivIt != iIt->body.end();
+           ++fvIt, ++ivIt )
+      {
+         if( !( fvIt->first == ivIt->first ) ||
+             fvIt->first.getNowIndex() != ivIt->first.getNowIndex() ||
+             fvIt->first.getPreIndex() != ivIt->first.getPreIndex() )
+         {
+            diffs++;
+         }
+      }
+
+      if( fvIt != fIt->body.end() || ivIt != iIt->body.end() ) diffs++;
+   }
+
+   return diffs;
+}
+
+
+   /** Prepare both systems every epoch, against state stores missing a
+    *  variable every other epoch.
+    *
+    * @return Number of differences.
+    */
+static int checkIndices( const Equation& equ )
+{
+   StateStore fullStore, incStore;
+
+   EquationSystemEx full, inc;
+   full.setStateStore(fullStore);
+   inc.setStateStore(incStore);
+   inc.setIncremental(true);
+
+   full.addEquation2Source( equ, SourceID(SourceID::GPS, "AAAA") );
+   full.addEquation2Source( equ, SourceID(SourceID::GPS, "BBBB") );
+   inc.addEquation2Source( equ, SourceID(SourceID::GPS, "AAAA") );
+   inc.addEquation2Source( equ, SourceID(SourceID::GPS, "BBBB") );
+
+   int diffs(0);
+
+   for(int epoch = 0; epoch < NumEpochs; ++epoch)
+   {
+      gnssDataMap fullData( makeData(epoch) );
+      gnssDataMap incData( makeData(epoch) );
+
+      full.Prepare(fullData);
+      inc.Prepare(incData);
+
+      diffs += compareIndices(epoch, full, inc);
+
+         // The clock of PRN 1 is dropped from the state every other epoch
+      VariableSet fullVars( full.getCurrentUnknowns() );
+      VariableSet incVars( inc.getCurrentUnknowns() );
+      if( epoch % 2 )
+      {
+         for( VariableSet::iterator it = fullVars.begin();
+              it != fullVars.end();
+              ++it )
+         {
+            if( it->getType() == TypeID::dcdtSat &&
+                it->getSatellite() == SatID(1, SatID::systemGPS) )
+            {
+               incVars.erase(*it);
+               fullVars.erase(it);
+               break;
+            }
+         }
+      }
+
+      fullStore.setVariableSet(fullVars);
+      incStore.setVariableSet(incVars);
+   }
+
+   cout << "Indices: " << diffs << " differences." << endl;
+
+   return diffs;
+}
+
+
+   /** Run a filter with each system, and compare the solutions.
+    *
+    * @return Number of differences.
+    */
+static int checkSolution( const Equation& equ )
+{
+   StateStore stores[2];
+   TimeUpdate timeUpdates[2];
+   MeasUpdate measUpdates[2];
+
+   for(int i = 0; i < 2; ++i)
+   {
+      EquationSystemEx equSystem;
+      equSystem.setIncremental( i == 1 );
+      equSystem.addEquation2Source( equ, SourceID(SourceID::GPS, "AAAA") );
+      equSystem.addEquation2Source( equ, SourceID(SourceID::GPS, "BBBB") );
+
+      timeUpdates[i].setEquationSystem(equSystem);
+      timeUpdates[i].setStateStore(stores[i]);
+      measUpdates[i].setEquationSystem(equSystem);
+      measUpdates[i].setStateStore(stores[i]);
+   }
+
+   int diffs(0);
+   double maxDiff(0.0);
+
+   for(int epoch = 0; epoch < NumEpochs; ++epoch)
+   {
+      for(int i = 0; i < 2; ++i)
+      {
+         gnssDataMap gData( makeData(epoch) );
+         timeUpdates[i].Process(gData);
+         measUpdates[i].Process(gData);
+      }
+
+      const VariableSet& fullVars( stores[0].getVariableSet() );
+      const VariableSet& incVars( stores[1].getVariableSet() );
+      Vector<double> fullState( stores[0].getStateVector() );
+      Vector<double> incState( stores[1].getStateVector() );
+
+      if( fullVars.size() != incVars.size() )
+      {
+         diffs++;
+         continue;
+      }
+
+      for( VariableSet::const_iterator fIt = fullVars.begin(),
+                                       iIt = incVars.begin();
+           fIt != fullVars.end();
+           ++fIt, ++iIt )
+      {
+         if( !( *fIt == *iIt ) || fIt->getNowIndex() != iIt->getNowIndex() )
+         {
+            diffs++;
+            continue;
+         }
+
+         double diff( std::fabs( fullState(fIt->getNowIndex())
+                                 - incState(iIt->getNowIndex()) ) );
+         if( diff > maxDiff ) maxDiff = diff;
+         if( diff > 1e-6 )
+         {
+            cout << "Epoch " << epoch << ", "
+                 << StringUtils::asString(*fIt) << ": "
+                 << fullState(fIt->getNowIndex()) << " rebuilt, "
+                 << incState(iIt->getNowIndex()) << " updated." << endl;
+            diffs++;
+         }
+      }
+   }
+
+   cout << "Solution: largest difference " << maxDiff << " m, "
+        << diffs << " differences." << endl;
+
+   return diffs;
+}
+
+
+   /// Returns 0 when successful.
+int main(int argc, char *argv[])
+{
+   try
+   {
+         // Same variables as gps_clock1
+      WhiteNoiseModel2 staClkModel;
+      staClkModel.addTypeID( TypeID::dcdtSta );
+      staClkModel.setSigma( 1e2 );
+
+      Variable staClk(TypeID::dcdtSta, &staClkModel);
+      staClk.setSourceIndexed(true);
+      staClk.setSatIndexed(false);
+      staClk.setDefaultCoefficient(+1.0);
+      staClk.setDefaultForced(true);
+
+      WhiteNoiseModel2 satClkModel;
+      satClkModel.addTypeID( TypeID::dcdtSat );
+      satClkModel.setSigma( 3e5 );
+
+      Variable satClk(TypeID::dcdtSat, &satClkModel);
+      satClk.setSourceIndexed(false);
+      satClk.setSatIndexed(true);
+      satClk.setDefaultCoefficient(-1.0);
+      satClk.setDefaultForced(true);
+
+      TropoRandomWalkModel2 tropoModel;
+
+      Variable staTropo(TypeID::wetMap, &tropoModel);
+      staTropo.setSourceIndexed(true);
+      staTropo.setSatIndexed(false);
+      staTropo.setInitialVariance(0.5);
+
+      Equation equ( Variable(TypeID::prefitC) );
+      equ.addVariable( satClk, true, -1.0 );
+      equ.addVariable( staClk, true, +1.0 );
+      equ.addVariable( staTropo );
+
+      int fails(0);
+
+      fails += checkIndices(equ);
+      fails += checkSolution(equ);
+
+      cout << fails << " failures.  Done." << endl;
+
+      return (fails ? 1 : 0);
+   }
+   catch(Exception& e)
+   {
+      cout << e;
+      return 1;
+   }
+   catch (...)
+   {
+      cout << "unknown error.  Done." << endl;
+      return 1;
+   }
+
+} // main()
@@ -26,6 +26,8 @@
 #include "SP3EphemerisStore.hpp"
 
 #include "NetworkObsStreams.hpp"
+#include "NetworkObsCache.hpp"
+#include "EpochPipeline.hpp"
 
 #include "DataStructures.hpp"
 
@@ -86,6 +88,8 @@
 
 #include "Counter.hpp"
 
+#include "ProcessingProfiler.hpp"
+
 
 using namespace std;
 using namespace gpstk;
@@ -288,48 +292,20 @@ int main(int argc, char* argv[])
     sp3Store.setPosGapInterval(900+1);
     sp3Store.setPosMaxInterval(9*900+1);
 
-    vector<string>::const_iterator sp3_it = sp3FileListVec.begin();
-    while(sp3_it != sp3FileListVec.end())
+    // parse all the sp3 and clk files at once, then merge them
+    SP3EphemerisStore::LoadStats loadStats;
+    try
     {
-        sp3File = (*sp3_it);
-
-        try
-        {
-            sp3Store.loadFile(sp3File);
-        }
-        catch(...)
-        {
-            cerr << "sp3 file '" << sp3File
-                 << "' load error." << endl;
-
-            ++sp3_it;
-            continue;
-        }
-
-        ++sp3_it;
+        loadStats = sp3Store.loadFiles(sp3FileListVec, clkFileListVec);
     }
-
-    vector<string>::const_iterator clk_it = clkFileListVec.begin();
-    while(clk_it != clkFileListVec.end())
+    catch(...)
     {
-        clkFile = (*clk_it);
-
-        try
-        {
-            sp3Store.loadRinexClockFile(clkFile);
-        }
-        catch(...)
-        {
-            cerr << "clk file '" << clkFile
-                 << "' load error." << endl;
-
-            ++clk_it;
-            continue;
-        }
-
-        ++clk_it;
+        cerr << "sp3/clk files load error." << endl;
     }
 
+    // the files which failed are listed here
+    loadStats.dump(cout);
+
 
     // nav file
     string navFileListName;
@@ -544,6 +520,7 @@ int main(int argc, char* argv[])
 
     // obs file
     NetworkObsStreams obsStreams;
+    NetworkObsSource streamSource(obsStreams);
 
     string obsFileListName;
     try
@@ -565,6 +542,49 @@ int main(int argc, char* argv[])
     }
 
 
+    // profile report file, optional
+    string profileFileName;
+
+    try
+    {
+        if( confReader.ifExist("profileFileName", "DEFAULT") )
+        {
+            profileFileName = confReader.getValue("profileFileName", "DEFAULT");
+        }
+    }
+    catch(...)
+    {
+        cerr << "profile file name get error." << endl;
+        exit(-1);
+    }
+
+    if( !profileFileName.empty() ) ProcessingProfiler::enable();
+
+
+    // directory of the binary caches of the obs files, optional
+    string obsCacheDirectory;
+
+    try
+    {
+        if( confReader.ifExist("obsCacheDirectory", "DEFAULT") )
+        {
+            obsCacheDirectory = confReader.getValue("obsCacheDirectory",
+                                                    "DEFAULT");
+        }
+    }
+    catch(...)
+    {
+        cerr << "obs cache directory get error." << endl;
+        exit(-1);
+    }
+
+    NetworkObsCache obsCache;
+    obsCache.setCacheDirectory(obsCacheDirectory);
+
+    EpochSource* pObsSource( &streamSource );
+    if( !obsCacheDirectory.empty() ) pObsSource = &obsCache;
+
+
     double clock_start( Counter::now() );
 
 
@@ -675,8 +695,12 @@ int main(int argc, char* argv[])
 
         ros.close();
 
-        // now, we can add OBS file to OBS streams
-        if( !obsStreams.addRinexObsFile( obsFile ) )
+        // now, we can add OBS file to OBS streams, or its cache
+        bool added( obsCacheDirectory.empty()
+                    ? obsStreams.addRinexObsFile( obsFile )
+                    : obsCache.addRinexObsFile( obsFile ) );
+
+        if( !added )
         {
             cerr << "obs file '" << obsFile << "' add error." << endl;
             continue;
@@ -827,7 +851,7 @@ int main(int argc, char* argv[])
     bool first(true);
 
     // process epoch by epoch
-    while( obsStreams.readEpochData(gData) )
+    while( pObsSource->readEpochData(gData) )
     {
         gps = gData.begin()->first;
 
@@ -1313,12 +1337,28 @@ int main(int argc, char* argv[])
             break;
         }
 
-    } // End of 'while( obsStreams.readEpochData(gData) )'
+    } // End of 'while( pObsSource->readEpochData(gData) )'
 
     double clock_end( Counter::now() );
 
     cerr << "time elapsed: " << setw(10) << clock_end - clock_start << endl;
 
+    // time, data and allocations of every processor
+    if( !profileFileName.empty() )
+    {
+        ofstream profileStream( profileFileName.c_str() );
+
+        if( profileFileName.size() > 5 &&
+            profileFileName.substr(profileFileName.size() - 5) == ".json" )
+        {
+            ProcessingProfiler::dumpJSON(profileStream);
+        }
+        else
+        {
+            ProcessingProfiler::dumpCSV(profileStream);
+        }
+    }
+
     return 0;
 
 }
@@ -0,0 +1,230 @@
+#pragma ident "$Id$"
+
+/**
+ * @file spanning_forest_test.cpp
+ * tests SpanningForest on a synthetic network of 150 receivers and 100
+ * satellites, whose arcs end and start at every epoch.
+ *
+ * At every epoch, the forest must be acyclic, made of edges of the epoch,
+ * and spanning: the ends of every edge are joined by the forest, which
+ * then has as many edges as the minimum spanning forest of Kruskal. At
+ * the first epoch, with no forest to keep, it must be the one of Kruskal.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <vector>
+
+#include "SpanningForest.hpp"
+#include "Kruskal.hpp"
+
+using namespace std;
+using namespace gpstk;
+
+   /// Number of receivers
+static const int NumSources = 150;
+
+   /// Number of satellites
+static const int NumSats = 100;
+
+   /// Number of epochs
+static const int NumEpochs = 40;
+
+
+   /// State of a receiver-satellite pair
+struct PairState
+{
+   bool seen;        ///< Whether the arc goes on
+   int arc;          ///< Arc number
+   double elev;      ///< Elevation
+};
+
+
+   /// Root of 'x' in a union-find
+static int findRoot(vector<int>& parent, int x)
+{
+   while( parent[x] != x ) x = parent[x] = parent[ parent[x] ];
+   return x;
+}
+
+
+   /** Check the forest of an epoch.
+    *
+    * @param edges      Edges of the epoch.
+    * @param forest     Edges of the forest.
+    * @param kruskal    Minimum spanning forest of Kruskal.
+    * @param srcIndex   Index of every receiver.
+    *
+    * @return Number of failures.
+    */
+static int checkForest( int epoch,
+                        const EdgeSet& edges,
+                        const EdgeSet& forest,
+                        const EdgeSet& kruskal,
+                        map<SourceID, int>& srcIndex )
+{
+   int fails(0);
+
+   vector<int> parent( NumSources + NumSats );
+   for(size_t i = 0; i < parent.size(); ++i) parent[i] = i;
+
+   for( EdgeSet::const_iterator it = forest.begin();
+        it != forest.end();
+        ++it )
+   {
+         // Edge of the epoch, with the same arc number
+      if( edges.find(*it) == edges.end() )
+      {
+         cout << "Epoch " << epoch << ": " << *it
+              << " is not an edge of the epoch." << endl;
+         fails++;
+      }
+
+      int a( findRoot( parent, srcIndex[ it->getSource() ] ) );
+      int b( findRoot( parent, NumSources + it->getSatellite().id - 1 ) );
+      if( a == b )
+      {
+         cout << "Epoch " << epoch << ": " << *it << " closes a cycle."
+              << endl;
+         fails++;
+      }
+      parent[a] = b;
+   }
+
+   int numApart(0);
+   for( EdgeSet::const_iterator it = edges.begin();
+        it != edges.end();
+        ++it )
+   {
+      int a( findRoot( parent, srcIndex[ it->getSource() ] ) );
+      int b( findRoot( parent, NumSources + it->getSatellite().id - 1 ) );
+      if( a != b ) numApart++;
+   }
+
+   if( numApart > 0 )
+   {
+      cout << "Epoch " << epoch << ": the ends of " << numApart
+           << " edges are not joined by the forest." << endl;
+      fails++;
+   }
+
+   if( forest.size() != kruskal.size() )
+   {
+      cout << "Epoch " << epoch << ": " << forest.size()
+           << " edges in the forest, " << kruskal.size()
+           << " in Kruskal's." << endl;
+      fails++;
+   }
+
+   return fails;
+}
+
+
+   /// Returns 0 when successful.
+int main(int argc, char *argv[])
+{
+   try
+   {
+      srand(1);
+
+      vector<SourceID> sources;
+      map<SourceID, int> srcIndex;
+      for(int i = 0; i < NumSources; ++i)
+      {
+         char name[8];
+         sprintf(name, "S%03d", i);
+         sources.push_back( SourceID(SourceID::GPS, name) );
+         srcIndex[ sources.back() ] = i;
+      }
+
+         // A third of the pairs are seen at first
+      vector< vector<PairState> > pairs( NumSources,
+                                         vector<PairState>(NumSats) );
+      for(int i = 0; i < NumSources; ++i)
+      {
+         for(int j = 0; j < NumSats; ++j)
+         {
+            pairs[i][j].seen = ( rand()%3 == 0 );
+            pairs[i][j].arc = 1;
+            pairs[i][j].elev = 10 + rand()%80;
+         }
+      }
+
+      SpanningForest forest;
+
+      int fails(0);
+      int numChanges(0);
+
+      for(int epoch = 0; epoch < NumEpochs; ++epoch)
+      {
+            // Arcs that end, and new arcs
+         if( epoch > 0 )
+         {
+            for(int k = 0; k < NumSources*NumSats/200; ++k)
+            {
+               PairState& p( pairs[ rand()%NumSources ][ rand()%NumSats ] );
+               p.seen = !p.seen;
+               if( p.seen ) p.arc++;
+            }
+         }
+
+         EdgeSet edges;
+
+         forest.beginEpoch();
+         for(int i = 0; i < NumSources; ++i)
+         {
+            for(int j = 0; j < NumSats; ++j)
+            {
+               if( !pairs[i][j].seen ) continue;
+
+               Edge edge( sources[i], SatID(j+1, SatID::systemGPS),
+                          pairs[i][j].arc, 1.0, pairs[i][j].elev );
+               forest.addEdge(edge);
+               edges.insert(edge);
+            }
+         }
+         forest.endEpoch();
+
+         EdgeSet treeEdges( forest.getTreeEdges() );
+
+         Kruskal kruskal(edges);
+         EdgeSet kruskalEdges( kruskal.createMST() );
+
+         fails += checkForest( epoch, edges, treeEdges, kruskalEdges,
+                               srcIndex );
+
+         if( epoch == 0 && treeEdges != kruskalEdges )
+         {
+            cout << "First epoch: the forest is not Kruskal's." << endl;
+            fails++;
+         }
+
+         if( epoch > 0 ) numChanges += forest.getNumTreeAdded();
+      }
+
+      cout << forest.getNumEdges() << " edges, "
+           << forest.getNumTreeEdges() << " in the forest, "
+           << numChanges << " forest edges changed in "
+           << NumEpochs - 1 << " epochs." << endl;
+
+         // The arcs must have split some trees
+      if( numChanges == 0 ) fails++;
+
+      cout << fails << " failures.  Done." << endl;
+
+      return (fails ? 1 : 0);
+   }
+   catch(Exception& e)
+   {
+      cout << e;
+      return 1;
+   }
+   catch (...)
+   {
+      cout << "unknown error.  Done." << endl;
+      return 1;
+   }
+
+} // main()
@@ -26,6 +26,8 @@
 
 #include "AdamsIntegrator.hpp"
 
+#include "OrbitFit.hpp"
+
 #include "Epoch.hpp"
 
 #include "StringUtils.hpp"
@@ -523,10 +525,7 @@ int main(void)
     Vector<double> r_obs(3,0.0);
 
 
-    epochMatrixMap epochOrbit;
-    satEpochMatrixMap satEpochOrbit;
-
-    Matrix<double> equation(3,7+numSRP,0.0);
+    OrbitFit orbitFit(numSRP);
 
     SolarSystem::Planet earth(SolarSystem::Earth);
     SolarSystem::Planet sun(SolarSystem::Sun);
@@ -616,62 +615,7 @@ int main(void)
                 continue;
             }
 
-            for(int m=0; m<3; ++m)
-            {
-                equation(m,0) = r_obs(m) - orbit(m);
-
-                for(int n=0; n<3; ++n)
-                {
-                    equation(m,1+n) = orbit( 6+3*m+n);
-                    equation(m,4+n) = orbit(15+3*m+n);
-                }
-
-                for(int n=0; n<numSRP; ++n)
-                {
-                    equation(m,7+n) = orbit(42+numSRP*m+n);
-                }
-
-//                for(int n=0; n<6+numSRP; ++n)
-//                {
-//                    cout << setw(20) << equation(m,1+n);
-//                }
-//                cout << endl;
-            }
-
-//            cout << fixed;
-//            cout << sat;
-//            cout << setw(20) << equation(0,0)
-//                 << setw(20) << equation(1,0)
-//                 << setw(20) << equation(2,0)
-//                 << endl;
-
-            satEpochMatrixMap::iterator it2( satEpochOrbit.find(sat) );
-
-            // if sat exists
-            if(it2 != satEpochOrbit.end())
-            {
-                epochOrbit = it2->second;
-
-                epochMatrixMap::iterator it3( epochOrbit.find(gps) );
-
-                // if epoch exists
-                if(it3 != epochOrbit.end())
-                {
-                    continue;
-                }
-                // if epoch not exist, add it
-                else
-                {
-                    epochOrbit[gps] = equation;
-                    it2->second = epochOrbit;
-                }
-            }
-            // if sat not exist
-            else
-            {
-                epochOrbit[gps] = equation;
-                satEpochOrbit[sat] = epochOrbit;
-            }
+            orbitFit.addObservation(sat, gps, r_obs, orbit);
         }
 
 //        break;
@@ -803,56 +747,7 @@ int main(void)
                 continue;
             }
 
-            for(int m=0; m<3; ++m)
-            {
-                equation(m,0) = r_obs(m) - orbit(m);
-
-                for(int n=0; n<3; ++n)
-                {
-                    equation(m,1+n) = orbit( 6+3*m+n);
-                    equation(m,4+n) = orbit(15+3*m+n);
-                }
-
-                for(int n=0; n<numSRP; ++n)
-                {
-                    equation(m,7+n) = orbit(42+numSRP*m+n);
-                }
-            }
-
-//            cout << fixed;
-//            cout << sat;
-//            cout << setw(20) << equation(0,0)
-//                 << setw(20) << equation(1,0)
-//                 << setw(20) << equation(2,0)
-//                 << endl;
-
-            satEpochMatrixMap::iterator it2( satEpochOrbit.find(sat) );
-
-            // if sat exists
-            if(it2 != satEpochOrbit.end())
-            {
-                epochOrbit = it2->second;
-
-                epochMatrixMap::iterator it3( epochOrbit.find(gps) );
-
-                // if epoch exists
-                if(it3 != epochOrbit.end())
-                {
-                    continue;
-                }
-                // if epoch not exist, add it
-                else
-                {
-                    epochOrbit[gps] = equation;
-                    it2->second = epochOrbit;
-                }
-            }
-            // if sat not exist
-            else
-            {
-                epochOrbit[gps] = equation;
-                satEpochOrbit[sat] = epochOrbit;
-            }
+            orbitFit.addObservation(sat, gps, r_obs, orbit);
         }
 
     } // End of 'while(true)'
@@ -874,52 +769,23 @@ int main(void)
     ofstream fics(icsFile.c_str());
     fics << fixed;
 
-    for(satEpochMatrixMap::const_iterator it = satEpochOrbit.begin();
-        it != satEpochOrbit.end();
-        ++it)
-    {
-        sat = it->first;
-        epochOrbit = it->second;
-
-        int numEqu( epochOrbit.size() );
+    orbitFit.fit();
 
-        Vector<double> omc(numEqu*3,0.0);
-        Matrix<double> design(numEqu*3,6+numSRP,0.0);
-
-        int count(0);
-        for(epochMatrixMap::const_iterator it2 = epochOrbit.begin();
-            it2 != epochOrbit.end();
-            ++it2)
-        {
-            equation = it2->second;
-
-            for(int i=0; i<3; ++i)
-            {
-                omc(3*count+i) = equation(i,0);
+    SatIDSet fitSats( orbitFit.getSatellites() );
 
-                for(int j=1; j<7+numSRP; ++j)
-                {
-                    design(3*count+i,j-1) = equation(i,j);
-                }
-            }
-
-            ++count;
-        }
-
-
-        Matrix<double> A( transpose(design)*design );
-        Vector<double> B( transpose(design)*omc );
-
-        Vector<double> dx( inverse(A)*B );
+    for(SatIDSet::const_iterator it = fitSats.begin();
+        it != fitSats.end();
+        ++it)
+    {
+        sat = *it;
 
-        double sigma(0.0);
+        OrbitFit::FitStats stats( orbitFit.getStats(sat) );
 
-        omc -= design*dx;
+        if(!stats.valid) continue;
 
-        for(int i=1; i<=numEqu*3; ++i)
-            sigma += omc(i-1)*omc(i-1);
+        Vector<double> dx( orbitFit.getCorrection(sat) );
 
-        sigma = std::sqrt(sigma/(numEqu*3-6-numSRP));
+        double sigma( stats.sigma );
 
         if(arcLen > 40 && sigma > 0.05) continue;
 //        if(arcLen < 40 && sigma > 0.02) continue;